@@ -1,13 +1,18 @@
 #include "LUFADriver.h"
 
-static HIDReport hidReportData;
-static SwitchReport switchReportData;
-static XInputReport xinputReportData;
+// MPG builds reports straight into these, see GamepadReportBuffers.h. The largest report is XInput's.
+static uint16_t reportBuffers[2][(sizeof(XInputReport) + 1) / 2];
 
 static InputMode inputMode;
 static void *reportData;
 static uint8_t reportSize;
-static uint8_t lastReportBytes[64] = {0};
+static bool reportPending = false;
+static void (*startOfFrameCallback)(void) = NULL;
+
+// Reported in place of the input mode's own strings
+GAMEPAD_STRING_DESCRIPTOR(usb_string_manufacturer, u"FeralAI");
+GAMEPAD_STRING_DESCRIPTOR(usb_string_product, u"MPG Sample Gamepad");
+GAMEPAD_STRING_DESCRIPTOR(usb_string_version, u"1.0");
 
 // Configures hardware and peripherals, such as the USB peripherals.
 void setupHardware(InputMode mode)
@@ -28,13 +33,14 @@ void setupHardware(InputMode mode)
 	GlobalInterruptEnable();
 }
 
-void sendReport(void *data, uint8_t size)
+void sendReport(void *data, uint8_t size, bool changed)
 {
 	reportData = data;
 	reportSize = size;
+	reportPending |= changed; // Keep a changed report pending until the endpoint accepts it
 	if (
-		memcmp(lastReportBytes, reportData, reportSize) != 0 && // Did the report change?
-		USB_DeviceState == DEVICE_STATE_Configured              // Is USB ready?
+		reportPending &&                               // Did the report change?
+		USB_DeviceState == DEVICE_STATE_Configured     // Is USB ready?
 	)
 	{
 		Endpoint_SelectEndpoint(EPADDR_OUT);
@@ -56,14 +62,29 @@ void sendReport(void *data, uint8_t size)
 		{
 			Endpoint_Write_Stream_LE(reportData, reportSize, NULL);
 			Endpoint_ClearIN();
-			memcpy(lastReportBytes, reportData, reportSize);
-			memset(reportData, 0, reportSize);
+			reportPending = false;
 		}
 	}
 
 	USB_USBTask();
 }
 
+void *getReportBuffer(uint8_t index)
+{
+	return reportBuffers[index];
+}
+
+uint16_t getReportBufferSize(void)
+{
+	return sizeof(reportBuffers[0]);
+}
+
+// Called from the USB interrupt at every start of frame once configured, e.g. to feed a GamepadScheduler.
+void setStartOfFrameCallback(void (*callback)(void))
+{
+	startOfFrameCallback = callback;
+}
+
 uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue, const uint16_t wIndex, const void **const address)
 {
 	const uint8_t descriptorType = (wValue >> 8);
@@ -84,13 +105,16 @@ uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue, const uint16_t wIndex
 			switch (descriptorIndex)
 			{
 				case 1:
-					*address = convertStringDescriptor(&size, USB_STRING_MANUFACTURER, strlen(USB_STRING_MANUFACTURER));
+					*address = &usb_string_manufacturer;
+					size = usb_string_manufacturer.bLength;
 					break;
 				case 2:
-					*address = convertStringDescriptor(&size, USB_STRING_PRODUCT, strlen(USB_STRING_PRODUCT));
+					*address = &usb_string_product;
+					size = usb_string_product.bLength;
 					break;
 				case 3:
-					*address = convertStringDescriptor(&size, USB_STRING_VERSION, strlen(USB_STRING_VERSION));
+					*address = &usb_string_version;
+					size = usb_string_version.bLength;
 					break;
 				default:
 					*address = getStringDescriptor(&size, inputMode, descriptorIndex);
@@ -137,6 +161,15 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 			Endpoint_ConfigureEndpoint(EPADDR_IN, EP_TYPE_INTERRUPT, HID_ENDPOINT_SIZE, 1);
 			break;
 	}
+
+	USB_Device_EnableSOFEvents();
+}
+
+// Fired every 1ms USB frame, which is when the host polls the interrupt endpoints at bInterval 1.
+void EVENT_USB_Device_StartOfFrame(void)
+{
+	if (startOfFrameCallback)
+		startOfFrameCallback();
 }
 
 // Process control requests sent to the device from the USB host.
@@ -149,20 +182,11 @@ void EVENT_USB_Device_ControlRequest(void)
 			{
 				Endpoint_ClearSETUP();
 
-				switch (inputMode)
-				{
-					case INPUT_MODE_XINPUT:
-						Endpoint_Write_Control_Stream_LE(&xinputReportData, XINPUT_ENDPOINT_SIZE);
-						break;
-
-					case INPUT_MODE_SWITCH:
-						Endpoint_Write_Control_Stream_LE(&switchReportData, HID_ENDPOINT_SIZE);
-						break;
-
-					case INPUT_MODE_HID:
-						Endpoint_Write_Control_Stream_LE(&hidReportData, HID_ENDPOINT_SIZE);
-						break;
-				}
+				// The newest report, rather than a copy kept for control requests
+				if (reportData)
+					Endpoint_Write_Control_Stream_LE(reportData, reportSize);
+				else
+					Endpoint_Write_Control_Stream_LE(reportBuffers[0], sizeof(reportBuffers[0]));
 
 				Endpoint_ClearOUT();
 			}
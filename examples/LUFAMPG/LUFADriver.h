@@ -10,10 +10,6 @@
 #define EPADDR_IN  (ENDPOINT_DIR_IN  | 1)
 #define EPADDR_OUT (ENDPOINT_DIR_OUT | 2)
 
-extern char USB_STRING_MANUFACTURER[];
-extern char USB_STRING_PRODUCT[];
-extern char USB_STRING_VERSION[];
-
 // LUFA USB descriptor callback
 
 uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue, const uint16_t wIndex, const void** const DescriptorAddress)
@@ -24,7 +20,10 @@ extern "C" {
 #endif
 
 void setupHardware(InputMode mode);
-void sendReport(void *data, uint8_t size);
+void sendReport(void *data, uint8_t size, bool changed);
+void setStartOfFrameCallback(void (*callback)(void));
+void *getReportBuffer(uint8_t index);
+uint16_t getReportBufferSize(void);
 
 // LUFA USB device event handlers
 
@@ -32,6 +31,7 @@ void EVENT_USB_Device_Connect(void);
 void EVENT_USB_Device_Disconnect(void);
 void EVENT_USB_Device_ConfigurationChanged(void);
 void EVENT_USB_Device_ControlRequest(void);
+void EVENT_USB_Device_StartOfFrame(void);
 
 #ifdef __cplusplus
 }
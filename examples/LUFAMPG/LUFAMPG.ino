@@ -14,9 +14,13 @@ uint32_t getMillis() { return millis(); }
 #include "TUFGamepad.h"
 TUFGamepad gamepad(DEBOUNCE_MILLIS); // The gamepad instance
 
-char USB_STRING_MANUFACTURER[] = "FeralAI";
-char USB_STRING_PRODUCT[] = "MPG Sample Gamepad";
-char USB_STRING_VERSION[] = "1.0";
+// Start each frame just before the host polls, see GamepadScheduler.h
+#include <GamepadScheduler.h>
+GamepadScheduler scheduler;
+void onStartOfFrame() { scheduler.onPoll(micros()); }
+
+// Reports are built in the driver's buffers instead of being copied out of MPG's
+GamepadReportBuffers reportBuffers(getReportBuffer(0), getReportBuffer(1), getReportBufferSize());
 
 void setup()
 {
@@ -40,6 +44,8 @@ void setup()
 	}
 
 	// Initialize USB device driver
+	gamepad.setReportBuffers(&reportBuffers);
+	setStartOfFrameCallback(onStartOfFrame);
 	setupHardware(gamepad.options.inputMode);
 }
 
@@ -47,10 +53,20 @@ void loop()
 {
 	static const uint8_t reportSize = gamepad.getReportSize();  // Get report size from Gamepad instance
 	static GamepadHotkey hotkey;                            // The last hotkey pressed
+	bool changed;                                               // Whether the report changed since the last loop
+
+	uint32_t start = micros();
+	if (!scheduler.ready(start))                                // Too early for the next poll, keep servicing USB
+	{
+		USB_USBTask();
+		return;
+	}
 
 	gamepad.read();                                             // Read raw inputs
-	gamepad.debounce();                                         // Run debouncing if enabled
+	gamepad.debounce();                                         // Analog inputs, debouncing if enabled, remap and turbo
 	hotkey = gamepad.hotkey();                                  // Check hotkey presses (D-pad mode, SOCD mode, etc.), hotkey enum returned
 	gamepad.process();                                          // Perform final input processing (SOCD cleaning, LS/RS emulation, etc.)
-	sendReport(gamepad.getReport(), reportSize);                // Convert and send it!
+	void *report = gamepad.getReport(&changed);                 // Convert, only rebuilt when the state changed
+	sendReport(report, reportSize, changed);                    // Send it if it changed!
+	scheduler.done(start, micros());                            // Learn how long a frame takes
 }
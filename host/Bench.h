@@ -0,0 +1,230 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/*
+	Minimal host benchmark harness.
+
+	Each case runs its workload in batches of `batchSize` operations. A batch is timed as a whole and divided by
+	the batch size, so the clock overhead does not dominate stages that take only a few nanoseconds. The per-batch
+	ns/op values form the sample set used for percentiles.
+
+	To keep baselines portable between machines, every run also times a fixed reference workload. Regression checks
+	compare the ratio `case ns/op / reference ns/op` rather than raw nanoseconds.
+
+	Every batch is followed by a short probe of strided reads from L1. On a shared host other tenants can make even
+	L1 loads up to 2x slower for seconds at a time while leaving the reference's arithmetic alone, so the probe time
+	of each batch tells whether the machine was quiet while it ran.
+*/
+
+// Keep a value alive without letting the compiler see what happens to it
+template <typename T>
+inline void __attribute__((always_inline)) benchKeep(T const &value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename T>
+inline void __attribute__((always_inline)) benchKeep(T &value)
+{
+	asm volatile("" : "+r,m"(value) : : "memory");
+}
+
+struct BenchResult
+{
+	std::string name;
+	double min;
+	double p50;
+	double p90;
+	double p99;
+	double max;
+	double mean;
+	double ratio; // p50 relative to the reference workload
+	uint32_t samples; // Batches the percentiles were taken from
+};
+
+class Bench
+{
+	public:
+		typedef void (*CaseFunc)(Bench &bench);
+
+		struct Case
+		{
+			const char *name;
+			CaseFunc func;
+		};
+
+		static std::vector<Case> &cases()
+		{
+			static std::vector<Case> registry;
+			return registry;
+		}
+
+		/**
+		 * @brief Number of timed batches per case.
+		 */
+		uint32_t samples {200};
+
+		/**
+		 * @brief Number of operations per timed batch.
+		 */
+		uint32_t batchSize {1000};
+
+		/**
+		 * @brief The reference workload p50, filled in before any case runs.
+		 */
+		double referenceNs {1.0};
+
+		/**
+		 * @brief Number of reads in the probe timed after every batch.
+		 */
+		static const uint32_t probeOps = 1000;
+
+		/**
+		 * @brief Time `op(n)`, where `op` must perform `n` operations.
+		 */
+		template <typename Op>
+		void run(Op op)
+		{
+			using Clock = std::chrono::steady_clock;
+
+			// Warm up caches and branch predictors
+			op(batchSize);
+
+			timings.resize(samples);
+			probes.resize(samples);
+			for (uint32_t i = 0; i < samples; i++)
+			{
+				Clock::time_point start = Clock::now();
+				op(batchSize);
+				Clock::time_point end = Clock::now();
+				timings[i] = std::chrono::duration<double, std::nano>(end - start).count() / batchSize;
+				probes[i] = probe();
+			}
+		}
+
+		/**
+		 * @brief Reduce the last `run()` into a result row.
+		 */
+		BenchResult summarize(const char *name) const
+		{
+			return summarize(name, timings, probes, HUGE_VAL, referenceNs);
+		}
+
+		/**
+		 * @brief Reduce stored batches into a result row, keeping only those whose probe took at most `probeLimit`
+		 * ns/op. The row has zero samples when no batch is left.
+		 */
+		static BenchResult summarize(const char *name, const std::vector<double> &timings,
+			const std::vector<double> &probes, double probeLimit, double referenceNs)
+		{
+			std::vector<double> sorted;
+			for (size_t i = 0; i < timings.size(); i++)
+			{
+				if (probes[i] <= probeLimit)
+					sorted.push_back(timings[i]);
+			}
+
+			BenchResult result {};
+			result.name = name;
+			result.samples = sorted.size();
+			if (sorted.empty())
+				return result;
+
+			std::sort(sorted.begin(), sorted.end());
+
+			double sum = 0;
+			for (double t : sorted)
+				sum += t;
+
+			result.min = sorted.front();
+			result.p50 = percentile(sorted, 50);
+			result.p90 = percentile(sorted, 90);
+			result.p99 = percentile(sorted, 99);
+			result.max = sorted.back();
+			result.mean = sum / sorted.size();
+			result.ratio = result.p50 / referenceNs;
+			return result;
+		}
+
+		/**
+		 * @brief Per-batch ns/op of the last `run()`.
+		 */
+		const std::vector<double> &getTimings() const { return timings; }
+
+		/**
+		 * @brief Per-batch probe ns/op of the last `run()`.
+		 */
+		const std::vector<double> &getProbes() const { return probes; }
+
+	private:
+		static double percentile(const std::vector<double> &sorted, int pct)
+		{
+			size_t index = (sorted.size() - 1) * pct / 100;
+			return sorted[index];
+		}
+
+		// Kept out of line and aligned so every case times the same copy of the loop, and edits elsewhere in the
+		// binary do not move it against cache lines and fetch blocks
+		static double __attribute__((noinline, aligned(64))) probe()
+		{
+			using Clock = std::chrono::steady_clock;
+			alignas(64) static uint32_t lines[1024];
+
+			// Give the write-backs of the batch time to drain, then walk once untimed to bring the lines back into L1,
+			// so the timed walk depends on the machine rather than on the case before it
+			uint32_t sum = 1;
+			for (uint32_t i = 0; i < 2000; i++)
+			{
+				sum = sum * 1664525U + 1013904223U;
+				benchKeep(sum);
+			}
+
+			Clock::time_point start;
+			for (int walk = 0; walk < 2; walk++)
+			{
+				start = Clock::now();
+				for (uint32_t i = 0; i < probeOps; i++)
+				{
+					sum += lines[(i * 67) & 1023];
+					benchKeep(sum);
+				}
+			}
+
+			Clock::time_point end = Clock::now();
+			return std::chrono::duration<double, std::nano>(end - start).count() / probeOps;
+		}
+
+		std::vector<double> timings;
+		std::vector<double> probes;
+};
+
+struct BenchRegistrar
+{
+	BenchRegistrar(const char *name, Bench::CaseFunc func)
+	{
+		Bench::cases().push_back({ name, func });
+	}
+};
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+
+// Register a benchmark case: BENCH_CASE("stage/variant") { ...setup...; bench.run([&](uint32_t n) { ... }); }
+#define BENCH_CASE(name) \
+	static void BENCH_CONCAT(benchCase, __LINE__)(Bench &bench); \
+	static BenchRegistrar BENCH_CONCAT(benchRegistrar, __LINE__)(name, BENCH_CONCAT(benchCase, __LINE__)); \
+	static void BENCH_CONCAT(benchCase, __LINE__)(Bench &bench)
@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Batch report conversion against the one-state-at-a-time path. One operation is one state converted into a
+ * caller-owned report array, so `loop` copies each getReport() result out of the static report.
+ */
+
+#include "Bench.h"
+#include "BenchGamepad.h"
+
+#define BATCH_FRAMES 4096
+
+template <typename Report>
+static void benchLoop(Bench &bench, InputMode mode)
+{
+	BenchGamepad gamepad;
+	gamepad.options.inputMode = mode;
+	std::vector<GamepadState> frames = generateInputMix(INPUT_MIX_MASHING, BATCH_FRAMES);
+	std::vector<Report> reports(BATCH_FRAMES);
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			gamepad.state = frames[index];
+			memcpy(&reports[index], gamepad.getReport(), sizeof(Report));
+			index = (index + 1) & (BATCH_FRAMES - 1);
+		}
+		benchKeep(reports[0]);
+	});
+}
+
+template <typename Report, typename Convert>
+static void benchBatch(Bench &bench, Convert convert)
+{
+	BatchFrames frames(generateInputMix(INPUT_MIX_MASHING, BATCH_FRAMES));
+	GamepadStateBatch batch = frames.batch();
+	std::vector<Report> reports(BATCH_FRAMES);
+
+	bench.run([&](uint32_t n) {
+		while (n > 0)
+		{
+			uint32_t count = (n < BATCH_FRAMES) ? n : BATCH_FRAMES;
+			convert(batch, count, reports.data());
+			benchKeep(reports[0]);
+			n -= count;
+		}
+	});
+}
+
+template <GamepadBatchKernel Kernel>
+static void benchXInputBatch(Bench &bench)
+{
+	benchBatch<XInputReport>(bench, [](const GamepadStateBatch &batch, size_t count, XInputReport *reports) {
+		convertXInputBatch(batch, count, reports, false, Kernel);
+	});
+}
+
+template <GamepadBatchKernel Kernel>
+static void benchSwitchBatch(Bench &bench)
+{
+	benchBatch<SwitchReport>(bench, [](const GamepadStateBatch &batch, size_t count, SwitchReport *reports) {
+		convertSwitchBatch(batch, count, reports, Kernel);
+	});
+}
+
+template <GamepadBatchKernel Kernel>
+static void benchHIDBatch(Bench &bench)
+{
+	benchBatch<HIDReport>(bench, [](const GamepadStateBatch &batch, size_t count, HIDReport *reports) {
+		convertHIDBatch(batch, count, reports, Kernel);
+	});
+}
+
+// `simd` is the widest kernel in this build: SSE2 by default on x86-64, AVX2 with -mavx2
+BENCH_CASE("batch/xinput-loop")              { benchLoop<XInputReport>(bench, INPUT_MODE_XINPUT); }
+BENCH_CASE("batch/xinput-scalar")            { benchXInputBatch<GAMEPAD_BATCH_SCALAR>(bench); }
+BENCH_CASE("batch/xinput-simd")              { benchXInputBatch<GAMEPAD_BATCH_AVX2>(bench); }
+BENCH_CASE("batch/switch-loop")              { benchLoop<SwitchReport>(bench, INPUT_MODE_SWITCH); }
+BENCH_CASE("batch/switch-scalar")            { benchSwitchBatch<GAMEPAD_BATCH_SCALAR>(bench); }
+BENCH_CASE("batch/switch-simd")              { benchSwitchBatch<GAMEPAD_BATCH_AVX2>(bench); }
+BENCH_CASE("batch/hid-loop")                 { benchLoop<HIDReport>(bench, INPUT_MODE_HID); }
+BENCH_CASE("batch/hid-scalar")               { benchHIDBatch<GAMEPAD_BATCH_SCALAR>(bench); }
+BENCH_CASE("batch/hid-simd")                 { benchHIDBatch<GAMEPAD_BATCH_AVX2>(bench); }
@@ -0,0 +1,201 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "GamepadBatch.h"
+#include "MPG.h"
+#include "MPGT.h"
+
+// Virtual millisecond clock backing getMillis() for host builds, one per thread
+extern thread_local uint32_t hostMillis;
+
+/**
+ * @brief Input mixes used to drive the pipeline. Each mix is a looping sequence of raw GamepadState frames.
+ */
+typedef enum
+{
+	INPUT_MIX_IDLE,     // Nothing pressed, sticks centered
+	INPUT_MIX_CASUAL,   // Mostly idle with occasional presses and holds
+	INPUT_MIX_MASHING,  // Rapid button and direction changes, frequent SOCD conflicts
+	INPUT_MIX_ANALOG,   // Buttons idle, analog sticks and triggers sweeping
+	INPUT_MIX_COUNT,
+} InputMix;
+
+inline const char *inputMixName(InputMix mix)
+{
+	switch (mix)
+	{
+		case INPUT_MIX_IDLE:    return "idle";
+		case INPUT_MIX_CASUAL:  return "casual";
+		case INPUT_MIX_MASHING: return "mashing";
+		case INPUT_MIX_ANALOG:  return "analog";
+		default:                return "?";
+	}
+}
+
+/**
+ * @brief Generate `count` frames of raw input for a mix. Deterministic for a given seed.
+ */
+inline std::vector<GamepadState> generateInputMix(InputMix mix, size_t count, uint32_t seed = 1)
+{
+	std::vector<GamepadState> frames(count);
+	uint32_t rng = seed;
+	auto next = [&rng]() { rng = rng * 1664525U + 1013904223U; return rng >> 8; };
+
+	GamepadState held;
+	for (size_t i = 0; i < count; i++)
+	{
+		GamepadState &frame = frames[i];
+		switch (mix)
+		{
+			case INPUT_MIX_IDLE:
+				break;
+
+			case INPUT_MIX_CASUAL:
+				// Change something roughly every 50 frames, hold it for a while
+				if (next() % 50 == 0)
+				{
+					held.buttons = (next() % 3 == 0) ? buttonMasks[next() % GAMEPAD_BUTTON_COUNT] : 0;
+					held.dpad = (next() % 2 == 0) ? dpadMasks[next() % 4] : 0;
+				}
+				frame.buttons = held.buttons;
+				frame.dpad = held.dpad;
+				break;
+
+			case INPUT_MIX_MASHING:
+				frame.buttons = next() & 0x3FFF;
+				frame.dpad = next() & GAMEPAD_MASK_DPAD;
+				break;
+
+			case INPUT_MIX_ANALOG:
+				frame.lx = static_cast<uint16_t>(i * 97);
+				frame.ly = static_cast<uint16_t>(i * 131);
+				frame.rx = static_cast<uint16_t>(next());
+				frame.ry = static_cast<uint16_t>(next());
+				frame.lt = static_cast<uint8_t>(i);
+				frame.rt = static_cast<uint8_t>(next());
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	return frames;
+}
+
+/**
+ * @brief MPG implementation whose `read()` replays a prepared list of frames.
+ */
+class BenchGamepad : public MPG
+{
+	public:
+		BenchGamepad(int debounceMS = 5) : MPG(debounceMS) { }
+
+		void setup() override { }
+
+		void read() override
+		{
+			const GamepadState &frame = frames[index];
+			if (++index == frames.size())
+				index = 0;
+
+			state.dpad = frame.dpad;
+			state.buttons = frame.buttons;
+			state.aux = frame.aux;
+			state.lx = frame.lx;
+			state.ly = frame.ly;
+			state.rx = frame.rx;
+			state.ry = frame.ry;
+			state.lt = frame.lt;
+			state.rt = frame.rt;
+		}
+
+		void load(const std::vector<GamepadState> &input)
+		{
+			frames = input;
+			index = 0;
+		}
+
+		std::vector<GamepadState> frames {1};
+		size_t index {0};
+};
+
+/**
+ * @brief Run one frame through the stages one at a time, the loop in the README and the LUFA example.
+ */
+inline void *runGamepadStages(BenchGamepad &gamepad, bool *changed = nullptr)
+{
+	gamepad.read();
+	gamepad.debounce();
+	gamepad.hotkey();
+	gamepad.process();
+	return gamepad.getReport(changed);
+}
+
+/**
+ * @brief Statically dispatched equivalent of BenchGamepad.
+ */
+template <int Mode = INPUT_MODE_RUNTIME>
+class BenchStaticGamepad : public MPGT<BenchStaticGamepad<Mode>, Mode>
+{
+	public:
+		BenchStaticGamepad(int debounceMS = 5) : MPGT<BenchStaticGamepad<Mode>, Mode>(debounceMS) { }
+
+		void setup() { }
+
+		inline void read()
+		{
+			const GamepadState &frame = frames[index];
+			if (++index == frames.size())
+				index = 0;
+
+			this->state = frame;
+		}
+
+		void load(const std::vector<GamepadState> &input)
+		{
+			frames = input;
+			index = 0;
+		}
+
+		std::vector<GamepadState> frames {1};
+		size_t index {0};
+};
+
+/**
+ * @brief Structure-of-arrays copy of a list of frames.
+ */
+struct BatchFrames
+{
+	BatchFrames(const std::vector<GamepadState> &frames)
+	{
+		for (const GamepadState &frame : frames)
+		{
+			dpad.push_back(frame.dpad);
+			buttons.push_back(frame.buttons);
+			lx.push_back(frame.lx);
+			ly.push_back(frame.ly);
+			rx.push_back(frame.rx);
+			ry.push_back(frame.ry);
+			lt.push_back(frame.lt);
+			rt.push_back(frame.rt);
+		}
+	}
+
+	GamepadStateBatch batch() const
+	{
+		return { dpad.data(), buttons.data(), lx.data(), ly.data(), rx.data(), ry.data(), lt.data(), rt.data() };
+	}
+
+	std::vector<uint8_t> dpad;
+	std::vector<uint16_t> buttons;
+	std::vector<uint16_t> lx, ly, rx, ry;
+	std::vector<uint8_t> lt, rt;
+};
@@ -0,0 +1,545 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Per-stage benchmarks for the MPG input pipeline:
+ *
+ *     read() -> debounce() -> hotkey() -> process() -> getReport()
+ *
+ * Stages that modify the state (hotkey, process, report) reload a raw frame before each operation, so their
+ * numbers include a 16 byte state copy. The `read` case measures that same copy through the virtual call.
+ */
+
+#include "Bench.h"
+#include "BenchGamepad.h"
+
+#define BENCH_FRAMES 4096
+
+// One simulated frame is 100us, so the millisecond clock ticks every 10 frames
+#define FRAMES_PER_MS 10
+
+static void loadState(MPG &gamepad, const GamepadState &frame)
+{
+	gamepad.state = frame;
+}
+
+template <InputMix Mix>
+static void benchRead(Bench &bench)
+{
+	BenchGamepad gamepad;
+	gamepad.load(generateInputMix(Mix, BENCH_FRAMES));
+	MPG *mpg = &gamepad;
+	benchKeep(mpg);
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			mpg->read();
+			benchKeep(mpg->state.buttons);
+		}
+	});
+}
+
+// Picking up analog inputs sampled in the background: each frame drains the scans pushed since the last one
+template <uint8_t ScansPerFrame>
+static void benchReadADC(Bench &bench)
+{
+	const GamepadADCAxis axes[] = { ADC_AXIS_LX, ADC_AXIS_LY, ADC_AXIS_RX, ADC_AXIS_RY };
+	GamepadADC adc(axes, 4);
+	std::vector<GamepadState> frames = generateInputMix(INPUT_MIX_ANALOG, BENCH_FRAMES);
+	GamepadState state;
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			const GamepadState &frame = frames[index];
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			const uint16_t scan[] = { static_cast<uint16_t>(frame.lx >> 4), static_cast<uint16_t>(frame.ly >> 4),
+				static_cast<uint16_t>(frame.rx >> 4), static_cast<uint16_t>(frame.ry >> 4) };
+			for (uint8_t s = 0; s < ScansPerFrame; s++)
+				adc.push(scan);
+
+			adc.read(state);
+			benchKeep(state.lx);
+		}
+	});
+}
+
+template <InputMix Mix>
+static void benchDebounce(Bench &bench)
+{
+	BenchGamepad gamepad;
+	gamepad.load(generateInputMix(Mix, BENCH_FRAMES));
+	hostMillis = 1000;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			gamepad.read();
+			if ((i % FRAMES_PER_MS) == 0)
+				hostMillis++;
+			gamepad.debounce();
+			benchKeep(gamepad.state.buttons);
+		}
+	});
+}
+
+// Analog keys: every input's travel follows the mix, swept up and down, and rapid trigger replaces debouncing
+template <InputMix Mix>
+static void benchRapidTrigger(Bench &bench)
+{
+	GamepadRapidTrigger trigger;
+	BenchGamepad gamepad;
+	gamepad.rapidTrigger = &trigger;
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+	hostMillis = 1000;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			const GamepadState &frame = frames[index];
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			uint32_t inputs = frame.buttons | (static_cast<uint32_t>(frame.dpad) << GAMEPAD_BUTTON_COUNT);
+			uint16_t sweep = static_cast<uint16_t>(index << 2);
+			for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+				trigger.travel[key] = static_cast<uint16_t>(sweep + ((inputs >> key) & 1) * 0xC000);
+
+			if ((i % FRAMES_PER_MS) == 0)
+				hostMillis++;
+			gamepad.debounce();
+			benchKeep(gamepad.state.buttons);
+		}
+	});
+}
+
+// Turbo on every button at assorted rates and a macro on each of the start buttons, a millisecond and so one wheel
+// tick per frame
+template <InputMix Mix>
+static void benchTurbo(Bench &bench)
+{
+	GamepadTurbo turbo(1000);
+	for (uint8_t i = 0; i < GAMEPAD_BUTTON_COUNT; i++)
+		turbo.setTurbo(1U << i, 5 + i * 7);
+
+	const GamepadMacroStep steps[] = { { GAMEPAD_MASK_B1, GAMEPAD_MASK_DOWN, 16 }, { GAMEPAD_MASK_B2, GAMEPAD_MASK_RIGHT, 33 } };
+	turbo.setMacro(0, GAMEPAD_MASK_S1, steps, 2);
+	turbo.setMacro(1, GAMEPAD_MASK_S2, steps, 2);
+
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+	uint32_t time = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			GamepadState state = frames[index];
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			turbo.update(state, ++time);
+			benchKeep(state.buttons);
+		}
+	});
+}
+
+// A swap, a 1:N mapping and a D-pad direction moved to a button, so every table holds something but the identity
+template <InputMix Mix>
+static void benchRemap(Bench &bench)
+{
+	GamepadRemap remap;
+	remap.setButton(GAMEPAD_MASK_B1, GAMEPAD_MASK_B2);
+	remap.setButton(GAMEPAD_MASK_B2, GAMEPAD_MASK_B1);
+	remap.setButton(GAMEPAD_MASK_A2, GAMEPAD_MASK_L1 | GAMEPAD_MASK_R1);
+	remap.setDpad(GAMEPAD_MASK_RIGHT, GAMEPAD_MASK_R3);
+
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			GamepadState state = frames[index];
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			remap.update(state);
+			benchKeep(state.buttons);
+		}
+	});
+}
+
+// Clean the D-pad alone, as `process()` does every frame
+template <InputMix Mix, SOCDMode Mode>
+static void benchSOCD(Bench &bench)
+{
+	GamepadSOCD socd;
+	socd.setCustom(SOCD_AXIS_UP_LEFT, SOCD_AXIS_LAST_INPUT);
+
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			uint8_t dpad = socd.update(Mode, frames[index].dpad);
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			benchKeep(dpad);
+		}
+	});
+}
+
+// Run a debouncer implementation directly, without going through MPG
+template <typename Debouncer, InputMix Mix, DebounceMode Mode = DEBOUNCE_MODE_LOCKOUT>
+static void benchDebouncer(Bench &bench)
+{
+	Debouncer debouncer(5);
+	debouncer.setMode(Mode);
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+	GamepadState state;
+	hostMillis = 1000;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			state.dpad = frames[index].dpad;
+			state.buttons = frames[index].buttons;
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			if ((i % FRAMES_PER_MS) == 0)
+				hostMillis++;
+			debouncer.debounce(&state);
+			benchKeep(state.buttons);
+		}
+	});
+}
+
+template <InputMix Mix>
+static void benchHotkey(Bench &bench)
+{
+	BenchGamepad gamepad;
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			loadState(gamepad, frames[index]);
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			GamepadHotkey hotkey = gamepad.hotkey();
+			benchKeep(hotkey);
+		}
+	});
+}
+
+template <InputMix Mix, DpadMode Dpad, SOCDMode SOCD>
+static void benchProcess(Bench &bench)
+{
+	BenchGamepad gamepad;
+	gamepad.options.dpadMode = Dpad;
+	gamepad.options.socdMode = SOCD;
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			loadState(gamepad, frames[index]);
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			gamepad.process();
+			benchKeep(gamepad.state.dpad);
+		}
+	});
+}
+
+// process() with the analog stage on both sticks, against the same frames without it
+template <InputMix Mix, bool Analog, bool Radial>
+static void benchAnalog(Bench &bench)
+{
+	GamepadStickConfig config;
+	config.innerDeadzone = 2000;
+	config.outerDeadzone = 30000;
+	config.antiDeadzone = 3000;
+	config.curve = ANALOG_CURVE_QUADRATIC;
+	config.radial = Radial;
+
+	GamepadAnalog analog;
+	analog.configure(ANALOG_STICK_LEFT, config);
+	analog.configure(ANALOG_STICK_RIGHT, config);
+
+	BenchGamepad gamepad;
+	gamepad.hasLeftAnalogStick = true;
+	gamepad.hasRightAnalogStick = true;
+	if (Analog)
+		gamepad.analog = &analog;
+
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			loadState(gamepad, frames[index]);
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			gamepad.process();
+			benchKeep(gamepad.state.lx);
+		}
+	});
+}
+
+template <InputMix Mix, InputMode Mode>
+static void benchGetReport(Bench &bench)
+{
+	BenchGamepad gamepad;
+	gamepad.options.inputMode = Mode;
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			loadState(gamepad, frames[index]);
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			void *report = gamepad.getReport();
+			benchKeep(report);
+		}
+	});
+}
+
+template <InputMix Mix>
+static void benchXInputReport(Bench &bench)
+{
+	BenchGamepad gamepad;
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			loadState(gamepad, frames[index]);
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			XInputReport *report = gamepad.getXInputReport();
+			benchKeep(report);
+		}
+	});
+}
+
+template <InputMix Mix>
+static void benchSwitchReport(Bench &bench)
+{
+	BenchGamepad gamepad;
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			loadState(gamepad, frames[index]);
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			SwitchReport *report = gamepad.getSwitchReport();
+			benchKeep(report);
+		}
+	});
+}
+
+template <InputMix Mix>
+static void benchHIDReport(Bench &bench)
+{
+	BenchGamepad gamepad;
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			loadState(gamepad, frames[index]);
+			index = (index + 1) & (BENCH_FRAMES - 1);
+			HIDReport *report = gamepad.getHIDReport();
+			benchKeep(report);
+		}
+	});
+}
+
+// Driver side of a frame: get the report and decide whether it needs sending. `Tracked` uses the changed flag from
+// getReport(), otherwise the report is rebuilt and compared against the last sent copy like LUFADriver used to.
+template <InputMix Mix, bool Tracked>
+static void benchSend(Bench &bench)
+{
+	BenchGamepad gamepad;
+	gamepad.options.inputMode = INPUT_MODE_XINPUT;
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	uint8_t lastReport[64] = { };
+	size_t index = 0;
+	uint32_t sent = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			loadState(gamepad, frames[index]);
+			index = (index + 1) & (BENCH_FRAMES - 1);
+
+			if (Tracked)
+			{
+				bool changed;
+				void *report = gamepad.getReport(&changed);
+				benchKeep(report);
+				sent += changed;
+			}
+			else
+			{
+				XInputReport *report = gamepad.getXInputReport();
+				if (memcmp(lastReport, report, sizeof(XInputReport)) != 0)
+				{
+					memcpy(lastReport, report, sizeof(XInputReport));
+					sent++;
+				}
+			}
+		}
+		benchKeep(sent);
+	});
+}
+
+// A driver with its own endpoint buffer: either copy each changed report into it, or have MPG build the report there
+template <InputMix Mix, bool Buffers>
+static void benchSubmit(Bench &bench)
+{
+	BenchGamepad gamepad;
+	gamepad.options.inputMode = INPUT_MODE_XINPUT;
+	std::vector<GamepadState> frames = generateInputMix(Mix, BENCH_FRAMES);
+	uint16_t endpoint[2][32];
+	GamepadReportBuffers buffers(endpoint[0], endpoint[1], sizeof(endpoint[0]));
+	if (Buffers)
+		gamepad.setReportBuffers(&buffers);
+
+	uint16_t size = gamepad.getReportSize();
+	size_t index = 0;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			loadState(gamepad, frames[index]);
+			index = (index + 1) & (BENCH_FRAMES - 1);
+
+			bool changed;
+			void *report = gamepad.getReport(&changed);
+			if (changed)
+			{
+				if (!Buffers)
+					memcpy(endpoint[0], report, size);
+				benchKeep(endpoint);
+			}
+		}
+	});
+}
+
+template <InputMix Mix, InputMode Mode>
+static void benchPipeline(Bench &bench)
+{
+	BenchGamepad gamepad;
+	gamepad.options.inputMode = Mode;
+	gamepad.load(generateInputMix(Mix, BENCH_FRAMES));
+	MPG *mpg = &gamepad;
+	benchKeep(mpg);
+	hostMillis = 1000;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			if ((i % FRAMES_PER_MS) == 0)
+				hostMillis++;
+			mpg->read();
+			mpg->debounce();
+			mpg->hotkey();
+			mpg->process();
+			void *report = mpg->getReport();
+			benchKeep(report);
+		}
+	});
+}
+
+// Same chain through MPGT, where nothing is virtual and the input mode may be fixed at compile time
+template <InputMix Mix, int Mode>
+static void benchStaticPipeline(Bench &bench)
+{
+	BenchStaticGamepad<Mode> gamepad;
+	gamepad.options.inputMode = (Mode == INPUT_MODE_RUNTIME) ? INPUT_MODE_XINPUT : static_cast<InputMode>(Mode);
+	gamepad.load(generateInputMix(Mix, BENCH_FRAMES));
+	hostMillis = 1000;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			if ((i % FRAMES_PER_MS) == 0)
+				hostMillis++;
+			auto *report = gamepad.update();
+			benchKeep(report);
+		}
+	});
+}
+
+BENCH_CASE("read/casual")                    { benchRead<INPUT_MIX_CASUAL>(bench); }
+BENCH_CASE("read/adc-4ch-4-scans")           { benchReadADC<4>(bench); }
+BENCH_CASE("read/adc-4ch-16-scans")          { benchReadADC<16>(bench); }
+
+BENCH_CASE("debounce/idle")                  { benchDebounce<INPUT_MIX_IDLE>(bench); }
+BENCH_CASE("debounce/casual")                { benchDebounce<INPUT_MIX_CASUAL>(bench); }
+BENCH_CASE("debounce/mashing")               { benchDebounce<INPUT_MIX_MASHING>(bench); }
+BENCH_CASE("debounce/rapid-trigger-casual")  { benchRapidTrigger<INPUT_MIX_CASUAL>(bench); }
+BENCH_CASE("debounce/rapid-trigger-mashing") { benchRapidTrigger<INPUT_MIX_MASHING>(bench); }
+BENCH_CASE("debouncer/timestamp-idle")       { benchDebouncer<GamepadDebouncer, INPUT_MIX_IDLE>(bench); }
+BENCH_CASE("debouncer/timestamp-mashing")    { benchDebouncer<GamepadDebouncer, INPUT_MIX_MASHING>(bench); }
+BENCH_CASE("debouncer/vertical-idle")        { benchDebouncer<GamepadVerticalDebouncer, INPUT_MIX_IDLE>(bench); }
+BENCH_CASE("debouncer/vertical-mashing")     { benchDebouncer<GamepadVerticalDebouncer, INPUT_MIX_MASHING>(bench); }
+BENCH_CASE("debouncer/timestamp-eager")      { benchDebouncer<GamepadDebouncer, INPUT_MIX_MASHING, DEBOUNCE_MODE_EAGER>(bench); }
+BENCH_CASE("debouncer/timestamp-defer")      { benchDebouncer<GamepadDebouncer, INPUT_MIX_MASHING, DEBOUNCE_MODE_DEFER>(bench); }
+BENCH_CASE("debouncer/vertical-defer")       { benchDebouncer<GamepadVerticalDebouncer, INPUT_MIX_MASHING, DEBOUNCE_MODE_DEFER>(bench); }
+
+BENCH_CASE("turbo/casual")                   { benchTurbo<INPUT_MIX_CASUAL>(bench); }
+BENCH_CASE("turbo/mashing")                  { benchTurbo<INPUT_MIX_MASHING>(bench); }
+
+BENCH_CASE("remap/mashing")                  { benchRemap<INPUT_MIX_MASHING>(bench); }
+
+BENCH_CASE("socd/mashing-neutral")           { benchSOCD<INPUT_MIX_MASHING, SOCD_MODE_NEUTRAL>(bench); }
+BENCH_CASE("socd/mashing-last-win")          { benchSOCD<INPUT_MIX_MASHING, SOCD_MODE_SECOND_INPUT_PRIORITY>(bench); }
+BENCH_CASE("socd/mashing-custom")            { benchSOCD<INPUT_MIX_MASHING, SOCD_MODE_CUSTOM>(bench); }
+
+BENCH_CASE("hotkey/idle")                    { benchHotkey<INPUT_MIX_IDLE>(bench); }
+BENCH_CASE("hotkey/casual")                  { benchHotkey<INPUT_MIX_CASUAL>(bench); }
+BENCH_CASE("hotkey/mashing")                 { benchHotkey<INPUT_MIX_MASHING>(bench); }
+
+BENCH_CASE("process/casual")                 { benchProcess<INPUT_MIX_CASUAL, DPAD_MODE_DIGITAL, SOCD_MODE_NEUTRAL>(bench); }
+BENCH_CASE("process/mashing")                { benchProcess<INPUT_MIX_MASHING, DPAD_MODE_DIGITAL, SOCD_MODE_NEUTRAL>(bench); }
+BENCH_CASE("process/mashing-last-win")       { benchProcess<INPUT_MIX_MASHING, DPAD_MODE_DIGITAL, SOCD_MODE_SECOND_INPUT_PRIORITY>(bench); }
+BENCH_CASE("process/mashing-left-analog")    { benchProcess<INPUT_MIX_MASHING, DPAD_MODE_LEFT_ANALOG, SOCD_MODE_UP_PRIORITY>(bench); }
+BENCH_CASE("process/analog-sticks")          { benchAnalog<INPUT_MIX_ANALOG, false, false>(bench); }
+BENCH_CASE("process/analog-sticks-radial")   { benchAnalog<INPUT_MIX_ANALOG, true, true>(bench); }
+BENCH_CASE("process/analog-sticks-axial")    { benchAnalog<INPUT_MIX_ANALOG, true, false>(bench); }
+
+BENCH_CASE("report/xinput-casual")           { benchXInputReport<INPUT_MIX_CASUAL>(bench); }
+BENCH_CASE("report/xinput-mashing")          { benchXInputReport<INPUT_MIX_MASHING>(bench); }
+BENCH_CASE("report/xinput-analog")           { benchXInputReport<INPUT_MIX_ANALOG>(bench); }
+BENCH_CASE("report/switch-mashing")          { benchSwitchReport<INPUT_MIX_MASHING>(bench); }
+BENCH_CASE("report/hid-mashing")             { benchHIDReport<INPUT_MIX_MASHING>(bench); }
+
+BENCH_CASE("getReport/xinput-mashing")       { benchGetReport<INPUT_MIX_MASHING, INPUT_MODE_XINPUT>(bench); }
+BENCH_CASE("getReport/switch-mashing")       { benchGetReport<INPUT_MIX_MASHING, INPUT_MODE_SWITCH>(bench); }
+BENCH_CASE("getReport/hid-mashing")          { benchGetReport<INPUT_MIX_MASHING, INPUT_MODE_HID>(bench); }
+
+BENCH_CASE("send/casual-memcmp")             { benchSend<INPUT_MIX_CASUAL, false>(bench); }
+BENCH_CASE("send/casual-tracked")            { benchSend<INPUT_MIX_CASUAL, true>(bench); }
+BENCH_CASE("send/mashing-memcmp")            { benchSend<INPUT_MIX_MASHING, false>(bench); }
+BENCH_CASE("send/mashing-tracked")           { benchSend<INPUT_MIX_MASHING, true>(bench); }
+BENCH_CASE("send/mashing-copy")              { benchSubmit<INPUT_MIX_MASHING, false>(bench); }
+BENCH_CASE("send/mashing-buffers")           { benchSubmit<INPUT_MIX_MASHING, true>(bench); }
+
+BENCH_CASE("pipeline/xinput-idle")           { benchPipeline<INPUT_MIX_IDLE, INPUT_MODE_XINPUT>(bench); }
+BENCH_CASE("pipeline/xinput-casual")         { benchPipeline<INPUT_MIX_CASUAL, INPUT_MODE_XINPUT>(bench); }
+BENCH_CASE("pipeline/xinput-mashing")        { benchPipeline<INPUT_MIX_MASHING, INPUT_MODE_XINPUT>(bench); }
+BENCH_CASE("pipeline/switch-mashing")        { benchPipeline<INPUT_MIX_MASHING, INPUT_MODE_SWITCH>(bench); }
+BENCH_CASE("pipeline/hid-analog")            { benchPipeline<INPUT_MIX_ANALOG, INPUT_MODE_HID>(bench); }
+
+BENCH_CASE("pipeline-static/xinput-idle")    { benchStaticPipeline<INPUT_MIX_IDLE, INPUT_MODE_XINPUT>(bench); }
+BENCH_CASE("pipeline-static/xinput-casual")  { benchStaticPipeline<INPUT_MIX_CASUAL, INPUT_MODE_XINPUT>(bench); }
+BENCH_CASE("pipeline-static/xinput-mashing") { benchStaticPipeline<INPUT_MIX_MASHING, INPUT_MODE_XINPUT>(bench); }
+BENCH_CASE("pipeline-static/switch-mashing") { benchStaticPipeline<INPUT_MIX_MASHING, INPUT_MODE_SWITCH>(bench); }
+BENCH_CASE("pipeline-static/hid-analog")     { benchStaticPipeline<INPUT_MIX_ANALOG, INPUT_MODE_HID>(bench); }
+BENCH_CASE("pipeline-static/runtime-casual") { benchStaticPipeline<INPUT_MIX_CASUAL, INPUT_MODE_RUNTIME>(bench); }
@@ -0,0 +1,37 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Overhead of the GAMEPAD_PROFILE instrumentation: reading the cycle counter, and timing one stage (two counter
+ * reads plus a histogram and ring update).
+ */
+
+#include "Bench.h"
+#include "GamepadProfiler.h"
+
+BENCH_CASE("profile/cycles")
+{
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			uint32_t cycles = gamepadCycles();
+			benchKeep(cycles);
+		}
+	});
+}
+
+BENCH_CASE("profile/scope")
+{
+	GamepadProfiler profiler;
+
+	bench.run([&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++)
+		{
+			GamepadProfileScope scope(profiler, static_cast<GamepadStage>(i % GAMEPAD_STAGE_COUNT));
+			benchKeep(i);
+		}
+	});
+	benchKeep(profiler);
+}
@@ -0,0 +1,49 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+/*
+	Host correctness checks. Each CHECK_CASE returns true on success and prints its own diagnostics on failure.
+	MPGCheck runs all registered checks, or only those whose name contains the first argument.
+*/
+
+class Check
+{
+	public:
+		typedef bool (*CaseFunc)();
+
+		struct Case
+		{
+			const char *name;
+			CaseFunc func;
+		};
+
+		static std::vector<Case> &cases()
+		{
+			static std::vector<Case> registry;
+			return registry;
+		}
+};
+
+struct CheckRegistrar
+{
+	CheckRegistrar(const char *name, Check::CaseFunc func)
+	{
+		Check::cases().push_back({ name, func });
+	}
+};
+
+#define CHECK_CONCAT_(a, b) a##b
+#define CHECK_CONCAT(a, b) CHECK_CONCAT_(a, b)
+
+// Register a check: CHECK_CASE("area/what") { ...; return ok; }
+#define CHECK_CASE(name) \
+	static bool CHECK_CONCAT(checkCase, __LINE__)(); \
+	static CheckRegistrar CHECK_CONCAT(checkRegistrar, __LINE__)(name, CHECK_CONCAT(checkCase, __LINE__)); \
+	static bool CHECK_CONCAT(checkCase, __LINE__)()
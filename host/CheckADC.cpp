@@ -0,0 +1,240 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies the analog acquisition ring, decimation and filter: scans come out in order and whole, also with the
+ * producer on another thread, a full ring drops new scans instead of overwriting unread ones, steady inputs come
+ * out exact, and the default filter trades noise for lag as documented.
+ */
+
+#include <atomic>
+#include <thread>
+
+#include "Check.h"
+#include "BenchGamepad.h"
+#include "GamepadADCSynth.h"
+
+static const GamepadADCAxis allAxes[] = { ADC_AXIS_LX, ADC_AXIS_LY, ADC_AXIS_RX, ADC_AXIS_RY, ADC_AXIS_LT, ADC_AXIS_RT };
+
+// No oversampling or filtering, and 16-bit samples, so values come out as they went in
+static GamepadADCConfig passThrough()
+{
+	GamepadADCConfig config;
+	config.bits = 16;
+	config.oversample = 1;
+	config.minAlpha = 0;
+	return config;
+}
+
+CHECK_CASE("adc/ring")
+{
+	GamepadADC adc(allAxes, 6, passThrough());
+
+	// Overfill the ring: the scans past its size are dropped, the first ones are kept
+	uint16_t scan[6];
+	uint32_t accepted = 0;
+	for (uint16_t i = 0; i < GAMEPAD_ADC_RING_SCANS + 5; i++)
+	{
+		for (uint8_t c = 0; c < 6; c++)
+			scan[c] = i * 100 + c;
+		accepted += adc.push(scan);
+	}
+
+	if (accepted != GAMEPAD_ADC_RING_SCANS || adc.getOverruns() != 5)
+	{
+		printf("  accepted %u scans with %u overruns, expected %u and 5\n", accepted, adc.getOverruns(), GAMEPAD_ADC_RING_SCANS);
+		return false;
+	}
+
+	uint8_t values = adc.update();
+	if (values != GAMEPAD_ADC_RING_SCANS || adc.getValue(2) != (GAMEPAD_ADC_RING_SCANS - 1) * 100 + 2)
+	{
+		printf("  drained %u values ending in %u\n", values, adc.getValue(2));
+		return false;
+	}
+
+	// Room again, and zero-copy scans work the same
+	uint16_t *slot = adc.nextScan();
+	if (!slot)
+	{
+		printf("  ring still full after draining\n");
+		return false;
+	}
+
+	for (uint8_t c = 0; c < 6; c++)
+		slot[c] = 40000 + c;
+	adc.commitScan();
+
+	GamepadState state;
+	adc.read(state);
+	if (state.lx != 40000 || state.ly != 40001 || state.rx != 40002 || state.ry != 40003 || state.lt != (40004 >> 8) || state.rt != (40005 >> 8))
+	{
+		printf("  read gave (%u, %u, %u, %u, %u, %u)\n", state.lx, state.ly, state.rx, state.ry, state.lt, state.rt);
+		return false;
+	}
+
+	return true;
+}
+
+CHECK_CASE("adc/decimate")
+{
+	// 12-bit samples summed in fours fill 16 bits, and a steady input settles exactly through the filter
+	const GamepadADCAxis axes[] = { ADC_AXIS_RY, ADC_AXIS_LT };
+	GamepadADC adc(axes, 2);
+
+	GamepadState state;
+	adc.read(state);
+	if (state.ry != GAMEPAD_JOYSTICK_MID || state.lt != 0)
+	{
+		printf("  axes changed before the first value was ready\n");
+		return false;
+	}
+
+	const uint16_t scan[] = { 1000, 4095 };
+	uint8_t values = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		adc.push(scan);
+		values += adc.update();
+	}
+
+	if (values != 0)
+	{
+		printf("  %u values from 3 scans with oversampling of 4\n", values);
+		return false;
+	}
+
+	for (int i = 0; i < 400; i++)
+	{
+		adc.push(scan);
+		adc.update();
+	}
+
+	adc.read(state);
+	if (state.ry != 16000 || state.lt != 0xFF)
+	{
+		printf("  settled at %u and %u, expected 16000 and 255\n", state.ry, state.lt);
+		return false;
+	}
+
+	return true;
+}
+
+CHECK_CASE("adc/filter")
+{
+	GamepadADCConfig raw;
+	raw.oversample = 1;
+	raw.minAlpha = 0;
+	GamepadADCConfig fixed;
+	fixed.beta = 0;
+	GamepadADCConfig adaptive;
+
+	ADCMeasurement rawResult = measureADC(raw, 20, 2);
+	ADCMeasurement fixedResult = measureADC(fixed, 20, 2);
+	ADCMeasurement adaptiveResult = measureADC(adaptive, 20, 2);
+
+	// Most of the noise gone, without the step lag of a plain EMA as smooth
+	bool ok = adaptiveResult.noiseRms * 4 < rawResult.noiseRms
+		&& adaptiveResult.noiseRms < fixedResult.noiseRms * 1.5
+		&& adaptiveResult.stepUs >= 0 && adaptiveResult.stepUs <= 4 * 20
+		&& adaptiveResult.stepUs * 10 < fixedResult.stepUs
+		&& adaptiveResult.rampLagUs * 4 < fixedResult.rampLagUs;
+
+	if (!ok)
+	{
+		printf("  noise rms raw %.1f, EMA %.1f, adaptive %.1f\n", rawResult.noiseRms, fixedResult.noiseRms, adaptiveResult.noiseRms);
+		printf("  step us EMA %.0f, adaptive %.0f; ramp lag us EMA %.1f, adaptive %.1f\n",
+			fixedResult.stepUs, adaptiveResult.stepUs, fixedResult.rampLagUs, adaptiveResult.rampLagUs);
+	}
+
+	return ok;
+}
+
+CHECK_CASE("adc/threads")
+{
+	// The producer stands in for the ADC interrupt: every scan holds its sequence number in all channels
+	GamepadADC adc(allAxes, 6, passThrough());
+	const uint32_t scans = 50000;
+	std::atomic<bool> done {false};
+
+	std::thread producer([&]() {
+		uint16_t scan[6];
+		for (uint32_t sequence = 1; sequence <= scans; sequence++)
+		{
+			for (uint8_t c = 0; c < 6; c++)
+				scan[c] = static_cast<uint16_t>(sequence);
+			while (!adc.push(scan))
+				std::this_thread::yield();
+		}
+		done = true;
+	});
+
+	uint16_t expected = 1;
+	uint32_t received = 0;
+	bool ok = true;
+	while (ok && received < scans)
+	{
+		uint8_t values = adc.update();
+		if (values == 0)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		uint16_t last = static_cast<uint16_t>(expected + values - 1);
+		for (uint8_t c = 0; c < 6; c++)
+		{
+			if (adc.getValue(c) != last)
+			{
+				printf("  channel %u is %u after scan %u\n", c, adc.getValue(c), last);
+				ok = false;
+			}
+		}
+		expected = last + 1;
+		received += values;
+	}
+
+	producer.join();
+	if (ok && (received != scans || !done))
+	{
+		printf("  received %u of %u scans\n", received, scans);
+		ok = false;
+	}
+
+	return ok;
+}
+
+CHECK_CASE("adc/pipeline")
+{
+	// Whatever the board's read() left in the sticks is replaced from the ring, whether the frame runs through
+	// update() or the stages one at a time
+	const GamepadADCAxis axes[] = { ADC_AXIS_LX, ADC_AXIS_LY };
+	bool ok = true;
+	for (int stages = 0; stages < 2; stages++)
+	{
+		GamepadADC adc(axes, 2, passThrough());
+
+		BenchGamepad gamepad;
+		gamepad.adc = &adc;
+		gamepad.hasLeftAnalogStick = true;
+		gamepad.options.inputMode = INPUT_MODE_HID;
+
+		const uint16_t scan[] = { 0xFFFF, 0 };
+		adc.push(scan);
+		if (stages)
+			runGamepadStages(gamepad);
+		else
+			gamepad.update();
+
+		if (gamepad.state.lx != 0xFFFF || gamepad.state.ly != 0)
+		{
+			printf("  state stick %s is (%u, %u), expected (65535, 0)\n", stages ? "stage by stage" : "of update()",
+				gamepad.state.lx, gamepad.state.ly);
+			ok = false;
+		}
+	}
+
+	return ok;
+}
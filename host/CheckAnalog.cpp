@@ -0,0 +1,267 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies the fixed-point analog stage against a floating point model of the same deadzones and curves, over a
+ * grid of stick positions, and checks the properties boards rely on: centered inside the inner deadzone, circular
+ * full deflection past the outer one, and output that never shrinks as the stick moves out.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "Check.h"
+#include "BenchGamepad.h"
+#include "GamepadAnalog.h"
+
+// Largest difference from the model allowed, in axis counts out of 32768. Rounding the distance and the reciprocal
+// down costs a few counts where a curve is steep.
+#define ANALOG_TOLERANCE 6
+
+static double modelCurve(GamepadCurve curve, double t)
+{
+	switch (curve)
+	{
+		case ANALOG_CURVE_QUADRATIC: return t * t;
+		case ANALOG_CURVE_CUBIC:     return t * t * t;
+		case ANALOG_CURVE_SQRT:      return sqrt(t);
+		default:                     return t;
+	}
+}
+
+// The curve is a table of points, so the model interpolates between exact points the same way
+static double modelShape(const GamepadStickConfig &config, double distance)
+{
+	double range = std::max(1.0, static_cast<double>(config.outerDeadzone) - config.innerDeadzone);
+	double t = std::min(1.0, (distance - config.innerDeadzone) / range);
+	double segments = GAMEPAD_ANALOG_CURVE_POINTS - 1;
+	double index = std::min(segments - 1, floor(t * segments));
+	double low = modelCurve(config.curve, index / segments);
+	double high = modelCurve(config.curve, (index + 1) / segments);
+	double curved = low + (high - low) * (t * segments - index);
+
+	double anti = config.antiDeadzone;
+	return anti + curved * (GAMEPAD_ANALOG_FULL - anti);
+}
+
+static void model(const GamepadStickConfig &config, double x, double y, double &outX, double &outY)
+{
+	if (!config.radial)
+	{
+		outX = (fabs(x) <= config.innerDeadzone) ? 0 : copysign(modelShape(config, fabs(x)), x);
+		outY = (fabs(y) <= config.innerDeadzone) ? 0 : copysign(modelShape(config, fabs(y)), y);
+		return;
+	}
+
+	// The stage measures whole distances
+	double distance = sqrt(x * x + y * y);
+	if (floor(distance) <= config.innerDeadzone || distance == 0)
+	{
+		outX = outY = 0;
+		return;
+	}
+
+	double scale = modelShape(config, distance) / distance;
+	outX = x * scale;
+	outY = y * scale;
+}
+
+static bool checkConfig(const char *name, const GamepadStickConfig &config)
+{
+	GamepadAnalog analog;
+	analog.configure(ANALOG_STICK_LEFT, config);
+
+	for (int32_t x = -32767; x <= 32768; x += 257)
+	{
+		for (int32_t y = -32767; y <= 32768; y += 263)
+		{
+			GamepadState state;
+			state.lx = static_cast<uint16_t>(GAMEPAD_JOYSTICK_MID + x);
+			state.ly = static_cast<uint16_t>(GAMEPAD_JOYSTICK_MID + y);
+			analog.process(state);
+
+			double expectX, expectY;
+			model(config, x, y, expectX, expectY);
+			expectX = std::max(0.0, std::min(65535.0, GAMEPAD_JOYSTICK_MID + expectX));
+			expectY = std::max(0.0, std::min(65535.0, GAMEPAD_JOYSTICK_MID + expectY));
+
+			int error = std::max(abs(state.lx - static_cast<int>(lround(expectX))), abs(state.ly - static_cast<int>(lround(expectY))));
+			if (error > ANALOG_TOLERANCE)
+			{
+				printf("  %s, curve %d, radial %d: input (%d, %d) gave (%u, %u), expected (%.0f, %.0f)\n", name, config.curve,
+					config.radial, x, y, state.lx, state.ly, expectX, expectY);
+				return false;
+			}
+
+			if (state.rx != GAMEPAD_JOYSTICK_MID || state.ry != GAMEPAD_JOYSTICK_MID)
+			{
+				printf("  %s: centered right stick moved to (%u, %u)\n", name, state.rx, state.ry);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("analog/isqrt")
+{
+	// Every stick distance squared is under 2^31, check around each perfect square up there and beyond
+	for (uint32_t root = 0; root <= 65535; root++)
+	{
+		uint32_t square = root * root;
+		uint32_t next = (root == 65535) ? UINT32_MAX : square + 2 * root;
+		if (isqrt32(square) != root || isqrt32(next) != root || (square > 0 && isqrt32(square - 1) != root - 1))
+		{
+			printf("  isqrt32 is wrong around %u squared\n", root);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("analog/model")
+{
+	bool ok = true;
+	const GamepadCurve curves[] = { ANALOG_CURVE_LINEAR, ANALOG_CURVE_QUADRATIC, ANALOG_CURVE_CUBIC, ANALOG_CURVE_SQRT };
+	for (GamepadCurve curve : curves)
+	{
+		for (int radial = 0; radial < 2; radial++)
+		{
+			GamepadStickConfig config;
+			config.curve = curve;
+			config.radial = radial;
+			ok &= checkConfig("default", config);
+
+			config.innerDeadzone = 3000;
+			config.outerDeadzone = 30000;
+			ok &= checkConfig("deadzones", config);
+
+			config.antiDeadzone = 6000;
+			ok &= checkConfig("anti-deadzone", config);
+
+			config.innerDeadzone = 40000;
+			config.outerDeadzone = 20000;
+			ok &= checkConfig("inverted", config);
+		}
+	}
+
+	return ok;
+}
+
+CHECK_CASE("analog/properties")
+{
+	GamepadStickConfig config;
+	config.innerDeadzone = 2500;
+	config.outerDeadzone = 29000;
+	config.antiDeadzone = 4000;
+	config.curve = ANALOG_CURVE_QUADRATIC;
+
+	GamepadAnalog analog;
+	analog.configure(ANALOG_STICK_LEFT, config);
+	analog.configure(ANALOG_STICK_RIGHT, config);
+
+	// Walk rays out from center in 64 directions
+	for (int step = 0; step < 64; step++)
+	{
+		double angle = step * 2 * M_PI / 64;
+		uint32_t last = 0;
+		for (int distance = 0; distance <= 46341; distance += 37)
+		{
+			GamepadState state;
+			state.lx = static_cast<uint16_t>(std::max(0L, std::min(65535L, lround(GAMEPAD_JOYSTICK_MID + distance * cos(angle)))));
+			state.ly = static_cast<uint16_t>(std::max(0L, std::min(65535L, lround(GAMEPAD_JOYSTICK_MID + distance * sin(angle)))));
+			int32_t inX = state.lx - GAMEPAD_JOYSTICK_MID;
+			int32_t inY = state.ly - GAMEPAD_JOYSTICK_MID;
+			uint32_t inDistance = static_cast<uint32_t>(sqrt(static_cast<double>(inX * inX + inY * inY)));
+			analog.process(state);
+
+			int32_t x = state.lx - GAMEPAD_JOYSTICK_MID;
+			int32_t y = state.ly - GAMEPAD_JOYSTICK_MID;
+			uint32_t out = static_cast<uint32_t>(lround(sqrt(static_cast<double>(x) * x + static_cast<double>(y) * y)));
+
+			if (inDistance <= config.innerDeadzone && out != 0)
+			{
+				printf("  distance %u inside the inner deadzone gave %u\n", inDistance, out);
+				return false;
+			}
+			if (inDistance > config.innerDeadzone + 1U && out + ANALOG_TOLERANCE < config.antiDeadzone)
+			{
+				printf("  distance %u past the inner deadzone gave %u, under the anti-deadzone\n", inDistance, out);
+				return false;
+			}
+			if (inDistance >= config.outerDeadzone + 1U && (out + ANALOG_TOLERANCE < GAMEPAD_ANALOG_FULL || out > GAMEPAD_ANALOG_FULL + 2))
+			{
+				printf("  distance %u past the outer deadzone gave %u, expected a full deflection\n", inDistance, out);
+				return false;
+			}
+			if (out + ANALOG_TOLERANCE < last)
+			{
+				printf("  output fell from %u to %u moving out to %u at angle %d/64\n", last, out, inDistance, step);
+				return false;
+			}
+			last = std::max(last, out);
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("analog/custom-curve")
+{
+	// A step at half way: nothing below it, full deflection above
+	uint16_t points[GAMEPAD_ANALOG_CURVE_POINTS] = { };
+	for (int i = 9; i < GAMEPAD_ANALOG_CURVE_POINTS; i++)
+		points[i] = GAMEPAD_ANALOG_FULL;
+
+	GamepadAnalog analog;
+	analog.setCurve(ANALOG_STICK_RIGHT, points);
+
+	GamepadState low;
+	low.rx = GAMEPAD_JOYSTICK_MID + 15000;
+	analog.process(low);
+
+	GamepadState high;
+	high.rx = GAMEPAD_JOYSTICK_MID - 20000;
+	analog.process(high);
+
+	if (low.rx != GAMEPAD_JOYSTICK_MID || high.rx != GAMEPAD_JOYSTICK_MIN)
+	{
+		printf("  custom curve gave %u and %u, expected %u and %u\n", low.rx, high.rx, GAMEPAD_JOYSTICK_MID, GAMEPAD_JOYSTICK_MIN);
+		return false;
+	}
+
+	return true;
+}
+
+CHECK_CASE("analog/process")
+{
+	// process() applies the stage before D-pad emulation, which still overrides the stick it drives
+	GamepadAnalog analog;
+	GamepadStickConfig config;
+	config.innerDeadzone = 4000;
+	analog.configure(ANALOG_STICK_LEFT, config);
+	analog.configure(ANALOG_STICK_RIGHT, config);
+
+	BenchGamepad gamepad;
+	gamepad.analog = &analog;
+	gamepad.hasLeftAnalogStick = true;
+	gamepad.hasRightAnalogStick = true;
+	gamepad.options.dpadMode = DPAD_MODE_LEFT_ANALOG;
+	gamepad.state.dpad = GAMEPAD_MASK_UP;
+	gamepad.state.rx = GAMEPAD_JOYSTICK_MID + 2000;
+	gamepad.state.ry = GAMEPAD_JOYSTICK_MID - 2000;
+	gamepad.process();
+
+	if (gamepad.state.rx != GAMEPAD_JOYSTICK_MID || gamepad.state.ry != GAMEPAD_JOYSTICK_MID || gamepad.state.ly != GAMEPAD_JOYSTICK_MIN)
+	{
+		printf("  right stick (%u, %u), left Y %u, expected centered right stick and left Y %u\n",
+			gamepad.state.rx, gamepad.state.ry, gamepad.state.ly, GAMEPAD_JOYSTICK_MIN);
+		return false;
+	}
+
+	return true;
+}
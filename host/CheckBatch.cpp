@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies that every batch conversion kernel built in produces the same reports as MPG::getReport().
+ */
+
+#include <string.h>
+
+#include "Check.h"
+#include "BenchGamepad.h"
+
+template <typename Report>
+static bool compareBatch(InputMode mode, GamepadBatchKernel kernel, bool analogTriggers,
+	void (*convert)(const GamepadStateBatch &, size_t, Report *, bool, GamepadBatchKernel))
+{
+	// Not a multiple of the block size, so the scalar tail is covered too
+	const size_t frameCount = 4096 + 13;
+
+	for (int mix = 0; mix < INPUT_MIX_COUNT; mix++)
+	{
+		std::vector<GamepadState> frames = generateInputMix(static_cast<InputMix>(mix), frameCount, 11);
+		for (size_t i = 0; i < frameCount; i++)
+			frames[i].dpad |= (i & 0xF0);  // Stray high bits must be ignored like getReport() does
+
+		BatchFrames soa(frames);
+		std::vector<Report> reports(frameCount);
+		memset(reports.data(), 0xA5, sizeof(Report) * frameCount);
+		convert(soa.batch(), frameCount, reports.data(), analogTriggers, kernel);
+
+		BenchGamepad gamepad;
+		gamepad.options.inputMode = mode;
+		gamepad.hasAnalogTriggers = analogTriggers;
+		for (size_t i = 0; i < frameCount; i++)
+		{
+			gamepad.state = frames[i];
+			if (memcmp(gamepad.getReport(), &reports[i], sizeof(Report)) != 0)
+			{
+				printf("  mode %d, kernel %d, mix %s: mismatch at state %zu\n", mode, kernel,
+					inputMixName(static_cast<InputMix>(mix)), i);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static void convertXInput(const GamepadStateBatch &states, size_t count, XInputReport *reports, bool analogTriggers, GamepadBatchKernel kernel)
+{
+	convertXInputBatch(states, count, reports, analogTriggers, kernel);
+}
+
+static void convertSwitch(const GamepadStateBatch &states, size_t count, SwitchReport *reports, bool, GamepadBatchKernel kernel)
+{
+	convertSwitchBatch(states, count, reports, kernel);
+}
+
+static void convertHID(const GamepadStateBatch &states, size_t count, HIDReport *reports, bool, GamepadBatchKernel kernel)
+{
+	convertHIDBatch(states, count, reports, kernel);
+}
+
+CHECK_CASE("batch/matches-getReport")
+{
+	bool ok = true;
+	for (int kernel = GAMEPAD_BATCH_SCALAR; kernel <= getGamepadBatchKernel(); kernel++)
+	{
+		GamepadBatchKernel k = static_cast<GamepadBatchKernel>(kernel);
+		ok &= compareBatch<XInputReport>(INPUT_MODE_XINPUT, k, false, convertXInput);
+		ok &= compareBatch<XInputReport>(INPUT_MODE_XINPUT, k, true, convertXInput);
+		ok &= compareBatch<SwitchReport>(INPUT_MODE_SWITCH, k, false, convertSwitch);
+		ok &= compareBatch<HIDReport>(INPUT_MODE_HID, k, false, convertHID);
+	}
+
+	return ok;
+}
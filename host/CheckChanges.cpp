@@ -0,0 +1,185 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies that cached reports from getReport() always match a fresh conversion, and that the changed flag is set
+ * exactly when the state, input mode or report options changed. Also checks reports built in driver-owned buffers,
+ * and that a buffer being sent is never written.
+ */
+
+#include <string.h>
+
+#include "Check.h"
+#include "BenchGamepad.h"
+
+// Converts a state into separate report buffers, bypassing the report cache
+class FreshGamepad : public BenchGamepad
+{
+	public:
+		const void *convert(const MPGCore &source, InputMode mode)
+		{
+			state = source.state;
+			hasAnalogTriggers = source.hasAnalogTriggers;
+			return fillReport(mode, &xinput, &switchReport, &hid);
+		}
+
+		XInputReport xinput { };
+		SwitchReport switchReport { };
+		HIDReport hid { };
+};
+
+// Builds its reports in its own pair of buffers, like a USB driver's endpoint buffers
+class BufferedGamepad : public BenchGamepad
+{
+	public:
+		BufferedGamepad() : buffers(endpoint[0], endpoint[1], sizeof(endpoint[0]))
+		{
+			setReportBuffers(&buffers);
+		}
+
+		uint16_t endpoint[2][32];
+		GamepadReportBuffers buffers;
+};
+
+template <class Gamepad>
+static bool checkChanges(const char *name, InputMix mix)
+{
+	const size_t frameCount = 20000;
+	std::vector<GamepadState> frames = generateInputMix(mix, frameCount, 5);
+
+	Gamepad gamepad;
+	FreshGamepad fresh;
+	GamepadState previous;
+	InputMode previousMode = gamepad.options.inputMode;
+	bool previousTriggers = gamepad.hasAnalogTriggers;
+	uint32_t rebuilt = 0;
+
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		// Occasionally switch input mode or trigger support, which must also invalidate the report
+		if (i % 1500 == 700)
+			gamepad.options.inputMode = static_cast<InputMode>((gamepad.options.inputMode + 1) % 3);
+		if (i % 2100 == 1000)
+			gamepad.hasAnalogTriggers = !gamepad.hasAnalogTriggers;
+
+		gamepad.state = frames[i];
+
+		bool changed = false;
+		const void *report = gamepad.getReport(&changed);
+		uint16_t size = gamepad.getReportSize();
+		InputMode mode = gamepad.options.inputMode;
+
+		bool expectChanged = (i == 0)
+			|| compareGamepadState(previous, gamepad.state) != 0
+			|| mode != previousMode
+			|| gamepad.hasAnalogTriggers != previousTriggers;
+
+		if (changed != expectChanged)
+		{
+			printf("  %s, mix %s: changed flag is %d at frame %zu\n", name, inputMixName(mix), changed, i);
+			return false;
+		}
+
+		if (memcmp(report, fresh.convert(gamepad, mode), size) != 0)
+		{
+			printf("  %s, mix %s: cached report is stale at frame %zu\n", name, inputMixName(mix), i);
+			return false;
+		}
+
+		rebuilt += changed ? 1 : 0;
+		previous = gamepad.state;
+		previousMode = mode;
+		previousTriggers = gamepad.hasAnalogTriggers;
+	}
+
+	if (gamepad.generation != rebuilt)
+	{
+		printf("  %s, mix %s: generation %u does not match %u rebuilt reports\n", name, inputMixName(mix), gamepad.generation, rebuilt);
+		return false;
+	}
+
+	return true;
+}
+
+CHECK_CASE("changes/mpg")
+{
+	bool ok = true;
+	for (int mix = 0; mix < INPUT_MIX_COUNT; mix++)
+		ok &= checkChanges<BenchGamepad>("mpg", static_cast<InputMix>(mix));
+
+	return ok;
+}
+
+CHECK_CASE("changes/mpgt")
+{
+	bool ok = true;
+	for (int mix = 0; mix < INPUT_MIX_COUNT; mix++)
+		ok &= checkChanges<BenchStaticGamepad<INPUT_MODE_RUNTIME>>("mpgt", static_cast<InputMix>(mix));
+
+	return ok;
+}
+
+CHECK_CASE("changes/buffers")
+{
+	bool ok = true;
+	for (int mix = 0; mix < INPUT_MIX_COUNT; mix++)
+		ok &= checkChanges<BufferedGamepad>("buffers", static_cast<InputMix>(mix));
+
+	return ok;
+}
+
+CHECK_CASE("changes/buffers-sending")
+{
+	const size_t frameCount = 20000;
+	std::vector<GamepadState> frames = generateInputMix(INPUT_MIX_MASHING, frameCount, 9);
+
+	BufferedGamepad gamepad;
+	FreshGamepad fresh;
+	uint8_t inFlight[64];
+	const void *sending = nullptr;
+
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		if (i % 1000 == 500)
+			gamepad.options.inputMode = static_cast<InputMode>((gamepad.options.inputMode + 1) % 3);
+
+		gamepad.state = frames[i];
+		bool changed;
+		const void *report = gamepad.getReport(&changed);
+		uint16_t size = gamepad.getReportSize();
+		if (report != gamepad.endpoint[0] && report != gamepad.endpoint[1])
+		{
+			printf("  frame %zu: the report is not in the driver's buffers\n", i);
+			return false;
+		}
+
+		if (memcmp(report, fresh.convert(gamepad, gamepad.options.inputMode), size) != 0)
+		{
+			printf("  frame %zu: the report is stale\n", i);
+			return false;
+		}
+
+		// The transfer takes a few frames, and nothing may write to its buffer meanwhile
+		if (sending && memcmp(sending, inFlight, sizeof(inFlight)) != 0)
+		{
+			printf("  frame %zu: a report being sent was overwritten\n", i);
+			return false;
+		}
+
+		if (sending && i % 3 == 0)
+		{
+			gamepad.buffers.sent();
+			sending = nullptr;
+		}
+
+		if (!sending && changed)
+		{
+			sending = gamepad.buffers.send();
+			memcpy(inFlight, sending, sizeof(inFlight));
+		}
+	}
+
+	return true;
+}
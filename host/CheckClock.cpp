@@ -0,0 +1,339 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies the gamepad clock: debouncing, hotkey holds and MPGS saves timed the same across the 32-bit wrap as
+ * anywhere else, inputs left alone for longer than the wrap not blocked, and a gamepad given its own clock ignoring
+ * the board's. Times are in ticks, so the checks run on either clock. When built with GAMEPAD_CLOCK_MICROS=1 (the
+ * MPGCheckClock target) it also checks debounce windows shorter than a millisecond, and that the board's
+ * `getMicros()` is read when no clock is set.
+ */
+
+#include "Check.h"
+#include "BenchGamepad.h"
+#include "MPGS.h"
+
+extern thread_local uint32_t hostMicros;
+
+// A quarter of a millisecond, or a whole one on a millisecond clock
+static const uint32_t CLOCK_STEP = (GAMEPAD_CLOCK_TICKS_PER_MS > 4) ? GAMEPAD_CLOCK_TICKS_PER_MS / 4 : 1;
+
+#if GAMEPAD_CLOCK_MICROS
+struct ClockStep
+{
+	uint32_t us;       // Since the first step
+	uint8_t raw;       // B1
+	uint8_t expected;  // B1 after debouncing
+};
+
+// A 300 us lockout on B1: bounce inside the window is ignored, and the window ends on the first microsecond past it
+static const ClockStep lockoutSteps[] =
+{
+	{    0, 1, 1 },
+	{  100, 0, 1 },
+	{  300, 0, 1 },
+	{  301, 0, 0 },
+	{  400, 1, 0 },
+	{  601, 1, 0 },
+	{  602, 1, 1 },
+};
+
+// The vertical debouncer waits whole ticks, so the same window lasts until the next millisecond
+static const ClockStep tickSteps[] =
+{
+	{    0, 1, 1 },
+	{  100, 0, 1 },
+	{  301, 0, 1 },
+	{  999, 0, 1 },
+	{ 1000, 0, 0 },
+};
+
+// Run the steps through a gamepad's debounce(), with `setTime` moving whichever clock it reads
+template <class SetTime>
+static bool checkDebounceSteps(BenchGamepad &gamepad, const char *name, const ClockStep *steps, size_t count,
+	uint32_t startUs, SetTime setTime)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		setTime(startUs + steps[i].us);
+		gamepad.frames[0].buttons = steps[i].raw ? GAMEPAD_MASK_B1 : 0;
+		gamepad.read();
+		gamepad.debounce();
+		uint8_t b1 = (gamepad.state.buttons & GAMEPAD_MASK_B1) != 0;
+		if (b1 != steps[i].expected)
+		{
+			printf("  %s at %u us read %u, debounced %u, expected %u\n", name, steps[i].us, steps[i].raw, b1,
+				steps[i].expected);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("clock/sub-millisecond")
+{
+	// The board's clock stands still, so only the gamepad's own clock can move the windows
+	hostMillis = 1000;
+	GamepadVirtualClock clock;
+	auto setTime = [&clock](uint32_t us) { clock.set(us); };
+
+	BenchGamepad gamepad;
+	gamepad.clock = &clock;
+	gamepad.debouncer.setButtonIntervalUs(GAMEPAD_MASK_B1, 300, 300);
+	bool ok = gamepad.debouncer.getPressUs(0) == 300 && gamepad.debouncer.getPressMS(0) == 0;
+	ok &= checkDebounceSteps(gamepad, "lockout", lockoutSteps, sizeof(lockoutSteps) / sizeof(lockoutSteps[0]), 5000,
+		setTime);
+
+	// Deferred, a glitch shorter than the window is never reported, and a press is once it has been read for the window
+	// since the last released read
+	GamepadDebouncer deferred(0);
+	deferred.setMode(DEBOUNCE_MODE_DEFER);
+	deferred.setButtonIntervalUs(GAMEPAD_MASK_B1, 250, 250);
+	GamepadState state;
+	static const uint32_t glitch[][3] =
+	{
+		{ 0, 0, 0 }, { 100, 1, 0 }, { 300, 0, 0 }, { 400, 1, 0 }, { 549, 1, 0 }, { 550, 1, 1 },
+	};
+	for (const auto &step : glitch)
+	{
+		state.buttons = step[1] ? GAMEPAD_MASK_B1 : 0;
+		deferred.debounce(&state, 7000 + step[0]);
+		if (state.buttons != (step[2] ? GAMEPAD_MASK_B1 : 0))
+		{
+			printf("  deferred at %u us gave %04x\n", step[0], state.buttons);
+			ok = false;
+		}
+	}
+
+	// The vertical debouncer rounds the window up to a whole tick
+	GamepadVerticalDebouncer vertical(0);
+	vertical.setButtonIntervalUs(GAMEPAD_MASK_B1, 300, 300);
+	for (const ClockStep &step : tickSteps)
+	{
+		state.buttons = step.raw ? GAMEPAD_MASK_B1 : 0;
+		vertical.debounce(&state, 5000 + step.us);
+		if (state.buttons != (step.expected ? GAMEPAD_MASK_B1 : 0))
+		{
+			printf("  vertical at %u us gave %04x\n", step.us, state.buttons);
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+#endif
+
+// Both debouncers give the same output for the same inputs and steps, whether or not the clock wraps in between
+template <class Debouncer>
+static bool checkWrap(const char *name, DebounceMode mode)
+{
+	Debouncer before(5);
+	Debouncer across(5);
+	uint32_t rng = 25;
+	auto next = [&rng]() { rng = rng * 1664525U + 1013904223U; return rng >> 8; };
+
+	before.setMode(mode);
+	across.setMode(mode);
+	for (uint8_t i = 0; i < GAMEPAD_BUTTON_COUNT; i++)
+	{
+		uint32_t pressUs = next() % 8000;
+		uint32_t releaseUs = next() % 8000;
+		before.setButtonIntervalUs(buttonMasks[i], pressUs, releaseUs);
+		across.setButtonIntervalUs(buttonMasks[i], pressUs, releaseUs);
+	}
+
+	// Both starts are whole milliseconds apart, and the second wraps a second in
+	const uint32_t start = static_cast<uint32_t>(0U - 1000 * GAMEPAD_CLOCK_TICKS_PER_MS);
+	GamepadVirtualClock clockBefore(start - 4000000000UL);
+	GamepadVirtualClock clockAcross(start);
+	uint16_t buttons = 0;
+	bool wrapped = false;
+	for (uint32_t frame = 0; frame < 50000; frame++)
+	{
+		uint32_t step = next() % (CLOCK_STEP * 3);
+		clockBefore.advance(step);
+		clockAcross.advance(step);
+		wrapped |= clockAcross.now() < step;
+		if ((next() % 8) == 0)
+			buttons ^= buttonMasks[next() % GAMEPAD_BUTTON_COUNT];
+
+		GamepadState a;
+		GamepadState b;
+		a.buttons = b.buttons = buttons;
+		before.debounce(&a, clockBefore.now());
+		across.debounce(&b, clockAcross.now());
+		if (a.buttons != b.buttons)
+		{
+			printf("  %s mode %d frame %u: %04x before the wrap, %04x across it\n", name, mode, frame, a.buttons,
+				b.buttons);
+			return false;
+		}
+	}
+
+	if (!wrapped)
+		printf("  %s never wrapped\n", name);
+
+	return wrapped;
+}
+
+CHECK_CASE("clock/wraparound")
+{
+	bool ok = true;
+	for (int mode = 0; mode < DEBOUNCE_MODE_COUNT; mode++)
+	{
+		ok &= checkWrap<GamepadDebouncer>("timestamp", static_cast<DebounceMode>(mode));
+		ok &= checkWrap<GamepadVerticalDebouncer>("vertical", static_cast<DebounceMode>(mode));
+	}
+
+	return ok;
+}
+
+// An input released and then left alone for a whole wrap and a tick is pressed at once, not blocked by a time that
+// wrapped round to look recent. Polled often enough that only the one-a-call aging can catch it, then with two long gaps.
+template <class Debouncer>
+static bool checkStale(const char *name, uint32_t calls)
+{
+	Debouncer debouncer(5);
+	GamepadState state;
+	state.buttons = GAMEPAD_MASK_B1;
+	uint32_t now = 100 * GAMEPAD_CLOCK_TICKS_PER_MS;
+	debouncer.debounce(&state, now);
+	state.buttons = 0;
+	now += 10 * GAMEPAD_CLOCK_TICKS_PER_MS;
+	debouncer.debounce(&state, now);
+
+	const uint32_t step = static_cast<uint32_t>(0x100000000ULL / calls);
+	for (uint32_t call = 0; call < calls; call++)
+	{
+		now += step;
+		debouncer.debounce(&state, now);
+	}
+
+	state.buttons = GAMEPAD_MASK_B1;
+	debouncer.debounce(&state, now + 1);
+	if (state.buttons != GAMEPAD_MASK_B1)
+	{
+		printf("  %s over %u calls blocked the press\n", name, calls);
+		return false;
+	}
+
+	return true;
+}
+
+CHECK_CASE("clock/stale")
+{
+	bool ok = true;
+	for (uint32_t calls : { 1U << 20, 2U })
+	{
+		ok &= checkStale<GamepadDebouncer>("timestamp", calls);
+		ok &= checkStale<GamepadVerticalDebouncer>("vertical", calls);
+	}
+
+	return ok;
+}
+
+CHECK_CASE("clock/hotkey-hold")
+{
+	// A 20 ms hold pressed 5 ms before the wrap fires on the first step 20 ms in, and only once
+	GamepadHotkeys hotkeys;
+	uint32_t runs = 0;
+	hotkeys.add(GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2, 0, HOTKEY_TRIGGER_HOLD, 20,
+		[](GamepadState &, GamepadOptions &, void *context) { (*static_cast<uint32_t *>(context))++; }, &runs);
+
+	hostMillis = 1000;
+	GamepadVirtualClock clock(0xFFFFFFFF - 5 * GAMEPAD_CLOCK_TICKS_PER_MS);
+	const uint32_t fires = 20 * GAMEPAD_CLOCK_TICKS_PER_MS / CLOCK_STEP;
+	for (uint32_t step = 0; step <= fires * 2; step++)
+	{
+		GamepadState state;
+		GamepadOptions options;
+		state.buttons = GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2;
+		hotkeys.update(state, options, &clock);
+		if (runs != (step >= fires))
+		{
+			printf("  at %u ticks the hold ran %u times\n", step * CLOCK_STEP, runs);
+			return false;
+		}
+
+		clock.advance(CLOCK_STEP);
+	}
+
+	return true;
+}
+
+// MPGS on memory storage, holding whatever it is told to
+class ClockStorageGamepad : public MPGS
+{
+	public:
+		ClockStorageGamepad(GamepadStorage *storage) : MPGS(5, storage) { }
+
+		void setup() override { }
+
+		void read() override
+		{
+			state.buttons = buttons;
+			state.dpad = dpad;
+		}
+
+		uint16_t buttons {0};
+		uint8_t dpad {0};
+};
+
+CHECK_CASE("clock/save-delay")
+{
+	// F2 + Up held across the wrap is saved GAMEPAD_SAVE_DELAY_MS after it changed the SOCD mode, to the tick
+	GamepadMemoryStorage storage;
+	ClockStorageGamepad gamepad(&storage);
+	GamepadVirtualClock clock(0xFFFFFFFF - 300 * GAMEPAD_CLOCK_TICKS_PER_MS);
+	gamepad.clock = &clock;
+	gamepad.load();
+
+	hostMillis = 1000;
+	gamepad.buttons = GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3;
+	gamepad.dpad = GAMEPAD_MASK_UP;
+	const uint32_t frames = GAMEPAD_SAVE_DELAY_MS * GAMEPAD_CLOCK_TICKS_PER_MS / CLOCK_STEP;
+	for (uint32_t frame = 0; frame <= frames + 1; frame++)
+	{
+		gamepad.update();
+		bool saved = storage.getGamepadOptions().socdMode == SOCD_MODE_UP_PRIORITY;
+		if (gamepad.options.socdMode != SOCD_MODE_UP_PRIORITY || saved != (frame > frames))
+		{
+			printf("  frame %u at %u ticks: SOCD mode %d, %s\n", frame, frame * CLOCK_STEP, gamepad.options.socdMode,
+				saved ? "saved" : "not saved");
+			return false;
+		}
+
+		clock.advance(CLOCK_STEP);
+	}
+
+	return true;
+}
+
+#if GAMEPAD_CLOCK_MICROS
+CHECK_CASE("clock/board-micros")
+{
+	// With no clock set the gamepad reads the board's getMicros(), and getMillis() is left alone
+	hostMillis = 1000;
+	BenchGamepad gamepad;
+	gamepad.debouncer.setButtonIntervalUs(GAMEPAD_MASK_B1, 300, 300);
+	return checkDebounceSteps(gamepad, "board", lockoutSteps, sizeof(lockoutSteps) / sizeof(lockoutSteps[0]),
+		0xFFFFFF00, [](uint32_t us) { hostMicros = us; });
+}
+#else
+CHECK_CASE("clock/board-millis")
+{
+	// With no clock set the gamepad reads the board's getMillis() as it is, so it wraps every 49.7 days
+	BenchGamepad gamepad;
+	hostMillis = 1234;
+	bool ok = gamepad.now() == 1234;
+	hostMillis = 0xFFFFFFFF;
+	ok &= gamepad.now() == 0xFFFFFFFF;
+	if (!ok)
+		printf("  the board's time was not read from getMillis()\n");
+
+	return ok;
+}
+#endif
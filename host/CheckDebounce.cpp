@@ -0,0 +1,212 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies that GamepadVerticalDebouncer produces the same output as GamepadDebouncer, frame for frame, over
+ * randomized bouncy input with irregular frame timing, in every mode and with per-input windows, and that each mode
+ * treats presses, releases and bounce as documented.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Check.h"
+#include "GamepadDebouncer.h"
+
+extern thread_local uint32_t hostMillis;
+
+static bool compare(uint8_t debounceMS, uint32_t seed, uint32_t frames, DebounceMode mode = DEBOUNCE_MODE_LOCKOUT,
+	bool perInput = false)
+{
+	GamepadDebouncer legacy(debounceMS);
+	memset(legacy.dpadTime, 0, sizeof(legacy.dpadTime));
+	memset(legacy.buttonTime, 0, sizeof(legacy.buttonTime));
+	GamepadVerticalDebouncer vertical(debounceMS);
+
+	uint32_t rng = seed;
+	auto next = [&rng]() { rng = rng * 1664525U + 1013904223U; return rng >> 8; };
+
+	legacy.setMode(mode);
+	vertical.setMode(mode);
+	for (uint8_t i = 0; perInput && i < GAMEPAD_DIGITAL_INPUT_COUNT; i++)
+	{
+		uint8_t pressMS = next() % 12;
+		uint8_t releaseMS = next() % 12;
+		if (i < GAMEPAD_BUTTON_COUNT)
+		{
+			legacy.setButtonInterval(buttonMasks[i], pressMS, releaseMS);
+			vertical.setButtonInterval(buttonMasks[i], pressMS, releaseMS);
+		}
+		else
+		{
+			legacy.setDpadInterval(dpadMasks[i - GAMEPAD_BUTTON_COUNT], pressMS, releaseMS);
+			vertical.setDpadInterval(dpadMasks[i - GAMEPAD_BUTTON_COUNT], pressMS, releaseMS);
+		}
+	}
+
+	// Start late enough that no input is locked out by the zero initial timestamps
+	hostMillis = 1000;
+	GamepadState raw;
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		// Mostly sub-millisecond frames, with the occasional stall
+		uint32_t r = next() % 100;
+		hostMillis += (r < 70) ? 0 : (r < 95) ? 1 : (r < 99) ? 3 : 300;
+
+		// Flip a few inputs per frame, including bits outside the debounced masks
+		if (next() % 4 == 0)
+			raw.buttons ^= (1U << (next() % 16));
+		if (next() % 6 == 0)
+			raw.dpad ^= (1U << (next() % 8));
+
+		GamepadState a = raw;
+		GamepadState b = raw;
+		legacy.debounce(&a);
+		vertical.debounce(&b);
+
+		if (a.buttons != b.buttons || a.dpad != b.dpad)
+		{
+			printf("FAIL: debounceMS=%u mode=%d seed=%u frame=%u t=%u legacy=%04x/%x vertical=%04x/%x\n",
+				debounceMS, mode, seed, frame, hostMillis, a.buttons, a.dpad, b.buttons, b.dpad);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("debounce/vertical-matches-timestamp")
+{
+	const uint8_t intervals[] = { 0, 1, 2, 5, 8, 10, 20, 50, 100, 254 };
+	int failures = 0;
+
+	for (uint8_t debounceMS : intervals)
+		for (uint32_t seed = 1; seed <= 8; seed++)
+			failures += compare(debounceMS, seed, 200000) ? 0 : 1;
+
+	return failures == 0;
+}
+
+CHECK_CASE("debounce/vertical-matches-modes")
+{
+	const uint8_t intervals[] = { 0, 2, 5, 20, 254 };
+	int failures = 0;
+
+	for (int mode = 0; mode < DEBOUNCE_MODE_COUNT; mode++)
+	{
+		for (uint8_t debounceMS : intervals)
+			failures += compare(debounceMS, mode + 1, 100000, static_cast<DebounceMode>(mode)) ? 0 : 1;
+
+		for (uint32_t seed = 1; seed <= 8; seed++)
+			failures += compare(5, seed, 100000, static_cast<DebounceMode>(mode), true) ? 0 : 1;
+	}
+
+	return failures == 0;
+}
+
+struct DebounceStep
+{
+	uint32_t ms;     // Time of the frame
+	bool raw;        // B1 as read
+	bool expected;   // B1 as debounced
+};
+
+template <typename Debouncer>
+static bool runSteps(const char *name, Debouncer &debouncer, const DebounceStep *steps, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		hostMillis = 1000 + steps[i].ms;
+		GamepadState state;
+		state.buttons = steps[i].raw ? GAMEPAD_MASK_B1 : 0;
+		debouncer.debounce(&state);
+		if (((state.buttons & GAMEPAD_MASK_B1) != 0) != steps[i].expected)
+		{
+			printf("  %s: at %u ms B1 read %d debounced to %d, expected %d\n", name, steps[i].ms, steps[i].raw,
+				!steps[i].expected, steps[i].expected);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template <typename Debouncer>
+static bool checkModes(const char *name)
+{
+	bool ok = true;
+
+	// Lockout: both edges at once, then 5 ms of bounce ignored
+	static const DebounceStep lockout[] =
+	{
+		{ 0, true, true }, { 1, false, true }, { 5, false, true }, { 6, false, false }, { 7, true, false },
+		{ 11, true, false }, { 12, true, true },
+	};
+
+	Debouncer a(5);
+	ok &= runSteps(name, a, lockout, sizeof(lockout) / sizeof(lockout[0]));
+
+	// Asymmetric with a 2 ms press window and 8 ms release window
+	static const DebounceStep asymmetric[] =
+	{
+		{ 0, true, true }, { 1, false, true }, { 3, false, false }, { 4, true, false }, { 11, true, false },
+		{ 12, true, true },
+	};
+
+	Debouncer b(5);
+	b.setMode(DEBOUNCE_MODE_ASYMMETRIC);
+	b.setButtonInterval(GAMEPAD_MASK_B1, 2, 8);
+	ok &= runSteps(name, b, asymmetric, sizeof(asymmetric) / sizeof(asymmetric[0]));
+
+	// Eager: the press at once, bounce while held ignored, the release once it has read released for 5 ms, and the
+	// next press at once again
+	static const DebounceStep eager[] =
+	{
+		{ 0, true, true }, { 1, false, true }, { 2, true, true }, { 3, false, true }, { 4, true, true },
+		{ 20, true, true }, { 21, false, true }, { 24, false, true }, { 25, false, false }, { 25, true, true },
+	};
+
+	Debouncer c(5);
+	c.setMode(DEBOUNCE_MODE_EAGER);
+	ok &= runSteps(name, c, eager, sizeof(eager) / sizeof(eager[0]));
+
+	// Defer: a 2 ms glitch never shows, while a press and a release held for 5 ms do
+	static const DebounceStep defer[] =
+	{
+		{ 0, false, false }, { 1, true, false }, { 2, true, false }, { 3, false, false }, { 4, false, false },
+		{ 5, true, false }, { 6, true, false }, { 7, true, false }, { 8, true, false }, { 9, true, true },
+		{ 10, false, true }, { 11, false, true }, { 13, false, true }, { 14, false, false },
+	};
+
+	Debouncer d(5);
+	d.setMode(DEBOUNCE_MODE_DEFER);
+	ok &= runSteps(name, d, defer, sizeof(defer) / sizeof(defer[0]));
+
+	// Per-input windows: B1 with none follows every change, while B2 keeps the 5 ms lockout and misses most of them
+	Debouncer e(5);
+	e.setButtonInterval(GAMEPAD_MASK_B1, 0, 0);
+	ok &= e.getPressMS(0) == 0 && e.getPressMS(1) == 5 && e.getReleaseMS(GAMEPAD_BUTTON_COUNT) == 5;
+	for (uint32_t ms = 0; ms < 10 && ok; ms++)
+	{
+		hostMillis = 1000 + ms;
+		GamepadState state;
+		state.buttons = (ms & 1) ? (GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2) : 0;
+		e.debounce(&state);
+		ok &= ((state.buttons & GAMEPAD_MASK_B1) != 0) == ((ms & 1) != 0);
+		ok &= ((state.buttons & GAMEPAD_MASK_B2) != 0) == (ms >= 1 && ms < 8);
+	}
+
+	if (!ok)
+		printf("  %s did not debounce as its modes describe\n", name);
+
+	return ok;
+}
+
+CHECK_CASE("debounce/modes")
+{
+	bool ok = checkModes<GamepadDebouncer>("timestamp");
+	ok &= checkModes<GamepadVerticalDebouncer>("vertical");
+	return ok;
+}
@@ -0,0 +1,150 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Checks the descriptor table: the UTF-16 strings against their ASCII text, the sizes against the lengths inside the
+ * descriptors, fallbacks for unknown modes and indexes, and that the C build of the table matches.
+ */
+
+#include <string.h>
+
+#include <string>
+
+#include "Check.h"
+#include "GamepadDescriptors.h"
+
+extern "C" const void *getGamepadDescriptorC(uint16_t *size, InputMode mode, uint8_t type, uint8_t index);
+
+// Built by the compiler, not at startup
+static_assert(xinput_string_product.bLength == 2 + 2 * 23, "string descriptor length");
+static_assert(mac_string_serial.bString[4] == '8' && mac_string_serial.bString[5] == '4', "MAC address string");
+
+static const InputMode modes[] = { INPUT_MODE_XINPUT, INPUT_MODE_SWITCH, INPUT_MODE_HID };
+
+// Decode a string descriptor, or return "?" if its header is wrong
+static std::string decodeString(const void *data, uint16_t size)
+{
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	if (!bytes || size < 2 || size % 2 != 0 || bytes[0] != size || bytes[1] != USB_DESCRIPTOR_TYPE_STRING)
+		return "?";
+
+	std::string text;
+	for (uint16_t i = 2; i < size; i += 2)
+		text += (bytes[i + 1] == 0) ? static_cast<char>(bytes[i]) : '?';
+
+	return text;
+}
+
+static std::string lookupString(InputMode mode, uint8_t index)
+{
+	uint16_t size;
+	const void *data = getGamepadDescriptor(&size, mode, USB_DESCRIPTOR_TYPE_STRING, index);
+	return decodeString(data, size);
+}
+
+CHECK_CASE("descriptors/strings")
+{
+	const char *expected[][3] =
+	{
+		{ "Microsoft", "XInput STANDARD GAMEPAD", "1.0" },
+		{ "HORI CO.,LTD.", "POKKEN CONTROLLER", "1.0" },
+		{ "Generic", "HID Gamepad", "1.0" },
+	};
+
+	bool ok = true;
+	for (InputMode mode : modes)
+	{
+		for (uint8_t index = 1; index <= 3; index++)
+		{
+			std::string text = lookupString(mode, index);
+			if (text != expected[mode][index - 1])
+			{
+				printf("  mode %d string %u: \"%s\"\n", mode, index, text.c_str());
+				ok = false;
+			}
+		}
+
+		// LANGID 0x0409, and the default MAC address as the serial
+		uint16_t size;
+		const uint8_t *language = reinterpret_cast<const uint8_t *>(getStringDescriptor(&size, mode, 0));
+		ok &= size == 4 && language[0] == 4 && language[1] == USB_DESCRIPTOR_TYPE_STRING && language[2] == 0x09 && language[3] == 0x04;
+		ok &= lookupString(mode, 5) == "0202846A9600";
+	}
+
+	return ok;
+}
+
+CHECK_CASE("descriptors/sizes")
+{
+	bool ok = true;
+	for (InputMode mode : modes)
+	{
+		uint16_t size;
+		const uint8_t *device = getDeviceDescriptor(&size, mode);
+		ok &= device && size == 18 && device[0] == size && device[1] == USB_DESCRIPTOR_TYPE_DEVICE;
+
+		const uint8_t *configuration = getConfigurationDescriptor(&size, mode);
+		ok &= configuration && configuration[1] == USB_DESCRIPTOR_TYPE_CONFIGURATION && (configuration[2] | (configuration[3] << 8)) == size;
+
+		// The HID descriptor gives the length of the report descriptor
+		uint16_t reportSize;
+		const uint8_t *hid = getHIDDescriptor(&size, mode);
+		const uint8_t *report = getHIDReport(&reportSize, mode);
+		if (mode == INPUT_MODE_XINPUT)
+			ok &= !hid && size == 0 && !report && reportSize == 0;
+		else
+			ok &= hid && hid[0] == size && hid[1] == USB_DESCRIPTOR_TYPE_HID && report && (hid[7] | (hid[8] << 8)) == reportSize;
+
+		if (!ok)
+		{
+			printf("  mode %d has inconsistent sizes\n", mode);
+			return false;
+		}
+	}
+
+	return ok;
+}
+
+CHECK_CASE("descriptors/fallback")
+{
+	bool ok = true;
+	uint16_t size = 1;
+
+	// Configuration mode enumerates as HID
+	const void *hid = getGamepadDescriptor(&size, INPUT_MODE_HID, USB_DESCRIPTOR_TYPE_DEVICE, 0);
+	ok &= getGamepadDescriptor(&size, INPUT_MODE_CONFIG, USB_DESCRIPTOR_TYPE_DEVICE, 0) == hid;
+
+	// Nothing for unused string indexes or unknown types
+	for (uint8_t index : { 4, 6, 255 })
+		ok &= !getStringDescriptor(&size, INPUT_MODE_SWITCH, index) && size == 0;
+
+	ok &= !getGamepadDescriptor(&size, INPUT_MODE_HID, 0x06, 0) && size == 0;
+	return ok;
+}
+
+CHECK_CASE("descriptors/c")
+{
+	bool ok = true;
+	for (InputMode mode : modes)
+	{
+		for (uint8_t type : { USB_DESCRIPTOR_TYPE_DEVICE, USB_DESCRIPTOR_TYPE_CONFIGURATION, USB_DESCRIPTOR_TYPE_HID, USB_DESCRIPTOR_TYPE_HID_REPORT })
+		{
+			uint16_t size, sizeC;
+			const void *data = getGamepadDescriptor(&size, mode, type, 0);
+			const void *dataC = getGamepadDescriptorC(&sizeC, mode, type, 0);
+			ok &= size == sizeC && (size == 0 || memcmp(data, dataC, size) == 0);
+		}
+
+		for (uint8_t index = 0; index < 8; index++)
+		{
+			uint16_t size, sizeC;
+			const void *data = getGamepadDescriptor(&size, mode, USB_DESCRIPTOR_TYPE_STRING, index);
+			const void *dataC = getGamepadDescriptorC(&sizeC, mode, USB_DESCRIPTOR_TYPE_STRING, index);
+			ok &= size == sizeC && (size == 0 || memcmp(data, dataC, size) == 0);
+		}
+	}
+
+	return ok;
+}
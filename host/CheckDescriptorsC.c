@@ -0,0 +1,13 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+// USB drivers like the LUFA example include GamepadDescriptors.h from C, so the table is also built as C11
+
+#include "GamepadDescriptors.h"
+
+const void *getGamepadDescriptorC(uint16_t *size, InputMode mode, uint8_t type, uint8_t index)
+{
+	return getGamepadDescriptor(size, mode, type, index);
+}
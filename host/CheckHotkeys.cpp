@@ -0,0 +1,315 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies the hotkey registry: the defaults behave exactly like the F1/F2 switch they replaced on every input and
+ * across frames, hold and press triggers fire once, custom actions run with their context, and the last hotkey added
+ * wins over the defaults.
+ */
+
+#include "Check.h"
+#include "BenchGamepad.h"
+
+// The nested F1/F2 switch MPG::hotkey() ran before the registry
+struct LegacyHotkeys
+{
+	uint16_t f1Mask {GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2};
+	uint16_t f2Mask {GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3};
+	GamepadHotkey lastAction {HOTKEY_NONE};
+
+	GamepadHotkey run(GamepadState &state, GamepadOptions &options)
+	{
+		GamepadHotkey action = HOTKEY_NONE;
+		if ((state.buttons & f1Mask) == f1Mask)
+		{
+			switch (state.dpad & GAMEPAD_MASK_DPAD)
+			{
+				case GAMEPAD_MASK_LEFT:  action = HOTKEY_DPAD_LEFT_ANALOG; options.dpadMode = DPAD_MODE_LEFT_ANALOG; break;
+				case GAMEPAD_MASK_RIGHT: action = HOTKEY_DPAD_RIGHT_ANALOG; options.dpadMode = DPAD_MODE_RIGHT_ANALOG; break;
+				case GAMEPAD_MASK_DOWN:  action = HOTKEY_DPAD_DIGITAL; options.dpadMode = DPAD_MODE_DIGITAL; break;
+				case GAMEPAD_MASK_UP:    action = HOTKEY_HOME_BUTTON; break;
+			}
+
+			if (action != HOTKEY_NONE)
+			{
+				state.dpad = 0;
+				state.buttons &= ~f1Mask;
+				if (action == HOTKEY_HOME_BUTTON)
+					state.buttons |= GAMEPAD_MASK_A1;
+			}
+		}
+		else if ((state.buttons & f2Mask) == f2Mask)
+		{
+			switch (state.dpad & GAMEPAD_MASK_DPAD)
+			{
+				case GAMEPAD_MASK_DOWN:  action = HOTKEY_SOCD_NEUTRAL; options.socdMode = SOCD_MODE_NEUTRAL; break;
+				case GAMEPAD_MASK_UP:    action = HOTKEY_SOCD_UP_PRIORITY; options.socdMode = SOCD_MODE_UP_PRIORITY; break;
+				case GAMEPAD_MASK_LEFT:  action = HOTKEY_SOCD_LAST_INPUT; options.socdMode = SOCD_MODE_SECOND_INPUT_PRIORITY; break;
+				case GAMEPAD_MASK_RIGHT:
+					if (lastAction != HOTKEY_INVERT_Y_AXIS)
+						options.invertYAxis = !options.invertYAxis;
+					action = HOTKEY_INVERT_Y_AXIS;
+					break;
+			}
+
+			if (action != HOTKEY_NONE)
+			{
+				state.dpad = 0;
+				state.buttons &= ~f2Mask;
+			}
+		}
+
+		lastAction = action;
+		return action;
+	}
+};
+
+static bool compareFrame(const char *label, uint32_t frame, const GamepadState &input, GamepadHotkey hotkey,
+	GamepadHotkey expectedHotkey, const GamepadState &state, const GamepadState &expectedState,
+	const GamepadOptions &options, const GamepadOptions &expectedOptions)
+{
+	if (hotkey == expectedHotkey && state.buttons == expectedState.buttons && state.dpad == expectedState.dpad
+		&& equalGamepadOptions(options, expectedOptions))
+		return true;
+
+	printf("  %s frame %u, buttons %04x D-pad %x: hotkey %x buttons %04x D-pad %x, expected %x %04x %x\n", label, frame,
+		input.buttons, input.dpad, hotkey, state.buttons, state.dpad, expectedHotkey, expectedState.buttons,
+		expectedState.dpad);
+	printf("    D-pad mode %d SOCD %d invert Y %d, expected %d %d %d\n", options.dpadMode, options.socdMode,
+		options.invertYAxis, expectedOptions.dpadMode, expectedOptions.socdMode, expectedOptions.invertYAxis);
+	return false;
+}
+
+CHECK_CASE("hotkeys/legacy")
+{
+	// Every button and D-pad combination on its own, from a fresh gamepad
+	for (uint32_t input = 0; input < (1UL << (GAMEPAD_BUTTON_COUNT + 4)); input++)
+	{
+		GamepadState frame;
+		frame.buttons = static_cast<uint16_t>(input & 0x3FFF);
+		frame.dpad = static_cast<uint8_t>(input >> GAMEPAD_BUTTON_COUNT);
+
+		GamepadHotkeys hotkeys;
+		hotkeys.addDefaults();
+		LegacyHotkeys legacy;
+		GamepadState state = frame;
+		GamepadState expectedState = frame;
+		GamepadOptions options;
+		GamepadOptions expectedOptions;
+		GamepadHotkey hotkey = hotkeys.update(state, options);
+		GamepadHotkey expected = legacy.run(expectedState, expectedOptions);
+		if (!compareFrame("single", 0, frame, hotkey, expected, state, expectedState, options, expectedOptions))
+			return false;
+	}
+
+	// Long runs of frames with the modifiers held often, so toggles and hotkeys sliding into each other are covered.
+	// The masks change half way through.
+	std::vector<GamepadState> frames = generateInputMix(INPUT_MIX_MASHING, 200000, 7);
+	GamepadHotkeys hotkeys;
+	hotkeys.addDefaults();
+	LegacyHotkeys legacy;
+	GamepadOptions options;
+	GamepadOptions expectedOptions;
+	for (uint32_t i = 0; i < frames.size(); i++)
+	{
+		if (i == frames.size() / 2)
+		{
+			legacy.f1Mask = GAMEPAD_MASK_A1;
+			legacy.f2Mask = GAMEPAD_MASK_A2 | GAMEPAD_MASK_S1;
+			hotkeys.setModifiers(legacy.f1Mask, legacy.f2Mask);
+		}
+
+		GamepadState frame = frames[i];
+		// Mostly single directions, which is what the hotkeys are on
+		if (i % 3)
+			frame.dpad &= static_cast<uint8_t>(-frame.dpad);
+		if (i % 5 == 0)
+			frame.buttons |= (i % 2) ? legacy.f1Mask : legacy.f2Mask;
+
+		GamepadState state = frame;
+		GamepadState expectedState = frame;
+		GamepadHotkey hotkey = hotkeys.update(state, options);
+		GamepadHotkey expected = legacy.run(expectedState, expectedOptions);
+		if (!compareFrame("run", i, frame, hotkey, expected, state, expectedState, options, expectedOptions))
+			return false;
+	}
+
+	return true;
+}
+
+struct ActionCount
+{
+	uint32_t runs {0};
+};
+
+static void countAction(GamepadState &state, GamepadOptions &options, void *context)
+{
+	static_cast<ActionCount *>(context)->runs++;
+	options.invertXAxis = !options.invertXAxis;
+	state.buttons |= GAMEPAD_MASK_A2;
+}
+
+CHECK_CASE("hotkeys/triggers")
+{
+	// Held for 30 ms twice: the hold action needs 20 ms, the press action fires at once, and held runs every frame
+	GamepadHotkeys hotkeys;
+	ActionCount hold;
+	ActionCount press;
+	ActionCount held;
+	hotkeys.add(GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2, 0, HOTKEY_TRIGGER_HOLD, 20, countAction, &hold);
+	hotkeys.add(GAMEPAD_MASK_B3, GAMEPAD_MASK_UP, HOTKEY_TRIGGER_PRESS, 0, countAction, &press);
+	hotkeys.add(GAMEPAD_MASK_B4, GAMEPAD_MASK_DOWN, HOTKEY_TRIGGER_HELD, 0, countAction, &held);
+
+	const struct { uint16_t buttons; uint8_t dpad; ActionCount *action; } chords[] =
+	{
+		{ GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2 | GAMEPAD_MASK_R1, GAMEPAD_MASK_LEFT, &hold },
+		{ GAMEPAD_MASK_B3, GAMEPAD_MASK_UP, &press },
+		{ GAMEPAD_MASK_B4, GAMEPAD_MASK_DOWN, &held },
+	};
+
+	hostMillis = 1000;
+	for (const auto &chord : chords)
+	{
+		for (int press = 0; press < 2; press++)
+		{
+			for (int ms = 0; ms < 30; ms++)
+			{
+				GamepadState state;
+				GamepadOptions options;
+				state.buttons = chord.buttons;
+				state.dpad = chord.dpad;
+				uint32_t runs = chord.action->runs;
+				GamepadHotkey hotkey = hotkeys.update(state, options);
+				bool ran = chord.action->runs != runs;
+
+				// The chord is hidden, other inputs and the D-pad of a button-only chord pass through
+				uint16_t buttons = (chord.action == &hold) ? GAMEPAD_MASK_R1 : 0;
+				uint8_t dpad = (chord.action == &hold) ? GAMEPAD_MASK_LEFT : 0;
+				if (hotkey != HOTKEY_CUSTOM || (state.buttons & ~GAMEPAD_MASK_A2) != buttons || state.dpad != dpad
+					|| ran != options.invertXAxis || ran != ((state.buttons & GAMEPAD_MASK_A2) != 0))
+				{
+					printf("  chord %04x %x at %d ms: hotkey %x buttons %04x D-pad %x, action %s\n", chord.buttons,
+						chord.dpad, ms, hotkey, state.buttons, state.dpad, ran ? "ran" : "did not run");
+					return false;
+				}
+
+				hostMillis++;
+			}
+
+			GamepadState released;
+			GamepadOptions options;
+			if (hotkeys.update(released, options) != HOTKEY_NONE)
+			{
+				printf("  chord %04x %x still held after release\n", chord.buttons, chord.dpad);
+				return false;
+			}
+		}
+	}
+
+	if (hold.runs != 2 || press.runs != 2 || held.runs != 60)
+	{
+		printf("  actions ran %u, %u and %u times, expected 2, 2 and 60\n", hold.runs, press.runs, held.runs);
+		return false;
+	}
+
+	return true;
+}
+
+CHECK_CASE("hotkeys/recompile")
+{
+	// New modifiers and hotkeys while a chord is held leave it held: the press action does not run again, and the
+	// hold still fires 20 ms after the chord was pressed
+	GamepadHotkeys pressHotkeys;
+	GamepadHotkeys holdHotkeys;
+	ActionCount press;
+	ActionCount hold;
+	pressHotkeys.add(GAMEPAD_HOTKEY_F1, 0, HOTKEY_TRIGGER_PRESS, 0, countAction, &press);
+	holdHotkeys.add(GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2, 0, HOTKEY_TRIGGER_HOLD, 20, countAction, &hold);
+
+	hostMillis = 1000;
+	for (int ms = 0; ms < 30; ms++)
+	{
+		if (ms == 5)
+		{
+			pressHotkeys.setModifiers(GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2, GAMEPAD_MASK_A1);
+			holdHotkeys.setModifiers(GAMEPAD_MASK_A1, GAMEPAD_MASK_A2);
+		}
+		if (ms == 10)
+		{
+			pressHotkeys.add(GAMEPAD_MASK_R1, 0, HOTKEY_CAPTURE_BUTTON);
+			holdHotkeys.add(GAMEPAD_MASK_R1, 0, HOTKEY_CAPTURE_BUTTON);
+		}
+
+		GamepadState state;
+		GamepadOptions options;
+		state.buttons = GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2 | GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2;
+		pressHotkeys.update(state, options);
+		state.buttons = GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2;
+		holdHotkeys.update(state, options);
+		if (press.runs != 1 || hold.runs != (ms >= 20))
+		{
+			printf("  at %d ms the press ran %u times and the hold %u\n", ms, press.runs, hold.runs);
+			return false;
+		}
+
+		hostMillis++;
+	}
+
+	return true;
+}
+
+CHECK_CASE("hotkeys/custom")
+{
+	// A custom F1 + Up replaces Home on a gamepad, without a subclass
+	BenchGamepad gamepad(0);
+	gamepad.options.inputMode = INPUT_MODE_HID;
+	ActionCount count;
+	uint8_t index = gamepad.hotkeys.add(GAMEPAD_HOTKEY_F1, GAMEPAD_MASK_UP, HOTKEY_TRIGGER_PRESS, 0, countAction, &count);
+
+	GamepadState press;
+	press.buttons = GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2;
+	press.dpad = GAMEPAD_MASK_UP;
+	gamepad.load(std::vector<GamepadState>(1, press));
+
+	hostMillis = 1000;
+	for (int i = 0; i < 10; i++)
+	{
+		hostMillis++;
+		gamepad.update();
+	}
+
+	if (count.runs != 1 || !gamepad.options.invertXAxis || gamepad.state.buttons != 0)
+	{
+		printf("  custom F1 + Up ran %u times, buttons %04x, expected once and no Home\n", count.runs, gamepad.state.buttons);
+		return false;
+	}
+
+	// Removed, the default is back, and follows a new F1 mask
+	gamepad.hotkeys.remove(index);
+	gamepad.f1Mask = GAMEPAD_MASK_A1 | GAMEPAD_MASK_A2;
+	press.buttons = gamepad.f1Mask;
+	gamepad.load(std::vector<GamepadState>(1, press));
+	hostMillis++;
+	gamepad.update();
+	if (gamepad.state.buttons != GAMEPAD_MASK_A1 || count.runs != 1)
+	{
+		printf("  default F1 + Up with a new F1 mask sent buttons %04x, expected Home only\n", gamepad.state.buttons);
+		return false;
+	}
+
+	// A full registry refuses more, and an empty chord is refused
+	GamepadHotkeys hotkeys;
+	for (uint8_t i = 0; i < GAMEPAD_HOTKEY_COUNT; i++)
+		hotkeys.add(GAMEPAD_MASK_B1, 0, HOTKEY_CAPTURE_BUTTON);
+
+	if (hotkeys.add(GAMEPAD_MASK_B2, 0, HOTKEY_CAPTURE_BUTTON) != GAMEPAD_HOTKEY_NONE
+		|| GamepadHotkeys().add(0, 0, HOTKEY_CAPTURE_BUTTON) != GAMEPAD_HOTKEY_NONE)
+	{
+		printf("  added past GAMEPAD_HOTKEY_COUNT or an empty chord\n");
+		return false;
+	}
+
+	return true;
+}
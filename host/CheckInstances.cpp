@@ -0,0 +1,194 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies that gamepad instances share no state: several gamepads run interleaved on one thread, or sharded across
+ * threads, produce exactly the reports each one produces on its own. The mashing input holds F1 and F2 often, so
+ * the hotkeys, SOCD cleaning and option toggles are all exercised.
+ */
+
+#include <string.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "BenchGamepad.h"
+#include "MPGS.h"
+
+static const size_t instanceFrames = 4000;
+
+static uint32_t hashReport(const void *report, uint16_t size)
+{
+	const uint8_t *bytes = static_cast<const uint8_t *>(report);
+	uint32_t hash = 2166136261U;
+	for (uint16_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 16777619U;
+
+	return hash;
+}
+
+static std::unique_ptr<BenchGamepad> makeGamepad(int index)
+{
+	std::unique_ptr<BenchGamepad> gamepad(new BenchGamepad());
+	gamepad->load(generateInputMix(INPUT_MIX_MASHING, 1024, 100 + index));
+	gamepad->options.inputMode = static_cast<InputMode>(index % 3);
+	gamepad->options.socdMode = SOCD_MODE_SECOND_INPUT_PRIORITY;
+	return gamepad;
+}
+
+// Run frames round robin over the gamepads, one clock tick per round, and hash every report
+static std::vector<std::vector<uint32_t>> runRoundRobin(std::vector<std::unique_ptr<BenchGamepad>> &gamepads)
+{
+	std::vector<std::vector<uint32_t>> hashes(gamepads.size());
+	hostMillis = 1000;
+	for (size_t frame = 0; frame < instanceFrames; frame++)
+	{
+		for (size_t i = 0; i < gamepads.size(); i++)
+		{
+			void *report = gamepads[i]->update();
+			hashes[i].push_back(hashReport(report, gamepads[i]->getReportSize()));
+		}
+		hostMillis++;
+	}
+
+	return hashes;
+}
+
+static std::vector<uint32_t> runAlone(int index)
+{
+	std::vector<std::unique_ptr<BenchGamepad>> gamepads;
+	gamepads.push_back(makeGamepad(index));
+	return runRoundRobin(gamepads)[0];
+}
+
+static bool compareHashes(const char *name, int index, const std::vector<uint32_t> &actual, const std::vector<uint32_t> &expected)
+{
+	for (size_t frame = 0; frame < expected.size(); frame++)
+	{
+		if (actual[frame] != expected[frame])
+		{
+			printf("  %s: gamepad %d report differs from running alone at frame %zu\n", name, index, frame);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("instances/interleaved")
+{
+	const int count = 6;
+	std::vector<std::unique_ptr<BenchGamepad>> gamepads;
+	for (int i = 0; i < count; i++)
+		gamepads.push_back(makeGamepad(i));
+
+	std::vector<std::vector<uint32_t>> hashes = runRoundRobin(gamepads);
+
+	bool ok = true;
+	for (int i = 0; i < count; i++)
+		ok &= compareHashes("interleaved", i, hashes[i], runAlone(i));
+
+	return ok;
+}
+
+CHECK_CASE("instances/threads")
+{
+	const int count = 16;
+	const int threadCount = 4;
+	std::vector<std::vector<std::unique_ptr<BenchGamepad>>> shards(threadCount);
+	for (int i = 0; i < count; i++)
+		shards[i % threadCount].push_back(makeGamepad(i));
+
+	// Each thread runs its shard on its own virtual clock
+	std::vector<std::vector<std::vector<uint32_t>>> results(threadCount);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; t++)
+		threads.emplace_back([&, t]() { results[t] = runRoundRobin(shards[t]); });
+
+	for (std::thread &thread : threads)
+		thread.join();
+
+	bool ok = true;
+	for (int i = 0; i < count; i++)
+		ok &= compareHashes("threads", i, results[i % threadCount][i / threadCount], runAlone(i));
+
+	return ok;
+}
+
+CHECK_CASE("instances/hotkey")
+{
+	// One gamepad holds the invert Y hotkey while another is idle, which must not retrigger the toggle
+	BenchGamepad held;
+	BenchGamepad idle;
+	GamepadState press;
+	press.buttons = GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3;
+	press.dpad = GAMEPAD_MASK_RIGHT;
+	held.load(std::vector<GamepadState>(1, press));
+
+	hostMillis = 1000;
+	for (int i = 0; i < 50; i++)
+	{
+		held.update();
+		idle.update();
+		hostMillis++;
+	}
+
+	if (!held.options.invertYAxis || idle.options.invertYAxis)
+	{
+		printf("  invert Y is %d on the held gamepad and %d on the idle one, expected 1 and 0\n",
+			held.options.invertYAxis, idle.options.invertYAxis);
+		return false;
+	}
+
+	return true;
+}
+
+class MemoryStorageGamepad : public MPGS
+{
+	public:
+		MemoryStorageGamepad() : MPGS(5, &memory) { }
+
+		void setup() override { }
+		void read() override { state.buttons = buttons; state.dpad = dpad; }
+
+		GamepadMemoryStorage memory;
+		uint16_t buttons {0};
+		uint8_t dpad {0};
+};
+
+CHECK_CASE("instances/storage")
+{
+	MemoryStorageGamepad first;
+	MemoryStorageGamepad second;
+	first.load();
+	second.load();
+
+	// Switch the first gamepad to up priority, then release the hotkey so the change saves
+	first.buttons = GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3;
+	first.dpad = GAMEPAD_MASK_UP;
+	hostMillis = 1000;
+	for (int i = 0; i < 20; i++)
+	{
+		if (i == 10)
+			first.buttons = first.dpad = 0;
+
+		first.update();
+		second.update();
+		hostMillis++;
+	}
+
+	if (first.memory.getGamepadOptions().socdMode != SOCD_MODE_UP_PRIORITY
+		|| second.memory.getGamepadOptions().socdMode != SOCD_MODE_NEUTRAL
+		|| second.options.socdMode != SOCD_MODE_NEUTRAL)
+	{
+		printf("  saved SOCD modes %d and %d, expected %d and %d\n", first.memory.getGamepadOptions().socdMode,
+			second.memory.getGamepadOptions().socdMode, SOCD_MODE_UP_PRIORITY, SOCD_MODE_NEUTRAL);
+		return false;
+	}
+
+	return true;
+}
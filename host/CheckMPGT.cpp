@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies that the statically dispatched MPGT produces byte-identical reports to MPG for every input mode.
+ */
+
+#include <string.h>
+
+#include "Check.h"
+#include "BenchGamepad.h"
+
+template <int Mode>
+static bool compareReports(InputMix mix, DpadMode dpadMode, SOCDMode socdMode)
+{
+	const size_t frameCount = 20000;
+	std::vector<GamepadState> frames = generateInputMix(mix, frameCount, 7);
+
+	BenchGamepad dynamicGamepad;
+	BenchStaticGamepad<Mode> staticGamepad;
+	dynamicGamepad.load(frames);
+	staticGamepad.load(frames);
+
+	dynamicGamepad.options.inputMode = (Mode == INPUT_MODE_RUNTIME) ? INPUT_MODE_SWITCH : static_cast<InputMode>(Mode);
+	staticGamepad.options.inputMode = dynamicGamepad.options.inputMode;
+
+	for (MPGCore *core : { static_cast<MPGCore *>(&dynamicGamepad), static_cast<MPGCore *>(&staticGamepad) })
+	{
+		core->options.dpadMode = dpadMode;
+		core->options.socdMode = socdMode;
+		core->hasAnalogTriggers = (mix == INPUT_MIX_ANALOG);
+		core->hasLeftAnalogStick = (mix == INPUT_MIX_ANALOG);
+	}
+
+	hostMillis = 1000;
+	for (size_t i = 0; i < frameCount; i++)
+	{
+		hostMillis += (i & 1);
+
+		dynamicGamepad.read();
+		dynamicGamepad.debounce();
+		dynamicGamepad.hotkey();
+		dynamicGamepad.process();
+		const void *expected = dynamicGamepad.getReport();
+		uint16_t size = dynamicGamepad.getReportSize();
+
+		const void *actual = staticGamepad.update();
+
+		if (size != staticGamepad.getReportSize() || memcmp(expected, actual, size) != 0)
+		{
+			printf("  mode %d, mix %s: report mismatch at frame %zu\n", Mode, inputMixName(mix), i);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template <int Mode>
+static bool compareAllMixes()
+{
+	bool ok = true;
+	for (int mix = 0; mix < INPUT_MIX_COUNT; mix++)
+	{
+		ok &= compareReports<Mode>(static_cast<InputMix>(mix), DPAD_MODE_DIGITAL, SOCD_MODE_NEUTRAL);
+		ok &= compareReports<Mode>(static_cast<InputMix>(mix), DPAD_MODE_LEFT_ANALOG, SOCD_MODE_SECOND_INPUT_PRIORITY);
+		ok &= compareReports<Mode>(static_cast<InputMix>(mix), DPAD_MODE_RIGHT_ANALOG, SOCD_MODE_UP_PRIORITY);
+	}
+
+	return ok;
+}
+
+CHECK_CASE("mpgt/xinput-matches-mpg")  { return compareAllMixes<INPUT_MODE_XINPUT>(); }
+CHECK_CASE("mpgt/switch-matches-mpg")  { return compareAllMixes<INPUT_MODE_SWITCH>(); }
+CHECK_CASE("mpgt/hid-matches-mpg")     { return compareAllMixes<INPUT_MODE_HID>(); }
+CHECK_CASE("mpgt/runtime-matches-mpg") { return compareAllMixes<INPUT_MODE_RUNTIME>(); }
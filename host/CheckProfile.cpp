@@ -0,0 +1,203 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies GamepadProfiler bucketing and statistics against exact values. When built with GAMEPAD_PROFILE=1 (the
+ * MPGCheckProfile target) it also checks that every pipeline stage is recorded once per frame.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "Check.h"
+#include "BenchGamepad.h"
+#include "GamepadProfiler.h"
+
+static uint32_t exactPercentile(std::vector<uint32_t> values, uint8_t percent)
+{
+	std::sort(values.begin(), values.end());
+	size_t rank = (values.size() * percent + 99) / 100;
+	return values[rank - 1];
+}
+
+CHECK_CASE("profile/buckets")
+{
+	bool ok = true;
+	for (uint32_t bucket = 1; bucket < GAMEPAD_PROFILE_BUCKETS - 1; bucket++)
+	{
+		uint32_t low = 1UL << (bucket - 1);
+		uint32_t high = (1UL << bucket) - 1;
+		if (GamepadProfiler::getBucket(low) != bucket || GamepadProfiler::getBucket(high) != bucket)
+		{
+			printf("  bucket %u does not hold [%u, %u]\n", bucket, low, high);
+			ok = false;
+		}
+	}
+
+	ok &= GamepadProfiler::getBucket(0) == 0;
+	ok &= GamepadProfiler::getBucket(UINT32_MAX) == GAMEPAD_PROFILE_BUCKETS - 1;
+	return ok;
+}
+
+CHECK_CASE("profile/stats")
+{
+	GamepadProfiler profiler;
+	std::vector<uint32_t> values;
+	uint32_t seed = 12345;
+	for (int i = 0; i < 5000; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		uint32_t cycles = 20 + ((seed >> 8) % 400);
+		if ((i % 97) == 0)
+			cycles += 100000; // Occasional outlier, e.g. an interrupt landing mid-stage
+		values.push_back(cycles);
+		profiler.record(GAMEPAD_STAGE_PROCESS, cycles);
+	}
+
+	GamepadProfileStats stats = profiler.getStats(GAMEPAD_STAGE_PROCESS);
+	uint32_t min = *std::min_element(values.begin(), values.end());
+	uint32_t max = *std::max_element(values.begin(), values.end());
+	uint32_t p50 = exactPercentile(values, 50);
+	uint32_t p99 = exactPercentile(values, 99);
+
+	// Percentiles are bucket upper bounds, so they may be up to twice the exact value but never below it
+	bool ok = stats.count == values.size() && stats.min == min && stats.max == max
+		&& stats.p50 >= p50 && stats.p50 <= p50 * 2
+		&& stats.p99 >= p99 && stats.p99 <= p99 * 2;
+
+	if (!ok)
+	{
+		printf("  count %u min %u p50 %u p99 %u max %u, expected %zu %u ~%u ~%u %u\n",
+			stats.count, stats.min, stats.p50, stats.p99, stats.max, values.size(), min, p50, p99, max);
+	}
+
+	if (profiler.getStats(GAMEPAD_STAGE_READ).count != 0)
+	{
+		printf("  samples leaked into another stage\n");
+		ok = false;
+	}
+
+	profiler.reset();
+	ok &= profiler.getStats(GAMEPAD_STAGE_PROCESS).count == 0;
+	return ok;
+}
+
+// Percentiles must not drift once the 16-bit buckets fill up, e.g. after an hour of frames at 1 kHz
+CHECK_CASE("profile/long-run")
+{
+	GamepadProfiler profiler;
+	GamepadProfileStats early {};
+	const uint32_t frameCount = 3600000;
+	for (uint32_t i = 1; i <= frameCount; i++)
+	{
+		profiler.record(GAMEPAD_STAGE_PROCESS, (i % 200) == 0 ? 600 : 40);
+		if (i == 60000)
+			early = profiler.getStats(GAMEPAD_STAGE_PROCESS);
+	}
+
+	GamepadProfileStats late = profiler.getStats(GAMEPAD_STAGE_PROCESS);
+	bool ok = early.p50 == 63 && early.p99 == 63 && late.p50 == early.p50 && late.p99 == early.p99
+		&& late.count == frameCount && late.min == 40 && late.max == 600;
+
+	if (!ok)
+	{
+		printf("  after %u frames p50 %u p99 %u, after %u frames count %u min %u p50 %u p99 %u max %u\n",
+			60000, early.p50, early.p99, frameCount, late.count, late.min, late.p50, late.p99, late.max);
+	}
+
+	return ok;
+}
+
+CHECK_CASE("profile/recent")
+{
+	GamepadProfiler profiler;
+	bool ok = profiler.getRecent(0).stage == GAMEPAD_STAGE_COUNT;
+
+	for (uint32_t i = 0; i < GAMEPAD_PROFILE_RING_SIZE + 3; i++)
+		profiler.record(static_cast<GamepadStage>(i % GAMEPAD_STAGE_COUNT), i * 10);
+
+	for (uint32_t offset = 0; offset < GAMEPAD_PROFILE_RING_SIZE; offset++)
+	{
+		uint32_t i = GAMEPAD_PROFILE_RING_SIZE + 2 - offset;
+		GamepadProfileSample sample = profiler.getRecent(offset);
+		if (sample.stage != i % GAMEPAD_STAGE_COUNT || sample.cycles != i * 10)
+		{
+			printf("  recent %u is stage %u, %u cycles\n", offset, sample.stage, sample.cycles);
+			ok = false;
+		}
+	}
+
+	profiler.record(GAMEPAD_STAGE_READ, UINT32_MAX);
+	ok &= profiler.getRecent(0).cycles == GAMEPAD_PROFILE_SAMPLE_MAX;
+	ok &= profiler.getStats(GAMEPAD_STAGE_READ).max == UINT32_MAX;
+	return ok;
+}
+
+static std::string dumped;
+
+static void dumpLine(const char *line)
+{
+	dumped += line;
+	dumped += '\n';
+}
+
+CHECK_CASE("profile/dump")
+{
+	GamepadProfiler profiler;
+	profiler.record(GAMEPAD_STAGE_HOTKEY, 7);
+	profiler.record(GAMEPAD_STAGE_REPORT, 300);
+
+	dumped.clear();
+	profiler.dump(dumpLine);
+
+	bool ok = dumped.find("hotkey 1 7 7 7 7\n") != std::string::npos
+		&& dumped.find("report 1 300 300 300 300\n") != std::string::npos
+		&& dumped.find("read 0 0 0 0 0\n") != std::string::npos
+		&& dumped.find("recent\nhotkey 7\nreport 300\n") != std::string::npos;
+
+	if (!ok)
+		printf("%s", dumped.c_str());
+
+	return ok;
+}
+
+#if GAMEPAD_PROFILE
+
+template <class Gamepad>
+static bool checkStages(const char *name)
+{
+	const uint32_t frameCount = 2000;
+	Gamepad gamepad;
+	gamepad.load(generateInputMix(INPUT_MIX_MASHING, frameCount));
+	gamepad.profiler.begin();
+	hostMillis = 1000;
+
+	for (uint32_t i = 0; i < frameCount; i++)
+	{
+		hostMillis++;
+		gamepad.update();
+	}
+
+	bool ok = true;
+	for (uint8_t stage = 0; stage < GAMEPAD_STAGE_COUNT; stage++)
+	{
+		GamepadProfileStats stats = gamepad.profiler.getStats(static_cast<GamepadStage>(stage));
+		if (stats.count != frameCount || stats.min > stats.p50 || stats.p50 > stats.p99 || stats.p99 > stats.max)
+		{
+			printf("  %s %s: count %u min %u p50 %u p99 %u max %u\n", name, getGamepadStageName(static_cast<GamepadStage>(stage)),
+				stats.count, stats.min, stats.p50, stats.p99, stats.max);
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+CHECK_CASE("profile/stages-mpg")  { return checkStages<BenchGamepad>("mpg"); }
+CHECK_CASE("profile/stages-mpgt") { return checkStages<BenchStaticGamepad<INPUT_MODE_XINPUT>>("mpgt"); }
+
+#endif
@@ -0,0 +1,167 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies analog keys: rapid trigger releases and presses again on small moves anywhere in the travel, a fixed
+ * actuation point keeps its hysteresis, each key keeps its own settings, and the keys the stage drives skip the
+ * debouncer while the others still go through it.
+ */
+
+#include "Check.h"
+#include "BenchGamepad.h"
+#include "GamepadTravelSynth.h"
+
+// Percent of full travel
+static uint16_t travel(uint32_t percent)
+{
+	return static_cast<uint16_t>(percent * GAMEPAD_TRAVEL_FULL / 100);
+}
+
+// Move key 0 through the given travel percentages and compare the output at each step
+static bool checkSteps(GamepadRapidTrigger &trigger, const uint32_t *steps, const char *expected)
+{
+	for (uint32_t i = 0; expected[i]; i++)
+	{
+		trigger.travel[0] = travel(steps[i]);
+		GamepadState state;
+		trigger.read(state);
+		if ((state.buttons & GAMEPAD_MASK_B1) != (expected[i] == '1' ? GAMEPAD_MASK_B1 : 0))
+		{
+			printf("  step %u at %u%% travel: B1 is %s, expected %c (%s)\n", i, steps[i],
+				(state.buttons & GAMEPAD_MASK_B1) ? "pressed" : "released", expected[i], expected);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("rapid/trigger")
+{
+	GamepadRapidTrigger trigger;
+	GamepadKeyConfig config;
+	config.actuation = travel(20);
+	config.pressSensitivity = travel(10);
+	config.releaseSensitivity = travel(5);
+	trigger.configure(0, config);
+
+	// Press at actuation from rest, release 5% up from the deepest point, press again 10% down from the highest,
+	// and always released short of actuation
+	const uint32_t steps[] = { 0, 15, 20, 60, 90, 86, 84, 80, 85, 90, 91, 70, 75, 79, 80, 30, 19, 21, 22 };
+	return checkSteps(trigger, steps, "0011110001100010011");
+}
+
+CHECK_CASE("rapid/fixed")
+{
+	GamepadRapidTrigger trigger;
+	GamepadKeyConfig config;
+	config.actuation = travel(50);
+	config.releaseSensitivity = travel(5);
+	config.rapid = false;
+	trigger.configure(0, config);
+
+	const uint32_t steps[] = { 0, 49, 50, 100, 60, 46, 44, 49, 50 };
+	return checkSteps(trigger, steps, "001111001");
+}
+
+CHECK_CASE("rapid/keys")
+{
+	// Only B2 and D-pad left are analog, and B2 is twice as sensitive
+	GamepadRapidTrigger trigger((1UL << 1) | (1UL << GAMEPAD_KEY_LEFT));
+	GamepadKeyConfig config;
+	trigger.configure(0xFF, config);
+	config.releaseSensitivity = travel(2);
+	trigger.configure(1, config);
+
+	GamepadState state;
+	state.buttons = GAMEPAD_MASK_B1;
+	state.dpad = GAMEPAD_MASK_UP;
+	trigger.travel[0] = travel(100);
+	trigger.travel[1] = travel(100);
+	trigger.travel[GAMEPAD_KEY_LEFT] = travel(100);
+	trigger.read(state);
+	if (state.buttons != (GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2) || state.dpad != (GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT))
+	{
+		printf("  pressed buttons %04x and D-pad %x, expected %04x and %x\n", state.buttons, state.dpad,
+			GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2, GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT);
+		return false;
+	}
+
+	trigger.travel[1] = travel(97);
+	trigger.travel[GAMEPAD_KEY_LEFT] = travel(97);
+	trigger.read(state);
+	if (state.buttons != GAMEPAD_MASK_B1 || state.dpad != (GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT))
+	{
+		printf("  3%% up released buttons %04x and D-pad %x, expected only B2 released\n", state.buttons, state.dpad);
+		return false;
+	}
+
+	return true;
+}
+
+CHECK_CASE("rapid/debounce")
+{
+	// B1 is analog and re-pressed 1 ms after its release, B2 is a switch bouncing at the same time
+	GamepadRapidTrigger trigger(1);
+	BenchGamepad gamepad(5);
+	gamepad.rapidTrigger = &trigger;
+	gamepad.options.inputMode = INPUT_MODE_HID;
+
+	const struct { uint32_t travel; uint16_t buttons; uint16_t expected; } frames[] =
+	{
+		{ 100, GAMEPAD_MASK_B2, GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2 },
+		{  90, 0,               GAMEPAD_MASK_B2 },
+		{ 100, GAMEPAD_MASK_B2, GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2 },
+		{  90, 0,               GAMEPAD_MASK_B2 },
+	};
+
+	hostMillis = 1000;
+	for (const auto &frame : frames)
+	{
+		hostMillis++;
+		trigger.travel[0] = travel(frame.travel);
+		gamepad.state.buttons = frame.buttons;
+		gamepad.debounce();
+		if (gamepad.state.buttons != frame.expected)
+		{
+			printf("  at %u ms buttons are %04x, expected %04x\n", hostMillis, gamepad.state.buttons, frame.expected);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("rapid/latency")
+{
+	// Releases faster than a fixed actuation point and catches the shallow trills it misses, without chattering
+	GamepadKeyConfig fixed;
+	fixed.actuation = travel(50);
+	fixed.releaseSensitivity = 0;
+	fixed.rapid = false;
+	GamepadKeyConfig rapid;
+
+	TravelScript taps = TravelScript::taps(10000, 20, 30000);
+	TravelScript trills = TravelScript::trills(10000, 20, 0.7, 15000);
+	TravelMeasurement fixedTaps = measureTravel(taps, fixed, 5, 100, 0.005);
+	TravelMeasurement rapidTaps = measureTravel(taps, rapid, 0, 100, 0.005);
+	TravelMeasurement fixedTrills = measureTravel(trills, fixed, 5, 100, 0.005);
+	TravelMeasurement rapidTrills = measureTravel(trills, rapid, 0, 100, 0.005);
+
+	bool ok = rapidTaps.releaseMeanUs * 4 < fixedTaps.releaseMeanUs
+		&& rapidTaps.pressMeanUs < fixedTaps.pressMeanUs
+		&& rapidTaps.missed == 0 && rapidTaps.extra == 0
+		&& rapidTrills.missed == 0 && rapidTrills.extra == 0
+		&& fixedTrills.missed > 0;
+
+	if (!ok)
+	{
+		printf("  taps: release %.0f us fixed, %.0f us rapid, rapid missed %u, extra %u\n", fixedTaps.releaseMeanUs,
+			rapidTaps.releaseMeanUs, rapidTaps.missed, rapidTaps.extra);
+		printf("  trills: fixed missed %u, rapid missed %u, extra %u\n", fixedTrills.missed, rapidTrills.missed, rapidTrills.extra);
+	}
+
+	return ok;
+}
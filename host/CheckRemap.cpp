@@ -0,0 +1,168 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies the remap tables against mapping each key in turn on every input, that the pipeline sends and runs hotkeys
+ * on the logical inputs, and that MPGS saves and loads the map.
+ */
+
+#include <stdlib.h>
+
+#include "Check.h"
+#include "BenchGamepad.h"
+#include "MPGS.h"
+
+// Map one key at a time, the way a board would patch its read()
+static void referenceRemap(const uint32_t *map, GamepadState &state)
+{
+	uint32_t keys = gamepadKeys(state.buttons, state.dpad);
+	uint32_t mapped = 0;
+	for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+	{
+		if (keys & (1UL << key))
+			mapped |= map[key];
+	}
+
+	state.buttons = mapped & GAMEPAD_KEY_BUTTONS;
+	state.dpad = (state.dpad & ~GAMEPAD_MASK_DPAD) | ((mapped >> GAMEPAD_BUTTON_COUNT) & GAMEPAD_MASK_DPAD);
+}
+
+static bool checkEveryInput(const GamepadRemap &remap, const char *name)
+{
+	for (uint32_t keys = 0; keys <= GAMEPAD_KEY_ALL; keys++)
+	{
+		// Bits above the D-pad are not inputs and pass through
+		GamepadState state;
+		state.buttons = keys & GAMEPAD_KEY_BUTTONS;
+		state.dpad = (keys >> GAMEPAD_BUTTON_COUNT) | ((keys & 1) << 6);
+
+		GamepadState expected = state;
+		referenceRemap(remap.getMap(), expected);
+		remap.update(state);
+		if (state.buttons != expected.buttons || state.dpad != expected.dpad)
+		{
+			printf("  %s: keys %05x gave buttons %04x D-pad %02x, expected %04x and %02x\n", name, keys, state.buttons,
+				state.dpad, expected.buttons, expected.dpad);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("remap/tables")
+{
+	GamepadRemap remap;
+	bool ok = remap.isIdentity() && checkEveryInput(remap, "identity");
+
+	// Swaps, one key to several, several keys to one, keys switched off, and D-pad and buttons crossing over
+	remap.setButton(GAMEPAD_MASK_B1, GAMEPAD_MASK_B2);
+	remap.setButton(GAMEPAD_MASK_B2, GAMEPAD_MASK_B1);
+	remap.setButton(GAMEPAD_MASK_A2, GAMEPAD_MASK_L1 | GAMEPAD_MASK_R1, GAMEPAD_MASK_DOWN);
+	remap.setButton(GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3, GAMEPAD_MASK_S2);
+	remap.setButton(GAMEPAD_MASK_A1, 0);
+	remap.setDpad(GAMEPAD_MASK_UP, GAMEPAD_MASK_B3);
+	remap.setDpad(GAMEPAD_MASK_RIGHT, GAMEPAD_MASK_R2, GAMEPAD_MASK_LEFT);
+	ok &= !remap.isIdentity() && remap.getKey(GAMEPAD_KEY_UP) == GAMEPAD_MASK_B3 && checkEveryInput(remap, "edited");
+
+	srand(22);
+	for (int n = 0; n < 8 && ok; n++)
+	{
+		uint32_t map[GAMEPAD_DIGITAL_INPUT_COUNT];
+		for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+			map[key] = static_cast<uint32_t>(rand()) & ((n % 2) ? GAMEPAD_KEY_ALL : (1UL << (rand() % 20)));
+
+		remap.setMap(map);
+		ok &= checkEveryInput(remap, "random");
+	}
+
+	// Going back to the identity
+	uint16_t revision = remap.getRevision();
+	remap.reset();
+	ok &= remap.isIdentity() && remap.getRevision() != revision && checkEveryInput(remap, "reset");
+	return ok;
+}
+
+CHECK_CASE("remap/pipeline")
+{
+	GamepadRemap remap;
+	remap.setButton(GAMEPAD_MASK_B1, GAMEPAD_MASK_B2);
+	remap.setButton(GAMEPAD_MASK_A2, GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2);
+	remap.setDpad(GAMEPAD_MASK_LEFT, GAMEPAD_MASK_B4);
+
+	BenchGamepad gamepad(5);
+	gamepad.remap = &remap;
+	gamepad.options.inputMode = INPUT_MODE_HID;
+	bool ok = true;
+
+	hostMillis = 1000;
+	gamepad.frames[0].buttons = GAMEPAD_MASK_B1;
+	gamepad.frames[0].dpad = GAMEPAD_MASK_LEFT;
+	gamepad.update();
+	if (gamepad.state.buttons != (GAMEPAD_MASK_B2 | GAMEPAD_MASK_B4) || gamepad.state.dpad != 0)
+	{
+		ok = false;
+		printf("  B1 and Left sent buttons %04x D-pad %x, expected B2 and B4\n", gamepad.state.buttons, gamepad.state.dpad);
+	}
+
+	// Hotkeys see the logical inputs: A2 is F1, so A2 and Up is Home
+	gamepad.frames[0].buttons = GAMEPAD_MASK_A2;
+	gamepad.frames[0].dpad = GAMEPAD_MASK_UP;
+	hostMillis += 10;
+	gamepad.update();
+	if (gamepad.state.buttons != GAMEPAD_MASK_A1 || gamepad.state.dpad != 0)
+	{
+		printf("  A2 and Up sent buttons %04x D-pad %x, expected Home\n", gamepad.state.buttons, gamepad.state.dpad);
+		ok = false;
+	}
+
+	return ok;
+}
+
+class RemapGamepad : public MPGS
+{
+	public:
+		RemapGamepad(GamepadStorage *storage) : MPGS(5, storage) { }
+
+		void setup() override { }
+		void read() override { }
+};
+
+CHECK_CASE("remap/storage")
+{
+	GamepadMemoryStorage storage;
+	GamepadRemap remap;
+	RemapGamepad gamepad(&storage);
+	gamepad.remap = &remap;
+	gamepad.load();
+	hostMillis = 1000;
+
+	// A map changed in code waits for the sketch to save it, then is saved on the next frame
+	uint32_t map[GAMEPAD_DIGITAL_INPUT_COUNT];
+	remap.setButton(GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2, GAMEPAD_MASK_B3);
+	gamepad.hotkey();
+	bool ok = !storage.getRemap(map) && !gamepad.isSaving();
+
+	gamepad.requestSave();
+	gamepad.hotkey();
+	gamepad.hotkey();
+	ok &= storage.getRemap(map) && map[0] == GAMEPAD_MASK_B3 && map[1] == GAMEPAD_MASK_B3 && map[2] == GAMEPAD_MASK_B3;
+
+	// A gamepad starting on the same storage loads it
+	GamepadRemap loaded;
+	RemapGamepad next(&storage);
+	next.remap = &loaded;
+	next.load();
+	for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+		ok &= loaded.getKey(key) == remap.getKey(key);
+
+	// And loading does not count as a change to save
+	next.hotkey();
+	ok &= !next.isSaving();
+	if (!ok)
+		printf("  the map did not round trip through storage\n");
+
+	return ok;
+}
@@ -0,0 +1,187 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies the table-driven report conversion against the original per-button conversion for every combination of
+ * buttons and D-pad inputs.
+ */
+
+#include <string.h>
+
+#include "Check.h"
+#include "BenchGamepad.h"
+
+// Exposes the report conversion of MPGCore
+class ReportGamepad : public BenchGamepad
+{
+	public:
+		using MPGCore::fillHIDReport;
+		using MPGCore::fillSwitchReport;
+		using MPGCore::fillXInputReport;
+};
+
+static uint8_t legacyHat(uint8_t dpad)
+{
+	switch (dpad & GAMEPAD_MASK_DPAD)
+	{
+		case GAMEPAD_MASK_UP:                        return HID_HAT_UP;
+		case GAMEPAD_MASK_UP | GAMEPAD_MASK_RIGHT:   return HID_HAT_UPRIGHT;
+		case GAMEPAD_MASK_RIGHT:                     return HID_HAT_RIGHT;
+		case GAMEPAD_MASK_DOWN | GAMEPAD_MASK_RIGHT: return HID_HAT_DOWNRIGHT;
+		case GAMEPAD_MASK_DOWN:                      return HID_HAT_DOWN;
+		case GAMEPAD_MASK_DOWN | GAMEPAD_MASK_LEFT:  return HID_HAT_DOWNLEFT;
+		case GAMEPAD_MASK_LEFT:                      return HID_HAT_LEFT;
+		case GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT:    return HID_HAT_UPLEFT;
+		default:                                     return HID_HAT_NOTHING;
+	}
+}
+
+static void legacyHIDReport(MPGCore &g, HIDReport *report)
+{
+	report->hat = legacyHat(g.state.dpad);
+	report->buttons = 0
+		| (g.pressedB1() ? HID_MASK_CROSS    : 0)
+		| (g.pressedB2() ? HID_MASK_CIRCLE   : 0)
+		| (g.pressedB3() ? HID_MASK_SQUARE   : 0)
+		| (g.pressedB4() ? HID_MASK_TRIANGLE : 0)
+		| (g.pressedL1() ? HID_MASK_L1       : 0)
+		| (g.pressedR1() ? HID_MASK_R1       : 0)
+		| (g.pressedL2() ? HID_MASK_L2       : 0)
+		| (g.pressedR2() ? HID_MASK_R2       : 0)
+		| (g.pressedS1() ? HID_MASK_SELECT   : 0)
+		| (g.pressedS2() ? HID_MASK_START    : 0)
+		| (g.pressedL3() ? HID_MASK_L3       : 0)
+		| (g.pressedR3() ? HID_MASK_R3       : 0)
+		| (g.pressedA1() ? HID_MASK_PS       : 0)
+		| (g.pressedA2() ? HID_MASK_TP       : 0)
+	;
+	report->lx = static_cast<uint8_t>(g.state.lx >> 8);
+	report->ly = static_cast<uint8_t>(g.state.ly >> 8);
+	report->rx = static_cast<uint8_t>(g.state.rx >> 8);
+	report->ry = static_cast<uint8_t>(g.state.ry >> 8);
+}
+
+static void legacySwitchReport(MPGCore &g, SwitchReport *report)
+{
+	report->hat = legacyHat(g.state.dpad);
+	report->buttons = 0
+		| (g.pressedB1() ? SWITCH_MASK_B       : 0)
+		| (g.pressedB2() ? SWITCH_MASK_A       : 0)
+		| (g.pressedB3() ? SWITCH_MASK_Y       : 0)
+		| (g.pressedB4() ? SWITCH_MASK_X       : 0)
+		| (g.pressedL1() ? SWITCH_MASK_L       : 0)
+		| (g.pressedR1() ? SWITCH_MASK_R       : 0)
+		| (g.pressedL2() ? SWITCH_MASK_ZL      : 0)
+		| (g.pressedR2() ? SWITCH_MASK_ZR      : 0)
+		| (g.pressedS1() ? SWITCH_MASK_MINUS   : 0)
+		| (g.pressedS2() ? SWITCH_MASK_PLUS    : 0)
+		| (g.pressedL3() ? SWITCH_MASK_L3      : 0)
+		| (g.pressedR3() ? SWITCH_MASK_R3      : 0)
+		| (g.pressedA1() ? SWITCH_MASK_HOME    : 0)
+		| (g.pressedA2() ? SWITCH_MASK_CAPTURE : 0)
+	;
+	report->lx = static_cast<uint8_t>(g.state.lx >> 8);
+	report->ly = static_cast<uint8_t>(g.state.ly >> 8);
+	report->rx = static_cast<uint8_t>(g.state.rx >> 8);
+	report->ry = static_cast<uint8_t>(g.state.ry >> 8);
+	report->vendor = 0;
+}
+
+static void legacyXInputReport(MPGCore &g, XInputReport *report)
+{
+	report->report_id = 0;
+	report->report_size = XINPUT_ENDPOINT_SIZE;
+	report->buttons1 = 0
+		| (g.pressedUp()    ? XBOX_MASK_UP    : 0)
+		| (g.pressedDown()  ? XBOX_MASK_DOWN  : 0)
+		| (g.pressedLeft()  ? XBOX_MASK_LEFT  : 0)
+		| (g.pressedRight() ? XBOX_MASK_RIGHT : 0)
+		| (g.pressedS2()    ? XBOX_MASK_START : 0)
+		| (g.pressedS1()    ? XBOX_MASK_BACK  : 0)
+		| (g.pressedL3()    ? XBOX_MASK_LS    : 0)
+		| (g.pressedR3()    ? XBOX_MASK_RS    : 0)
+	;
+	report->buttons2 = 0
+		| (g.pressedL1() ? XBOX_MASK_LB   : 0)
+		| (g.pressedR1() ? XBOX_MASK_RB   : 0)
+		| (g.pressedA1() ? XBOX_MASK_HOME : 0)
+		| (g.pressedB1() ? XBOX_MASK_A    : 0)
+		| (g.pressedB2() ? XBOX_MASK_B    : 0)
+		| (g.pressedB3() ? XBOX_MASK_X    : 0)
+		| (g.pressedB4() ? XBOX_MASK_Y    : 0)
+	;
+	report->lx = static_cast<int16_t>(g.state.lx) + INT16_MIN;
+	report->ly = static_cast<int16_t>(~g.state.ly) + INT16_MIN;
+	report->rx = static_cast<int16_t>(g.state.rx) + INT16_MIN;
+	report->ry = static_cast<int16_t>(~g.state.ry) + INT16_MIN;
+	if (g.hasAnalogTriggers)
+	{
+		report->lt = g.state.lt;
+		report->rt = g.state.rt;
+	}
+	else
+	{
+		report->lt = g.pressedL2() ? 0xFF : 0;
+		report->rt = g.pressedR2() ? 0xFF : 0;
+	}
+}
+
+// Run every buttons/D-pad combination (with a few analog values) through both conversions
+template <typename Report, typename Fill, typename Legacy>
+static bool compareAll(const char *name, Fill fill, Legacy legacy)
+{
+	ReportGamepad gamepad;
+	Report expected, actual;
+
+	for (int analogTriggers = 0; analogTriggers < 2; analogTriggers++)
+	{
+		gamepad.hasAnalogTriggers = analogTriggers;
+		for (uint32_t buttons = 0; buttons < (1U << 16); buttons++)
+		{
+			for (uint8_t dpad = 0; dpad < 16; dpad++)
+			{
+				gamepad.state.buttons = buttons;
+				gamepad.state.dpad = dpad;
+				gamepad.state.lx = static_cast<uint16_t>(buttons * 7);
+				gamepad.state.ly = static_cast<uint16_t>(buttons * 13);
+				gamepad.state.rx = static_cast<uint16_t>(~buttons);
+				gamepad.state.ry = static_cast<uint16_t>(buttons << 3);
+				gamepad.state.lt = static_cast<uint8_t>(buttons);
+				gamepad.state.rt = dpad;
+
+				memset(&expected, 0xA5, sizeof(Report));
+				memset(&actual, 0xA5, sizeof(Report));
+				legacy(gamepad, &expected);
+				fill(gamepad, &actual);
+
+				if (memcmp(&expected, &actual, sizeof(Report)) != 0)
+				{
+					printf("  %s: mismatch for buttons 0x%04X, dpad 0x%X\n", name, buttons, dpad);
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("reports/hid-matches-legacy")
+{
+	return compareAll<HIDReport>("hid",
+		[](ReportGamepad &g, HIDReport *r) { g.fillHIDReport(r); }, legacyHIDReport);
+}
+
+CHECK_CASE("reports/switch-matches-legacy")
+{
+	return compareAll<SwitchReport>("switch",
+		[](ReportGamepad &g, SwitchReport *r) { g.fillSwitchReport(r); }, legacySwitchReport);
+}
+
+CHECK_CASE("reports/xinput-matches-legacy")
+{
+	return compareAll<XInputReport>("xinput",
+		[](ReportGamepad &g, XInputReport *r) { g.fillXInputReport(r); }, legacyXInputReport);
+}
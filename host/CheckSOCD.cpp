@@ -0,0 +1,251 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies the SOCD tables: the up priority, neutral and last input modes match the switch they replaced from every
+ * state on every D-pad value and over long random sequences, and the first input and custom axis policies resolve
+ * as documented.
+ */
+
+#include <stdlib.h>
+
+#include "Check.h"
+#include "GamepadSOCD.h"
+
+// runSOCDCleaner() before the tables
+struct LegacySOCD
+{
+	DpadDirection lastUD {DIRECTION_NONE};
+	DpadDirection lastLR {DIRECTION_NONE};
+
+	uint8_t run(SOCDMode mode, uint8_t dpad)
+	{
+		uint8_t newDpad = 0;
+
+		switch (dpad & (GAMEPAD_MASK_UP | GAMEPAD_MASK_DOWN))
+		{
+			case (GAMEPAD_MASK_UP | GAMEPAD_MASK_DOWN):
+				if (mode == SOCD_MODE_UP_PRIORITY)
+				{
+					newDpad |= GAMEPAD_MASK_UP;
+					lastUD = DIRECTION_UP;
+				}
+				else if (mode == SOCD_MODE_SECOND_INPUT_PRIORITY && lastUD != DIRECTION_NONE)
+					newDpad |= (lastUD == DIRECTION_UP) ? GAMEPAD_MASK_DOWN : GAMEPAD_MASK_UP;
+				else
+					lastUD = DIRECTION_NONE;
+				break;
+
+			case GAMEPAD_MASK_UP:
+				newDpad |= GAMEPAD_MASK_UP;
+				lastUD = DIRECTION_UP;
+				break;
+
+			case GAMEPAD_MASK_DOWN:
+				newDpad |= GAMEPAD_MASK_DOWN;
+				lastUD = DIRECTION_DOWN;
+				break;
+
+			default:
+				lastUD = DIRECTION_NONE;
+				break;
+		}
+
+		switch (dpad & (GAMEPAD_MASK_LEFT | GAMEPAD_MASK_RIGHT))
+		{
+			case (GAMEPAD_MASK_LEFT | GAMEPAD_MASK_RIGHT):
+				if (mode == SOCD_MODE_SECOND_INPUT_PRIORITY && lastLR != DIRECTION_NONE)
+					newDpad |= (lastLR == DIRECTION_LEFT) ? GAMEPAD_MASK_RIGHT : GAMEPAD_MASK_LEFT;
+				else
+					lastLR = DIRECTION_NONE;
+				break;
+
+			case GAMEPAD_MASK_LEFT:
+				newDpad |= GAMEPAD_MASK_LEFT;
+				lastLR = DIRECTION_LEFT;
+				break;
+
+			case GAMEPAD_MASK_RIGHT:
+				newDpad |= GAMEPAD_MASK_RIGHT;
+				lastLR = DIRECTION_RIGHT;
+				break;
+
+			default:
+				lastLR = DIRECTION_NONE;
+				break;
+		}
+
+		return newDpad;
+	}
+};
+
+static const SOCDMode legacyModes[] = { SOCD_MODE_UP_PRIORITY, SOCD_MODE_NEUTRAL, SOCD_MODE_SECOND_INPUT_PRIORITY };
+
+// The D-pad values leaving each axis with nothing, its first direction or its second direction held last
+static const uint8_t primes[] =
+{
+	0,
+	GAMEPAD_MASK_UP,
+	GAMEPAD_MASK_DOWN,
+	GAMEPAD_MASK_LEFT,
+	GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT,
+	GAMEPAD_MASK_DOWN | GAMEPAD_MASK_LEFT,
+	GAMEPAD_MASK_RIGHT,
+	GAMEPAD_MASK_UP | GAMEPAD_MASK_RIGHT,
+	GAMEPAD_MASK_DOWN | GAMEPAD_MASK_RIGHT,
+};
+
+CHECK_CASE("socd/legacy-exhaustive")
+{
+	// From each state, every D-pad value with and without bits above the directions in every mode, then every
+	// direction in every mode again to compare the states left behind
+	for (uint8_t prime : primes)
+	{
+		for (SOCDMode mode : legacyModes)
+		{
+			for (uint16_t dpad = 0; dpad <= 0xFF; dpad++)
+			{
+				for (SOCDMode nextMode : legacyModes)
+				{
+					for (uint8_t next = 0; next <= GAMEPAD_MASK_DPAD; next++)
+					{
+						LegacySOCD legacy;
+						GamepadSOCD socd;
+						legacy.run(SOCD_MODE_NEUTRAL, prime);
+						socd.update(SOCD_MODE_NEUTRAL, prime);
+
+						uint8_t expected = legacy.run(mode, dpad);
+						uint8_t actual = socd.update(mode, dpad);
+						uint8_t expectedNext = legacy.run(nextMode, next);
+						uint8_t actualNext = socd.update(nextMode, next);
+						if (actual != expected || actualNext != expectedNext)
+						{
+							printf("  from %x, mode %d D-pad %02x then mode %d D-pad %x gave %x %x, expected %x %x\n", prime,
+								mode, dpad, nextMode, next, actual, actualNext, expected, expectedNext);
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("socd/legacy-sequences")
+{
+	// Rolls and mashing, switching modes now and then like the F2 hotkeys do
+	LegacySOCD legacy;
+	GamepadSOCD socd;
+	SOCDMode mode = SOCD_MODE_SECOND_INPUT_PRIORITY;
+	uint8_t dpad = 0;
+	srand(23);
+
+	for (uint32_t frame = 0; frame < 1000000; frame++)
+	{
+		if ((rand() % 1000) == 0)
+			mode = legacyModes[rand() % 3];
+		if ((rand() % 4) == 0)
+			dpad ^= 1U << (rand() % 4);
+
+		uint8_t expected = legacy.run(mode, dpad);
+		uint8_t actual = socd.update(mode, dpad);
+		if (actual != expected)
+		{
+			printf("  frame %u, mode %d D-pad %x gave %x, expected %x\n", frame, mode, dpad, actual, expected);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool checkSteps(GamepadSOCD &socd, SOCDMode mode, const char *name, const uint8_t (*steps)[2], size_t count)
+{
+	socd.reset();
+	for (size_t i = 0; i < count; i++)
+	{
+		uint8_t dpad = socd.update(mode, steps[i][0]);
+		if (dpad != steps[i][1])
+		{
+			printf("  %s step %zu, D-pad %x gave %x, expected %x\n", name, i, steps[i][0], dpad, steps[i][1]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+CHECK_CASE("socd/first-input")
+{
+	static const uint8_t steps[][2] =
+	{
+		{ GAMEPAD_MASK_UP,                                       GAMEPAD_MASK_UP },
+		{ GAMEPAD_MASK_UP | GAMEPAD_MASK_DOWN,                   GAMEPAD_MASK_UP },   // Up was first
+		{ GAMEPAD_MASK_DOWN,                                     GAMEPAD_MASK_DOWN },
+		{ GAMEPAD_MASK_UP | GAMEPAD_MASK_DOWN,                   GAMEPAD_MASK_DOWN }, // Now Down was
+		{ GAMEPAD_MASK_RIGHT,                                    GAMEPAD_MASK_RIGHT },
+		{ GAMEPAD_MASK_LEFT | GAMEPAD_MASK_RIGHT,                GAMEPAD_MASK_RIGHT },
+		{ 0,                                                     0 },
+		{ GAMEPAD_MASK_DPAD,                                     0 },                 // Pressed together
+		{ GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT,                   GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT },
+		{ GAMEPAD_MASK_DPAD,                                     GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT },
+	};
+
+	GamepadSOCD socd;
+	return checkSteps(socd, SOCD_MODE_FIRST_INPUT_PRIORITY, "first input", steps, sizeof(steps) / sizeof(steps[0]));
+}
+
+CHECK_CASE("socd/custom")
+{
+	GamepadSOCD socd;
+	GamepadSOCD reference;
+	bool ok = socd.getCustomVertical() == SOCD_AXIS_NEUTRAL && socd.getCustomHorizontal() == SOCD_AXIS_NEUTRAL;
+
+	// Up priority vertically and last input horizontally
+	static const uint8_t mixed[][2] =
+	{
+		{ GAMEPAD_MASK_DOWN,                                     GAMEPAD_MASK_DOWN },
+		{ GAMEPAD_MASK_UP | GAMEPAD_MASK_DOWN,                   GAMEPAD_MASK_UP },
+		{ GAMEPAD_MASK_LEFT,                                     GAMEPAD_MASK_LEFT },
+		{ GAMEPAD_MASK_LEFT | GAMEPAD_MASK_RIGHT,                GAMEPAD_MASK_RIGHT },
+		{ GAMEPAD_MASK_DPAD,                                     GAMEPAD_MASK_UP | GAMEPAD_MASK_RIGHT },
+	};
+
+	socd.setCustom(SOCD_AXIS_UP_LEFT, SOCD_AXIS_LAST_INPUT);
+	ok &= socd.getCustomVertical() == SOCD_AXIS_UP_LEFT && socd.getCustomHorizontal() == SOCD_AXIS_LAST_INPUT;
+	ok &= checkSteps(socd, SOCD_MODE_CUSTOM, "up and last", mixed, sizeof(mixed) / sizeof(mixed[0]));
+
+	// Down and Right win on both axes
+	static const uint8_t downRight[][2] =
+	{
+		{ GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT,                   GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT },
+		{ GAMEPAD_MASK_DPAD,                                     GAMEPAD_MASK_DOWN | GAMEPAD_MASK_RIGHT },
+	};
+
+	socd.setCustom(SOCD_AXIS_DOWN_RIGHT, SOCD_AXIS_DOWN_RIGHT);
+	ok &= checkSteps(socd, SOCD_MODE_CUSTOM, "down and right", downRight, sizeof(downRight) / sizeof(downRight[0]));
+
+	// The policies of the fixed modes give the same D-pad as the modes themselves
+	socd.setCustom(SOCD_AXIS_UP_LEFT, SOCD_AXIS_NEUTRAL);
+	socd.reset();
+	srand(230);
+	for (uint32_t frame = 0; frame < 100000 && ok; frame++)
+	{
+		uint8_t dpad = rand() & GAMEPAD_MASK_DPAD;
+		ok &= socd.update(SOCD_MODE_CUSTOM, dpad) == reference.update(SOCD_MODE_UP_PRIORITY, dpad);
+	}
+
+	// Modes out of range, e.g. from corrupt options, and policies out of range are neutral
+	socd.setCustom(static_cast<SOCDAxisPolicy>(SOCD_AXIS_COUNT), static_cast<SOCDAxisPolicy>(0xFF));
+	ok &= socd.getCustomVertical() == SOCD_AXIS_NEUTRAL && socd.getCustomHorizontal() == SOCD_AXIS_NEUTRAL;
+	ok &= socd.update(static_cast<SOCDMode>(SOCD_MODE_COUNT), GAMEPAD_MASK_UP) == GAMEPAD_MASK_UP;
+	ok &= socd.update(static_cast<SOCDMode>(SOCD_MODE_COUNT), GAMEPAD_MASK_DPAD) == 0;
+	if (!ok)
+		printf("  the custom policies did not resolve as set\n");
+
+	return ok;
+}
@@ -0,0 +1,175 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Checks GamepadScheduler on its own against a fake start-of-frame source, then through the simulator against a
+ * free-running loop.
+ */
+
+#include "Check.h"
+#include "GamepadSimulator.h"
+
+struct ScheduledLoop
+{
+	uint32_t starts {0};
+	uint32_t early {0};   // Frames that ended more than one lead before their poll
+	uint32_t late {0};    // Frames that ended after their poll
+};
+
+// Drive the scheduler with polls every `periodUs` and frames of `costUs`, starting at `startUs`
+static ScheduledLoop runScheduler(GamepadScheduler &scheduler, uint32_t startUs, uint32_t periodUs, uint32_t costUs, uint32_t polls,
+	uint32_t burst = 1)
+{
+	ScheduledLoop loop;
+	uint32_t now = startUs;
+	uint32_t nextPoll = startUs + periodUs;
+	uint32_t seen = 0;
+
+	for (uint32_t poll = 0; poll < polls; )
+	{
+		// The main loop only looks every `burst` polls, e.g. while busy with something else
+		if (static_cast<int32_t>(now - nextPoll) >= 0)
+		{
+			scheduler.onPoll(nextPoll);
+			nextPoll += periodUs;
+			poll++;
+			if (++seen % burst != 0)
+				continue;
+		}
+
+		if (!scheduler.ready(now))
+		{
+			now++;
+			continue;
+		}
+
+		uint32_t target = scheduler.getTarget();
+		bool locked = scheduler.isLocked();
+		uint32_t end = now + costUs;
+		scheduler.done(now, end);
+		loop.starts++;
+
+		if (locked && burst == 1)
+		{
+			if (static_cast<int32_t>(end - target) > 0)
+				loop.late++;
+			else if (static_cast<int32_t>(target - end) > static_cast<int32_t>(scheduler.getLead()))
+				loop.early++;
+		}
+
+		now = end;
+	}
+
+	return loop;
+}
+
+CHECK_CASE("scheduler/lock")
+{
+	bool ok = true;
+
+	// A clock that wraps partway through, full and high speed poll rates
+	static const uint32_t periods[] = { 1000, 125 };
+	for (uint32_t period : periods)
+	{
+		GamepadScheduler scheduler(20);
+		ScheduledLoop loop = runScheduler(scheduler, 0xFFFF0000, period, period / 4, 2000);
+
+		// One frame per poll, each finishing inside its guard window
+		bool locked = scheduler.isLocked() && scheduler.getPeriod() == period;
+		if (!locked || loop.late > 0 || loop.early > 0 || loop.starts < 2000 || loop.starts > 2000 + 200)
+		{
+			printf("  period %u: locked %d at %u us, %u frames, %u late, %u early\n", period, scheduler.isLocked(),
+				scheduler.getPeriod(), loop.starts, loop.late, loop.early);
+			ok = false;
+		}
+	}
+
+	// Polls the main loop only sees in threes still give the right interval
+	GamepadScheduler bursty(20);
+	runScheduler(bursty, 0, 1000, 100, 300, 3);
+	if (bursty.getPeriod() != 1000)
+	{
+		printf("  bursts: period %u\n", bursty.getPeriod());
+		ok = false;
+	}
+
+	return ok;
+}
+
+CHECK_CASE("scheduler/fallback")
+{
+	bool ok = true;
+
+	// With no polls it never holds a frame back
+	GamepadScheduler idle;
+	for (uint32_t now = 0; now < 10000; now += 100)
+	{
+		ok &= idle.ready(now);
+		idle.done(now, now + 100);
+	}
+
+	// Nor when frames take longer than the poll interval
+	GamepadScheduler slow(20);
+	ScheduledLoop loop = runScheduler(slow, 0, 125, 150, 500);
+	ok &= !slow.isLocked() && loop.starts > 0;
+
+	// A new poll rate, e.g. after a bus reset, relearns and relocks
+	GamepadScheduler relock(20);
+	runScheduler(relock, 0, 1000, 100, 100);
+	runScheduler(relock, 200000, 125, 30, 100);
+	ok &= relock.isLocked() && relock.getPeriod() == 125;
+
+	if (!ok)
+		printf("  slow locked %d, relock period %u\n", slow.isLocked(), relock.getPeriod());
+
+	return ok;
+}
+
+CHECK_CASE("scheduler/age")
+{
+	GamepadTimeline timeline = generateGamepadScenario(GAMEPAD_SCENARIO_TAPS, 20000000, 0, 5);
+
+	GamepadSimConfig config;
+	config.debounceMS = 0;
+	config.frameCostUs = 300;
+	config.frameJitterUs = 40;
+	config.pollJitterUs = 10;
+	config.pollDriftPpm = 150;
+
+	GamepadSimulator<> simulator;
+	bool ok = true;
+
+	static const uint32_t periods[] = { 1000, 4000 };
+	for (uint32_t period : periods)
+	{
+		config.pollPeriodUs = period;
+
+		// A loop() that spins
+		config.scheduled = false;
+		config.scanPeriodUs = 0;
+		GamepadSimResult spin = simulator.run(timeline, config);
+
+		config.scheduled = true;
+		GamepadSimResult scheduled = simulator.run(timeline, config);
+
+		// Input age is the read-to-poll time: about one lead when scheduled, one to two frame times when spinning. Only
+		// the frames before the scheduler locks can be as old as a spinning loop's.
+		bool better = scheduled.meanAge() + config.frameCostUs / 4 < spin.meanAge()
+			&& scheduled.age(99) + config.frameCostUs / 2 < spin.age(99)
+			&& scheduled.age(99) <= config.frameCostUs + config.frameJitterUs + config.guardUs + config.pollJitterUs
+			&& scheduled.delivered == spin.delivered && scheduled.lost == 0 && scheduled.phantom == 0
+			&& scheduled.frames < spin.frames;
+
+		if (!better)
+		{
+			printf("  poll %u us: spin age mean %.0f p99 %u, %llu frames; scheduled age mean %.0f p99 %u, %llu frames, %u of %u delivered\n",
+				period, spin.meanAge(), spin.age(99), static_cast<unsigned long long>(spin.frames), scheduled.meanAge(),
+				scheduled.age(99), static_cast<unsigned long long>(scheduled.frames), scheduled.delivered, scheduled.edges);
+			ok = false;
+		}
+	}
+
+	return ok;
+}
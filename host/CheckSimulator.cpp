@@ -0,0 +1,199 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Checks the simulator against timelines whose outcome is known, so sweeps built on it can be trusted.
+ */
+
+#include "Check.h"
+#include "GamepadSimulator.h"
+
+static bool expect(const char *name, bool condition, const GamepadSimResult &result)
+{
+	if (!condition)
+	{
+		printf("  %s: edges %u delivered %u lost %u phantom %u, latency min %u max %u\n", name,
+			result.edges, result.delivered, result.lost, result.phantom, result.latency(0), result.latency(100));
+	}
+
+	return condition;
+}
+
+CHECK_CASE("sim/decode")
+{
+	// Every single input must survive a report round trip in every mode it is observable in
+	bool ok = true;
+	hostMillis = 1000;
+	for (int mode = INPUT_MODE_XINPUT; mode <= INPUT_MODE_HID; mode++)
+	{
+		InputMode inputMode = static_cast<InputMode>(mode);
+		uint32_t observable = GamepadReportDecoder::getObservableInputs(inputMode);
+		for (uint32_t bit = 0; bit < 20; bit++)
+		{
+			uint32_t input = 1UL << bit;
+			if (!(observable & input))
+				continue;
+
+			for (int dpadMode = DPAD_MODE_DIGITAL; dpadMode <= DPAD_MODE_RIGHT_ANALOG; dpadMode++)
+			{
+				SimulatedGamepad gamepad(0);
+				gamepad.options.inputMode = inputMode;
+				gamepad.options.dpadMode = static_cast<DpadMode>(dpadMode);
+				gamepad.raw = input;
+				uint32_t decoded = GamepadReportDecoder::decode(inputMode, gamepad.options.dpadMode, gamepad.update());
+				if (decoded != input)
+				{
+					printf("  mode %d, dpad mode %d: input %05x decoded as %05x\n", mode, dpadMode, input, decoded);
+					ok = false;
+				}
+			}
+		}
+	}
+
+	ok &= (GamepadReportDecoder::getObservableInputs(INPUT_MODE_XINPUT) & GAMEPAD_MASK_A2) == 0;
+	return ok;
+}
+
+CHECK_CASE("sim/latency")
+{
+	// Clean taps with no debounce show up at the first poll after the next scan
+	GamepadTimeline timeline;
+	for (uint64_t i = 0; i < 100; i++)
+		timeline.tap(10000 + i * 50000 + (i * 37) % 1000, (i % 2) ? GAMEPAD_MASK_B1 : GAMEPAD_MASK_DL, 20000);
+
+	GamepadSimConfig config;
+	config.debounceMS = 0;
+	config.scanPeriodUs = 100;
+	config.pollPeriodUs = 1000;
+
+	GamepadSimulator<> simulator;
+	GamepadSimResult result = simulator.run(timeline, config);
+	bool ok = expect("no debounce", result.edges == 200 && result.delivered == 200 && result.lost == 0 && result.phantom == 0
+		&& result.latency(100) <= config.pollPeriodUs + config.scanPeriodUs, result);
+
+	// Scanning slower than the poll rate adds up to one scan period
+	config.scanPeriodUs = 4000;
+	result = simulator.run(timeline, config);
+	ok &= expect("slow scan", result.delivered == 200 && result.latency(100) > 1000 && result.latency(100) <= 5000, result);
+
+	return ok;
+}
+
+CHECK_CASE("sim/bounce")
+{
+	GamepadTimeline timeline(7);
+	for (uint64_t i = 0; i < 200; i++)
+		timeline.tap(10000 + i * 60000, GAMEPAD_MASK_B2, 30000, 3000);
+
+	GamepadSimConfig config;
+	config.pollPeriodUs = 125;
+	config.scanPeriodUs = 50;
+
+	// Without debouncing the chatter reaches the host
+	config.debounceMS = 0;
+	GamepadSimulator<> simulator;
+	GamepadSimResult raw = simulator.run(timeline, config);
+	bool ok = expect("raw", raw.delivered == 400 && raw.phantom > 0, raw);
+
+	// Debouncing longer than the bounce removes it without delaying the first edge
+	config.debounceMS = 5;
+	GamepadSimResult debounced = simulator.run(timeline, config);
+	ok &= expect("debounced", debounced.delivered == 400 && debounced.phantom == 0 && debounced.latency(100) <= 175, debounced);
+
+	return ok;
+}
+
+CHECK_CASE("sim/debounce-modes")
+{
+	// A contact captured every 200 us, closing with 2.4 ms of bounce
+	static const char capture[] = "000111010011010111111111";
+	std::vector<uint8_t> levels;
+	for (const char *c = capture; *c; c++)
+		levels.push_back(*c == '1');
+
+	GamepadBounceWaveform waveform = GamepadBounceWaveform::fromSamples(levels, 200);
+	bool ok = waveform.flipsUs.size() == 8 && waveform.flipsUs.front() == 600 && waveform.flipsUs.back() == 2400;
+	if (!ok)
+		printf("  the capture gave %zu flips\n", waveform.flipsUs.size());
+
+	GamepadTimeline timeline;
+	for (uint64_t i = 0; i < 200; i++)
+	{
+		timeline.press(10000 + i * 60000, GAMEPAD_MASK_B2, waveform);
+		timeline.release(40000 + i * 60000, GAMEPAD_MASK_B2, waveform);
+	}
+
+	GamepadSimConfig config;
+	config.pollPeriodUs = 125;
+	config.scanPeriodUs = 50;
+	config.debounceMS = 5;
+	GamepadSimulator<> simulator;
+
+	// Lockout reports both edges by the next poll
+	GamepadSimResult lockout = simulator.run(timeline, config);
+	ok &= expect("lockout", lockout.delivered == 400 && lockout.phantom == 0 && lockout.pressLatency(100) <= 175
+		&& lockout.releaseLatency(100) <= 175, lockout);
+
+	// Eager reports presses as fast, and releases once the bounce has been over for the window
+	config.debounceMode = DEBOUNCE_MODE_EAGER;
+	GamepadSimResult eager = simulator.run(timeline, config);
+	ok &= expect("eager", eager.delivered == 400 && eager.phantom == 0 && eager.pressLatency(100) <= 175
+		&& eager.releaseLatency(0) > 6000, eager);
+
+	// Defer holds back presses too
+	config.debounceMode = DEBOUNCE_MODE_DEFER;
+	GamepadSimResult defer = simulator.run(timeline, config);
+	ok &= expect("defer", defer.delivered == 400 && defer.phantom == 0 && defer.pressLatency(0) > 6000, defer);
+
+	// A release window shorter than the bounce lets it through as phantom presses
+	config.debounceMode = DEBOUNCE_MODE_ASYMMETRIC;
+	config.releaseDebounceMS = 0;
+	GamepadSimResult asymmetric = simulator.run(timeline, config);
+	ok &= expect("asymmetric", asymmetric.phantom > 0, asymmetric);
+
+	return ok;
+}
+
+CHECK_CASE("sim/socd")
+{
+	// Hold left, press right, release left, release right
+	GamepadTimeline timeline;
+	timeline.press(10000, GAMEPAD_MASK_DL);
+	timeline.press(50000, GAMEPAD_MASK_DR);
+	timeline.release(80000, GAMEPAD_MASK_DL);
+	timeline.release(120000, GAMEPAD_MASK_DR);
+
+	GamepadSimConfig config;
+	config.debounceMS = 0;
+	GamepadSimulator<> simulator;
+
+	// Neutral drops left as a phantom release and holds back the right press until left is let go
+	config.socdMode = SOCD_MODE_NEUTRAL;
+	GamepadSimResult neutral = simulator.run(timeline, config);
+	bool ok = expect("neutral", neutral.edges == 4 && neutral.delivered == 4 && neutral.phantom == 1
+		&& neutral.latency(100) > 20000, neutral);
+
+	// Last input shows the right press at once, dropping left as a phantom release
+	config.socdMode = SOCD_MODE_SECOND_INPUT_PRIORITY;
+	GamepadSimResult lastInput = simulator.run(timeline, config);
+	ok &= expect("last input", lastInput.delivered == 4 && lastInput.phantom == 1 && lastInput.latency(100) <= 1100, lastInput);
+
+	return ok;
+}
+
+CHECK_CASE("sim/deterministic")
+{
+	GamepadSimConfig config;
+	config.inputMode = INPUT_MODE_HID;
+	GamepadSimulator<> simulator;
+
+	GamepadTimeline first = generateGamepadScenario(GAMEPAD_SCENARIO_HOTKEYS, 20000000, 2000, 3);
+	GamepadTimeline second = generateGamepadScenario(GAMEPAD_SCENARIO_HOTKEYS, 20000000, 2000, 3);
+	GamepadSimResult a = simulator.run(first, config);
+	GamepadSimResult b = simulator.run(second, config);
+
+	return expect("repeat", a.edges > 100 && a.edges == b.edges && a.delivered == b.delivered && a.lost == b.lost
+		&& a.phantom == b.phantom && a.latencies == b.latencies, a);
+}
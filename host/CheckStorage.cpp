@@ -0,0 +1,603 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Checks GamepadLogStorage on a file-backed flash image: round trips, wear spread, large write sizes, recovery from
+ * power loss at every byte of a save and from damaged records, and MPGS saving hotkey changes in slices.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "Check.h"
+#include "GamepadChecksum.h"
+#include "GamepadFileFlash.h"
+#include "GamepadLogStorage.h"
+#include "MPGS.h"
+
+extern thread_local uint32_t hostMillis;
+
+// A fresh flash image in the temp directory, removed when it goes out of scope
+class TempFlash : public GamepadFileFlash
+{
+	public:
+		TempFlash(uint32_t sectorSize, uint16_t sectorCount, uint16_t writeSize = 1)
+			: GamepadFileFlash(sectorSize, sectorCount, writeSize)
+		{
+			int fd = mkstemp(path);
+			if (fd >= 0)
+				::close(fd);
+
+			open(path);
+		}
+
+		~TempFlash()
+		{
+			close();
+			unlink(path);
+		}
+
+		char path[32] {"/tmp/mpg-flash-XXXXXX"};
+};
+
+// MPGS gamepad driven by raw button and D-pad values, one millisecond per frame
+class StorageGamepad : public MPGS
+{
+	public:
+		StorageGamepad(GamepadStorage *storage) : MPGS(5, storage) { }
+
+		void setup() override { }
+
+		void read() override
+		{
+			state.buttons = buttons;
+			state.dpad = dpad;
+		}
+
+		// Run frames with the given inputs held, returning the most time the flash was busy in one of them
+		uint64_t hold(GamepadFileFlash &flash, uint16_t held, uint8_t direction, uint32_t frames)
+		{
+			buttons = held;
+			dpad = direction;
+
+			uint64_t most = 0;
+			for (uint32_t i = 0; i < frames; i++)
+			{
+				uint64_t busy = flash.busyUs;
+				update();
+				hostMillis++;
+				most = std::max(most, flash.busyUs - busy);
+			}
+
+			return most;
+		}
+
+		uint16_t buttons {0};
+		uint8_t dpad {0};
+};
+
+// The blocking behaviour MPGS had before saves were sliced: save on every frame a hotkey is held
+class BlockingStorageGamepad : public StorageGamepad
+{
+	public:
+		BlockingStorageGamepad(GamepadStorage *storage) : StorageGamepad(storage) { }
+
+		GamepadHotkey hotkey() override
+		{
+			GamepadHotkey action = MPG::hotkey();
+			if (action != HOTKEY_NONE)
+				save();
+
+			return action;
+		}
+};
+
+#define HOTKEY_F2 (GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3)
+
+static GamepadOptions makeOptions(uint32_t n)
+{
+	GamepadOptions options;
+	options.inputMode = static_cast<InputMode>(n % 3);
+	options.dpadMode = static_cast<DpadMode>((n / 3) % 3);
+	options.socdMode = static_cast<SOCDMode>((n / 9) % 3);
+	options.invertXAxis = (n / 27) % 2;
+	options.invertYAxis = (n / 54) % 2;
+	return options;
+}
+
+static bool sameOptions(const GamepadOptions &a, const GamepadOptions &b)
+{
+	return a.inputMode == b.inputMode && a.dpadMode == b.dpadMode && a.socdMode == b.socdMode
+		&& a.invertXAxis == b.invertXAxis && a.invertYAxis == b.invertYAxis;
+}
+
+static GamepadOptions reboot(GamepadFlash &flash, bool *found = nullptr)
+{
+	GamepadLogStorage storage(&flash);
+	storage.start();
+	if (found)
+		*found = storage.hasOptions();
+
+	return storage.getGamepadOptions();
+}
+
+static void saveOptions(GamepadLogStorage &storage, const GamepadOptions &options)
+{
+	storage.setGamepadOptions(options);
+	storage.save();
+}
+
+CHECK_CASE("storage/crc")
+{
+	const uint8_t check[] = "123456789";
+	bool ok = computeGamepadCRC32(check, 9) == 0xCBF43926;
+
+	// Checksumming in pieces gives the same result
+	ok &= computeGamepadCRC32(check + 4, 5, computeGamepadCRC32(check, 4)) == 0xCBF43926;
+	ok &= computeGamepadCRC32(check, 0) == 0;
+	return ok;
+}
+
+CHECK_CASE("storage/round-trip")
+{
+	TempFlash flash(1024, 4);
+	bool ok = true;
+
+	// A blank image gives defaults
+	bool found = true;
+	GamepadOptions options = reboot(flash, &found);
+	ok &= !found && sameOptions(options, GamepadOptions());
+
+	for (uint32_t n = 0; n < 108; n++)
+	{
+		GamepadLogStorage storage(&flash);
+		storage.start();
+		saveOptions(storage, makeOptions(n));
+
+		options = reboot(flash, &found);
+		if (!found || !sameOptions(options, makeOptions(n)) || options.checksum == 0 || options.checksum != storage.getGamepadOptions().checksum)
+		{
+			printf("  options %u did not survive a reboot\n", n);
+			ok = false;
+		}
+	}
+
+	// The image lives in the file, not in the object
+	GamepadFileFlash reopened(1024, 4);
+	ok &= reopened.open(flash.path) && sameOptions(reboot(reopened), makeOptions(107));
+	return ok;
+}
+
+CHECK_CASE("storage/wear")
+{
+	TempFlash flash(1024, 4);
+	GamepadLogStorage storage(&flash);
+	storage.start();
+
+	const uint32_t saves = 5000;
+	uint32_t slots = storage.getSlotCount() - 1;
+	for (uint32_t n = 0; n < saves; n++)
+	{
+		saveOptions(storage, makeOptions(n % 2));
+
+		// Saving unchanged options writes nothing
+		uint64_t writes = flash.writes;
+		saveOptions(storage, makeOptions(n % 2));
+		if (flash.writes != writes)
+		{
+			printf("  unchanged options were written\n");
+			return false;
+		}
+	}
+
+	// Sectors are erased in turn, and only when the ring comes back around to them
+	uint32_t opened = (saves + slots - 1) / slots;
+	uint32_t expected = opened - flash.sectorCount;
+	uint32_t total = 0;
+	uint32_t least = UINT32_MAX;
+	uint32_t most = 0;
+	for (uint32_t count : flash.erases)
+	{
+		total += count;
+		least = std::min(least, count);
+		most = std::max(most, count);
+	}
+
+	// Each save writes one record, plus a header when it opens a sector, a write unit at a time
+	uint64_t written = static_cast<uint64_t>(saves + opened) * GAMEPAD_STORAGE_SLOT_SIZE;
+	bool ok = total == expected && most - least <= 1 && flash.bytesWritten == written && flash.failures == 0;
+	ok &= sameOptions(reboot(flash), makeOptions((saves - 1) % 2));
+	if (!ok)
+		printf("  %u erases (expected %u), spread %u-%u, %llu bytes written\n", total, expected, least, most,
+			static_cast<unsigned long long>(flash.bytesWritten));
+
+	return ok;
+}
+
+CHECK_CASE("storage/write-size")
+{
+	bool ok = true;
+
+	// Page-sized writes, e.g. RP2040 flash, take a whole page per slot
+	TempFlash paged(4096, 3, 256);
+	GamepadLogStorage storage(&paged);
+	storage.start();
+	ok &= storage.getSlotCount() == 16;
+	for (uint32_t n = 0; n < 100; n++)
+		saveOptions(storage, makeOptions(n));
+
+	ok &= paged.failures == 0 && sameOptions(reboot(paged), makeOptions(99));
+
+	// Writes larger than GAMEPAD_STORAGE_SLOT_MAX leave the storage unusable rather than corrupting anything
+	TempFlash huge(8192, 2, GAMEPAD_STORAGE_SLOT_MAX * 2);
+	GamepadLogStorage unusable(&huge);
+	unusable.start();
+	saveOptions(unusable, makeOptions(5));
+	ok &= unusable.getSlotCount() == 0 && huge.writes == 0 && !unusable.hasOptions();
+
+	return ok;
+}
+
+CHECK_CASE("storage/power-loss")
+{
+	TempFlash flash(256, 3);
+	size_t imageSize = static_cast<size_t>(flash.sectorSize) * flash.sectorCount;
+	bool ok = true;
+
+	// Start from a full sector after a lap of the ring, so the next save erases, writes a header and a record, and
+	// from a sector with room
+	for (uint32_t fill : { 15U * 4, 15U * 4 + 7 })
+	{
+		memset(flash.data(), 0xFF, imageSize);
+		GamepadLogStorage setup(&flash);
+		setup.start();
+		for (uint32_t n = 0; n < fill; n++)
+			saveOptions(setup, makeOptions(n % 2 + 1));
+
+		GamepadOptions before = makeOptions((fill - 1) % 2 + 1);
+		GamepadOptions after = makeOptions(7);
+		std::vector<uint8_t> image(flash.data(), flash.data() + imageSize);
+
+		for (int64_t cut = 0; ; cut++)
+		{
+			memcpy(flash.data(), image.data(), imageSize);
+			flash.failAfter(cut);
+
+			GamepadLogStorage storage(&flash);
+			storage.start();
+			saveOptions(storage, after);
+			bool completed = !flash.hasLostPower();
+			flash.powerCycle();
+
+			// Never anything but the old or the new options, and the new ones once the save completed
+			GamepadOptions recovered = reboot(flash);
+			if (!(completed ? sameOptions(recovered, after) : (sameOptions(recovered, before) || sameOptions(recovered, after))))
+			{
+				printf("  fill %u, power lost after %lld operations: unexpected options\n", fill, static_cast<long long>(cut));
+				ok = false;
+			}
+
+			// The next boot can keep saving
+			GamepadLogStorage next(&flash);
+			next.start();
+			saveOptions(next, makeOptions(20));
+			saveOptions(next, makeOptions(21));
+			if (!sameOptions(reboot(flash), makeOptions(21)))
+			{
+				printf("  fill %u, power lost after %lld operations: cannot save afterwards\n", fill, static_cast<long long>(cut));
+				ok = false;
+			}
+
+			if (completed)
+				break;
+		}
+	}
+
+	return ok;
+}
+
+CHECK_CASE("storage/damaged")
+{
+	TempFlash flash(512, 3);
+	size_t imageSize = static_cast<size_t>(flash.sectorSize) * flash.sectorCount;
+	bool ok = true;
+
+	GamepadLogStorage storage(&flash);
+	storage.start();
+	for (uint32_t n = 0; n < 40; n++)
+		saveOptions(storage, makeOptions(n));
+
+	// A flipped bit in the newest record falls back to the one before it
+	uint32_t newest = storage.getActiveSector() * flash.sectorSize + (storage.getNextSlot() - 1) * GAMEPAD_STORAGE_SLOT_SIZE;
+	flash.data()[newest + 5] ^= 0x02;
+	ok &= sameOptions(reboot(flash), makeOptions(38));
+
+	// So does a newer record version this build does not know
+	uint8_t record[GAMEPAD_STORAGE_SLOT_SIZE];
+	encodeGamepadOptionsRecord(record, makeOptions(39));
+	record[1]++;
+	uint32_t crc = computeGamepadCRC32(record, 12);
+	for (int i = 0; i < 4; i++)
+		record[12 + i] = static_cast<uint8_t>(crc >> (i * 8));
+	memcpy(flash.data() + newest + GAMEPAD_STORAGE_SLOT_SIZE, record, sizeof(record));
+	ok &= sameOptions(reboot(flash), makeOptions(38));
+
+	// Random contents, e.g. flash that was never erased, read as no options and are erased on the first save
+	srand(3);
+	for (size_t i = 0; i < imageSize; i++)
+		flash.data()[i] = static_cast<uint8_t>(rand());
+
+	bool found = true;
+	GamepadLogStorage fresh(&flash);
+	fresh.start();
+	ok &= !fresh.hasOptions() && sameOptions(fresh.getGamepadOptions(), GamepadOptions());
+	saveOptions(fresh, makeOptions(11));
+	ok &= sameOptions(reboot(flash, &found), makeOptions(11)) && found;
+
+	return ok;
+}
+
+// Rotate every key by `n`
+static void makeRemap(uint32_t n, uint32_t *map)
+{
+	for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+		map[key] = 1UL << ((key + n) % GAMEPAD_DIGITAL_INPUT_COUNT);
+}
+
+// The remap found at boot: the `n` it was made from, -1 for none or -2 for anything else
+static int32_t rebootRemap(GamepadFlash &flash)
+{
+	GamepadLogStorage storage(&flash);
+	storage.start();
+	uint32_t map[GAMEPAD_DIGITAL_INPUT_COUNT];
+	if (!storage.getRemap(map))
+		return -1;
+
+	for (uint32_t n = 0; n < GAMEPAD_DIGITAL_INPUT_COUNT; n++)
+	{
+		uint32_t expected[GAMEPAD_DIGITAL_INPUT_COUNT];
+		makeRemap(n, expected);
+		if (memcmp(map, expected, sizeof(map)) == 0)
+			return n;
+	}
+
+	return -2;
+}
+
+static void saveRemap(GamepadLogStorage &storage, uint32_t n, const GamepadOptions &options)
+{
+	uint32_t map[GAMEPAD_DIGITAL_INPUT_COUNT];
+	makeRemap(n, map);
+	storage.setRemap(map);
+	storage.setGamepadOptions(options);
+	storage.save();
+}
+
+CHECK_CASE("storage/remap")
+{
+	TempFlash flash(256, 2);
+	GamepadLogStorage storage(&flash);
+	storage.start();
+	bool ok = !storage.hasRemap() && rebootRemap(flash) == -1;
+
+	saveRemap(storage, 5, makeOptions(1));
+	ok &= storage.hasRemap() && rebootRemap(flash) == 5 && sameOptions(reboot(flash), makeOptions(1));
+
+	// Saving the same remap again writes nothing
+	uint64_t writes = flash.writes;
+	saveRemap(storage, 5, makeOptions(1));
+	ok &= flash.writes == writes;
+
+	// Options saved on their own go round the ring many times, and every sector they open carries the remap
+	for (uint32_t n = 0; n < 100; n++)
+		saveOptions(storage, makeOptions(n % 2 + 2));
+
+	ok &= flash.erases[0] > 2 && rebootRemap(flash) == 5 && sameOptions(reboot(flash), makeOptions(3));
+
+	// A remap saved on its own keeps the options
+	uint32_t map[GAMEPAD_DIGITAL_INPUT_COUNT];
+	makeRemap(9, map);
+	storage.setRemap(map);
+	storage.save();
+	ok &= rebootRemap(flash) == 9 && sameOptions(reboot(flash), makeOptions(3));
+
+	// A remap staged while another is being written cuts that one short, and the next save writes it
+	makeRemap(10, map);
+	storage.setRemap(map);
+	storage.beginSave(storage.getGamepadOptions());
+	for (int i = 0; i < 40 && storage.getSaveStep() != STORAGE_SAVE_VERIFY; i++)
+		storage.stepSave();
+
+	makeRemap(11, map);
+	storage.setRemap(map);
+	while (!storage.stepSave()) { }
+	ok &= rebootRemap(flash) == 9;
+	storage.save();
+	ok &= rebootRemap(flash) == 11;
+
+	// Sectors too small to hold a remap and options still save the options
+	TempFlash small(64, 2);
+	GamepadLogStorage tiny(&small);
+	tiny.start();
+	for (uint32_t n = 0; n < 10; n++)
+		saveRemap(tiny, n, makeOptions(n));
+
+	ok &= rebootRemap(small) == -1 && sameOptions(reboot(small), makeOptions(9)) && small.failures == 0;
+	if (!ok)
+		printf("  remap %d after the last save\n", rebootRemap(flash));
+
+	return ok;
+}
+
+CHECK_CASE("storage/remap-power-loss")
+{
+	TempFlash flash(256, 2);
+	size_t imageSize = static_cast<size_t>(flash.sectorSize) * flash.sectorCount;
+	bool ok = true;
+
+	// From a sector with room for the records, and from one without, so the save erases the other sector and carries
+	// the options and remap over
+	for (uint32_t fill : { 0U, 5U })
+	{
+		memset(flash.data(), 0xFF, imageSize);
+		GamepadLogStorage setup(&flash);
+		setup.start();
+		saveRemap(setup, 1, makeOptions(1));
+		for (uint32_t n = 0; n < fill; n++)
+			saveOptions(setup, makeOptions(n % 2 + 2));
+
+		GamepadOptions before = setup.getGamepadOptions();
+		std::vector<uint8_t> image(flash.data(), flash.data() + imageSize);
+
+		for (int64_t cut = 0; ; cut++)
+		{
+			memcpy(flash.data(), image.data(), imageSize);
+			flash.failAfter(cut);
+
+			GamepadLogStorage storage(&flash);
+			storage.start();
+			saveRemap(storage, 2, makeOptions(7));
+			bool completed = !flash.hasLostPower();
+			flash.powerCycle();
+
+			// Never part of a remap, and the new one once the save completed. A torn header loses both sectors'
+			// records, as it always has for options.
+			int32_t remap = rebootRemap(flash);
+			GamepadOptions options = reboot(flash);
+			bool expected = completed ? (remap == 2 && sameOptions(options, makeOptions(7)))
+				: (remap >= -1 && remap <= 2 && (sameOptions(options, before) || sameOptions(options, makeOptions(7))
+					|| sameOptions(options, GamepadOptions())));
+			if (!expected)
+			{
+				printf("  fill %u, power lost after %lld operations: remap %d\n", fill, static_cast<long long>(cut), remap);
+				ok = false;
+			}
+
+			// The next boot saves the remap that was lost
+			GamepadLogStorage next(&flash);
+			next.start();
+			saveRemap(next, 3, makeOptions(20));
+			if (rebootRemap(flash) != 3)
+			{
+				printf("  fill %u, power lost after %lld operations: cannot save afterwards\n", fill, static_cast<long long>(cut));
+				ok = false;
+			}
+
+			if (completed)
+				break;
+		}
+	}
+
+	return ok;
+}
+
+CHECK_CASE("storage/coalesce")
+{
+	TempFlash flash(4096, 2, 256);
+	GamepadLogStorage storage(&flash);
+	storage.start();
+	StorageGamepad gamepad(&storage);
+	gamepad.load();
+	hostMillis = 1000;
+	bool ok = true;
+
+	// Flipping through SOCD modes with the hotkey held writes nothing yet
+	gamepad.hold(flash, HOTKEY_F2, GAMEPAD_MASK_RIGHT, 20);
+	for (uint8_t direction : { GAMEPAD_MASK_UP, GAMEPAD_MASK_LEFT, GAMEPAD_MASK_DOWN, GAMEPAD_MASK_UP })
+		gamepad.hold(flash, HOTKEY_F2, direction, 20);
+
+	ok &= flash.writes == 0 && gamepad.isSaving();
+
+	// Releasing it saves only where it ended up: a sector header and one record
+	gamepad.hold(flash, 0, 0, 50);
+	ok &= flash.writes == 2 && !gamepad.isSaving() && sameOptions(reboot(flash), gamepad.options);
+	ok &= gamepad.options.socdMode == SOCD_MODE_UP_PRIORITY && gamepad.options.invertYAxis;
+
+	// A hotkey held past the quiet period is saved without waiting for the release
+	gamepad.hold(flash, HOTKEY_F2, GAMEPAD_MASK_DOWN, GAMEPAD_SAVE_DELAY_MS - 10);
+	ok &= flash.writes == 2;
+	gamepad.hold(flash, HOTKEY_F2, GAMEPAD_MASK_DOWN, 20);
+	ok &= flash.writes == 3 && sameOptions(reboot(flash), gamepad.options);
+	gamepad.hold(flash, 0, 0, 20);
+	ok &= flash.writes == 3;
+
+	// Options changed by the sketch, even every frame, wait for the sketch to save them
+	for (uint32_t i = 0; i < 50; i++)
+	{
+		gamepad.options.invertXAxis = (i % 2) != 0;
+		gamepad.hold(flash, 0, 0, 1);
+	}
+
+	ok &= flash.writes == 3 && !gamepad.isSaving();
+	gamepad.requestSave();
+	gamepad.hold(flash, 0, 0, 5);
+	ok &= flash.writes == 4 && !gamepad.isSaving() && sameOptions(reboot(flash), gamepad.options);
+
+	// save() still finishes before returning
+	gamepad.options.invertXAxis = !gamepad.options.invertXAxis;
+	gamepad.save();
+	ok &= flash.writes == 5 && sameOptions(reboot(flash), gamepad.options);
+
+	if (!ok)
+		printf("  %llu writes\n", static_cast<unsigned long long>(flash.writes));
+
+	return ok;
+}
+
+CHECK_CASE("storage/stall")
+{
+	// Byte-wide EEPROM, and flash with 4KB sectors and 256 byte pages; sizes keep the ring wrapping
+	const struct { uint32_t sectorSize; uint16_t writeSize; uint32_t eraseUs; uint32_t writeUs; } media[] =
+	{
+		{ 256,  1,   460000, 3400 },
+		{ 4096, 256, 45000,  800 },
+	};
+
+	bool ok = true;
+	for (const auto &medium : media)
+	{
+		uint64_t blocking = 0;
+		uint64_t sliced = 0;
+		GamepadOptions saved[2];
+		for (int pass = 0; pass < 2; pass++)
+		{
+			TempFlash flash(medium.sectorSize, 2, medium.writeSize);
+			flash.eraseUs = medium.eraseUs;
+			flash.writeUs = medium.writeUs;
+			GamepadLogStorage storage(&flash);
+			storage.start();
+
+			StorageGamepad slicedGamepad(&storage);
+			BlockingStorageGamepad blockingGamepad(&storage);
+			StorageGamepad &gamepad = pass ? slicedGamepad : blockingGamepad;
+			gamepad.load();
+			hostMillis = 1000;
+
+			// Tap between two SOCD modes, long enough for every save to finish before the next tap
+			uint64_t most = 0;
+			for (uint32_t n = 0; n < 100; n++)
+			{
+				most = std::max(most, gamepad.hold(flash, HOTKEY_F2, (n % 2) ? GAMEPAD_MASK_DOWN : GAMEPAD_MASK_UP, 5));
+				most = std::max(most, gamepad.hold(flash, 0, 0, 40));
+			}
+
+			(pass ? sliced : blocking) = most;
+			saved[pass] = reboot(flash);
+			ok &= flash.failures == 0 && flash.erases[0] > 0;
+		}
+
+		// Sliced, a frame waits for one erase or one write unit at most, and both ways save the same options
+		uint64_t largest = std::max(medium.eraseUs, medium.writeUs);
+		ok &= sliced <= largest && sliced < blocking && sameOptions(saved[0], saved[1]);
+		if (!ok)
+			printf("  %u byte writes: worst frame %lluus blocking, %lluus sliced\n", medium.writeSize,
+				static_cast<unsigned long long>(blocking), static_cast<unsigned long long>(sliced));
+	}
+
+	return ok;
+}
@@ -0,0 +1,188 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Round trips states through GamepadTraceWriter and GamepadTraceReader, and checks that damaged traces are
+ * rejected without reading out of bounds.
+ */
+
+#include <string.h>
+
+#include "Check.h"
+#include "BenchGamepad.h"
+#include "GamepadTraceReader.h"
+
+static std::vector<uint8_t> traceBytes;
+
+static void appendTrace(const uint8_t *data, uint8_t length)
+{
+	traceBytes.insert(traceBytes.end(), data, data + length);
+}
+
+struct TracedState
+{
+	uint32_t timeUs;
+	GamepadState state;
+};
+
+// Frames are spaced by `stepUs`, or by random gaps from 0 to ~1s when it is 0
+static std::vector<TracedState> recordTrace(const std::vector<GamepadState> &frames, uint32_t seed, uint32_t stepUs = 0)
+{
+	traceBytes.clear();
+	GamepadTraceWriter writer(appendTrace);
+	std::vector<TracedState> recorded;
+	uint32_t rng = seed;
+	uint32_t time = 0xFFFF0000; // Wraps partway through
+
+	writer.begin(time);
+	for (const GamepadState &frame : frames)
+	{
+		rng = rng * 1664525U + 1013904223U;
+		uint32_t step = rng >> 8;
+		time += stepUs ? stepUs : ((step % 4 == 0) ? (step & 0xFFFFF) : (step % 200));
+		if (writer.record(time, frame))
+			recorded.push_back({ time, frame });
+	}
+
+	return recorded;
+}
+
+static bool checkRoundTrip(const char *name, const std::vector<GamepadState> &frames)
+{
+	std::vector<TracedState> recorded = recordTrace(frames, 9);
+	GamepadTraceReader reader;
+	if (!reader.open(traceBytes.data(), traceBytes.size()))
+	{
+		printf("  %s: header rejected\n", name);
+		return false;
+	}
+
+	uint32_t start = 0xFFFF0000;
+	for (size_t i = 0; i < recorded.size(); i++)
+	{
+		if (!reader.next())
+		{
+			printf("  %s: trace ended at record %zu of %zu\n", name, i, recorded.size());
+			return false;
+		}
+
+		uint32_t expectedTime = recorded[i].timeUs - start;
+		if (static_cast<uint32_t>(reader.timeUs) != expectedTime || compareGamepadState(reader.state, recorded[i].state) != 0)
+		{
+			printf("  %s: record %zu differs\n", name, i);
+			return false;
+		}
+	}
+
+	if (reader.next() || reader.malformed)
+	{
+		printf("  %s: unexpected data after the last record\n", name);
+		return false;
+	}
+
+	return true;
+}
+
+CHECK_CASE("trace/round-trip")
+{
+	bool ok = true;
+	for (int mix = 0; mix < INPUT_MIX_COUNT; mix++)
+		ok &= checkRoundTrip(inputMixName(static_cast<InputMix>(mix)), generateInputMix(static_cast<InputMix>(mix), 20000, 3));
+
+	// Every field changing independently
+	std::vector<GamepadState> frames(20000);
+	uint32_t rng = 5;
+	for (GamepadState &frame : frames)
+	{
+		auto next = [&rng]() { rng = rng * 1664525U + 1013904223U; return rng >> 8; };
+		frame.dpad = (next() % 2) ? next() & GAMEPAD_MASK_DPAD : 0;
+		frame.buttons = (next() % 2) ? next() : 0;
+		frame.aux = (next() % 8) ? 0 : next();
+		frame.lx = (next() % 3) ? GAMEPAD_JOYSTICK_MID : next();
+		frame.ly = next();
+		frame.rx = (next() % 5) ? GAMEPAD_JOYSTICK_MID : next();
+		frame.ry = GAMEPAD_JOYSTICK_MID;
+		frame.lt = (next() % 4) ? 0 : next();
+		frame.rt = next();
+	}
+
+	ok &= checkRoundTrip("fields", frames);
+	return ok;
+}
+
+CHECK_CASE("trace/varint")
+{
+	static const uint32_t deltas[] = { 0, 1, 127, 128, 16383, 16384, 0x1FFFFF, 0x200000, 0xFFFFFFF, 0x10000000, UINT32_MAX };
+
+	bool ok = true;
+	for (uint32_t delta : deltas)
+	{
+		GamepadState state;
+		state.buttons = GAMEPAD_MASK_B1;
+		uint8_t record[GAMEPAD_TRACE_RECORD_MAX];
+		uint8_t length = encodeGamepadTraceRecord(record, delta, GAMEPAD_CHANGED_BUTTONS, state);
+
+		GamepadState decoded;
+		uint32_t decodedDelta;
+		if (decodeGamepadTraceRecord(record, length, decodedDelta, decoded) != length || decodedDelta != delta || decoded.buttons != state.buttons)
+		{
+			printf("  delta %u does not round trip\n", delta);
+			ok = false;
+		}
+	}
+
+	GamepadState all;
+	uint8_t record[GAMEPAD_TRACE_RECORD_MAX];
+	ok &= encodeGamepadTraceRecord(record, UINT32_MAX, GAMEPAD_TRACE_MASK_FIELDS, all) == GAMEPAD_TRACE_RECORD_MAX;
+	return ok;
+}
+
+CHECK_CASE("trace/size")
+{
+	// Button-only play scanned at 1kHz should average a handful of bytes per change
+	std::vector<TracedState> recorded = recordTrace(generateInputMix(INPUT_MIX_CASUAL, 200000, 4), 4, 1000);
+	double perRecord = static_cast<double>(traceBytes.size() - GAMEPAD_TRACE_HEADER_SIZE) / recorded.size();
+	if (perRecord > 6.0)
+	{
+		printf("  %.2f bytes per record\n", perRecord);
+		return false;
+	}
+
+	return true;
+}
+
+CHECK_CASE("trace/damaged")
+{
+	recordTrace(generateInputMix(INPUT_MIX_MASHING, 300, 6), 6);
+	std::vector<uint8_t> full = traceBytes;
+	bool ok = true;
+
+	// Every truncation either ends on a record boundary or is reported, and never reads past the end
+	for (size_t length = GAMEPAD_TRACE_HEADER_SIZE; length < full.size(); length++)
+	{
+		std::vector<uint8_t> truncated(full.begin(), full.begin() + length);
+		GamepadTraceReader reader;
+		reader.open(truncated.data(), truncated.size());
+		while (reader.next()) { }
+
+		if (reader.offset > length || (!reader.malformed && reader.offset != length))
+		{
+			printf("  truncated to %zu bytes: stopped at %zu, malformed %d\n", length, reader.offset, reader.malformed);
+			ok = false;
+		}
+	}
+
+	std::vector<uint8_t> reserved = full;
+	reserved[GAMEPAD_TRACE_HEADER_SIZE] |= 0x80;
+	GamepadTraceReader reader;
+	reader.open(reserved.data(), reserved.size());
+	ok &= !reader.next() && reader.malformed;
+
+	std::vector<uint8_t> version = full;
+	version[4] = GAMEPAD_TRACE_VERSION + 1;
+	ok &= !reader.open(version.data(), version.size());
+
+	return ok;
+}
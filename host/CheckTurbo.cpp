@@ -0,0 +1,293 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * Verifies turbo rates as the host sees them, polled at 1 and 8 kHz with one or several frames per poll, macro
+ * playback and recording tick by tick, and the clock taking over when polls stop or a frame comes late.
+ */
+
+#include "Check.h"
+#include "BenchGamepad.h"
+
+struct TurboRate
+{
+	uint16_t button;
+	uint16_t rate;
+};
+
+// Hold every button for `seconds` and count the presses the host sees at each poll, against the set rate
+static bool checkRates(uint16_t pollHz, const TurboRate *rates, uint8_t count, uint8_t framesPerPoll)
+{
+	const uint32_t seconds = 10;
+	GamepadTurbo turbo(pollHz);
+	uint16_t held = 0;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		turbo.setTurbo(rates[i].button, rates[i].rate);
+		held |= rates[i].button;
+	}
+
+	uint32_t presses[GAMEPAD_BUTTON_COUNT] = { };
+	uint16_t last = 0;
+	for (uint32_t poll = 0; poll < pollHz * seconds; poll++)
+	{
+		turbo.onPoll();
+		GamepadState state;
+		for (uint8_t frame = 0; frame < framesPerPoll; frame++)
+		{
+			state.buttons = held;
+			turbo.update(state, poll * 1000 / pollHz);
+		}
+
+		// Only the last frame before the poll reaches the host
+		uint16_t rising = state.buttons & ~last;
+		last = state.buttons;
+		for (uint8_t i = 0; i < GAMEPAD_BUTTON_COUNT; i++)
+			presses[i] += (rising >> i) & 1;
+	}
+
+	bool ok = true;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		uint8_t index = 0;
+		while (!(rates[i].button & (1U << index)))
+			index++;
+
+		int32_t expected = rates[i].rate * seconds;
+		int32_t error = static_cast<int32_t>(presses[index]) - expected;
+		if (error < -1 || error > 1)
+		{
+			printf("  %u Hz polls, %u frames per poll: %u presses/s seen %u times in %u s, expected %d\n", pollHz,
+				framesPerPoll, rates[i].rate, presses[index], seconds, expected);
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+CHECK_CASE("turbo/rate-1khz")
+{
+	// Rates that do and do not divide the poll rate, one slower than a turn of the wheel, and the 500 Hz maximum
+	const TurboRate rates[] =
+	{
+		{ GAMEPAD_MASK_B1, 30 }, { GAMEPAD_MASK_B2, 20 }, { GAMEPAD_MASK_B3, 15 }, { GAMEPAD_MASK_B4, 12 },
+		{ GAMEPAD_MASK_L1, 7 }, { GAMEPAD_MASK_R1, 1 }, { GAMEPAD_MASK_L2, 333 }, { GAMEPAD_MASK_R2, 500 },
+	};
+
+	return checkRates(1000, rates, 8, 1) && checkRates(1000, rates, 8, 3);
+}
+
+CHECK_CASE("turbo/rate-8khz")
+{
+	const TurboRate rates[] =
+	{
+		{ GAMEPAD_MASK_B1, 30 }, { GAMEPAD_MASK_B2, 20 }, { GAMEPAD_MASK_B3, 15 }, { GAMEPAD_MASK_B4, 12 },
+		{ GAMEPAD_MASK_L1, 7 }, { GAMEPAD_MASK_R1, 1 }, { GAMEPAD_MASK_L2, 333 }, { GAMEPAD_MASK_R2, 4000 },
+	};
+
+	return checkRates(8000, rates, 8, 1) && checkRates(8000, rates, 8, 3);
+}
+
+CHECK_CASE("turbo/release")
+{
+	// Turbo starts pressed, and stops at once when the button is let go
+	GamepadTurbo turbo(1000);
+	turbo.setTurbo(GAMEPAD_MASK_B1, 100);
+
+	const char *expected = "11111000001111100000111000";
+	for (uint32_t frame = 0; expected[frame]; frame++)
+	{
+		GamepadState state;
+		state.buttons = (frame < 23) ? GAMEPAD_MASK_B1 : 0;
+		turbo.update(state, frame + 1);
+		if ((state.buttons != 0) != (expected[frame] == '1'))
+		{
+			printf("  frame %u: B1 %s, expected %s\n", frame, state.buttons ? "pressed" : "released", expected);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Run frames with the given inputs and compare each output, a millisecond and so one tick apart
+static bool checkFrames(GamepadTurbo &turbo, const GamepadState *inputs, const GamepadState *outputs, uint8_t count)
+{
+	for (uint8_t i = 0; i < count; i++)
+	{
+		GamepadState state = inputs[i];
+		turbo.update(state, turbo.getTicks() + 1);
+		if (state.buttons != outputs[i].buttons || state.dpad != outputs[i].dpad)
+		{
+			printf("  frame %u: buttons %04x D-pad %x, expected %04x and %x\n", i, state.buttons, state.dpad,
+				outputs[i].buttons, outputs[i].dpad);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static GamepadState frame(uint16_t buttons, uint8_t dpad = 0)
+{
+	GamepadState state;
+	state.buttons = buttons;
+	state.dpad = dpad;
+	return state;
+}
+
+CHECK_CASE("turbo/macro")
+{
+	GamepadTurbo turbo(1000);
+	const GamepadMacroStep steps[] =
+	{
+		{ GAMEPAD_MASK_B1, 0, 2 },
+		{ GAMEPAD_MASK_B2, GAMEPAD_MASK_UP, 3 },
+	};
+	turbo.setMacro(0, GAMEPAD_MASK_S2, steps, 2);
+
+	// The trigger is hidden, and other inputs pass through while the macro plays
+	const GamepadState inputs[] =
+	{
+		frame(GAMEPAD_MASK_S2), frame(GAMEPAD_MASK_S2), frame(GAMEPAD_MASK_B4), frame(0), frame(0), frame(0),
+		frame(GAMEPAD_MASK_S2),
+	};
+	const GamepadState outputs[] =
+	{
+		frame(GAMEPAD_MASK_B1), frame(GAMEPAD_MASK_B1), frame(GAMEPAD_MASK_B2 | GAMEPAD_MASK_B4, GAMEPAD_MASK_UP),
+		frame(GAMEPAD_MASK_B2, GAMEPAD_MASK_UP), frame(GAMEPAD_MASK_B2, GAMEPAD_MASK_UP), frame(0), frame(GAMEPAD_MASK_B1),
+	};
+
+	return checkFrames(turbo, inputs, outputs, 7);
+}
+
+CHECK_CASE("turbo/record")
+{
+	GamepadTurbo turbo(1000);
+	turbo.beginRecording(1, GAMEPAD_MASK_S1);
+	const GamepadState inputs[] =
+	{
+		frame(0), frame(0), frame(0), frame(0), frame(0),
+		frame(GAMEPAD_MASK_B3), frame(GAMEPAD_MASK_B3), frame(GAMEPAD_MASK_B3), frame(GAMEPAD_MASK_B3),
+		frame(GAMEPAD_MASK_B3 | GAMEPAD_MASK_B4, GAMEPAD_MASK_LEFT), frame(GAMEPAD_MASK_B3 | GAMEPAD_MASK_B4, GAMEPAD_MASK_LEFT),
+		frame(0), frame(0), frame(0),
+	};
+	if (!checkFrames(turbo, inputs, inputs, 14))
+		return false;
+
+	uint8_t count = turbo.endRecording();
+	const GamepadMacroStep *steps;
+	turbo.getMacroSteps(1, &steps);
+	if (count != 2 || steps[0].buttons != GAMEPAD_MASK_B3 || steps[0].ticks != 4
+		|| steps[1].buttons != (GAMEPAD_MASK_B3 | GAMEPAD_MASK_B4) || steps[1].dpad != GAMEPAD_MASK_LEFT || steps[1].ticks != 2)
+	{
+		printf("  recorded %u steps\n", count);
+		for (uint8_t i = 0; i < count; i++)
+			printf("    %04x %x for %u ticks\n", steps[i].buttons, steps[i].dpad, steps[i].ticks);
+		return false;
+	}
+
+	// Played back on S1
+	const GamepadState replay[] = { frame(GAMEPAD_MASK_S1), frame(0), frame(0), frame(0), frame(0), frame(0), frame(0) };
+	const GamepadState played[] =
+	{
+		frame(GAMEPAD_MASK_B3), frame(GAMEPAD_MASK_B3), frame(GAMEPAD_MASK_B3), frame(GAMEPAD_MASK_B3),
+		frame(GAMEPAD_MASK_B3 | GAMEPAD_MASK_B4, GAMEPAD_MASK_LEFT), frame(GAMEPAD_MASK_B3 | GAMEPAD_MASK_B4, GAMEPAD_MASK_LEFT),
+		frame(0),
+	};
+
+	return checkFrames(turbo, replay, played, 7);
+}
+
+CHECK_CASE("turbo/stall")
+{
+	GamepadTurbo turbo(1000);
+	const GamepadMacroStep steps[] = { { GAMEPAD_MASK_B1, 0, 40 }, { GAMEPAD_MASK_B2, 0, 40 } };
+	turbo.setMacro(0, GAMEPAD_MASK_S2, steps, 2);
+
+	uint32_t time = 0;
+	GamepadState state;
+	for (int i = 0; i < 5; i++)
+	{
+		turbo.onPoll();
+		state = frame(i == 0 ? GAMEPAD_MASK_S2 : 0);
+		turbo.update(state, ++time);
+	}
+
+	// 258 polls go by before the next frame, which runs a whole turn of the wheel rather than the 2 polls a byte
+	// counts, and 10 more frames reach the second step
+	for (int i = 0; i < 258; i++)
+		turbo.onPoll();
+	time += 258;
+
+	for (int i = 0; i < 10; i++)
+	{
+		turbo.onPoll();
+		state = frame(0);
+		turbo.update(state, time++);
+	}
+
+	if (state.buttons != GAMEPAD_MASK_B2)
+	{
+		printf("  after a frame 258 polls late: buttons %04x at tick %u, expected %04x\n", state.buttons,
+			turbo.getTicks(), GAMEPAD_MASK_B2);
+		return false;
+	}
+
+	// The host stops polling, and the clock finishes the macro
+	for (int i = 0; i < 100; i++)
+	{
+		state = frame(0);
+		turbo.update(state, time++);
+	}
+
+	if (turbo.isPlaying(0) || state.buttons)
+	{
+		printf("  100 ms after polls stopped: buttons %04x at tick %u, expected the macro to be done\n",
+			state.buttons, turbo.getTicks());
+		return false;
+	}
+
+	return true;
+}
+
+CHECK_CASE("turbo/pipeline")
+{
+	// Turbo runs on the debounced inputs, so the pipeline sends the toggling button, whether the frame runs through
+	// update() or the stages one at a time
+	bool ok = true;
+	for (int stages = 0; stages < 2; stages++)
+	{
+		GamepadTurbo turbo(1000);
+		turbo.setTurbo(GAMEPAD_MASK_B1, 250);
+
+		BenchGamepad gamepad(0);
+		gamepad.turbo = &turbo;
+		gamepad.options.inputMode = INPUT_MODE_HID;
+		gamepad.frames[0].buttons = GAMEPAD_MASK_B1;
+
+		uint8_t pattern = 0;
+		hostMillis = 1000;
+		for (int i = 0; i < 8; i++)
+		{
+			hostMillis++;
+			if (stages)
+				runGamepadStages(gamepad);
+			else
+				gamepad.update();
+
+			pattern = (pattern << 1) | (gamepad.state.buttons & GAMEPAD_MASK_B1);
+		}
+
+		if (pattern != 0xCC)
+		{
+			printf("  B1 over 8 frames %s was %02x, expected cc\n", stages ? "stage by stage" : "of update()", pattern);
+			ok = false;
+		}
+	}
+
+	return ok;
+}
@@ -0,0 +1,147 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "GamepadADC.h"
+
+/*
+	Synthetic ADC input for host builds.
+
+	ADCSynth produces the scans a board's ADC would, from a known signal plus Gaussian noise, quantized to the ADC
+	resolution. measureADC() runs a GamepadADC over the standard signals and reports the trade-off between noise
+	and lag for its settings, all in 16-bit counts and microseconds:
+
+	- noise: a stick held still off center, measured as the RMS and peak error of the output once settled.
+	- step: the stick snapped from center to full. This is the time from the snap until the output first gets 90%
+	  of the way there.
+	- ramp: the stick moved steadily across its range in 100 ms. This is the average lag of the output behind the
+	  true position, expressed as time.
+*/
+
+class ADCSynth
+{
+	public:
+		ADCSynth(uint8_t bits, double noiseLsb, uint32_t seed = 1) : bits(bits), noiseLsb(noiseLsb), rng(seed) { }
+
+		/**
+		 * @brief Sample a true position (0-1 of full scale) the way the ADC would.
+		 */
+		uint16_t sample(double position)
+		{
+			double full = (1U << bits) - 1;
+			double code = position * full + gaussian() * noiseLsb;
+			return static_cast<uint16_t>(std::max(0.0, std::min(full, round(code))));
+		}
+
+	protected:
+		// Irwin-Hall approximation, plenty for noise
+		double gaussian()
+		{
+			double sum = 0;
+			for (int i = 0; i < 12; i++)
+			{
+				rng = rng * 1664525U + 1013904223U;
+				sum += (rng >> 8) / 16777216.0;
+			}
+			return sum - 6.0;
+		}
+
+		uint8_t bits;
+		double noiseLsb;
+		uint32_t rng;
+};
+
+struct ADCMeasurement
+{
+	double noiseRms {0};  // 16-bit counts
+	double noisePeak {0}; // 16-bit counts
+	double stepUs {0};    // Time to 90% of a full step, or -1 if never reached
+	double rampLagUs {0}; // Average lag behind a steady sweep
+};
+
+/**
+ * @brief Measure noise and lag for an ADC configuration.
+ *
+ * @param scanUs Time between scans
+ * @param noiseLsb ADC noise, as a standard deviation in ADC counts
+ */
+inline ADCMeasurement measureADC(const GamepadADCConfig &config, double scanUs, double noiseLsb, uint32_t seed = 1)
+{
+	const GamepadADCAxis axes[] = { ADC_AXIS_LX };
+	const double scale = 65535.0;
+	ADCMeasurement result;
+
+	// Held still at 30% for 100 ms, measured over the second half
+	{
+		GamepadADC adc(axes, 1, config);
+		ADCSynth synth(config.bits, noiseLsb, seed);
+		const double position = 0.3;
+		double sumSquares = 0;
+		uint32_t count = 0;
+		for (double time = 0; time < 100000; time += scanUs)
+		{
+			uint16_t scan = synth.sample(position);
+			adc.push(&scan);
+			if (adc.update() && time >= 50000)
+			{
+				double error = adc.getValue(0) - position * scale;
+				sumSquares += error * error;
+				result.noisePeak = std::max(result.noisePeak, fabs(error));
+				count++;
+			}
+		}
+		result.noiseRms = count ? sqrt(sumSquares / count) : 0;
+	}
+
+	// Settled at center, then snapped to full at 20 ms
+	{
+		GamepadADC adc(axes, 1, config);
+		ADCSynth synth(config.bits, noiseLsb, seed);
+		const double stepAt = 20000;
+		result.stepUs = -1;
+		for (double time = 0; time < 60000; time += scanUs)
+		{
+			double position = (time < stepAt) ? 0.5 : 1.0;
+			uint16_t scan = synth.sample(position);
+			adc.push(&scan);
+			if (adc.update() && time >= stepAt && adc.getValue(0) >= (0.5 + 0.5 * 0.9) * scale)
+			{
+				result.stepUs = time + scanUs - stepAt;
+				break;
+			}
+		}
+	}
+
+	// Swept from 0 to 100% over 100 ms, lag averaged over the middle half
+	{
+		GamepadADC adc(axes, 1, config);
+		ADCSynth synth(config.bits, noiseLsb, seed);
+		const double sweepUs = 100000;
+		double lagSum = 0;
+		uint32_t count = 0;
+		for (double time = 0; time < sweepUs; time += scanUs)
+		{
+			uint16_t scan = synth.sample(time / sweepUs);
+			adc.push(&scan);
+			if (adc.update() && time >= sweepUs / 4 && time < sweepUs * 3 / 4)
+			{
+				// The newest scan was taken at `time`, a position behind it by `lag` was seen `lag` ago
+				double seen = adc.getValue(0) / scale;
+				lagSum += (time / sweepUs - seen) * sweepUs;
+				count++;
+			}
+		}
+		result.rampLagUs = count ? lagSum / count : 0;
+	}
+
+	return result;
+}
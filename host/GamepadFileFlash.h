@@ -0,0 +1,180 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "GamepadFlash.h"
+
+/**
+ * @brief GamepadFlash backed by a file, with NOR flash rules, wear counters and power loss injection.
+ *
+ * The file is memory-mapped, so the medium survives the process like real flash does and can be inspected or
+ * damaged from outside. Writes can only clear bits, and each sector's erases are counted:
+ *
+ *     GamepadFileFlash flash(4096, 4);
+ *     flash.open("options.bin");
+ *     GamepadLogStorage storage(&flash);
+ */
+class GamepadFileFlash : public GamepadFlash
+{
+	public:
+		GamepadFileFlash(uint32_t sectorSize = 4096, uint16_t sectorCount = 4, uint16_t writeSize = 1)
+			: sectorSize(sectorSize), sectorCount(sectorCount), writeSize(writeSize), erases(sectorCount) { }
+
+		~GamepadFileFlash() { close(); }
+
+		/**
+		 * @brief Map a flash image, creating or extending it with erased sectors as needed.
+		 */
+		bool open(const char *path)
+		{
+			close();
+			int fd = ::open(path, O_RDWR | O_CREAT, 0644);
+			if (fd < 0)
+				return false;
+
+			size_t size = static_cast<size_t>(sectorSize) * sectorCount;
+			struct stat info;
+			if (fstat(fd, &info) != 0 || ftruncate(fd, size) != 0)
+			{
+				::close(fd);
+				return false;
+			}
+
+			void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			::close(fd);
+			if (mapped == MAP_FAILED)
+				return false;
+
+			memory = static_cast<uint8_t *>(mapped);
+			mappedSize = size;
+			if (static_cast<size_t>(info.st_size) < size)
+				memset(memory + info.st_size, 0xFF, size - info.st_size);
+
+			return true;
+		}
+
+		void close()
+		{
+			if (memory)
+				munmap(memory, mappedSize);
+
+			memory = nullptr;
+			mappedSize = 0;
+		}
+
+		uint32_t getSectorSize() override { return sectorSize; }
+		uint16_t getSectorCount() override { return sectorCount; }
+		uint16_t getWriteSize() override { return writeSize; }
+
+		void read(uint32_t address, uint8_t *data, uint16_t length) override
+		{
+			reads++;
+			if (address + length <= mappedSize)
+				memcpy(data, memory + address, length);
+			else
+				memset(data, 0xFF, length);
+		}
+
+		bool write(uint32_t address, const uint8_t *data, uint16_t length) override
+		{
+			if (powerLost || address % writeSize != 0 || length % writeSize != 0 || address + length > mappedSize)
+			{
+				failures++;
+				return false;
+			}
+
+			writes++;
+			busyUs += writeUs;
+			for (uint16_t i = 0; i < length; i++)
+			{
+				if (budget == 0)
+				{
+					powerLost = true;
+					return false;
+				}
+
+				memory[address + i] &= data[i];
+				bytesWritten++;
+				if (budget > 0)
+					budget--;
+			}
+
+			return true;
+		}
+
+		bool erase(uint16_t sector) override
+		{
+			if (powerLost || sector >= sectorCount)
+				return false;
+
+			// An interrupted erase leaves the first half erased and the rest untouched
+			uint8_t *start = memory + static_cast<size_t>(sector) * sectorSize;
+			if (budget == 0)
+			{
+				memset(start, 0xFF, sectorSize / 2);
+				powerLost = true;
+				return false;
+			}
+
+			memset(start, 0xFF, sectorSize);
+			erases[sector]++;
+			busyUs += eraseUs;
+			if (budget > 0)
+				budget--;
+
+			return true;
+		}
+
+		/**
+		 * @brief Lose power after `operations` more bytes written or sectors erased, or never if negative.
+		 */
+		void failAfter(int64_t operations)
+		{
+			budget = operations;
+			powerLost = false;
+		}
+
+		/**
+		 * @brief Restore power after a simulated loss.
+		 */
+		void powerCycle()
+		{
+			budget = -1;
+			powerLost = false;
+		}
+
+		inline uint8_t *data() { return memory; }
+		inline bool hasLostPower() const { return powerLost; }
+
+		const uint32_t sectorSize;
+		const uint16_t sectorCount;
+		const uint16_t writeSize;
+
+		std::vector<uint32_t> erases;  // Per sector
+		uint64_t reads {0};
+		uint64_t writes {0};
+		uint64_t bytesWritten {0};
+		uint64_t failures {0};         // Rejected writes: misaligned, out of range or without power
+
+		// Time the medium would spend busy, for measuring how long a save stalls the caller
+		uint32_t eraseUs {0};          // Per sector erase
+		uint32_t writeUs {0};          // Per write call, e.g. one page program
+		uint64_t busyUs {0};
+
+	protected:
+		uint8_t *memory {nullptr};
+		size_t mappedSize {0};
+		int64_t budget {-1};
+		bool powerLost {false};
+};
@@ -0,0 +1,697 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "GamepadScheduler.h"
+#include "MPG.h"
+
+/*
+	Deterministic pipeline simulator for host builds.
+
+	A GamepadTimeline describes what the player does: physical press and release edges with microsecond timestamps,
+	optionally followed by contact bounce, either random or replayed from recorded GamepadBounceWaveform captures.
+	GamepadSimulator replays it through a real `MPG` subclass on a virtual clock, one scan every `scanPeriodUs`, and
+	samples the report the way the USB host would, once every `pollPeriodUs`. Each physical edge is matched to the
+	first poll whose report shows it, which gives the end-to-end input latency of presses and releases for the chosen
+	debounce, SOCD, D-pad and input mode settings.
+
+	Frames can be given a cost, so a report only becomes visible to the host some time after its inputs were read,
+	and polls can jitter and drift against the device clock. With `scheduled` set, the polls drive a
+	GamepadScheduler the way a USB start-of-frame interrupt would, and frames start when it says so. Every poll
+	records the age of the inputs in the report it picked up.
+
+	Inputs are packed as `buttons | (dpad << 16)`, so the GAMEPAD_MASK_B1..A2 and GAMEPAD_MASK_DU..DR masks can be
+	used directly.
+*/
+
+// Virtual millisecond clock backing getMillis() for host builds
+extern thread_local uint32_t hostMillis;
+
+#define GAMEPAD_SIM_INPUT_MASK (0x3FFFUL | (static_cast<uint32_t>(GAMEPAD_MASK_DPAD) << 16))
+
+/**
+ * @brief Recorded contact bounce: the times after an edge at which the contacts flip, an even number of them so
+ * they settle at the new level.
+ */
+struct GamepadBounceWaveform
+{
+	std::vector<uint32_t> flipsUs;
+
+	/**
+	 * @brief Take the bounce from a capture of one contact's level sampled every `periodUs`, e.g. from a logic
+	 * analyzer. The first change is the edge, and every change after it is bounce.
+	 */
+	static GamepadBounceWaveform fromSamples(const std::vector<uint8_t> &levels, uint32_t periodUs)
+	{
+		GamepadBounceWaveform waveform;
+		size_t edge = 0;
+		while (edge < levels.size() && levels[edge] == levels[0])
+			edge++;
+
+		for (size_t i = edge + 1; i < levels.size(); i++)
+		{
+			if (levels[i] != levels[i - 1])
+				waveform.flipsUs.push_back(static_cast<uint32_t>((i - edge) * periodUs));
+		}
+
+		// A capture that ends bouncing keeps the flips up to the last time it was at the new level
+		if (waveform.flipsUs.size() % 2)
+			waveform.flipsUs.pop_back();
+
+		return waveform;
+	}
+};
+
+/**
+ * @brief Scripted or recorded physical input over time.
+ */
+class GamepadTimeline
+{
+	public:
+		struct Edge
+		{
+			uint64_t timeUs;
+			uint32_t inputs;   // Inputs that changed
+			uint32_t level;    // Physical level of every input after the edge
+		};
+
+		struct Toggle
+		{
+			uint64_t timeUs;
+			uint32_t inputs;   // Raw input bits flipped at this time, including bounce
+		};
+
+		GamepadTimeline(uint32_t seed = 1) : rng(seed) { }
+
+		/**
+		 * @brief Press inputs at `timeUs`. Edges must be added in time order.
+		 *
+		 * @param bounceUs Contacts chatter for this long after the edge before settling
+		 */
+		void press(uint64_t timeUs, uint32_t inputs, uint32_t bounceUs = 0) { change(timeUs, level | inputs, bounceUs); }
+
+		/**
+		 * @brief Release inputs at `timeUs`. Edges must be added in time order.
+		 */
+		void release(uint64_t timeUs, uint32_t inputs, uint32_t bounceUs = 0) { change(timeUs, level & ~inputs, bounceUs); }
+
+		/**
+		 * @brief Press inputs at `timeUs`, bouncing as recorded.
+		 */
+		void press(uint64_t timeUs, uint32_t inputs, const GamepadBounceWaveform &waveform)
+		{
+			change(timeUs, level | inputs, waveform);
+		}
+
+		/**
+		 * @brief Release inputs at `timeUs`, bouncing as recorded.
+		 */
+		void release(uint64_t timeUs, uint32_t inputs, const GamepadBounceWaveform &waveform)
+		{
+			change(timeUs, level & ~inputs, waveform);
+		}
+
+		/**
+		 * @brief Press inputs at `timeUs` and release them `holdUs` later. Nothing else may be added in between.
+		 */
+		void tap(uint64_t timeUs, uint32_t inputs, uint32_t holdUs, uint32_t bounceUs = 0)
+		{
+			press(timeUs, inputs, bounceUs);
+			release(timeUs + holdUs, inputs, bounceUs);
+		}
+
+		/**
+		 * @brief Set the physical level of all inputs at `timeUs`. Edges must be added in time order.
+		 */
+		void change(uint64_t timeUs, uint32_t newLevel, uint32_t bounceUs = 0)
+		{
+			uint32_t changed = addEdge(timeUs, newLevel);
+
+			// Bounce is an even number of extra flips, so the inputs settle at the new level
+			if (changed && bounceUs > 1)
+			{
+				uint32_t flips = 2 * (1 + next() % 3);
+				for (uint32_t i = 0; i < flips; i++)
+					toggles.push_back({ timeUs + 1 + next() % (bounceUs - 1), changed });
+			}
+		}
+
+		/**
+		 * @brief Set the physical level of all inputs at `timeUs`, with the changed inputs bouncing as recorded.
+		 */
+		void change(uint64_t timeUs, uint32_t newLevel, const GamepadBounceWaveform &waveform)
+		{
+			uint32_t changed = addEdge(timeUs, newLevel);
+			if (changed == 0)
+				return;
+
+			for (uint32_t flipUs : waveform.flipsUs)
+				toggles.push_back({ timeUs + flipUs, changed });
+		}
+
+		/**
+		 * @brief Build a timeline from a recording of raw states sampled every `periodUs`.
+		 */
+		static GamepadTimeline fromFrames(const std::vector<GamepadState> &frames, uint32_t periodUs)
+		{
+			GamepadTimeline timeline;
+			for (size_t i = 0; i < frames.size(); i++)
+				timeline.change(i * periodUs, frames[i].buttons | (static_cast<uint32_t>(frames[i].dpad) << 16));
+
+			return timeline;
+		}
+
+		/**
+		 * @brief Sort the raw toggles. Called by the simulator before a run.
+		 */
+		void finish()
+		{
+			if (!sorted)
+			{
+				std::stable_sort(toggles.begin(), toggles.end(), [](const Toggle &a, const Toggle &b) { return a.timeUs < b.timeUs; });
+				sorted = true;
+			}
+		}
+
+		uint64_t endUs() const
+		{
+			uint64_t end = 0;
+			for (const Toggle &toggle : toggles)
+				end = std::max(end, toggle.timeUs);
+
+			return end;
+		}
+
+		std::vector<Edge> edges;
+		std::vector<Toggle> toggles;
+		uint32_t level {0};
+
+	protected:
+		uint32_t next() { rng = rng * 1664525U + 1013904223U; return rng >> 8; }
+
+		uint32_t addEdge(uint64_t timeUs, uint32_t newLevel)
+		{
+			newLevel &= GAMEPAD_SIM_INPUT_MASK;
+			uint32_t changed = level ^ newLevel;
+			if (changed == 0)
+				return 0;
+
+			level = newLevel;
+			edges.push_back({ timeUs, changed, level });
+			toggles.push_back({ timeUs, changed });
+			sorted = false;
+			return changed;
+		}
+
+		uint32_t rng;
+		bool sorted {true};
+};
+
+/**
+ * @brief Scripted play styles for sweeps.
+ */
+typedef enum
+{
+	GAMEPAD_SCENARIO_TAPS,     // Single button and direction taps with contact bounce
+	GAMEPAD_SCENARIO_SOCD,     // Fighting game style left/right and up/down rolls that overlap
+	GAMEPAD_SCENARIO_HOTKEYS,  // Taps mixed with F1/F2 hotkeys that change the D-pad and SOCD modes
+	GAMEPAD_SCENARIO_COUNT,
+} GamepadScenario;
+
+inline const char *getGamepadScenarioName(GamepadScenario scenario)
+{
+	switch (scenario)
+	{
+		case GAMEPAD_SCENARIO_TAPS:    return "taps";
+		case GAMEPAD_SCENARIO_SOCD:    return "socd";
+		case GAMEPAD_SCENARIO_HOTKEYS: return "hotkeys";
+		default:                       return "?";
+	}
+}
+
+/**
+ * @brief Generate a timeline for a scenario. Deterministic for a given seed.
+ *
+ * @param maxBounceUs Each edge bounces for a random time up to this long
+ * @param waveforms Recorded bounce to pick from at random for each edge instead, if given and not empty
+ */
+inline GamepadTimeline generateGamepadScenario(GamepadScenario scenario, uint64_t durationUs, uint32_t maxBounceUs = 2000,
+	uint32_t seed = 1, const std::vector<GamepadBounceWaveform> *waveforms = nullptr)
+{
+	GamepadTimeline timeline(seed);
+	uint32_t rng = seed * 2654435761U;
+	auto next = [&rng]() { rng = rng * 1664525U + 1013904223U; return rng >> 8; };
+	auto bounce = [&]() { return maxBounceUs ? next() % (maxBounceUs + 1) : 0; };
+	bool recorded = waveforms && !waveforms->empty();
+	auto waveform = [&]() -> const GamepadBounceWaveform & { return (*waveforms)[next() % waveforms->size()]; };
+
+	auto press = [&](uint64_t timeUs, uint32_t inputs)
+	{
+		if (recorded)
+			timeline.press(timeUs, inputs, waveform());
+		else
+			timeline.press(timeUs, inputs, bounce());
+	};
+
+	auto release = [&](uint64_t timeUs, uint32_t inputs)
+	{
+		if (recorded)
+			timeline.release(timeUs, inputs, waveform());
+		else
+			timeline.release(timeUs, inputs, bounce());
+	};
+
+	static const uint32_t directions[4] = { GAMEPAD_MASK_DU, GAMEPAD_MASK_DD, GAMEPAD_MASK_DL, GAMEPAD_MASK_DR };
+	static const uint32_t hotkeys[] =
+	{
+		GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2 | GAMEPAD_MASK_DU, // Home
+		GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2 | GAMEPAD_MASK_DL, // D-pad as left stick
+		GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2 | GAMEPAD_MASK_DD, // D-pad digital
+		GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3 | GAMEPAD_MASK_DL, // SOCD last input
+		GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3 | GAMEPAD_MASK_DD, // SOCD neutral
+	};
+
+	uint64_t time = 10000;
+	while (time < durationUs)
+	{
+		switch (scenario)
+		{
+			case GAMEPAD_SCENARIO_SOCD:
+			{
+				// Hold one direction, roll onto its opposite, then let go of the first
+				uint32_t axis = (next() % 2) * 2;
+				uint32_t first = directions[axis + next() % 2];
+				uint32_t second = (first == directions[axis]) ? directions[axis + 1] : directions[axis];
+				uint32_t overlapUs = 2000 + next() % 30000;
+
+				press(time, first);
+				time += 20000 + next() % 60000;
+				press(time, second);
+				time += overlapUs;
+				release(time, first);
+				time += 20000 + next() % 60000;
+				release(time, second);
+				time += 20000 + next() % 100000;
+				break;
+			}
+
+			case GAMEPAD_SCENARIO_HOTKEYS:
+				if (next() % 8 == 0)
+				{
+					uint32_t hotkey = hotkeys[next() % (sizeof(hotkeys) / sizeof(hotkeys[0]))];
+					uint32_t modifiers = hotkey & ~(static_cast<uint32_t>(GAMEPAD_MASK_DPAD) << 16);
+					press(time, modifiers);
+					time += 30000 + next() % 50000;
+					press(time, hotkey & ~modifiers);
+					time += 50000 + next() % 50000;
+					release(time, hotkey);
+					time += 50000 + next() % 100000;
+					break;
+				}
+
+				// Fall through to a plain tap
+				[[fallthrough]];
+
+			default:
+			{
+				uint32_t input = (next() % 3 == 0) ? directions[next() % 4] : (1UL << (next() % GAMEPAD_BUTTON_COUNT));
+				uint32_t holdUs = 30000 + next() % 120000;
+				if (recorded)
+				{
+					timeline.press(time, input, waveform());
+					timeline.release(time + holdUs, input, waveform());
+				}
+				else
+				{
+					timeline.tap(time, input, holdUs, bounce());
+				}
+				time += holdUs + 20000 + next() % 150000;
+				break;
+			}
+		}
+	}
+
+	return timeline;
+}
+
+/**
+ * @brief Decodes reports back into the packed inputs a USB host would see.
+ */
+class GamepadReportDecoder
+{
+	public:
+		/**
+		 * @brief Inputs that have a representation in a report mode.
+		 */
+		static uint32_t getObservableInputs(InputMode mode)
+		{
+			const GamepadReportMapping &mapping = getMapping(mode);
+			uint32_t inputs = static_cast<uint32_t>(GAMEPAD_MASK_DPAD) << 16;
+			for (int i = 0; i < GAMEPAD_BUTTON_COUNT; i++)
+			{
+				if (mapping.buttons[i] != 0 || (mode == INPUT_MODE_XINPUT && (buttonMasks[i] & (GAMEPAD_MASK_L2 | GAMEPAD_MASK_R2))))
+					inputs |= buttonMasks[i];
+			}
+
+			return inputs;
+		}
+
+		/**
+		 * @brief Decode a report built in `mode`. D-pad directions sent as a stick in `dpadMode` are decoded as well.
+		 */
+		static uint32_t decode(InputMode mode, DpadMode dpadMode, const void *report)
+		{
+			uint16_t bits;
+			uint8_t dpad = 0;
+			uint16_t x = GAMEPAD_JOYSTICK_MID;
+			uint16_t y = GAMEPAD_JOYSTICK_MID;
+			uint32_t inputs = 0;
+
+			if (mode == INPUT_MODE_XINPUT)
+			{
+				const XInputReport *xinput = static_cast<const XInputReport *>(report);
+				bits = xinput->buttons1 | (xinput->buttons2 << 8);
+				for (int d = 0; d < 4; d++)
+				{
+					if (bits & xinputReportMapping.dpad[d])
+						dpad |= dpadMasks[d];
+				}
+
+				if (xinput->lt) inputs |= GAMEPAD_MASK_L2;
+				if (xinput->rt) inputs |= GAMEPAD_MASK_R2;
+
+				int16_t sx = (dpadMode == DPAD_MODE_RIGHT_ANALOG) ? xinput->rx : xinput->lx;
+				int16_t sy = (dpadMode == DPAD_MODE_RIGHT_ANALOG) ? xinput->ry : xinput->ly;
+				x = static_cast<uint16_t>(sx) ^ 0x8000;
+				y = ~(static_cast<uint16_t>(sy) ^ 0x8000);
+			}
+			else
+			{
+				// HID and Switch share the leading layout
+				const HIDReport *hid = static_cast<const HIDReport *>(report);
+				bits = hid->buttons;
+				for (uint8_t value = 0; value < 16; value++)
+				{
+					if (hatReportTable[value] == hid->hat && hid->hat != HID_HAT_NOTHING)
+					{
+						dpad = value;
+						break;
+					}
+				}
+
+				uint8_t sx = (dpadMode == DPAD_MODE_RIGHT_ANALOG) ? hid->rx : hid->lx;
+				uint8_t sy = (dpadMode == DPAD_MODE_RIGHT_ANALOG) ? hid->ry : hid->ly;
+				x = (sx << 8) | sx;
+				y = (sy << 8) | sy;
+			}
+
+			const GamepadReportMapping &mapping = getMapping(mode);
+			for (int i = 0; i < GAMEPAD_BUTTON_COUNT; i++)
+			{
+				if (mapping.buttons[i] != 0 && (bits & mapping.buttons[i]))
+					inputs |= buttonMasks[i];
+			}
+
+			if (dpadMode != DPAD_MODE_DIGITAL)
+			{
+				if (x < 0x4000) dpad |= GAMEPAD_MASK_LEFT;
+				if (x > 0xC000) dpad |= GAMEPAD_MASK_RIGHT;
+				if (y < 0x4000) dpad |= GAMEPAD_MASK_UP;
+				if (y > 0xC000) dpad |= GAMEPAD_MASK_DOWN;
+			}
+
+			return inputs | (static_cast<uint32_t>(dpad) << 16);
+		}
+
+	protected:
+		static const GamepadReportMapping &getMapping(InputMode mode)
+		{
+			switch (mode)
+			{
+				case INPUT_MODE_XINPUT: return xinputReportMapping;
+				case INPUT_MODE_SWITCH: return switchReportMapping;
+				default:                return hidReportMapping;
+			}
+		}
+};
+
+/**
+ * @brief MPG board whose inputs are set by the simulator.
+ */
+class SimulatedGamepad : public MPG
+{
+	public:
+		SimulatedGamepad(int debounceMS = 5) : MPG(debounceMS) { }
+
+		void setup() override { }
+
+		void read() override
+		{
+			state = GamepadState();
+			state.buttons = static_cast<uint16_t>(raw);
+			state.dpad = static_cast<uint8_t>(raw >> 16);
+		}
+
+		uint32_t raw {0};
+};
+
+struct GamepadSimConfig
+{
+	InputMode inputMode {INPUT_MODE_XINPUT};
+	SOCDMode socdMode {SOCD_MODE_NEUTRAL};
+	DpadMode dpadMode {DPAD_MODE_DIGITAL};
+	uint8_t debounceMS {5};
+	DebounceMode debounceMode {DEBOUNCE_MODE_LOCKOUT};
+	int16_t releaseDebounceMS {-1}; // Release window of every input, or -1 for `debounceMS`
+	uint32_t scanPeriodUs {100};    // Time between loop() iterations, 0 to start the next frame as soon as one ends
+	uint32_t frameCostUs {0};       // Time from read() to the report being ready for the host
+	uint32_t frameJitterUs {0};     // Random extra frame time, up to this much
+	uint32_t pollPeriodUs {1000};   // USB polling interval (bInterval)
+	uint32_t pollPhaseUs {0};       // Offset of the first poll from the start of the timeline
+	uint32_t pollJitterUs {0};      // Random lateness of each poll, up to this much
+	int32_t pollDriftPpm {0};       // Host clock speed relative to the device clock
+	bool scheduled {false};         // Start frames with a GamepadScheduler fed by the polls instead of every scanPeriodUs
+	uint16_t guardUs {GAMEPAD_SCHEDULER_GUARD_US};
+	uint32_t idleUs {4};            // Time between ready() checks while the scheduler waits
+	uint32_t seed {1};
+};
+
+struct GamepadSimResult
+{
+	uint64_t frames {0};
+	uint64_t polls {0};
+	uint32_t edges {0};       // Physical edges on inputs the report can show
+	uint32_t delivered {0};   // Edges that reached the host
+	uint32_t lost {0};        // Edges that never reached the host, e.g. masked by SOCD or a hotkey, or too short
+	uint32_t phantom {0};     // Report transitions without a physical edge: leaked bounce, SOCD or hotkey outputs
+	std::vector<uint32_t> latencies;  // Per delivered edge, in microseconds, sorted after run()
+	std::vector<uint32_t> pressLatencies;    // The same for presses alone
+	std::vector<uint32_t> releaseLatencies;  // And for releases
+	std::vector<uint32_t> ages;       // Per poll, time since the polled report's inputs were read, sorted after run()
+
+	/**
+	 * @brief Latency at a percentile from 0 to 100.
+	 */
+	uint32_t latency(double percent) const { return percentile(latencies, percent); }
+	uint32_t pressLatency(double percent) const { return percentile(pressLatencies, percent); }
+	uint32_t releaseLatency(double percent) const { return percentile(releaseLatencies, percent); }
+
+	double meanLatency() const { return mean(latencies); }
+	double meanPressLatency() const { return mean(pressLatencies); }
+	double meanReleaseLatency() const { return mean(releaseLatencies); }
+
+	/**
+	 * @brief Input age at a percentile from 0 to 100.
+	 */
+	uint32_t age(double percent) const { return percentile(ages, percent); }
+	double meanAge() const { return mean(ages); }
+
+	static uint32_t percentile(const std::vector<uint32_t> &values, double percent)
+	{
+		if (values.empty())
+			return 0;
+
+		size_t index = static_cast<size_t>(percent / 100.0 * (values.size() - 1) + 0.5);
+		return values[index];
+	}
+
+	static double mean(const std::vector<uint32_t> &values)
+	{
+		double sum = 0;
+		for (uint32_t value : values)
+			sum += value;
+
+		return values.empty() ? 0 : sum / values.size();
+	}
+};
+
+/**
+ * @brief Replays a timeline through MPG and measures what the USB host sees.
+ */
+template <class Gamepad = SimulatedGamepad>
+class GamepadSimulator
+{
+	public:
+		// The virtual clock starts here so debounce timestamps of 0 are already expired
+		static const uint64_t CLOCK_START_US = 1000000;
+
+		// Keep polling this long after the last edge so late edges can be delivered
+		static const uint64_t TAIL_US = 100000;
+
+		GamepadSimResult run(GamepadTimeline &timeline, const GamepadSimConfig &config)
+		{
+			timeline.finish();
+
+			Gamepad gamepad(config.debounceMS);
+			gamepad.debouncer.setMode(config.debounceMode);
+			if (config.releaseDebounceMS >= 0)
+			{
+				uint8_t releaseMS = static_cast<uint8_t>(config.releaseDebounceMS);
+				gamepad.debouncer.setButtonInterval((1U << GAMEPAD_BUTTON_COUNT) - 1, config.debounceMS, releaseMS);
+				gamepad.debouncer.setDpadInterval(GAMEPAD_MASK_DPAD, config.debounceMS, releaseMS);
+			}
+
+			gamepad.options.inputMode = config.inputMode;
+			gamepad.options.socdMode = config.socdMode;
+			gamepad.options.dpadMode = config.dpadMode;
+
+			// One idle frame clears the state MPG keeps between calls
+			hostMillis = CLOCK_START_US / 1000;
+			gamepad.raw = 0;
+			const void *report = gamepad.update();
+
+			GamepadSimResult result;
+			GamepadScheduler scheduler(config.guardUs);
+			uint32_t observable = GamepadReportDecoder::getObservableInputs(config.inputMode);
+			uint32_t visible = GamepadReportDecoder::decode(gamepad.options.inputMode, gamepad.options.dpadMode, report);
+			uint32_t seen = visible;
+			uint32_t decodedGeneration = gamepad.generation;
+			uint64_t visibleRead = 0;
+			uint32_t pending = 0;
+			uint32_t pendingLevel = 0;
+			uint64_t pendingTime[32];
+
+			const GamepadTimeline::Toggle *toggle = timeline.toggles.data();
+			const GamepadTimeline::Toggle *toggleEnd = toggle + timeline.toggles.size();
+			const GamepadTimeline::Edge *edge = timeline.edges.data();
+			const GamepadTimeline::Edge *edgeEnd = edge + timeline.edges.size();
+
+			uint64_t end = timeline.endUs() + TAIL_US;
+			uint64_t pollIndex = 0;
+			uint32_t rng = config.seed;
+			uint32_t raw = 0;
+
+			auto random = [&rng](uint32_t limit) -> uint32_t
+			{
+				rng = rng * 1664525U + 1013904223U;
+				return limit ? (rng >> 8) % (limit + 1) : 0;
+			};
+
+			auto pollTime = [&config, &pollIndex, &random]() -> uint64_t
+			{
+				int64_t nominal = static_cast<int64_t>(pollIndex) * config.pollPeriodUs;
+				return config.pollPhaseUs + nominal + nominal * config.pollDriftPpm / 1000000 + random(config.pollJitterUs);
+			};
+
+			// Polls before `until` see the last published report
+			uint64_t nextPoll = pollTime();
+			auto pollUntil = [&](uint64_t until)
+			{
+				for (; nextPoll < until; pollIndex++, nextPoll = pollTime())
+				{
+					result.polls++;
+					result.ages.push_back(static_cast<uint32_t>(nextPoll - visibleRead));
+					if (config.scheduled)
+						scheduler.onPoll(static_cast<uint32_t>(CLOCK_START_US + nextPoll));
+
+					uint32_t changed = visible ^ seen;
+					seen = visible;
+
+					// An edge is delivered once the report shows its level, which may already be the case, e.g. a release
+					// while SOCD cleaning was hiding the input
+					uint32_t delivered = pending & ~(seen ^ pendingLevel);
+					result.phantom += __builtin_popcount(changed & ~delivered);
+					if (delivered == 0)
+						continue;
+
+					result.delivered += __builtin_popcount(delivered);
+					pending &= ~delivered;
+					for (uint32_t bits = delivered; bits; bits &= bits - 1)
+					{
+						uint32_t bit = __builtin_ctz(bits);
+						uint32_t latency = static_cast<uint32_t>(nextPoll - pendingTime[bit]);
+						result.latencies.push_back(latency);
+						if ((pendingLevel >> bit) & 1)
+							result.pressLatencies.push_back(latency);
+						else
+							result.releaseLatencies.push_back(latency);
+					}
+				}
+			};
+
+			for (uint64_t time = 0; time < end; )
+			{
+				pollUntil(time);
+				if (config.scheduled && !scheduler.ready(static_cast<uint32_t>(CLOCK_START_US + time)))
+				{
+					time += config.idleUs;
+					continue;
+				}
+
+				for (; toggle != toggleEnd && toggle->timeUs <= time; toggle++)
+					raw ^= toggle->inputs;
+
+				for (; edge != edgeEnd && edge->timeUs <= time; edge++)
+				{
+					uint32_t inputs = edge->inputs & observable;
+					result.edges += __builtin_popcount(inputs);
+					result.lost += __builtin_popcount(pending & inputs);
+					pending |= inputs;
+					pendingLevel = (pendingLevel & ~inputs) | (edge->level & inputs);
+					for (uint32_t bits = inputs; bits; bits &= bits - 1)
+						pendingTime[__builtin_ctz(bits)] = edge->timeUs;
+				}
+
+				hostMillis = static_cast<uint32_t>((CLOCK_START_US + time) / 1000);
+				gamepad.raw = raw;
+				report = gamepad.update();
+				result.frames++;
+
+				// Polls while the frame runs still see the previous report
+				uint64_t ready = time + config.frameCostUs + random(config.frameJitterUs);
+				pollUntil(ready);
+
+				if (gamepad.generation != decodedGeneration)
+				{
+					decodedGeneration = gamepad.generation;
+					visible = GamepadReportDecoder::decode(gamepad.options.inputMode, gamepad.options.dpadMode, report);
+				}
+				visibleRead = time;
+
+				if (config.scheduled)
+				{
+					scheduler.done(static_cast<uint32_t>(CLOCK_START_US + time), static_cast<uint32_t>(CLOCK_START_US + ready));
+					time = std::max(ready, time + 1);
+				}
+				else
+				{
+					time = std::max(ready, time + std::max(config.scanPeriodUs, 1U));
+				}
+			}
+
+			result.lost += __builtin_popcount(pending);
+			std::sort(result.latencies.begin(), result.latencies.end());
+			std::sort(result.pressLatencies.begin(), result.pressLatencies.end());
+			std::sort(result.releaseLatencies.begin(), result.releaseLatencies.end());
+			std::sort(result.ages.begin(), result.ages.end());
+			return result;
+		}
+};
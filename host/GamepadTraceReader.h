@@ -0,0 +1,133 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "GamepadTrace.h"
+
+/**
+ * @brief Sequential reader for GamepadTrace.h traces.
+ *
+ * Files are memory-mapped, so traces of any size are read in place with no copies and no per-record allocation:
+ *
+ *     GamepadTraceReader reader;
+ *     if (reader.open("capture.mpgr"))
+ *         while (reader.next())
+ *             use(reader.timeUs, reader.state);
+ */
+class GamepadTraceReader
+{
+	public:
+		~GamepadTraceReader() { close(); }
+
+		/**
+		 * @brief Map a trace file.
+		 *
+		 * @return bool False if the file cannot be mapped or has no valid header
+		 */
+		bool open(const char *path)
+		{
+			close();
+			int fd = ::open(path, O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			struct stat info;
+			if (fstat(fd, &info) != 0 || info.st_size < GAMEPAD_TRACE_HEADER_SIZE)
+			{
+				::close(fd);
+				return false;
+			}
+
+			void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (mapped == MAP_FAILED)
+				return false;
+
+			madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+			mapping = mapped;
+			mappingSize = info.st_size;
+			return open(static_cast<const uint8_t *>(mapped), mappingSize);
+		}
+
+		/**
+		 * @brief Read a trace from memory. The data must outlive the reader.
+		 */
+		bool open(const uint8_t *trace, size_t traceSize)
+		{
+			if (!checkGamepadTraceHeader(trace, traceSize))
+				return false;
+
+			data = trace;
+			size = traceSize;
+			rewind();
+			return true;
+		}
+
+		void close()
+		{
+			if (mapping)
+				munmap(mapping, mappingSize);
+
+			mapping = nullptr;
+			mappingSize = 0;
+			data = nullptr;
+			size = 0;
+		}
+
+		/**
+		 * @brief Go back to the first record.
+		 */
+		void rewind()
+		{
+			offset = GAMEPAD_TRACE_HEADER_SIZE;
+			state = GamepadState();
+			timeUs = 0;
+			deltaUs = 0;
+			records = 0;
+			malformed = false;
+		}
+
+		/**
+		 * @brief Advance to the next record.
+		 *
+		 * @return bool False at the end of the trace, or at a truncated or malformed record (see `malformed`)
+		 */
+		inline bool next()
+		{
+			if (offset >= size)
+				return false;
+
+			size_t length = decodeGamepadTraceRecord(data + offset, size - offset, deltaUs, state);
+			if (length == 0)
+			{
+				malformed = true;
+				return false;
+			}
+
+			offset += length;
+			timeUs += deltaUs;
+			records++;
+			return true;
+		}
+
+		GamepadState state;        // State after the current record
+		uint64_t timeUs {0};       // Time of the current record since the start of the trace
+		uint32_t deltaUs {0};      // Time since the previous record
+		uint64_t records {0};      // Records read so far
+		size_t offset {0};         // Byte offset of the next record
+		size_t size {0};           // Trace size in bytes
+		bool malformed {false};
+
+	protected:
+		const uint8_t *data {nullptr};
+		void *mapping {nullptr};
+		size_t mappingSize {0};
+};
@@ -0,0 +1,221 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "GamepadDebouncer.h"
+#include "GamepadRapidTrigger.h"
+
+/*
+	Synthetic analog key travel for host builds.
+
+	A TravelScript is how a player moves one analog key: a path of travel positions (0 at rest, 1 bottomed out)
+	over time, moving at a finite speed between them. Each point where the key turns around is an edge the player
+	meant. Turning down is a press and turning up is a release. measureTravel() samples the script once every
+	`scanUs`, with Gaussian noise on every reading, and runs it through a GamepadRapidTrigger key and optionally a
+	GamepadDebouncer. It then matches each output edge to the edge the player meant, all in microseconds:
+
+	- press and release: time from the key turning around until the output changes, mean and worst case.
+	- missed: edges the player meant that never showed, e.g. a key lifted too little to get back past a fixed
+	  actuation point.
+	- extra: output edges the player did not mean, e.g. noise chattering around a threshold.
+*/
+
+// Virtual millisecond clock backing getMillis() for host builds
+extern thread_local uint32_t hostMillis;
+
+class TravelScript
+{
+	public:
+		struct Point
+		{
+			double timeUs;
+			double position;
+		};
+
+		/**
+		 * @param strokeUs Time the key takes to move its full travel
+		 */
+		TravelScript(double strokeUs) : strokeUs(strokeUs) { points.push_back({ 0, 0 }); }
+
+		/**
+		 * @brief Move the key to `position`, starting `holdUs` after it reached the previous point.
+		 */
+		void moveTo(double position, double holdUs)
+		{
+			const Point last = points.back();
+			double start = last.timeUs + holdUs;
+			points.push_back({ start, last.position });
+			points.push_back({ start + fabs(position - last.position) * strokeUs, position });
+		}
+
+		double position(double timeUs) const
+		{
+			auto next = std::upper_bound(points.begin(), points.end(), timeUs, [](double time, const Point &point) { return time < point.timeUs; });
+			if (next == points.begin())
+				return points.front().position;
+			if (next == points.end())
+				return points.back().position;
+
+			const Point &from = *(next - 1);
+			double span = next->timeUs - from.timeUs;
+			return (span > 0) ? from.position + (next->position - from.position) * (timeUs - from.timeUs) / span : next->position;
+		}
+
+		double duration() const { return points.back().timeUs; }
+
+		/**
+		 * @brief The edges the player meant: the times the key turned around, with the level it turned to.
+		 */
+		void edges(std::vector<Point> &out) const
+		{
+			int direction = 0;
+			for (size_t i = 1; i < points.size(); i++)
+			{
+				double delta = points[i].position - points[i - 1].position;
+				int turn = (delta > 0) ? 1 : (delta < 0) ? -1 : 0;
+				if (turn != 0 && turn != direction)
+				{
+					out.push_back({ points[i - 1].timeUs, (turn > 0) ? 1.0 : 0.0 });
+					direction = turn;
+				}
+			}
+		}
+
+		/**
+		 * @brief Full presses from rest to the bottom and back, held for `holdUs` each way.
+		 */
+		static TravelScript taps(double strokeUs, uint32_t count, double holdUs)
+		{
+			TravelScript script(strokeUs);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				script.moveTo(1, holdUs);
+				script.moveTo(0, holdUs);
+			}
+			return script;
+		}
+
+		/**
+		 * @brief A key pressed to the bottom, then lifted only to `high` and pressed again, over and over.
+		 */
+		static TravelScript trills(double strokeUs, uint32_t count, double high, double holdUs)
+		{
+			TravelScript script(strokeUs);
+			script.moveTo(1, holdUs);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				script.moveTo(high, holdUs);
+				script.moveTo(1, holdUs);
+			}
+			script.moveTo(0, holdUs);
+			return script;
+		}
+
+	protected:
+		double strokeUs;
+		std::vector<Point> points;
+};
+
+struct TravelMeasurement
+{
+	double pressMeanUs {0};
+	double pressMaxUs {0};
+	double releaseMeanUs {0};
+	double releaseMaxUs {0};
+	uint32_t edges {0};  // Edges the player meant
+	uint32_t missed {0};
+	uint32_t extra {0};
+};
+
+/**
+ * @brief Run a script through one key.
+ *
+ * @param debounceMS Debounce the key's output for this long after a change, or 0 for no debouncer
+ * @param noise Reading noise, as a standard deviation in travel (0-1)
+ */
+inline TravelMeasurement measureTravel(const TravelScript &script, const GamepadKeyConfig &config, uint8_t debounceMS,
+	double scanUs, double noise, uint32_t seed = 1)
+{
+	GamepadRapidTrigger trigger(1);
+	trigger.configure(0, config);
+	GamepadDebouncer debouncer(debounceMS);
+
+	std::vector<TravelScript::Point> meant;
+	script.edges(meant);
+
+	TravelMeasurement result;
+	result.edges = meant.size();
+	uint32_t presses = 0;
+	uint32_t releases = 0;
+
+	uint32_t rng = seed;
+	auto gaussian = [&rng]() {
+		double sum = 0;
+		for (int i = 0; i < 12; i++)
+		{
+			rng = rng * 1664525U + 1013904223U;
+			sum += (rng >> 8) / 16777216.0;
+		}
+		return sum - 6.0;
+	};
+
+	// The last edge matched, and the latest edge the player meant up to now
+	int matched = -1;
+	int latest = -1;
+	bool level = false;
+	for (double time = 0; time < script.duration() + 20000; time += scanUs)
+	{
+		hostMillis = static_cast<uint32_t>(time / 1000);
+		double reading = (script.position(time) + gaussian() * noise) * GAMEPAD_TRAVEL_FULL;
+		trigger.travel[0] = static_cast<uint16_t>(std::max(0.0, std::min<double>(GAMEPAD_TRAVEL_FULL, round(reading))));
+
+		GamepadState state;
+		trigger.read(state);
+		if (debounceMS)
+			debouncer.debounce(&state);
+
+		while (latest + 1 < static_cast<int>(meant.size()) && meant[latest + 1].timeUs <= time)
+			latest++;
+
+		bool output = state.buttons & 1;
+		if (output == level)
+			continue;
+
+		level = output;
+		if (latest <= matched || (meant[latest].position > 0.5) != output)
+		{
+			result.extra++;
+			continue;
+		}
+
+		result.missed += latest - matched - 1;
+		matched = latest;
+		double latency = time - meant[latest].timeUs;
+		if (output)
+		{
+			result.pressMeanUs += latency;
+			result.pressMaxUs = std::max(result.pressMaxUs, latency);
+			presses++;
+		}
+		else
+		{
+			result.releaseMeanUs += latency;
+			result.releaseMaxUs = std::max(result.releaseMaxUs, latency);
+			releases++;
+		}
+	}
+
+	result.missed += meant.size() - matched - 1;
+	result.pressMeanUs = presses ? result.pressMeanUs / presses : 0;
+	result.releaseMeanUs = releases ? result.releaseMeanUs / releases : 0;
+	return result;
+}
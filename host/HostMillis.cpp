@@ -0,0 +1,17 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#include <stdint.h>
+
+// Host builds drive debouncing from a virtual clock instead of a hardware timer. Each thread has its own, so threads
+// running separate gamepads do not share a clock. Tests that need finer steps give the gamepad a GamepadVirtualClock.
+thread_local uint32_t hostMillis = 0;
+
+uint32_t getMillis() { return hostMillis; }
+
+// Only used by builds with GAMEPAD_CLOCK_MICROS, which read the board's time from here instead of `getMillis()`
+thread_local uint32_t hostMicros = 0;
+
+uint32_t getMicros() { return hostMicros; }
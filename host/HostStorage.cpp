@@ -0,0 +1,15 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#include "GamepadStorage.h"
+
+// Boards implement the default GamepadStorage themselves, host builds keep the options in memory
+static GamepadOptions hostOptions;
+
+void GamepadStorage::start() { }
+void GamepadStorage::save() { }
+
+GamepadOptions GamepadStorage::getGamepadOptions() { return hostOptions; }
+void GamepadStorage::setGamepadOptions(GamepadOptions options) { hostOptions = options; }
@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * MPG analog acquisition noise and latency report
+ *
+ * Usage: MPGADC [--scan-us <n>] [--noise <lsb>] [--bits <n>]
+ *
+ * Feeds synthetic ADC scans (20 us apart, 12-bit, 2 LSB of noise by default) through GamepadADC with a range of
+ * oversampling and filter settings, and prints the noise left on a still stick against the lag on a step and a
+ * steady sweep, see GamepadADCSynth.h.
+ *
+ * Exits with 1 if the default adaptive filter is not quieter than the raw samples.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GamepadADCSynth.h"
+
+struct NamedConfig
+{
+	const char *name;
+	uint8_t oversample;
+	uint8_t minAlpha;
+	uint8_t beta;
+};
+
+static const NamedConfig configs[] =
+{
+	{ "raw",                  1,  0,   0 },
+	{ "oversample 4",         4,  0,   0 },
+	{ "oversample 16",       16,  0,   0 },
+	{ "4 + EMA 1/16",         4, 16,   0 },
+	{ "4 + EMA 1/32",         4,  8,   0 },
+	{ "4 + adaptive",         4, 16, 128 },
+	{ "4 + adaptive, slow",   4,  8,  32 },
+	{ "16 + adaptive",       16, 16, 128 },
+};
+
+int main(int argc, char **argv)
+{
+	double scanUs = 20;
+	double noise = 2;
+	int bits = 12;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--scan-us") == 0 && i + 1 < argc)
+			scanUs = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc)
+			noise = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--bits") == 0 && i + 1 < argc)
+			bits = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--scan-us <n>] [--noise <lsb>] [--bits <n>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("%d-bit ADC, %.1f LSB noise, one scan every %.1f us\n", bits, noise, scanUs);
+	printf("%-20s %12s %12s %12s %12s\n", "settings", "noise rms", "noise peak", "step 90% us", "ramp lag us");
+
+	double rawNoise = 0;
+	double adaptiveNoise = 0;
+	for (const NamedConfig &named : configs)
+	{
+		GamepadADCConfig config;
+		config.bits = bits;
+		config.oversample = named.oversample;
+		config.minAlpha = named.minAlpha;
+		config.beta = named.beta;
+
+		ADCMeasurement result = measureADC(config, scanUs, noise);
+		printf("%-20s %12.1f %12.0f %12.0f %12.1f\n", named.name, result.noiseRms, result.noisePeak, result.stepUs, result.rampLagUs);
+
+		if (named.oversample == 1 && named.minAlpha == 0)
+			rawNoise = result.noiseRms;
+		if (named.oversample == 4 && named.minAlpha == 16 && named.beta != 0)
+			adaptiveNoise = result.noiseRms;
+	}
+
+	return (adaptiveNoise < rawNoise) ? 0 : 1;
+}
@@ -0,0 +1,381 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * MPG host benchmark
+ *
+ * Runs every registered BENCH_CASE and prints ns/op percentiles and throughput. With `--check <file>` the results
+ * are compared against a stored baseline and the process exits non-zero if any case got slower than the allowed
+ * tolerance, which lets CTest catch performance regressions. The cases are measured in passes and each one is
+ * compared by the median over its quiet runs. On a shared host other tenants can slow the load-heavy cases by up to
+ * 2x for seconds at a time, more than any useful tolerance, so only batches whose probe (see Bench.h) is within 6%
+ * of its quiet level count, and a run counts once half of its batches do. Passes continue until every case
+ * has `--repeats` quiet runs. If a case cannot get enough of them the check is reported as skipped rather than
+ * passed or failed. The baseline records each case's quiet probe level next to its ratio.
+ *
+ * On Linux the benchmark re-runs itself without address randomization and pins the page offsets of its stack and
+ * buffers, so two runs of the same build give the same layout.
+ *
+ * Usage: MPGBench [--filter <text>] [--samples <n>] [--batch <n>] [--repeats <n>] [--check <file>]
+ *                 [--tolerance <fraction>] [--write-baseline <file>] [--list]
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#ifdef __linux__
+#include <alloca.h>
+#include <malloc.h>
+#include <sys/personality.h>
+#include <unistd.h>
+#endif
+
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include "Bench.h"
+
+// Fixed integer workload every case is normalized against
+static double measureReference(Bench &bench)
+{
+	bench.run([](uint32_t n) {
+		uint32_t x = 1;
+		for (uint32_t i = 0; i < n; i++)
+		{
+			x = x * 1664525U + 1013904223U;
+			benchKeep(x);
+		}
+	});
+
+	BenchResult result = bench.summarize("reference");
+	return result.p50;
+}
+
+// A batch is quiet when its probe is within this fraction of the probe's quiet level
+static const double quietMargin = 0.06;
+
+// How far a case's quiet level may sit above the machine's
+static const double caseOffsetLimit = 0.05;
+
+// A case needs at least this many quiet runs to be checked at all
+static const uint32_t minQuietRuns = 3;
+
+// Exit code for a check that could not be measured, reported to CTest as a skip
+static const int exitSkipped = 77;
+
+// The batches of one measurement, kept until the quiet level is known
+struct BenchRun
+{
+	const char *name;
+	std::vector<double> timings;
+	std::vector<double> probes;
+	double referenceNs;
+};
+
+// The probes after the batches of some runs, relative to their reference
+static void appendProbes(std::vector<double> &probes, const std::vector<BenchRun> &runs)
+{
+	for (const BenchRun &run : runs)
+	{
+		for (double probe : run.probes)
+			probes.push_back(probe / run.referenceNs);
+	}
+}
+
+// A low percentile of the probes rather than the quickest one, because a reference measured in a burst of noise makes
+// the probes against it look quieter than the machine ever gets
+static double getProbeFloor(std::vector<double> probes)
+{
+	if (probes.empty())
+		return HUGE_VAL;
+
+	size_t index = std::min(std::max<size_t>(probes.size() / 50, 4), probes.size() - 1);
+	std::nth_element(probes.begin(), probes.begin() + index, probes.end());
+	return probes[index];
+}
+
+// The probe's quiet level for a case. It is per case because the probe runs a few percent slower after some cases than
+// after others, but capped against the machine's level so a case that only ever ran while the machine was busy does
+// not take its busy level for a quiet one. A recorded level takes precedence when this run never got as quiet.
+static double getQuietLevel(const std::vector<BenchRun> &runs, double machineLevel, double recorded)
+{
+	std::vector<double> probes;
+	appendProbes(probes, runs);
+	return std::min({ getProbeFloor(probes), machineLevel * (1.0 + caseOffsetLimit), recorded });
+}
+
+// Measure one case against a fresh reference
+static BenchRun runCase(Bench &bench, const Bench::Case &c)
+{
+	bench.referenceNs = measureReference(bench);
+	c.func(bench);
+	return { c.name, bench.getTimings(), bench.getProbes(), bench.referenceNs };
+}
+
+// The runs where at least half of the batches were quiet, summarized over those batches. The probe does not
+// see all of the noise, and the quiet batches of a mostly busy run are often as slow as the rest of it.
+static std::vector<BenchResult> getQuietRuns(const std::vector<BenchRun> &runs, double quietLevel)
+{
+	std::vector<BenchResult> quiet;
+	for (const BenchRun &run : runs)
+	{
+		double probeLimit = quietLevel * (1.0 + quietMargin) * run.referenceNs;
+		BenchResult result = Bench::summarize(run.name, run.timings, run.probes, probeLimit, run.referenceNs);
+		if (result.samples * 2 >= run.timings.size())
+			quiet.push_back(result);
+	}
+
+	return quiet;
+}
+
+// The run with the median ratio
+static BenchResult medianRun(std::vector<BenchResult> runs)
+{
+	std::sort(runs.begin(), runs.end(), [](const BenchResult &a, const BenchResult &b) { return a.ratio < b.ratio; });
+	return runs[runs.size() / 2];
+}
+
+struct BaselineEntry
+{
+	double ratio;
+	double probe; // Quiet probe level, relative to the reference
+};
+
+static std::map<std::string, BaselineEntry> readBaseline(const char *path)
+{
+	std::map<std::string, BaselineEntry> baseline;
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream fields(line);
+		std::string name;
+		BaselineEntry entry { 0, HUGE_VAL };
+		if (fields >> name >> entry.ratio)
+		{
+			fields >> entry.probe;
+			baseline[name] = entry;
+		}
+	}
+
+	return baseline;
+}
+
+static bool writeBaseline(const char *path, const std::vector<BenchResult> &results, const std::vector<double> &levels)
+{
+	FILE *file = fopen(path, "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "# MPGBench baseline: <case> <p50 ns/op divided by reference ns/op> <quiet probe ns/op, likewise>\n");
+	for (size_t i = 0; i < results.size(); i++)
+		fprintf(file, "%s %.4f %.4f\n", results[i].name.c_str(), results[i].ratio, levels[i]);
+
+	fclose(file);
+	return true;
+}
+
+static void printResult(const BenchResult &result)
+{
+	printf("%-36s %9.2f %9.2f %9.2f %9.2f %9.2f %10.2f %8.3f\n",
+		result.name.c_str(), result.min, result.p50, result.p90, result.p99, result.max,
+		1000.0 / result.p50, result.ratio);
+}
+
+int main(int argc, char **argv)
+{
+#ifdef __linux__
+	// Address randomization lands code and data in different cache sets and predictor slots on every run, which
+	// moves some cases by 2x between runs of the same build. Start over once without it.
+	int persona = personality(0xffffffff);
+	if (persona != -1 && !(persona & ADDR_NO_RANDOMIZE) && personality(persona | ADDR_NO_RANDOMIZE) != -1)
+		execv("/proc/self/exe", argv);
+
+	// Frame buffers come from the heap, so where they land against the stack depends on what was allocated before,
+	// e.g. whether a baseline was read. Mapping every buffer of a page or more gives them the same page offset in
+	// every run.
+	mallopt(M_MMAP_THRESHOLD, 4096);
+
+	// The stack starts below the arguments and environment, so shift it to the same page offset in every run
+	char *stackPad = static_cast<char *>(alloca(reinterpret_cast<uintptr_t>(__builtin_frame_address(0)) & 4095));
+	benchKeep(stackPad);
+#endif
+
+	const char *filter = nullptr;
+	const char *checkPath = nullptr;
+	const char *writePath = nullptr;
+	double tolerance = 0.15;
+	uint32_t repeats = 5;
+	bool listOnly = false;
+
+	Bench bench;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		if (arg == "--filter" && hasValue)
+			filter = argv[++i];
+		else if (arg == "--samples" && hasValue)
+			bench.samples = strtoul(argv[++i], nullptr, 10);
+		else if (arg == "--batch" && hasValue)
+			bench.batchSize = strtoul(argv[++i], nullptr, 10);
+		else if (arg == "--repeats" && hasValue)
+			repeats = strtoul(argv[++i], nullptr, 10);
+		else if (arg == "--check" && hasValue)
+			checkPath = argv[++i];
+		else if (arg == "--tolerance" && hasValue)
+			tolerance = strtod(argv[++i], nullptr);
+		else if (arg == "--write-baseline" && hasValue)
+			writePath = argv[++i];
+		else if (arg == "--list")
+			listOnly = true;
+		else
+		{
+			fprintf(stderr, "Unknown argument: %s\n", arg.c_str());
+			return 2;
+		}
+	}
+
+	if (bench.samples == 0 || bench.batchSize == 0 || repeats == 0)
+	{
+		fprintf(stderr, "--samples, --batch and --repeats must be non-zero\n");
+		return 2;
+	}
+
+	std::vector<Bench::Case> cases = Bench::cases();
+	std::sort(cases.begin(), cases.end(), [](const Bench::Case &a, const Bench::Case &b) { return strcmp(a.name, b.name) < 0; });
+
+	if (listOnly)
+	{
+		for (const Bench::Case &c : cases)
+			printf("%s\n", c.name);
+		return 0;
+	}
+
+	std::map<std::string, BaselineEntry> baseline;
+	if (checkPath)
+	{
+		baseline = readBaseline(checkPath);
+		if (baseline.empty())
+		{
+			fprintf(stderr, "Baseline %s is missing or empty\n", checkPath);
+			return 2;
+		}
+	}
+
+	bench.referenceNs = measureReference(bench);
+	printf("reference: %.3f ns/op, %u samples x %u ops, median of %u quiet runs\n\n", bench.referenceNs, bench.samples,
+		bench.batchSize, repeats);
+
+	std::vector<const Bench::Case *> selected;
+	std::vector<double> recordedLevels;
+	for (const Bench::Case &c : cases)
+	{
+		if (filter && !strstr(c.name, filter))
+			continue;
+
+		auto expected = baseline.find(c.name);
+		selected.push_back(&c);
+		recordedLevels.push_back(expected != baseline.end() ? expected->second.probe : HUGE_VAL);
+	}
+
+	// Every case gets `repeats` passes, then cases short of quiet runs get more until the pass limit
+	std::vector<std::vector<BenchRun>> runs(selected.size());
+	std::vector<double> levels(selected.size(), HUGE_VAL);
+	uint32_t passes = 0;
+	for (bool waiting = true; waiting && passes < repeats * 16; passes++)
+	{
+		for (size_t i = 0; i < selected.size(); i++)
+		{
+			if (passes >= repeats && getQuietRuns(runs[i], levels[i]).size() >= repeats)
+				continue;
+
+			runs[i].push_back(runCase(bench, *selected[i]));
+		}
+
+		std::vector<double> probes;
+		for (const std::vector<BenchRun> &caseRuns : runs)
+			appendProbes(probes, caseRuns);
+
+		double machineLevel = getProbeFloor(probes);
+		waiting = false;
+		for (size_t i = 0; i < selected.size(); i++)
+		{
+			levels[i] = getQuietLevel(runs[i], machineLevel, recordedLevels[i]);
+			waiting |= (getQuietRuns(runs[i], levels[i]).size() < repeats);
+		}
+	}
+
+	printf("%-36s %9s %9s %9s %9s %9s %10s %8s\n", "case (ns/op)", "min", "p50", "p90", "p99", "max", "Mops/s", "ratio");
+
+	std::vector<BenchResult> results;
+	std::vector<double> resultLevels;
+	int regressions = 0;
+	int unmeasured = 0;
+	for (size_t i = 0; i < selected.size(); i++)
+	{
+		std::vector<BenchResult> quiet = getQuietRuns(runs[i], levels[i]);
+		if (quiet.size() < std::min(minQuietRuns, repeats))
+		{
+			printf("%-36s\n  (only %zu of %zu runs were quiet)\n", selected[i]->name, quiet.size(), runs[i].size());
+			unmeasured++;
+			continue;
+		}
+
+		BenchResult result = medianRun(quiet);
+		auto expected = baseline.find(result.name);
+		bool regressed = (expected != baseline.end() && result.ratio > expected->second.ratio * (1.0 + tolerance));
+
+		printResult(result);
+		results.push_back(result);
+		resultLevels.push_back(levels[i]);
+
+		if (regressed)
+		{
+			printf("  REGRESSION: ratio %.3f exceeds baseline %.3f by more than %.0f%%\n",
+				result.ratio, expected->second.ratio, tolerance * 100);
+			regressions++;
+		}
+		else if (checkPath && expected == baseline.end())
+		{
+			printf("  (no baseline entry)\n");
+		}
+	}
+
+	printf("\n%u passes\n", passes);
+
+	if (writePath)
+	{
+		if (unmeasured)
+		{
+			fprintf(stderr, "%d case(s) had too few quiet runs, %s not written\n", unmeasured, writePath);
+			return 2;
+		}
+
+		if (!writeBaseline(writePath, results, resultLevels))
+		{
+			fprintf(stderr, "Could not write %s\n", writePath);
+			return 2;
+		}
+	}
+
+	if (regressions)
+	{
+		printf("\n%d case(s) regressed\n", regressions);
+		return 1;
+	}
+
+	if (checkPath && unmeasured)
+	{
+		printf("\n%d case(s) could not be measured while the machine was quiet\n", unmeasured);
+		return exitSkipped;
+	}
+
+	return 0;
+}
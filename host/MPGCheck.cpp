@@ -0,0 +1,40 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * MPG host checks
+ *
+ * Usage: MPGCheck [name filter]
+ */
+
+#include <string.h>
+
+#include "Check.h"
+
+int main(int argc, char **argv)
+{
+	const char *filter = (argc > 1) ? argv[1] : nullptr;
+	int failures = 0;
+	int ran = 0;
+
+	for (const Check::Case &c : Check::cases())
+	{
+		if (filter && !strstr(c.name, filter))
+			continue;
+
+		bool ok = c.func();
+		printf("%-40s %s\n", c.name, ok ? "OK" : "FAIL");
+		failures += ok ? 0 : 1;
+		ran++;
+	}
+
+	if (ran == 0)
+	{
+		printf("No checks matched\n");
+		return 2;
+	}
+
+	return failures ? 1 : 0;
+}
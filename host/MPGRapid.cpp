@@ -0,0 +1,104 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * MPG analog key latency report
+ *
+ * Usage: MPGRapid [--scan-us <n>] [--stroke-ms <n>] [--noise <percent>] [--debounce <ms>]
+ *
+ * Plays scripted taps and trills on an analog key (full travel in 10 ms, read every 100 us with 0.5% noise by
+ * default) and compares a fixed actuation point at half travel plus debouncing, as a switch would be read, against
+ * rapid trigger. Prints press and release latency and the edges missed or added, see GamepadTravelSynth.h.
+ *
+ * Exits with 1 if rapid trigger does not release faster than the fixed actuation point with debouncing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GamepadTravelSynth.h"
+
+struct NamedPath
+{
+	const char *name;
+	uint16_t actuation;
+	uint16_t sensitivity;
+	bool rapid;
+	bool debounce;
+};
+
+static const NamedPath paths[] =
+{
+	{ "fixed 50% + debounce", 32768,    0, false, true },
+	{ "fixed 50%",            32768,    0, false, false },
+	{ "fixed 50%, 5% hyst.",  32768, 3277, false, false },
+	{ "rapid 5%",              6554, 3277, true,  false },
+	{ "rapid 2.5%",            6554, 1638, true,  false },
+};
+
+int main(int argc, char **argv)
+{
+	double scanUs = 100;
+	double strokeUs = 10000;
+	double noise = 0.5;
+	int debounceMS = 5;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--scan-us") == 0 && i + 1 < argc)
+			scanUs = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--stroke-ms") == 0 && i + 1 < argc)
+			strokeUs = strtod(argv[++i], nullptr) * 1000;
+		else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc)
+			noise = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--debounce") == 0 && i + 1 < argc)
+			debounceMS = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--scan-us <n>] [--stroke-ms <n>] [--noise <percent>] [--debounce <ms>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	struct
+	{
+		const char *name;
+		TravelScript script;
+	} scenarios[] =
+	{
+		{ "taps",              TravelScript::taps(strokeUs, 50, 30000) },
+		{ "trills to 40%",     TravelScript::trills(strokeUs, 50, 0.4, 15000) },
+		{ "trills to 70%",     TravelScript::trills(strokeUs, 50, 0.7, 15000) },
+	};
+
+	printf("Full travel in %.1f ms, read every %.0f us, %.1f%% noise, %d ms debounce\n", strokeUs / 1000, scanUs, noise, debounceMS);
+
+	double fixedRelease = 0;
+	double rapidRelease = 0;
+	for (const auto &scenario : scenarios)
+	{
+		printf("\n%s\n", scenario.name);
+		printf("%-22s %10s %10s %12s %12s %8s %8s\n", "settings", "press us", "press max", "release us", "release max", "missed", "extra");
+		for (const NamedPath &path : paths)
+		{
+			GamepadKeyConfig config;
+			config.actuation = path.actuation;
+			config.pressSensitivity = path.sensitivity;
+			config.releaseSensitivity = path.sensitivity;
+			config.rapid = path.rapid;
+
+			TravelMeasurement result = measureTravel(scenario.script, config, path.debounce ? debounceMS : 0, scanUs, noise / 100);
+			printf("%-22s %10.0f %10.0f %12.0f %12.0f %4u/%-3u %8u\n", path.name, result.pressMeanUs, result.pressMaxUs,
+				result.releaseMeanUs, result.releaseMaxUs, result.missed, result.edges, result.extra);
+
+			if (&scenario == &scenarios[0] && &path == &paths[0])
+				fixedRelease = result.releaseMeanUs;
+			if (&scenario == &scenarios[0] && &path == &paths[3])
+				rapidRelease = result.releaseMeanUs;
+		}
+	}
+
+	return (rapidRelease < fixedRelease) ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * MPG many-controller load test
+ *
+ * Usage: MPGScale [--seconds <n>] [--instances <max>] [--threads <n>]
+ *
+ * Runs 1, 2, 4, ... up to <max> independent gamepads, sharded round robin over up to <threads> threads (all hardware
+ * threads by default). Every gamepad replays its own mashing input through the full update() pipeline, one frame per
+ * round, and each thread advances its own virtual clock once per round. For each count it prints the total frames per
+ * second and the frames per second per thread, i.e. per core while there are no more threads than cores.
+ *
+ * Exits with 1 if any thread made no progress.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "BenchGamepad.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct ScaleResult
+{
+	uint64_t frames {0};
+	double seconds {0};
+	unsigned threads {0};
+};
+
+static ScaleResult runInstances(unsigned instances, unsigned maxThreads, double seconds)
+{
+	unsigned threadCount = std::min(instances, maxThreads);
+	std::vector<std::vector<std::unique_ptr<BenchGamepad>>> shards(threadCount);
+	for (unsigned i = 0; i < instances; i++)
+	{
+		std::unique_ptr<BenchGamepad> gamepad(new BenchGamepad());
+		gamepad->load(generateInputMix(INPUT_MIX_MASHING, 1024, 1 + i));
+		gamepad->options.inputMode = static_cast<InputMode>(i % 3);
+		gamepad->options.socdMode = SOCD_MODE_SECOND_INPUT_PRIORITY;
+		shards[i % threadCount].push_back(std::move(gamepad));
+	}
+
+	std::atomic<bool> running {true};
+	std::vector<uint64_t> frames(threadCount);
+	std::vector<std::thread> threads;
+	Clock::time_point start = Clock::now();
+	for (unsigned t = 0; t < threadCount; t++)
+	{
+		threads.emplace_back([&, t]() {
+			std::vector<std::unique_ptr<BenchGamepad>> &shard = shards[t];
+			uint64_t count = 0;
+			hostMillis = 1000;
+			while (running.load(std::memory_order_relaxed))
+			{
+				for (std::unique_ptr<BenchGamepad> &gamepad : shard)
+				{
+					bool changed;
+					benchKeep(gamepad->update(&changed));
+				}
+				count += shard.size();
+				hostMillis++;
+			}
+			frames[t] = count;
+		});
+	}
+
+	std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+	running = false;
+	for (std::thread &thread : threads)
+		thread.join();
+
+	ScaleResult result;
+	result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	result.threads = threadCount;
+	for (uint64_t count : frames)
+	{
+		if (count == 0)
+			return ScaleResult();
+
+		result.frames += count;
+	}
+
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	double seconds = 0.5;
+	unsigned maxInstances = 256;
+	unsigned maxThreads = std::max(1U, std::thread::hardware_concurrency());
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+			seconds = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc)
+			maxInstances = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			maxThreads = std::max(1, atoi(argv[++i]));
+		else
+		{
+			fprintf(stderr, "Usage: %s [--seconds <n>] [--instances <max>] [--threads <n>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("hardware threads: %u, using up to %u\n", std::thread::hardware_concurrency(), maxThreads);
+	printf("%10s %8s %16s %16s %12s\n", "instances", "threads", "frames/s", "frames/s/core", "ns/frame");
+
+	bool ok = true;
+	for (unsigned instances = 1; ; instances *= 2)
+	{
+		instances = std::min(instances, maxInstances);
+		ScaleResult result = runInstances(instances, maxThreads, seconds);
+		if (result.frames == 0)
+		{
+			printf("%10u %8u no progress\n", instances, std::min(instances, maxThreads));
+			ok = false;
+		}
+		else
+		{
+			double rate = result.frames / result.seconds;
+			double perCore = rate / result.threads;
+			printf("%10u %8u %16.0f %16.0f %12.1f\n", instances, result.threads, rate, perCore, 1e9 / perCore);
+		}
+
+		if (instances == maxInstances)
+			break;
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * MPG input latency sweep
+ *
+ * Usage: MPGSim [--seconds <n>] [--bounce <us>] [--scan <us>] [--poll <us>] [--seed <n>] [--waveforms <file>]
+ *
+ * Replays each scripted scenario (taps, SOCD rolls, hotkeys) for `seconds` of simulated time through every
+ * combination of input mode, SOCD mode and debounce time, and prints the end-to-end latency from physical edge to
+ * USB poll, along with lost edges and phantom report transitions. Use it to compare settings before flashing them.
+ *
+ * A second table plays taps through each debounce mode, with press and release latency apart. Edges bounce for a
+ * random time up to `bounce`, or as one of the recorded waveforms in the `waveforms` file: one capture per line,
+ * the sample period in microseconds followed by the contact's level as 0s and 1s, e.g. `100 0001101011111`.
+ *
+ * A second table compares a spinning loop() against one driven by GamepadScheduler for a range of frame times, on
+ * jittery, drifting polls: the age of the inputs in each polled report, the edge latency, and frames run per poll.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "GamepadSimulator.h"
+
+static const char *getInputModeName(InputMode mode)
+{
+	switch (mode)
+	{
+		case INPUT_MODE_XINPUT: return "xinput";
+		case INPUT_MODE_SWITCH: return "switch";
+		default:                return "hid";
+	}
+}
+
+static const char *getSOCDModeName(SOCDMode mode)
+{
+	switch (mode)
+	{
+		case SOCD_MODE_UP_PRIORITY:          return "up";
+		case SOCD_MODE_NEUTRAL:              return "neutral";
+		case SOCD_MODE_SECOND_INPUT_PRIORITY: return "last";
+		case SOCD_MODE_FIRST_INPUT_PRIORITY:  return "first";
+		default:                              return "custom";
+	}
+}
+
+static const char *getDebounceModeName(DebounceMode mode)
+{
+	switch (mode)
+	{
+		case DEBOUNCE_MODE_ASYMMETRIC: return "asymmetric";
+		case DEBOUNCE_MODE_EAGER:      return "eager";
+		case DEBOUNCE_MODE_DEFER:      return "defer";
+		default:                       return "lockout";
+	}
+}
+
+// One capture per line, the sample period and then the levels, skipping blank lines and # comments
+static bool loadWaveforms(const char *path, std::vector<GamepadBounceWaveform> &waveforms)
+{
+	FILE *file = fopen(path, "r");
+	if (!file)
+		return false;
+
+	char line[4096];
+	while (fgets(line, sizeof(line), file))
+	{
+		char *levels = nullptr;
+		unsigned long periodUs = strtoul(line, &levels, 10);
+		if (levels == line || periodUs == 0)
+			continue;
+
+		std::vector<uint8_t> samples;
+		for (char *c = levels; *c; c++)
+		{
+			if (*c == '0' || *c == '1')
+				samples.push_back(*c == '1');
+		}
+
+		GamepadBounceWaveform waveform = GamepadBounceWaveform::fromSamples(samples, periodUs);
+		if (samples.size() > 1)
+			waveforms.push_back(waveform);
+	}
+
+	fclose(file);
+	return !waveforms.empty();
+}
+
+int main(int argc, char **argv)
+{
+	double seconds = 60.0;
+	uint32_t bounceUs = 2000;
+	uint32_t seed = 1;
+	GamepadSimConfig base;
+	std::vector<GamepadBounceWaveform> waveforms;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+			seconds = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--bounce") == 0 && i + 1 < argc)
+			bounceUs = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--scan") == 0 && i + 1 < argc)
+			base.scanPeriodUs = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--poll") == 0 && i + 1 < argc)
+			base.pollPeriodUs = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--waveforms") == 0 && i + 1 < argc)
+		{
+			if (!loadWaveforms(argv[++i], waveforms))
+			{
+				fprintf(stderr, "No waveforms in %s\n", argv[i]);
+				return 2;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--seconds <n>] [--bounce <us>] [--scan <us>] [--poll <us>] [--seed <n>] "
+				"[--waveforms <file>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (base.scanPeriodUs == 0 || base.pollPeriodUs == 0)
+	{
+		fprintf(stderr, "Scan and poll periods must be non-zero\n");
+		return 2;
+	}
+
+	static const InputMode inputModes[] = { INPUT_MODE_XINPUT, INPUT_MODE_SWITCH, INPUT_MODE_HID };
+	static const SOCDMode socdModes[] = { SOCD_MODE_NEUTRAL, SOCD_MODE_UP_PRIORITY, SOCD_MODE_SECOND_INPUT_PRIORITY,
+		SOCD_MODE_FIRST_INPUT_PRIORITY };
+	static const uint8_t debounceTimes[] = { 0, 1, 2, 5, 10 };
+
+	printf("scan %u us, poll %u us, bounce up to %u us, %.0f s per run\n\n", base.scanPeriodUs, base.pollPeriodUs, bounceUs, seconds);
+	printf("%-8s %-7s %-8s %4s %7s %9s %9s %9s %9s %6s %8s\n",
+		"scenario", "mode", "socd", "ms", "edges", "mean us", "p50 us", "p99 us", "max us", "lost", "phantom");
+
+	GamepadSimulator<> simulator;
+	uint64_t frames = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	for (int scenario = 0; scenario < GAMEPAD_SCENARIO_COUNT; scenario++)
+	{
+		GamepadTimeline timeline = generateGamepadScenario(static_cast<GamepadScenario>(scenario),
+			static_cast<uint64_t>(seconds * 1e6), bounceUs, seed);
+
+		for (InputMode inputMode : inputModes)
+		{
+			for (SOCDMode socdMode : socdModes)
+			{
+				for (uint8_t debounceMS : debounceTimes)
+				{
+					GamepadSimConfig config = base;
+					config.inputMode = inputMode;
+					config.socdMode = socdMode;
+					config.debounceMS = debounceMS;
+
+					GamepadSimResult result = simulator.run(timeline, config);
+					frames += result.frames;
+
+					printf("%-8s %-7s %-8s %4u %7u %9.0f %9u %9u %9u %6u %8u\n",
+						getGamepadScenarioName(static_cast<GamepadScenario>(scenario)), getInputModeName(inputMode),
+						getSOCDModeName(socdMode), debounceMS, result.edges, result.meanLatency(), result.latency(50),
+						result.latency(99), result.latency(100), result.lost, result.phantom);
+				}
+			}
+		}
+	}
+
+	printf("\n%-10s %5s %7s %9s %9s %9s %9s %6s %8s\n",
+		"debounce", "ms", "edges", "press", "p99", "release", "p99", "lost", "phantom");
+
+	struct DebounceRun
+	{
+		DebounceMode mode;
+		uint8_t pressMS;
+		int16_t releaseMS;
+	};
+
+	static const DebounceRun debounceRuns[] =
+	{
+		{ DEBOUNCE_MODE_LOCKOUT, 5, -1 },
+		{ DEBOUNCE_MODE_ASYMMETRIC, 5, 2 },
+		{ DEBOUNCE_MODE_ASYMMETRIC, 2, 8 },
+		{ DEBOUNCE_MODE_EAGER, 5, 5 },
+		{ DEBOUNCE_MODE_EAGER, 5, 10 },
+		{ DEBOUNCE_MODE_DEFER, 5, 5 },
+	};
+
+	GamepadTimeline bouncyTaps = generateGamepadScenario(GAMEPAD_SCENARIO_TAPS, static_cast<uint64_t>(seconds * 1e6),
+		bounceUs, seed, &waveforms);
+	for (const DebounceRun &run : debounceRuns)
+	{
+		GamepadSimConfig config = base;
+		config.debounceMS = run.pressMS;
+		config.debounceMode = run.mode;
+		config.releaseDebounceMS = run.releaseMS;
+
+		GamepadSimResult result = simulator.run(bouncyTaps, config);
+		frames += result.frames;
+
+		char windows[16];
+		snprintf(windows, sizeof(windows), "%u/%u", run.pressMS, run.releaseMS < 0 ? run.pressMS : run.releaseMS);
+		printf("%-10s %5s %7u %9.0f %9u %9.0f %9u %6u %8u\n", getDebounceModeName(run.mode), windows, result.edges,
+			result.meanPressLatency(), result.pressLatency(99), result.meanReleaseLatency(), result.releaseLatency(99),
+			result.lost, result.phantom);
+	}
+
+	printf("\n%-9s %-9s %9s %9s %9s %9s %9s %7s\n",
+		"frame us", "loop", "age mean", "age p99", "age max", "lat mean", "lat p99", "frames");
+
+	static const uint32_t frameCosts[] = { 50, 150, 300, 600 };
+	GamepadTimeline taps = generateGamepadScenario(GAMEPAD_SCENARIO_TAPS, static_cast<uint64_t>(seconds * 1e6), 0, seed);
+	for (uint32_t frameCost : frameCosts)
+	{
+		for (int scheduled = 0; scheduled < 2; scheduled++)
+		{
+			GamepadSimConfig config = base;
+			config.debounceMS = 0;
+			config.scanPeriodUs = 0;
+			config.frameCostUs = frameCost;
+			config.frameJitterUs = frameCost / 8;
+			config.pollJitterUs = 10;
+			config.pollDriftPpm = 100;
+			config.scheduled = scheduled;
+			config.seed = seed;
+
+			GamepadSimResult result = simulator.run(taps, config);
+			frames += result.frames;
+
+			printf("%-9u %-9s %9.0f %9u %9u %9.0f %9u %7.2f\n", frameCost, scheduled ? "scheduled" : "spin",
+				result.meanAge(), result.age(99), result.age(100), result.meanLatency(), result.latency(99),
+				result.polls ? static_cast<double>(result.frames) / result.polls : 0.0);
+		}
+	}
+
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("\n%llu frames in %.2f s, %.1f M frames/s\n", static_cast<unsigned long long>(frames), elapsed, frames / elapsed / 1e6);
+
+	return 0;
+}
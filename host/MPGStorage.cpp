@@ -0,0 +1,211 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * MPG options storage wear benchmark
+ *
+ * Usage: MPGStorage [--saves <n>] [--endurance <cycles>] [--image <file>]
+ *
+ * Saves changing options `saves` times through GamepadLogStorage on file-backed flash in a few typical layouts, and
+ * prints the erase and write counts, how evenly the erases are spread, how many reads the next boot needs to find
+ * the newest options, and how many saves the medium would last at `endurance` erase cycles per sector. The last
+ * column compares that with rewriting the options in place, which costs one erase per save on flash.
+ *
+ * A second table gives the longest the flash keeps a frame waiting, from typical datasheet erase and write times,
+ * when each save runs to completion and when it is spread over frames with `stepSave()`. An erase cannot be split, so
+ * the frames that erase are also left out, which is every frame but one per sector filled.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "GamepadFileFlash.h"
+#include "GamepadLogStorage.h"
+
+struct StorageLayout
+{
+	const char *name;
+	uint32_t sectorSize;
+	uint16_t sectorCount;
+	uint16_t writeSize;
+	uint32_t eraseUs;
+	uint32_t writeUs;
+};
+
+static const StorageLayout layouts[] =
+{
+	{ "eeprom-1k",   256,  4,   1,   460000, 3400 }, // AVR EEPROM, erased a byte at a time
+	{ "flash-2x4k",  4096, 2,   256, 45000,  800 },  // QSPI NOR, e.g. RP2040
+	{ "flash-4x4k",  4096, 4,   256, 45000,  800 },
+	{ "flash-8x4k",  4096, 8,   16,  25000,  70 },
+};
+
+struct StorageStall
+{
+	uint64_t most {0};         // Longest the flash was busy in one call
+	uint64_t mostWriting {0};  // The same, leaving out calls that erased a sector
+};
+
+static uint64_t countErases(const GamepadFileFlash &flash)
+{
+	uint64_t total = 0;
+	for (uint32_t count : flash.erases)
+		total += count;
+
+	return total;
+}
+
+// Save changing options `saves` times, whole or a step per call
+static StorageStall runSaves(GamepadFileFlash &flash, uint32_t saves, bool sliced, GamepadOptions &options)
+{
+	GamepadLogStorage storage(&flash);
+	storage.start();
+
+	StorageStall stall;
+	uint64_t busy = flash.busyUs;
+	uint64_t erases = countErases(flash);
+	auto measure = [&]()
+	{
+		uint64_t taken = flash.busyUs - busy;
+		stall.most = std::max(stall.most, taken);
+		if (countErases(flash) == erases)
+			stall.mostWriting = std::max(stall.mostWriting, taken);
+
+		busy = flash.busyUs;
+		erases = countErases(flash);
+	};
+
+	for (uint32_t n = 0; n < saves; n++)
+	{
+		options.socdMode = static_cast<SOCDMode>(n % 3);
+		options.invertXAxis = (n / 3) % 2;
+
+		if (sliced)
+		{
+			storage.beginSave(options);
+			while (!storage.stepSave())
+				measure();
+		}
+		else
+		{
+			storage.setGamepadOptions(options);
+			storage.save();
+		}
+		measure();
+	}
+
+	return stall;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t saves = 100000;
+	double endurance = 100000;
+	const char *image = "mpg-storage.bin";
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--saves") == 0 && i + 1 < argc)
+			saves = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--endurance") == 0 && i + 1 < argc)
+			endurance = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc)
+			image = argv[++i];
+		else
+		{
+			fprintf(stderr, "Usage: %s [--saves <n>] [--endurance <cycles>] [--image <file>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("%u saves, %.0f erase cycles per sector\n\n", saves, endurance);
+	printf("%-11s %6s %8s %8s %10s %11s %10s %8s %12s %8s\n",
+		"layout", "slots", "erases", "max/sec", "writes", "bytes", "boot reads", "us/save", "lifetime", "vs place");
+
+	int status = 0;
+	StorageStall stalls[sizeof(layouts) / sizeof(layouts[0])][2];
+	for (const StorageLayout &layout : layouts)
+	{
+		unlink(image);
+		GamepadFileFlash flash(layout.sectorSize, layout.sectorCount, layout.writeSize);
+		if (!flash.open(image))
+		{
+			perror(image);
+			return 1;
+		}
+
+		flash.eraseUs = layout.eraseUs;
+		flash.writeUs = layout.writeUs;
+
+		GamepadOptions options;
+		auto start = std::chrono::steady_clock::now();
+		stalls[&layout - layouts][0] = runSaves(flash, saves, false, options);
+		double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+		uint32_t erases = 0;
+		uint32_t most = 0;
+		for (uint32_t count : flash.erases)
+		{
+			erases += count;
+			most = std::max(most, count);
+		}
+
+		// Boot cost: reads to find the newest options
+		uint64_t reads = flash.reads;
+		GamepadLogStorage boot(&flash);
+		boot.start();
+		reads = flash.reads - reads;
+
+		GamepadOptions loaded = boot.getGamepadOptions();
+		if (loaded.socdMode != options.socdMode || loaded.invertXAxis != options.invertXAxis || flash.failures != 0)
+		{
+			fprintf(stderr, "%s: the newest options were not recovered\n", layout.name);
+			status = 1;
+		}
+
+		// Saves until the most-erased sector reaches its endurance; in place, every save erases the same sector
+		double lifetime = most ? endurance * saves / most : endurance * flash.sectorCount * (boot.getSlotCount() - 1);
+		printf("%-11s %6u %8u %8u %10llu %11llu %10llu %8.2f %12.3g %7.0fx\n", layout.name, boot.getSlotCount() - 1,
+			erases, most, static_cast<unsigned long long>(flash.writes), static_cast<unsigned long long>(flash.bytesWritten),
+			static_cast<unsigned long long>(reads), elapsed / saves, lifetime, lifetime / endurance);
+	}
+
+	// The same saves again on a fresh image, a slice at a time
+	printf("\n%-11s %8s %8s %14s %14s %14s %14s\n", "layout", "erase us", "write us",
+		"blocking", "sliced", "blocking write", "sliced write");
+	for (const StorageLayout &layout : layouts)
+	{
+		unlink(image);
+		GamepadFileFlash flash(layout.sectorSize, layout.sectorCount, layout.writeSize);
+		if (!flash.open(image))
+		{
+			perror(image);
+			return 1;
+		}
+
+		flash.eraseUs = layout.eraseUs;
+		flash.writeUs = layout.writeUs;
+
+		GamepadOptions options;
+		StorageStall *stall = stalls[&layout - layouts];
+		stall[1] = runSaves(flash, saves, true, options);
+		printf("%-11s %8u %8u %12.1fms %12.1fms %12.1fms %12.1fms\n", layout.name, layout.eraseUs, layout.writeUs,
+			stall[0].most / 1000.0, stall[1].most / 1000.0, stall[0].mostWriting / 1000.0, stall[1].mostWriting / 1000.0);
+
+		if (stall[1].most > layout.eraseUs || stall[1].mostWriting > layout.writeUs)
+		{
+			fprintf(stderr, "%s: a save slice did more than one erase or write\n", layout.name);
+			status = 1;
+		}
+	}
+
+	unlink(image);
+	return status;
+}
@@ -0,0 +1,213 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * MPG cross-thread stress test
+ *
+ * Usage: MPGStress [--seconds <n>]
+ *
+ * Runs GamepadMailbox with a producer and a consumer thread, standing in for the two cores of a dual-core board.
+ *
+ * - mailbox: the producer publishes sequence-stamped states as fast as it can. The consumer checks that every value
+ *   it receives is complete (never torn) and newer than the last one. It also measures the handoff latency from
+ *   publish to receive.
+ * - pipeline: a scanner gamepad runs read() + debounce() and publishes its state. A reporter gamepad receives it
+ *   and runs hotkey() + process() + getReport().
+ *
+ * Exits with 1 if any torn or out-of-order value is seen.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "BenchGamepad.h"
+#include "GamepadMailbox.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static uint64_t nowNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct StampedState
+{
+	GamepadState state;
+	uint32_t sequence {0};
+	uint64_t stampNs {0};
+};
+
+// Fill every field from the sequence number so a torn read is detectable
+static void fillState(GamepadState &state, uint32_t sequence)
+{
+	state.dpad = sequence & GAMEPAD_MASK_DPAD;
+	state.buttons = static_cast<uint16_t>(sequence * 3);
+	state.aux = static_cast<uint16_t>(sequence * 5);
+	state.lx = static_cast<uint16_t>(sequence * 7);
+	state.ly = static_cast<uint16_t>(sequence * 11);
+	state.rx = static_cast<uint16_t>(sequence * 13);
+	state.ry = static_cast<uint16_t>(sequence * 17);
+	state.lt = static_cast<uint8_t>(sequence * 19);
+	state.rt = static_cast<uint8_t>(sequence * 23);
+}
+
+static bool checkState(const GamepadState &state, uint32_t sequence)
+{
+	GamepadState expected;
+	fillState(expected, sequence);
+	return compareGamepadState(state, expected) == 0;
+}
+
+static double percentile(std::vector<uint64_t> &values, double p)
+{
+	if (values.empty())
+		return 0;
+
+	size_t index = static_cast<size_t>(p * (values.size() - 1));
+	return static_cast<double>(values[index]);
+}
+
+static bool runMailbox(double seconds)
+{
+	GamepadMailbox<StampedState> mailbox;
+	std::atomic<bool> running {true};
+	uint32_t published = 0;
+
+	std::thread producer([&]() {
+		StampedState value;
+		while (running.load(std::memory_order_relaxed))
+		{
+			value.sequence++;
+			fillState(value.state, value.sequence);
+			value.stampNs = nowNs();
+			mailbox.publish(value);
+		}
+		published = value.sequence;
+	});
+
+	std::vector<uint64_t> latencies;
+	latencies.reserve(1 << 20);
+	uint32_t received = 0;
+	uint32_t torn = 0;
+	uint32_t reordered = 0;
+	uint32_t last = 0;
+
+	uint64_t start = nowNs();
+	uint64_t end = start + static_cast<uint64_t>(seconds * 1e9);
+	StampedState value;
+	while (nowNs() < end)
+	{
+		if (!mailbox.receive(value))
+			continue;
+
+		uint64_t now = nowNs();
+		received++;
+		if (!checkState(value.state, value.sequence))
+			torn++;
+		if (value.sequence <= last)
+			reordered++;
+		last = value.sequence;
+
+		if (latencies.size() < latencies.capacity())
+			latencies.push_back(now - value.stampNs);
+	}
+
+	running = false;
+	producer.join();
+
+	double elapsed = (nowNs() - start) / 1e9;
+	std::sort(latencies.begin(), latencies.end());
+
+	printf("mailbox\n");
+	printf("  published  %12.0f /s\n", published / elapsed);
+	printf("  received   %12.0f /s (%.1f%% of published)\n", received / elapsed, published ? 100.0 * received / published : 0.0);
+	printf("  latency    p50 %.0f ns, p99 %.0f ns, max %.0f ns\n",
+		percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 1.0));
+	printf("  torn %u, out of order %u\n", torn, reordered);
+
+	return torn == 0 && reordered == 0 && received > 0;
+}
+
+static bool runPipeline(double seconds)
+{
+	BenchGamepad scanner;
+	BenchGamepad reporter;
+	scanner.load(generateInputMix(INPUT_MIX_CASUAL, 4096));
+	GamepadMailbox<> mailbox;
+	std::atomic<bool> running {true};
+	uint32_t scans = 0;
+
+	// The scanner owns the virtual clock, the reporter never reads it
+	std::thread scannerThread([&]() {
+		hostMillis = 1000;
+		while (running.load(std::memory_order_relaxed))
+		{
+			if ((++scans % 10) == 0)
+				hostMillis++;
+
+			scanner.read();
+			scanner.debounce();
+			mailbox.publish(scanner.state);
+		}
+	});
+
+	uint32_t frames = 0;
+	uint32_t sent = 0;
+	uint64_t start = nowNs();
+	uint64_t end = start + static_cast<uint64_t>(seconds * 1e9);
+	while (nowNs() < end)
+	{
+		if (!mailbox.receive(reporter.state))
+			continue;
+
+		bool changed;
+		reporter.hotkey();
+		reporter.process();
+		void *report = reporter.getReport(&changed);
+		benchKeep(report);
+		frames++;
+		sent += changed;
+	}
+
+	running = false;
+	scannerThread.join();
+
+	double elapsed = (nowNs() - start) / 1e9;
+	printf("pipeline\n");
+	printf("  scanned    %12.0f /s\n", scans / elapsed);
+	printf("  processed  %12.0f /s\n", frames / elapsed);
+	printf("  changed    %12.0f /s\n", sent / elapsed);
+
+	return frames > 0;
+}
+
+int main(int argc, char **argv)
+{
+	double seconds = 1.0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+			seconds = strtod(argv[++i], nullptr);
+		else
+		{
+			fprintf(stderr, "Usage: %s [--seconds <n>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+	bool ok = runMailbox(seconds);
+	ok &= runPipeline(seconds);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,317 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+/*
+ * MPG trace tool
+ *
+ * Usage:
+ *   MPGTrace generate <file> [--seconds <n>] [--scenario taps|socd|hotkeys] [--scan <us>] [--bounce <us>] [--analog] [--seed <n>]
+ *   MPGTrace summary <file> [--debounce <ms>]
+ *   MPGTrace dump <file> [--count <n>] [--debounce <ms>]
+ *
+ * `generate` records a simulated player into a trace the way firmware would, scanning every `scan` microseconds.
+ * `summary` replays a trace through MPG in every input mode and prints press counts, inter-event gaps, and how many
+ * distinct reports each mode produced along with a fingerprint of the report stream. `dump` prints each record with
+ * the report every mode would send for it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "GamepadSimulator.h"
+#include "GamepadTraceReader.h"
+
+static const char *inputNames[] =
+{
+	"B1", "B2", "B3", "B4", "L1", "R1", "L2", "R2", "S1", "S2", "L3", "R3", "A1", "A2", "", "",
+	"Up", "Down", "Left", "Right",
+};
+
+static const char *inputModeNames[] = { "xinput", "switch", "hid" };
+
+static uint32_t packInputs(const GamepadState &state)
+{
+	return state.buttons | (static_cast<uint32_t>(state.dpad) << 16);
+}
+
+/**
+ * @brief Replays trace states through MPG in one input mode.
+ */
+class TraceGamepad : public MPG
+{
+	public:
+		TraceGamepad(InputMode mode, int debounceMS) : MPG(debounceMS)
+		{
+			options.inputMode = mode;
+			hasAnalogTriggers = true;
+			hasLeftAnalogStick = true;
+			hasRightAnalogStick = true;
+		}
+
+		void setup() override { }
+		void read() override { state = *source; }
+
+		const GamepadState *source {nullptr};
+		uint64_t changes {0};
+		uint64_t fingerprint {14695981039346656037ULL};
+};
+
+static FILE *output = nullptr;
+static uint64_t written = 0;
+
+static void writeTrace(const uint8_t *data, uint8_t length)
+{
+	fwrite(data, 1, length, output);
+	written += length;
+}
+
+static int generate(const char *path, double seconds, GamepadScenario scenario, uint32_t scanUs, uint32_t bounceUs, bool analog, uint32_t seed)
+{
+	output = fopen(path, "wb");
+	if (!output)
+	{
+		perror(path);
+		return 1;
+	}
+
+	static char buffer[1 << 16];
+	setvbuf(output, buffer, _IOFBF, sizeof(buffer));
+
+	GamepadTimeline timeline = generateGamepadScenario(scenario, static_cast<uint64_t>(seconds * 1e6), bounceUs, seed);
+	timeline.finish();
+
+	GamepadTraceWriter trace(writeTrace);
+	trace.begin(0);
+
+	GamepadState state;
+	uint32_t raw = 0;
+	uint64_t records = 0;
+	uint64_t end = timeline.endUs() + scanUs;
+	const GamepadTimeline::Toggle *toggle = timeline.toggles.data();
+	const GamepadTimeline::Toggle *toggleEnd = toggle + timeline.toggles.size();
+
+	for (uint64_t time = 0; time < end; time += scanUs)
+	{
+		for (; toggle != toggleEnd && toggle->timeUs <= time; toggle++)
+			raw ^= toggle->inputs;
+
+		state.buttons = static_cast<uint16_t>(raw);
+		state.dpad = static_cast<uint8_t>(raw >> 16);
+
+		// A slow circle on the left stick, quantized like a 10-bit ADC
+		if (analog)
+		{
+			uint32_t phase = static_cast<uint32_t>(time / 1000) % 4000;
+			uint32_t ramp = (phase < 2000) ? phase : 4000 - phase;
+			state.lx = static_cast<uint16_t>((ramp * 0xFFFF / 2000) & 0xFFC0);
+			state.ly = static_cast<uint16_t>(((2000 - ramp) * 0xFFFF / 2000) & 0xFFC0);
+		}
+
+		records += trace.record(static_cast<uint32_t>(time), state) ? 1 : 0;
+	}
+
+	fclose(output);
+	printf("%s: %llu records, %llu bytes, %.2f bytes/record\n", path, static_cast<unsigned long long>(records),
+		static_cast<unsigned long long>(written), records ? static_cast<double>(written - GAMEPAD_TRACE_HEADER_SIZE) / records : 0.0);
+
+	return 0;
+}
+
+static void formatReport(char *out, const void *report, uint16_t size)
+{
+	const uint8_t *bytes = static_cast<const uint8_t *>(report);
+	for (uint16_t i = 0; i < size; i++)
+		out += sprintf(out, "%02x", bytes[i]);
+}
+
+static int replay(const char *path, bool dump, uint64_t count, int debounceMS)
+{
+	GamepadTraceReader reader;
+	if (!reader.open(path))
+	{
+		fprintf(stderr, "%s: not a trace\n", path);
+		return 1;
+	}
+
+	TraceGamepad gamepads[3] =
+	{
+		TraceGamepad(INPUT_MODE_XINPUT, debounceMS),
+		TraceGamepad(INPUT_MODE_SWITCH, debounceMS),
+		TraceGamepad(INPUT_MODE_HID, debounceMS),
+	};
+
+	for (TraceGamepad &gamepad : gamepads)
+		gamepad.source = &reader.state;
+
+	uint64_t presses[20] = { };
+	uint64_t gaps[33] = { };
+	uint32_t maxGap = 0;
+	uint32_t previous = 0;
+	char hex[3][80];
+
+	auto start = std::chrono::steady_clock::now();
+	while (reader.next())
+	{
+		uint32_t inputs = packInputs(reader.state);
+		for (uint32_t pressed = inputs & ~previous; pressed; pressed &= pressed - 1)
+			presses[__builtin_ctz(pressed)]++;
+		previous = inputs;
+
+		if (reader.records > 1)
+		{
+			gaps[32 - (reader.deltaUs ? __builtin_clz(reader.deltaUs) : 32)]++;
+			if (reader.deltaUs > maxGap)
+				maxGap = reader.deltaUs;
+		}
+
+		hostMillis = static_cast<uint32_t>(1000 + reader.timeUs / 1000);
+		for (int mode = 0; mode < 3; mode++)
+		{
+			TraceGamepad &gamepad = gamepads[mode];
+			bool changed;
+			const uint8_t *report = static_cast<const uint8_t *>(gamepad.update(&changed));
+			if (!changed)
+				continue;
+
+			gamepad.changes++;
+			for (uint16_t i = 0; i < gamepad.getReportSize(); i++)
+				gamepad.fingerprint = (gamepad.fingerprint ^ report[i]) * 1099511628211ULL;
+		}
+
+		if (dump && reader.records <= count)
+		{
+			for (int mode = 0; mode < 3; mode++)
+				formatReport(hex[mode], gamepads[mode].getReport(), gamepads[mode].getReportSize());
+
+			printf("%12.3f ms %05x xinput %s switch %s hid %s\n", reader.timeUs / 1000.0, inputs, hex[0], hex[1], hex[2]);
+		}
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (reader.malformed)
+		fprintf(stderr, "%s: malformed or truncated record at byte %zu\n", path, reader.offset);
+
+	if (dump)
+		return reader.malformed ? 1 : 0;
+
+	printf("%s\n", path);
+	printf("  records    %llu in %zu bytes (%.2f bytes/record)\n", static_cast<unsigned long long>(reader.records), reader.size,
+		reader.records ? static_cast<double>(reader.size - GAMEPAD_TRACE_HEADER_SIZE) / reader.records : 0.0);
+	printf("  duration   %.3f s\n", reader.timeUs / 1e6);
+	printf("  replay     %.1f M records/s\n", reader.records / elapsed / 1e6);
+
+	printf("  presses   ");
+	for (int i = 0; i < 20; i++)
+	{
+		if (presses[i])
+			printf(" %s:%llu", inputNames[i], static_cast<unsigned long long>(presses[i]));
+	}
+	printf("\n");
+
+	uint64_t gapCount = 0;
+	for (uint64_t bucket : gaps)
+		gapCount += bucket;
+
+	printf("  gaps       ");
+	uint64_t seen = 0;
+	bool p50 = false;
+	for (int bucket = 0; bucket < 33 && gapCount; bucket++)
+	{
+		seen += gaps[bucket];
+		uint32_t upper = bucket ? static_cast<uint32_t>((1ULL << bucket) - 1) : 0;
+		if (!p50 && seen * 2 >= gapCount)
+		{
+			printf("p50 <%u us, ", upper + 1);
+			p50 = true;
+		}
+		if (seen * 100 >= gapCount * 99)
+		{
+			printf("p99 <%u us, ", upper + 1);
+			break;
+		}
+	}
+	printf("max %u us\n", maxGap);
+
+	for (int mode = 0; mode < 3; mode++)
+	{
+		formatReport(hex[mode], gamepads[mode].getReport(), gamepads[mode].getReportSize());
+		printf("  %-8s   %llu reports, fingerprint %016llx, last %s\n", inputModeNames[mode],
+			static_cast<unsigned long long>(gamepads[mode].changes), static_cast<unsigned long long>(gamepads[mode].fingerprint), hex[mode]);
+	}
+
+	return reader.malformed ? 1 : 0;
+}
+
+static int usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage:\n"
+		"  %s generate <file> [--seconds <n>] [--scenario taps|socd|hotkeys] [--scan <us>] [--bounce <us>] [--analog] [--seed <n>]\n"
+		"  %s summary <file> [--debounce <ms>]\n"
+		"  %s dump <file> [--count <n>] [--debounce <ms>]\n", name, name, name);
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 3)
+		return usage(argv[0]);
+
+	const char *command = argv[1];
+	const char *path = argv[2];
+	double seconds = 60;
+	GamepadScenario scenario = GAMEPAD_SCENARIO_TAPS;
+	uint32_t scanUs = 100;
+	uint32_t bounceUs = 1000;
+	uint32_t seed = 1;
+	bool analog = false;
+	uint64_t count = 50;
+	int debounceMS = 5;
+
+	for (int i = 3; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+			seconds = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc)
+		{
+			const char *name = argv[++i];
+			int s = 0;
+			for (; s < GAMEPAD_SCENARIO_COUNT; s++)
+			{
+				if (strcmp(name, getGamepadScenarioName(static_cast<GamepadScenario>(s))) == 0)
+					break;
+			}
+			if (s == GAMEPAD_SCENARIO_COUNT)
+				return usage(argv[0]);
+			scenario = static_cast<GamepadScenario>(s);
+		}
+		else if (strcmp(argv[i], "--scan") == 0 && i + 1 < argc)
+			scanUs = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--bounce") == 0 && i + 1 < argc)
+			bounceUs = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--analog") == 0)
+			analog = true;
+		else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+			count = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--debounce") == 0 && i + 1 < argc)
+			debounceMS = atoi(argv[++i]);
+		else
+			return usage(argv[0]);
+	}
+
+	if (strcmp(command, "generate") == 0 && scanUs > 0)
+		return generate(path, seconds, scenario, scanUs, bounceUs, analog, seed);
+	if (strcmp(command, "summary") == 0)
+		return replay(path, false, 0, debounceMS);
+	if (strcmp(command, "dump") == 0)
+		return replay(path, true, count, debounceMS);
+
+	return usage(argv[0]);
+}
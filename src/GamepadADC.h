@@ -0,0 +1,245 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "GamepadAtomics.h"
+#include "GamepadConfig.h"
+#include "GamepadState.h"
+
+/*
+	Analog input acquisition.
+
+	The ADC scans every analog channel in the background, from a DMA or conversion complete interrupt, and pushes
+	each scan into a ring of GAMEPAD_ADC_RING_SCANS scans. Nothing waits on a conversion. Each frame, `read()` drains
+	the ring and writes the latest filtered values to the state:
+
+	    // ADC interrupt or DMA complete: one sample per channel, in channel order
+	    adc.push(samples);
+
+	    // Or let the DMA write straight into the ring
+	    uint16_t *scan = adc.nextScan();
+	    if (scan)
+	        startDMA(scan, channelCount);
+	    ...
+	    adc.commitScan(); // From the DMA complete interrupt
+
+	Draining decimates: each `oversample` scans of a channel are summed into one 16-bit value, which averages out
+	noise and adds resolution. Each value then goes through an adaptive exponential filter. The filter weight of a
+	new value rises from `minAlpha` with the distance between it and the filtered value. A still stick is smoothed
+	heavily, and a moving stick is barely smoothed at all, so filtering removes noise without adding lag where it
+	shows. Everything is integer math.
+
+	The ring is single producer, single consumer. When it is full, new scans are dropped and counted in
+	`getOverruns()`, so the consumer never reads a scan being written.
+*/
+
+#define GAMEPAD_ADC_MAX_CHANNELS 6
+
+typedef enum
+{
+	ADC_AXIS_LX,
+	ADC_AXIS_LY,
+	ADC_AXIS_RX,
+	ADC_AXIS_RY,
+	ADC_AXIS_LT,
+	ADC_AXIS_RT,
+} GamepadADCAxis;
+
+struct GamepadADCConfig
+{
+	uint8_t bits {12};       // ADC resolution
+	uint8_t oversample {4};  // Scans summed into each value, a power of 2
+	uint8_t minAlpha {16};   // Weight of a new value while the input is still, out of 256. 0 turns the filter off.
+	uint8_t beta {128};      // How fast the weight rises as the input moves, per 256 counts of 16-bit distance
+};
+
+class GamepadADC
+{
+	public:
+		/**
+		 * @param axes The axis each channel of a scan feeds, in scan order
+		 * @param channelCount Channels per scan, at most GAMEPAD_ADC_MAX_CHANNELS
+		 */
+		GamepadADC(const GamepadADCAxis *axes, uint8_t channelCount, const GamepadADCConfig &config = GamepadADCConfig())
+			: channelCount((channelCount < GAMEPAD_ADC_MAX_CHANNELS) ? channelCount : GAMEPAD_ADC_MAX_CHANNELS)
+		{
+			memcpy(this->axes, axes, this->channelCount * sizeof(GamepadADCAxis));
+			configure(config);
+		}
+
+		/**
+		 * @brief Change the decimation and filter settings, restarting both.
+		 */
+		void configure(const GamepadADCConfig &config)
+		{
+			this->config = config;
+			oversampleShift = 0;
+			while ((2U << oversampleShift) <= config.oversample && oversampleShift < 7)
+				oversampleShift++;
+
+			// Sum of 2^oversampleShift samples of `bits` bits, scaled to 16 bits
+			valueShift = 16 - config.bits - oversampleShift;
+			pending = 0;
+			primed = false;
+			memset(sums, 0, sizeof(sums));
+		}
+
+		inline const GamepadADCConfig &getConfig() const { return config; }
+		inline uint8_t getChannelCount() const { return channelCount; }
+
+		/**
+		 * @brief The ring slot for the next scan, for the ADC or DMA to write into, or null if the ring is full.
+		 * Producer side only.
+		 */
+		inline uint16_t *nextScan()
+		{
+			uint8_t head = written;
+			if (static_cast<uint8_t>(head - gamepadAtomicLoadAcquire(&drained)) >= GAMEPAD_ADC_RING_SCANS)
+			{
+				overruns++;
+				return nullptr;
+			}
+
+			return ring[head & (GAMEPAD_ADC_RING_SCANS - 1)];
+		}
+
+		/**
+		 * @brief Publish the scan written to `nextScan()`. Producer side only.
+		 */
+		inline void commitScan()
+		{
+			gamepadAtomicStoreRelease(&written, static_cast<uint8_t>(written + 1));
+		}
+
+		/**
+		 * @brief Copy a scan into the ring. Producer side only.
+		 *
+		 * @return bool False if the ring was full and the scan was dropped
+		 */
+		inline bool push(const uint16_t *scan)
+		{
+			uint16_t *slot = nextScan();
+			if (!slot)
+				return false;
+
+			memcpy(slot, scan, channelCount * sizeof(uint16_t));
+			commitScan();
+			return true;
+		}
+
+		/**
+		 * @brief Decimate and filter every scan in the ring. Consumer side only.
+		 *
+		 * @return uint8_t The number of new filtered values per channel
+		 */
+		uint8_t update()
+		{
+			uint8_t tail = drained;
+			uint8_t head = gamepadAtomicLoadAcquire(&written);
+			uint8_t values = 0;
+			for (; tail != head; tail++)
+			{
+				const uint16_t *scan = ring[tail & (GAMEPAD_ADC_RING_SCANS - 1)];
+				for (uint8_t i = 0; i < channelCount; i++)
+					sums[i] += scan[i];
+
+				if (++pending < (1U << oversampleShift))
+					continue;
+
+				for (uint8_t i = 0; i < channelCount; i++)
+				{
+					filter(i, scale(sums[i]));
+					sums[i] = 0;
+				}
+				pending = 0;
+				primed = true;
+				values++;
+			}
+
+			gamepadAtomicStoreRelease(&drained, tail);
+			return values;
+		}
+
+		/**
+		 * @brief The latest filtered value of a channel, on a 16-bit scale.
+		 */
+		inline uint16_t getValue(uint8_t channel) const { return static_cast<uint16_t>(filtered[channel] >> 4); }
+
+		/**
+		 * @brief Drain the ring and write the latest values to the state's axes. Sticks get the full 16 bits and
+		 * triggers the top 8. Axes are left alone until the first value is ready.
+		 */
+		void read(GamepadState &state)
+		{
+			update();
+			if (!primed)
+				return;
+
+			for (uint8_t i = 0; i < channelCount; i++)
+			{
+				uint16_t value = getValue(i);
+				switch (axes[i])
+				{
+					case ADC_AXIS_LX: state.lx = value; break;
+					case ADC_AXIS_LY: state.ly = value; break;
+					case ADC_AXIS_RX: state.rx = value; break;
+					case ADC_AXIS_RY: state.ry = value; break;
+					case ADC_AXIS_LT: state.lt = value >> 8; break;
+					case ADC_AXIS_RT: state.rt = value >> 8; break;
+				}
+			}
+		}
+
+		/**
+		 * @brief Scans dropped because the ring was full, as seen by the producer.
+		 */
+		inline uint32_t getOverruns() const { return overruns; }
+
+	protected:
+		inline uint16_t scale(uint32_t sum) const
+		{
+			uint32_t value = (valueShift >= 0) ? (sum << valueShift) : (sum >> -valueShift);
+			return (value > 0xFFFF) ? 0xFFFF : static_cast<uint16_t>(value);
+		}
+
+		// Adaptive EMA, kept with 4 fractional bits so slow drifts are not lost to rounding
+		inline void filter(uint8_t channel, uint16_t value)
+		{
+			int32_t target = static_cast<int32_t>(value) << 4;
+			if (!primed || config.minAlpha == 0)
+			{
+				filtered[channel] = target;
+				return;
+			}
+
+			int32_t error = target - filtered[channel];
+			uint32_t distance = static_cast<uint32_t>((error < 0) ? -error : error) >> 4;
+			uint32_t alpha = config.minAlpha + ((distance * config.beta) >> 8);
+			if (alpha > 256)
+				alpha = 256;
+
+			filtered[channel] += (error * static_cast<int32_t>(alpha)) / 256;
+		}
+
+		GamepadADCConfig config;
+		GamepadADCAxis axes[GAMEPAD_ADC_MAX_CHANNELS];
+		uint8_t channelCount;
+		uint8_t oversampleShift {0};
+		int8_t valueShift {0};
+
+		uint16_t ring[GAMEPAD_ADC_RING_SCANS][GAMEPAD_ADC_MAX_CHANNELS];
+		uint8_t written {0};    // Written by the producer: scans pushed, wrapping
+		uint8_t drained {0};    // Written by the consumer: scans drained, wrapping
+		uint32_t overruns {0};  // Producer only
+
+		uint32_t sums[GAMEPAD_ADC_MAX_CHANNELS];
+		int32_t filtered[GAMEPAD_ADC_MAX_CHANNELS] { };
+		uint8_t pending {0};
+		bool primed {false};
+};
@@ -0,0 +1,38 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#include "GamepadAnalog.h"
+
+// Curve value at a 0-32768 input, all on the same scale
+static uint16_t curvePoint(GamepadCurve curve, uint32_t input)
+{
+	switch (curve)
+	{
+		case ANALOG_CURVE_QUADRATIC: return static_cast<uint16_t>((input * input) >> 15);
+		case ANALOG_CURVE_CUBIC:     return static_cast<uint16_t>((((input * input) >> 15) * input) >> 15);
+		case ANALOG_CURVE_SQRT:      return isqrt32(input << 15);
+		default:                     return static_cast<uint16_t>(input);
+	}
+}
+
+void GamepadAnalog::configure(GamepadStick stick, const GamepadStickConfig &config)
+{
+	Stick &target = sticks[stick];
+	target.config = config;
+	if (target.config.antiDeadzone > GAMEPAD_ANALOG_FULL)
+		target.config.antiDeadzone = GAMEPAD_ANALOG_FULL;
+
+	target.range = (config.outerDeadzone > config.innerDeadzone) ? config.outerDeadzone - config.innerDeadzone : 1;
+	target.reciprocal = (1UL << 28) / target.range;
+
+	for (uint8_t i = 0; i < GAMEPAD_ANALOG_CURVE_POINTS; i++)
+		target.curve[i] = curvePoint(config.curve, static_cast<uint32_t>(i) * (GAMEPAD_ANALOG_FULL / (GAMEPAD_ANALOG_CURVE_POINTS - 1)));
+}
+
+void GamepadAnalog::setCurve(GamepadStick stick, const uint16_t points[GAMEPAD_ANALOG_CURVE_POINTS])
+{
+	for (uint8_t i = 0; i < GAMEPAD_ANALOG_CURVE_POINTS; i++)
+		sticks[stick].curve[i] = (points[i] > GAMEPAD_ANALOG_FULL) ? GAMEPAD_ANALOG_FULL : points[i];
+}
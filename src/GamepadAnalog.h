@@ -0,0 +1,169 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "GamepadState.h"
+
+/*
+	Analog stick processing with integer math only, so it runs the same on AVR and Cortex-M0 as on the host.
+
+	Each stick is measured as a distance from center on a 0-32768 scale, either as a whole (radial) or per axis.
+	The distance between the inner and outer deadzones becomes a 16-bit fraction, goes through a 17 point response
+	curve, and is lifted by the anti-deadzone. In radial mode the stick direction is then rescaled to the new
+	distance, so the output is circular: a full diagonal has the same length as a full deflection on one axis. Per
+	stick this takes one integer square root and one division. The deadzone range is applied with a reciprocal
+	worked out in `configure()`.
+*/
+
+#define GAMEPAD_ANALOG_FULL 32768      // Full deflection from center
+#define GAMEPAD_ANALOG_CURVE_POINTS 17 // Curve points at every 1/16 of the range, both ends included
+
+typedef enum
+{
+	ANALOG_CURVE_LINEAR,
+	ANALOG_CURVE_QUADRATIC, // Finer control near center
+	ANALOG_CURVE_CUBIC,     // Even finer control near center
+	ANALOG_CURVE_SQRT,      // Faster response near center
+} GamepadCurve;
+
+typedef enum
+{
+	ANALOG_STICK_LEFT,
+	ANALOG_STICK_RIGHT,
+} GamepadStick;
+
+struct GamepadStickConfig
+{
+	uint16_t innerDeadzone {0};                   // Distances up to this read as centered
+	uint16_t outerDeadzone {GAMEPAD_ANALOG_FULL}; // Distances from this out read as full deflection
+	uint16_t antiDeadzone {0};                    // Smallest output distance past the inner deadzone
+	GamepadCurve curve {ANALOG_CURVE_LINEAR};
+	bool radial {true};                           // Measure the whole stick rather than each axis
+};
+
+/**
+ * @brief Integer square root, rounded down. Always 16 steps without branches, so stick noise costs no mispredicts.
+ */
+inline uint16_t isqrt32(uint32_t value)
+{
+	uint32_t root = 0;
+	for (uint32_t bit = 1UL << 30; bit != 0; bit >>= 2)
+	{
+		uint32_t trial = root + bit;
+		uint32_t take = -static_cast<uint32_t>(value >= trial);
+		value -= trial & take;
+		root = (root >> 1) + (bit & take);
+	}
+
+	return static_cast<uint16_t>(root);
+}
+
+class GamepadAnalog
+{
+	public:
+		GamepadAnalog()
+		{
+			configure(ANALOG_STICK_LEFT, GamepadStickConfig());
+			configure(ANALOG_STICK_RIGHT, GamepadStickConfig());
+		}
+
+		/**
+		 * @brief Set a stick's deadzones and curve, and build its curve table.
+		 */
+		void configure(GamepadStick stick, const GamepadStickConfig &config);
+
+		/**
+		 * @brief Replace a stick's curve with custom points, each the output distance (0-32768) at every 1/16 of the
+		 * way from the inner to the outer deadzone. The points should rise.
+		 */
+		void setCurve(GamepadStick stick, const uint16_t points[GAMEPAD_ANALOG_CURVE_POINTS]);
+
+		inline const GamepadStickConfig &getConfig(GamepadStick stick) const { return sticks[stick].config; }
+
+		/**
+		 * @brief Apply deadzones and curves to both sticks.
+		 */
+		inline void process(GamepadState &state)
+		{
+			processStick(sticks[ANALOG_STICK_LEFT], state.lx, state.ly);
+			processStick(sticks[ANALOG_STICK_RIGHT], state.rx, state.ry);
+		}
+
+	protected:
+		struct Stick
+		{
+			GamepadStickConfig config;
+			uint16_t curve[GAMEPAD_ANALOG_CURVE_POINTS];
+			uint16_t range;      // outerDeadzone - innerDeadzone, at least 1
+			uint32_t reciprocal; // 2^28 / range
+		};
+
+		// Map a distance from center to the output distance
+		inline uint16_t shape(const Stick &stick, uint16_t distance) const
+		{
+			uint16_t offset = distance - stick.config.innerDeadzone;
+			if (offset >= stick.range)
+				return stick.curve[GAMEPAD_ANALOG_CURVE_POINTS - 1];
+
+			// Position between the deadzones as a 16-bit fraction, then interpolate between curve points 4096 apart
+			uint16_t position = static_cast<uint16_t>((offset * stick.reciprocal) >> 12);
+			uint8_t index = position >> 12;
+			int32_t low = stick.curve[index];
+			int32_t high = stick.curve[index + 1];
+			uint16_t curved = static_cast<uint16_t>(low + (((high - low) * (position & 0xFFF)) >> 12));
+
+			uint16_t anti = stick.config.antiDeadzone;
+			return anti + static_cast<uint16_t>((static_cast<uint32_t>(curved) * (GAMEPAD_ANALOG_FULL - anti)) >> 15);
+		}
+
+		static inline uint16_t toAxis(int32_t value)
+		{
+			value += GAMEPAD_JOYSTICK_MID;
+			return (value < GAMEPAD_JOYSTICK_MIN) ? GAMEPAD_JOYSTICK_MIN : (value > GAMEPAD_JOYSTICK_MAX) ? GAMEPAD_JOYSTICK_MAX : value;
+		}
+
+		inline void processAxis(const Stick &stick, uint16_t &axis)
+		{
+			int32_t value = static_cast<int32_t>(axis) - GAMEPAD_JOYSTICK_MID;
+			uint16_t distance = (value < 0) ? -value : value;
+			if (distance <= stick.config.innerDeadzone)
+			{
+				axis = GAMEPAD_JOYSTICK_MID;
+				return;
+			}
+
+			uint16_t shaped = shape(stick, distance);
+			axis = toAxis((value < 0) ? -static_cast<int32_t>(shaped) : shaped);
+		}
+
+		inline void processStick(const Stick &stick, uint16_t &x, uint16_t &y)
+		{
+			if (!stick.config.radial)
+			{
+				processAxis(stick, x);
+				processAxis(stick, y);
+				return;
+			}
+
+			int32_t dx = static_cast<int32_t>(x) - GAMEPAD_JOYSTICK_MID;
+			int32_t dy = static_cast<int32_t>(y) - GAMEPAD_JOYSTICK_MID;
+			uint16_t distance = isqrt32(static_cast<uint32_t>(dx * dx) + static_cast<uint32_t>(dy * dy));
+			if (distance <= stick.config.innerDeadzone || distance == 0)
+			{
+				x = GAMEPAD_JOYSTICK_MID;
+				y = GAMEPAD_JOYSTICK_MID;
+				return;
+			}
+
+			// Keep the direction, rescaled to the shaped distance. |d| <= distance, so d * scale stays under 2^31.
+			int32_t scale = (static_cast<int32_t>(shape(stick, distance)) << 15) / distance;
+			x = toAxis((dx * scale) >> 15);
+			y = toAxis((dy * scale) >> 15);
+		}
+
+		Stick sticks[2];
+};
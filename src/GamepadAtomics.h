@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+	Minimal atomics for sharing data between cores or with interrupt handlers.
+
+	Only plain loads and stores of naturally aligned values are used, so nothing here needs libatomic. On 32-bit
+	targets, including Cortex-M0+ (RP2040) which has no read-modify-write instructions, 8 and 32-bit values are
+	atomic. On 8-bit AVR (e.g. ATmega32U4) only 8-bit values are, since a wider access is split into byte accesses
+	an interrupt can land between, and using anything wider fails to compile there. Ordering is sequentially consistent. On GCC and Clang that emits the required barriers (e.g. `dmb`
+	on ARM). Other compilers fall back to volatile accesses, which is only sufficient on single-core targets.
+
+	The acquire and release variants are enough for an index handed from one writer to one reader, like a ring
+	buffer's head and tail, and are cheaper: on x86 the store is a plain move instead of a locked exchange.
+*/
+
+#if defined(__AVR__)
+#define GAMEPAD_ATOMIC_CHECK(T) static_assert(sizeof(T) == 1, "Only 8-bit values are atomic on AVR")
+#else
+#define GAMEPAD_ATOMIC_CHECK(T) static_assert(sizeof(T) <= 4, "Values wider than 32 bits are not atomic")
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+
+template <typename T>
+inline T __attribute__((always_inline)) gamepadAtomicLoad(const T *value)
+{
+	GAMEPAD_ATOMIC_CHECK(T);
+	return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+}
+
+template <typename T>
+inline void __attribute__((always_inline)) gamepadAtomicStore(T *value, T newValue)
+{
+	GAMEPAD_ATOMIC_CHECK(T);
+	__atomic_store_n(value, newValue, __ATOMIC_SEQ_CST);
+}
+
+template <typename T>
+inline T __attribute__((always_inline)) gamepadAtomicLoadAcquire(const T *value)
+{
+	GAMEPAD_ATOMIC_CHECK(T);
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+template <typename T>
+inline void __attribute__((always_inline)) gamepadAtomicStoreRelease(T *value, T newValue)
+{
+	GAMEPAD_ATOMIC_CHECK(T);
+	__atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+}
+
+#else
+
+template <typename T>
+inline T gamepadAtomicLoad(const T *value)
+{
+	GAMEPAD_ATOMIC_CHECK(T);
+	return *static_cast<const volatile T *>(value);
+}
+
+template <typename T>
+inline void gamepadAtomicStore(T *value, T newValue)
+{
+	GAMEPAD_ATOMIC_CHECK(T);
+	*static_cast<volatile T *>(value) = newValue;
+}
+
+template <typename T>
+inline T gamepadAtomicLoadAcquire(const T *value)
+{
+	GAMEPAD_ATOMIC_CHECK(T);
+	return *static_cast<const volatile T *>(value);
+}
+
+template <typename T>
+inline void gamepadAtomicStoreRelease(T *value, T newValue)
+{
+	GAMEPAD_ATOMIC_CHECK(T);
+	*static_cast<volatile T *>(value) = newValue;
+}
+
+#endif
@@ -0,0 +1,389 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#include "GamepadBatch.h"
+#include "GamepadMappings.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// States converted per SIMD block
+#define BATCH_BLOCK 16
+
+#if defined(__AVX2__)
+#define BATCH_WIDEST_KERNEL GAMEPAD_BATCH_AVX2
+#elif defined(__SSE2__)
+#define BATCH_WIDEST_KERNEL GAMEPAD_BATCH_SSE2
+#else
+#define BATCH_WIDEST_KERNEL GAMEPAD_BATCH_SCALAR
+#endif
+
+GamepadBatchKernel getGamepadBatchKernel()
+{
+	return BATCH_WIDEST_KERNEL;
+}
+
+/* Scalar conversion, used by the scalar kernel and for the states left over after the last full block */
+
+static inline void convertXInputState(const GamepadStateBatch &states, size_t i, XInputReport *report, bool analogTriggers)
+{
+	uint16_t buttons = convertGamepadButtons(xinputReportTable, states.buttons[i], states.dpad[i]);
+
+	report->report_id = 0;
+	report->report_size = XINPUT_ENDPOINT_SIZE;
+	report->buttons1 = static_cast<uint8_t>(buttons);
+	report->buttons2 = static_cast<uint8_t>(buttons >> 8);
+	report->lt = analogTriggers ? states.lt[i] : ((states.buttons[i] & GAMEPAD_MASK_L2) ? 0xFF : 0);
+	report->rt = analogTriggers ? states.rt[i] : ((states.buttons[i] & GAMEPAD_MASK_R2) ? 0xFF : 0);
+	report->lx = static_cast<int16_t>(states.lx[i]) + INT16_MIN;
+	report->ly = static_cast<int16_t>(~states.ly[i]) + INT16_MIN;
+	report->rx = static_cast<int16_t>(states.rx[i]) + INT16_MIN;
+	report->ry = static_cast<int16_t>(~states.ry[i]) + INT16_MIN;
+	memset(report->_reserved, 0, sizeof(report->_reserved));
+}
+
+static inline void finishReport(HIDReport *) { }
+static inline void finishReport(SwitchReport *report) { report->vendor = 0; }
+
+template <typename Report>
+static inline void convertHatState(const GamepadStateBatch &states, size_t i, Report *report, const GamepadReportTable &table)
+{
+	report->buttons = convertGamepadButtons(table, states.buttons[i], 0);
+	report->hat = convertGamepadHat(states.dpad[i]);
+	report->lx = static_cast<uint8_t>(states.lx[i] >> 8);
+	report->ly = static_cast<uint8_t>(states.ly[i] >> 8);
+	report->rx = static_cast<uint8_t>(states.rx[i] >> 8);
+	report->ry = static_cast<uint8_t>(states.ry[i] >> 8);
+	finishReport(report);
+}
+
+/*
+	SIMD kernels.
+
+	Each ISA provides the same small set of operations on 16-bit lanes, plus block operations that take 16 states
+	and produce 16 bytes. The converters below are written once against that interface.
+*/
+
+#if defined(__SSE2__)
+struct BatchSSE2
+{
+	typedef __m128i Vector;
+	static const size_t Lanes = 8;
+
+	static inline Vector zero() { return _mm_setzero_si128(); }
+	static inline Vector set1(uint16_t value) { return _mm_set1_epi16(static_cast<short>(value)); }
+	static inline Vector load(const uint16_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+	static inline void store(uint16_t *p, Vector v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+	static inline Vector bitwiseOr(Vector a, Vector b) { return _mm_or_si128(a, b); }
+	static inline Vector bitwiseXor(Vector a, Vector b) { return _mm_xor_si128(a, b); }
+
+	static inline Vector loadBytes(const uint8_t *p)
+	{
+		return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)), _mm_setzero_si128());
+	}
+
+	// `output` in every lane where all of `bits` are set in `value`
+	static inline Vector select(Vector value, Vector bits, Vector output)
+	{
+		return _mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(value, bits), bits), output);
+	}
+
+	// High byte of 16 values
+	static inline void narrow(const uint16_t *in, uint8_t *out)
+	{
+		__m128i low = _mm_srli_epi16(load(in), 8);
+		__m128i high = _mm_srli_epi16(load(in + 8), 8);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(low, high));
+	}
+
+	// 0xFF where any bit of `mask` is set in 16 button values
+	static inline void pressed(const uint16_t *buttons, uint16_t mask, uint8_t *out)
+	{
+		__m128i bits = set1(mask);
+		__m128i low = _mm_cmpeq_epi16(_mm_and_si128(load(buttons), bits), _mm_setzero_si128());
+		__m128i high = _mm_cmpeq_epi16(_mm_and_si128(load(buttons + 8), bits), _mm_setzero_si128());
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_xor_si128(_mm_packs_epi16(low, high), _mm_set1_epi8(-1)));
+	}
+
+	// Hat values of 16 D-pad values. SSE2 has no byte shuffle, so blend in each direction that maps to a hat.
+	static inline void hat(const uint8_t *dpad, uint8_t *out)
+	{
+		__m128i value = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(dpad)), _mm_set1_epi8(GAMEPAD_MASK_DPAD));
+		__m128i result = _mm_set1_epi8(HID_HAT_NOTHING);
+		for (uint8_t i = 0; i < 16; i++)
+		{
+			uint8_t hat = MPG_TABLE_READ8(&hatReportTable[i]);
+			if (hat == HID_HAT_NOTHING)
+				continue;
+
+			__m128i match = _mm_cmpeq_epi8(value, _mm_set1_epi8(static_cast<char>(i)));
+			result = _mm_or_si128(_mm_andnot_si128(match, result), _mm_and_si128(match, _mm_set1_epi8(static_cast<char>(hat))));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), result);
+	}
+};
+#endif
+
+#if defined(__AVX2__)
+struct BatchAVX2
+{
+	typedef __m256i Vector;
+	static const size_t Lanes = 16;
+
+	static inline Vector zero() { return _mm256_setzero_si256(); }
+	static inline Vector set1(uint16_t value) { return _mm256_set1_epi16(static_cast<short>(value)); }
+	static inline Vector load(const uint16_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+	static inline void store(uint16_t *p, Vector v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+	static inline Vector bitwiseOr(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+	static inline Vector bitwiseXor(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+
+	static inline Vector loadBytes(const uint8_t *p)
+	{
+		return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+	}
+
+	static inline Vector select(Vector value, Vector bits, Vector output)
+	{
+		return _mm256_and_si256(_mm256_cmpeq_epi16(_mm256_and_si256(value, bits), bits), output);
+	}
+
+	static inline void narrow(const uint16_t *in, uint8_t *out)
+	{
+		__m256i value = _mm256_srli_epi16(load(in), 8);
+		__m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), packed);
+	}
+
+	static inline void pressed(const uint16_t *buttons, uint16_t mask, uint8_t *out)
+	{
+		__m256i none = _mm256_cmpeq_epi16(_mm256_and_si256(load(buttons), set1(mask)), _mm256_setzero_si256());
+		__m128i packed = _mm_packs_epi16(_mm256_castsi256_si128(none), _mm256_extracti128_si256(none, 1));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_xor_si128(packed, _mm_set1_epi8(-1)));
+	}
+
+	// The hat table is exactly one byte shuffle
+	static inline void hat(const uint8_t *dpad, uint8_t *out)
+	{
+		__m128i table = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hatReportTable));
+		__m128i value = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(dpad)), _mm_set1_epi8(GAMEPAD_MASK_DPAD));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(table, value));
+	}
+};
+#endif
+
+/**
+ * @brief Button permutation for one report layout, expanded from its mapping row into one select per mapped input.
+ */
+template <class Isa>
+class BatchButtonMapper
+{
+	public:
+		BatchButtonMapper(const GamepadReportMapping &mapping)
+		{
+			for (uint8_t i = 0; i < GAMEPAD_BUTTON_COUNT; i++)
+			{
+				if (mapping.buttons[i] != 0)
+				{
+					buttonBits[buttonCount] = Isa::set1(buttonMasks[i]);
+					buttonOutput[buttonCount++] = Isa::set1(mapping.buttons[i]);
+				}
+			}
+
+			for (uint8_t i = 0; i < 4; i++)
+			{
+				if (mapping.dpad[i] != 0)
+				{
+					dpadBits[dpadCount] = Isa::set1(dpadMasks[i]);
+					dpadOutput[dpadCount++] = Isa::set1(mapping.dpad[i]);
+				}
+			}
+		}
+
+		inline void map(const uint16_t *buttons, const uint8_t *dpad, uint16_t *out) const
+		{
+			for (size_t lane = 0; lane < BATCH_BLOCK; lane += Isa::Lanes)
+			{
+				typename Isa::Vector value = Isa::load(buttons + lane);
+				typename Isa::Vector result = Isa::zero();
+				for (uint8_t i = 0; i < buttonCount; i++)
+					result = Isa::bitwiseOr(result, Isa::select(value, buttonBits[i], buttonOutput[i]));
+
+				if (dpadCount > 0)
+				{
+					value = Isa::loadBytes(dpad + lane);
+					for (uint8_t i = 0; i < dpadCount; i++)
+						result = Isa::bitwiseOr(result, Isa::select(value, dpadBits[i], dpadOutput[i]));
+				}
+
+				Isa::store(out + lane, result);
+			}
+		}
+
+	protected:
+		typename Isa::Vector buttonBits[GAMEPAD_BUTTON_COUNT];
+		typename Isa::Vector buttonOutput[GAMEPAD_BUTTON_COUNT];
+		typename Isa::Vector dpadBits[4];
+		typename Isa::Vector dpadOutput[4];
+		uint8_t buttonCount = 0;
+		uint8_t dpadCount = 0;
+};
+
+// Flip 16 axis values into XInput's signed range, inverting when `flip` is 0x7FFF
+template <class Isa>
+static inline void flipAxis(const uint16_t *in, uint16_t flip, int16_t *out)
+{
+	for (size_t lane = 0; lane < BATCH_BLOCK; lane += Isa::Lanes)
+		Isa::store(reinterpret_cast<uint16_t *>(out + lane), Isa::bitwiseXor(Isa::load(in + lane), Isa::set1(flip)));
+}
+
+template <class Isa>
+static size_t convertXInputBlocks(const GamepadStateBatch &states, size_t count, XInputReport *reports, bool analogTriggers)
+{
+	BatchButtonMapper<Isa> mapper(xinputReportMapping);
+	uint16_t buttons[BATCH_BLOCK];
+	int16_t lx[BATCH_BLOCK], ly[BATCH_BLOCK], rx[BATCH_BLOCK], ry[BATCH_BLOCK];
+	uint8_t lt[BATCH_BLOCK], rt[BATCH_BLOCK];
+
+	size_t i = 0;
+	for (; i + BATCH_BLOCK <= count; i += BATCH_BLOCK)
+	{
+		mapper.map(states.buttons + i, states.dpad + i, buttons);
+
+		// `+ INT16_MIN` flips the sign bit, and `~y + INT16_MIN` flips all the others
+		flipAxis<Isa>(states.lx + i, 0x8000, lx);
+		flipAxis<Isa>(states.ly + i, 0x7FFF, ly);
+		flipAxis<Isa>(states.rx + i, 0x8000, rx);
+		flipAxis<Isa>(states.ry + i, 0x7FFF, ry);
+
+		if (!analogTriggers)
+		{
+			Isa::pressed(states.buttons + i, GAMEPAD_MASK_L2, lt);
+			Isa::pressed(states.buttons + i, GAMEPAD_MASK_R2, rt);
+		}
+
+		for (size_t lane = 0; lane < BATCH_BLOCK; lane++)
+		{
+			XInputReport *report = &reports[i + lane];
+			report->report_id = 0;
+			report->report_size = XINPUT_ENDPOINT_SIZE;
+			report->buttons1 = static_cast<uint8_t>(buttons[lane]);
+			report->buttons2 = static_cast<uint8_t>(buttons[lane] >> 8);
+			report->lt = analogTriggers ? states.lt[i + lane] : lt[lane];
+			report->rt = analogTriggers ? states.rt[i + lane] : rt[lane];
+			report->lx = lx[lane];
+			report->ly = ly[lane];
+			report->rx = rx[lane];
+			report->ry = ry[lane];
+			memset(report->_reserved, 0, sizeof(report->_reserved));
+		}
+	}
+
+	return i;
+}
+
+template <class Isa, typename Report>
+static size_t convertHatBlocks(const GamepadStateBatch &states, size_t count, Report *reports, const GamepadReportMapping &mapping)
+{
+	BatchButtonMapper<Isa> mapper(mapping);
+	uint16_t buttons[BATCH_BLOCK];
+	uint8_t hat[BATCH_BLOCK], lx[BATCH_BLOCK], ly[BATCH_BLOCK], rx[BATCH_BLOCK], ry[BATCH_BLOCK];
+
+	size_t i = 0;
+	for (; i + BATCH_BLOCK <= count; i += BATCH_BLOCK)
+	{
+		mapper.map(states.buttons + i, states.dpad + i, buttons);
+		Isa::hat(states.dpad + i, hat);
+		Isa::narrow(states.lx + i, lx);
+		Isa::narrow(states.ly + i, ly);
+		Isa::narrow(states.rx + i, rx);
+		Isa::narrow(states.ry + i, ry);
+
+		for (size_t lane = 0; lane < BATCH_BLOCK; lane++)
+		{
+			Report *report = &reports[i + lane];
+			report->buttons = buttons[lane];
+			report->hat = hat[lane];
+			report->lx = lx[lane];
+			report->ly = ly[lane];
+			report->rx = rx[lane];
+			report->ry = ry[lane];
+			finishReport(report);
+		}
+	}
+
+	return i;
+}
+
+/* Kernel dispatch. Each converter handles the full blocks it can and returns where the scalar tail starts. */
+
+static inline GamepadBatchKernel availableKernel(GamepadBatchKernel kernel)
+{
+	return (kernel > BATCH_WIDEST_KERNEL) ? BATCH_WIDEST_KERNEL : kernel;
+}
+
+void convertXInputBatch(const GamepadStateBatch &states, size_t count, XInputReport *reports, bool analogTriggers,
+	GamepadBatchKernel kernel)
+{
+	size_t i = 0;
+	switch (availableKernel(kernel))
+	{
+#if defined(__AVX2__)
+		case GAMEPAD_BATCH_AVX2:
+			i = convertXInputBlocks<BatchAVX2>(states, count, reports, analogTriggers);
+			break;
+#endif
+#if defined(__SSE2__)
+		case GAMEPAD_BATCH_SSE2:
+			i = convertXInputBlocks<BatchSSE2>(states, count, reports, analogTriggers);
+			break;
+#endif
+		default:
+			break;
+	}
+
+	for (; i < count; i++)
+		convertXInputState(states, i, &reports[i], analogTriggers);
+}
+
+template <typename Report>
+static void convertHatBatch(const GamepadStateBatch &states, size_t count, Report *reports, GamepadBatchKernel kernel,
+	const GamepadReportMapping &mapping, const GamepadReportTable &table)
+{
+	size_t i = 0;
+	switch (availableKernel(kernel))
+	{
+#if defined(__AVX2__)
+		case GAMEPAD_BATCH_AVX2:
+			i = convertHatBlocks<BatchAVX2>(states, count, reports, mapping);
+			break;
+#endif
+#if defined(__SSE2__)
+		case GAMEPAD_BATCH_SSE2:
+			i = convertHatBlocks<BatchSSE2>(states, count, reports, mapping);
+			break;
+#endif
+		default:
+			(void)mapping;
+			break;
+	}
+
+	for (; i < count; i++)
+		convertHatState(states, i, &reports[i], table);
+}
+
+void convertSwitchBatch(const GamepadStateBatch &states, size_t count, SwitchReport *reports, GamepadBatchKernel kernel)
+{
+	convertHatBatch(states, count, reports, kernel, switchReportMapping, switchReportTable);
+}
+
+void convertHIDBatch(const GamepadStateBatch &states, size_t count, HIDReport *reports, GamepadBatchKernel kernel)
+{
+	convertHatBatch(states, count, reports, kernel, hidReportMapping, hidReportTable);
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "GamepadDescriptors.h"
+
+/*
+	Batch report conversion.
+
+	Converts many gamepad states at once, for hosts that relay or replay a large number of controllers. States are
+	passed in structure-of-arrays form so the button permutation, hat lookup, axis narrowing and XInput axis math can
+	run 16 states at a time in SIMD kernels. The states are expected to be already debounced and processed, the
+	conversion matches MPG::getReport() byte for byte.
+
+	The widest kernel the compiler targets is used: AVX2 when built with `-mavx2` (or `-march=native`), SSE2 on any
+	x86-64 build, and a scalar table-driven loop everywhere else.
+*/
+
+typedef enum
+{
+	GAMEPAD_BATCH_SCALAR,
+	GAMEPAD_BATCH_SSE2,
+	GAMEPAD_BATCH_AVX2,
+} GamepadBatchKernel;
+
+/**
+ * @brief Gamepad states in structure-of-arrays form. Every array holds `count` entries.
+ *
+ * The trigger arrays are only read when converting XInput reports with analog triggers.
+ */
+struct GamepadStateBatch
+{
+	const uint8_t *dpad;
+	const uint16_t *buttons;
+	const uint16_t *lx;
+	const uint16_t *ly;
+	const uint16_t *rx;
+	const uint16_t *ry;
+	const uint8_t *lt;
+	const uint8_t *rt;
+};
+
+/**
+ * @brief The widest kernel available in this build.
+ */
+GamepadBatchKernel getGamepadBatchKernel();
+
+/**
+ * @brief Convert `count` states to XInput reports.
+ *
+ * @param analogTriggers Use the `lt`/`rt` arrays, otherwise triggers follow the L2/R2 buttons
+ * @param kernel Kernel to use, falls back to the widest available kernel when not built in
+ */
+void convertXInputBatch(const GamepadStateBatch &states, size_t count, XInputReport *reports, bool analogTriggers,
+	GamepadBatchKernel kernel = getGamepadBatchKernel());
+
+/**
+ * @brief Convert `count` states to Switch reports.
+ */
+void convertSwitchBatch(const GamepadStateBatch &states, size_t count, SwitchReport *reports,
+	GamepadBatchKernel kernel = getGamepadBatchKernel());
+
+/**
+ * @brief Convert `count` states to HID reports.
+ */
+void convertHIDBatch(const GamepadStateBatch &states, size_t count, HIDReport *reports,
+	GamepadBatchKernel kernel = getGamepadBatchKernel());
@@ -0,0 +1,32 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief CRC-32 (IEEE 802.3, as used by zlib and PNG), four bits at a time so the table is only 64 bytes.
+ *
+ * @param crc The CRC of the preceding data, to checksum in pieces
+ */
+inline uint32_t computeGamepadCRC32(const uint8_t *data, size_t length, uint32_t crc = 0)
+{
+	static const uint32_t table[16] =
+	{
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+	};
+
+	crc = ~crc;
+	for (size_t i = 0; i < length; i++)
+	{
+		crc = (crc >> 4) ^ table[(crc ^ data[i]) & 0x0F];
+		crc = (crc >> 4) ^ table[(crc ^ (data[i] >> 4)) & 0x0F];
+	}
+
+	return ~crc;
+}
@@ -0,0 +1,120 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "GamepadConfig.h"
+
+/*
+	Clocks.
+
+	Timed stages read a free-running counter of ticks that wraps at 2^32. Times are only ever subtracted from one
+	another, so the wrap is harmless as long as the intervals compared are shorter than that, and stages that keep a
+	time for longer age it before it can wrap round.
+
+	By default the time comes from the board, with no indirection:
+
+	* `getMillis()`, a tick per millisecond wrapping every 49.7 days. This is all older sketches implement, and they
+	  are timed exactly as before.
+	* `getMicros()`, a tick per microsecond wrapping every 71.6 minutes, when the board defines GAMEPAD_CLOCK_MICROS
+	  as 1 and implements it, e.g. with Arduino's `micros()`. Debounce windows can then be set to fractions of a
+	  millisecond.
+
+	Durations are converted to ticks with GAMEPAD_CLOCK_TICKS_PER_MS, so timed code reads the same in both builds.
+
+	A gamepad can instead be given its own GamepadClock, read through one virtual call per frame, counting in the
+	same ticks. Host tests use GamepadVirtualClock to step time exactly, start it just before the wrap, or run
+	gamepads on separate timelines:
+
+	    GamepadVirtualClock clock(0xFFFFF000);
+	    gamepad.clock = &clock;
+	    clock.advance(GAMEPAD_CLOCK_TICKS_PER_MS);
+*/
+
+#if GAMEPAD_CLOCK_MICROS
+#define GAMEPAD_CLOCK_TICK_US 1UL
+#else
+#define GAMEPAD_CLOCK_TICK_US 1000UL
+#endif
+
+#define GAMEPAD_CLOCK_TICKS_PER_MS (1000UL / GAMEPAD_CLOCK_TICK_US)
+
+// Implement this wrapper function for your platform
+uint32_t getMillis();
+
+#if GAMEPAD_CLOCK_MICROS
+// Implement this wrapper function for your platform when GAMEPAD_CLOCK_MICROS is set
+uint32_t getMicros();
+#endif
+
+/**
+ * @brief The board's time in ticks, from `getMicros()` or `getMillis()` depending on GAMEPAD_CLOCK_MICROS.
+ */
+inline uint32_t __attribute__((always_inline)) getGamepadTime()
+{
+#if GAMEPAD_CLOCK_MICROS
+	return getMicros();
+#else
+	return getMillis();
+#endif
+}
+
+/**
+ * @brief Microseconds in whole ticks, rounded up so a window is never shorter than asked for.
+ */
+inline uint32_t getGamepadTicks(uint32_t us)
+{
+	return us / GAMEPAD_CLOCK_TICK_US + ((us % GAMEPAD_CLOCK_TICK_US) != 0);
+}
+
+/**
+ * @brief A time source in ticks that can be given to a gamepad in place of the board's.
+ */
+class GamepadClock
+{
+	public:
+		virtual ~GamepadClock() { }
+
+		/**
+		 * @brief Ticks since an arbitrary start, wrapping at 2^32.
+		 */
+		virtual uint32_t now() = 0;
+};
+
+/**
+ * @brief The board's time as a GamepadClock, for code that wants one object whichever clock is in use.
+ */
+class GamepadBoardClock : public GamepadClock
+{
+	public:
+		uint32_t now() override { return getGamepadTime(); }
+};
+
+/**
+ * @brief A clock that only moves when told to, for host tests and replaying recorded input.
+ */
+class GamepadVirtualClock : public GamepadClock
+{
+	public:
+		GamepadVirtualClock(uint32_t start = 0) : time(start) { }
+
+		uint32_t now() override { return time; }
+
+		inline void set(uint32_t ticks) { time = ticks; }
+		inline void advance(uint32_t ticks) { time += ticks; }
+
+	protected:
+		uint32_t time;
+};
+
+/**
+ * @brief The time from `clock`, or the board's when null.
+ */
+inline uint32_t __attribute__((always_inline)) getGamepadTime(GamepadClock *clock)
+{
+	return clock ? clock->now() : getGamepadTime();
+}
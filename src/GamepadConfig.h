@@ -16,3 +16,61 @@
 #ifndef DEFAULT_INPUT_MODE
 #define DEFAULT_INPUT_MODE INPUT_MODE_XINPUT
 #endif
+
+// Set to 1 to use the bit-parallel GamepadVerticalDebouncer in MPG instead of per-input timestamps
+#ifndef DEBOUNCE_VERTICAL_COUNTERS
+#define DEBOUNCE_VERTICAL_COUNTERS 0
+#endif
+
+// Set to 1 when the board implements `uint32_t getMicros()`, so timing is read from it in microsecond ticks instead
+// of from `getMillis()` in millisecond ticks, see GamepadClock.h
+#ifndef GAMEPAD_CLOCK_MICROS
+#define GAMEPAD_CLOCK_MICROS 0
+#endif
+
+// Set to 1 to time each pipeline stage into `MPGCore::profiler`, see GamepadProfiler.h
+#ifndef GAMEPAD_PROFILE
+#define GAMEPAD_PROFILE 0
+#endif
+
+#ifndef GAMEPAD_PROFILE_BUCKETS
+#define GAMEPAD_PROFILE_BUCKETS 20 // Histogram buckets per stage, the last one collects everything from 2^18 cycles up
+#endif
+
+#ifndef GAMEPAD_PROFILE_RING_SIZE
+#define GAMEPAD_PROFILE_RING_SIZE 16 // Recent samples kept, must be a power of 2
+#endif
+
+// Slack GamepadScheduler leaves between the end of a frame and the host's poll, covering clock and interrupt jitter
+#ifndef GAMEPAD_SCHEDULER_GUARD_US
+#define GAMEPAD_SCHEDULER_GUARD_US 25
+#endif
+
+#ifndef GAMEPAD_SCHEDULER_LOCK_POLLS
+#define GAMEPAD_SCHEDULER_LOCK_POLLS 8 // Consistent poll intervals seen before frames are aligned to them
+#endif
+
+// How long MPGS waits for a held hotkey to stop changing options before saving them anyway
+#ifndef GAMEPAD_SAVE_DELAY_MS
+#define GAMEPAD_SAVE_DELAY_MS 1000
+#endif
+
+#ifndef GAMEPAD_ADC_RING_SCANS
+#define GAMEPAD_ADC_RING_SCANS 16 // Analog scans buffered between reads, a power of 2 up to 128
+#endif
+
+#ifndef GAMEPAD_TURBO_WHEEL_SLOTS
+#define GAMEPAD_TURBO_WHEEL_SLOTS 32 // Time wheel slots for turbo and macro timers, a power of 2 up to 128
+#endif
+
+#ifndef GAMEPAD_MACRO_COUNT
+#define GAMEPAD_MACRO_COUNT 2 // Macros that can be bound at once
+#endif
+
+#ifndef GAMEPAD_MACRO_STEPS
+#define GAMEPAD_MACRO_STEPS 16 // Steps per macro, each one a set of buttons and D-pad held for some time
+#endif
+
+#ifndef GAMEPAD_HOTKEY_COUNT
+#define GAMEPAD_HOTKEY_COUNT 6 // Hotkeys that can be registered at once, including the F1 and F2 defaults, up to 16
+#endif
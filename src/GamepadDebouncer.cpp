@@ -5,28 +5,194 @@
 
 #include "GamepadDebouncer.h"
 
-void GamepadDebouncer::debounce(GamepadState *state)
+GamepadDebouncer::GamepadDebouncer(const uint8_t debounceMS) : debounceMS(debounceMS)
 {
-	uint32_t now = getMillis();
+	for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+		setWindows(key, debounceMS * GAMEPAD_CLOCK_TICKS_PER_MS, debounceMS * GAMEPAD_CLOCK_TICKS_PER_MS);
+}
+
+// Restart the wait of the inputs reading their debounced level that need it, then look at the ones that differ. A
+// change away from a level waits that level's window plus its extra ticks.
+template <typename Bits>
+static inline Bits debounceBits(Bits debounced, Bits raw, Bits restarting, uint32_t *times, const uint16_t *const *windows,
+	const uint8_t *bias, uint32_t now)
+{
+	Bits changed = debounced ^ raw;
+	for (unsigned bits = restarting & ~changed; bits; bits &= bits - 1)
+		times[__builtin_ctz(bits)] = now;
 
-	for (int i = 0; i < 4; i++)
+	for (unsigned bits = changed; bits; bits &= bits - 1)
 	{
-		if ((debounceState.dpad & dpadMasks[i]) != (state->dpad & dpadMasks[i]) && (now - dpadTime[i]) > debounceMS)
+		uint8_t i = __builtin_ctz(bits);
+		uint8_t level = (debounced >> i) & 1;
+		if ((now - times[i]) >= static_cast<uint32_t>(windows[level][i] + bias[level]))
 		{
-			debounceState.dpad ^= dpadMasks[i];
-			dpadTime[i] = now;
+			debounced ^= static_cast<Bits>(1U << i);
+			times[i] = now;
 		}
 	}
 
-	for (int i = 0; i < GAMEPAD_BUTTON_COUNT; i++)
+	return debounced;
+}
+
+void GamepadDebouncer::debounce(GamepadState *state, uint32_t now)
+{
+	static const uint16_t BUTTONS = (1U << GAMEPAD_BUTTON_COUNT) - 1;
+
+	// A time older than every wait has expired however much older it is, so every sixteenth of the wrap the old ones
+	// are brought up to the longest wait. None is then left long enough to wrap round and block its input.
+	if (now - agedAt >= 0x10000000UL)
 	{
-		if ((debounceState.buttons & buttonMasks[i]) != (state->buttons & buttonMasks[i]) && (now - buttonTime[i]) > debounceMS)
-		{
-			debounceState.buttons ^= buttonMasks[i];
-			buttonTime[i] = now;
-		}
+		for (uint8_t i = 0; i < GAMEPAD_BUTTON_COUNT; i++)
+			ageTime(buttonTime[i], now);
+		for (uint8_t i = 0; i < 4; i++)
+			ageTime(dpadTime[i], now);
+
+		agedAt = now;
+	}
+
+	uint8_t dpad = debounceState.dpad;
+	uint16_t buttons = debounceState.buttons;
+	uint8_t rawDpad = state->dpad & GAMEPAD_MASK_DPAD;
+	uint16_t rawButtons = state->buttons & BUTTONS;
+	uint8_t restartDpad = (restart[1] ? dpad : 0) | (restart[0] ? (~dpad & GAMEPAD_MASK_DPAD) : 0);
+	uint16_t restartButtons = (restart[1] ? buttons : 0) | (restart[0] ? (~buttons & BUTTONS) : 0);
+
+	// Most calls change nothing, and only need the restarts
+	if (!((dpad ^ rawDpad) | (buttons ^ rawButtons)))
+	{
+		for (unsigned bits = restartButtons; bits; bits &= bits - 1)
+			buttonTime[__builtin_ctz(bits)] = now;
+		for (unsigned bits = restartDpad; bits; bits &= bits - 1)
+			dpadTime[__builtin_ctz(bits)] = now;
+	}
+	else
+	{
+		// The window of each level, or none
+		static const uint16_t noWindows[GAMEPAD_DIGITAL_INPUT_COUNT] = { };
+		const uint16_t *levelWindows[2];
+		for (uint8_t level = 0; level < 2; level++)
+			levelWindows[level] = timed[level] ? windows[row[level]] : noWindows;
+
+		debounceState.buttons = debounceBits<uint16_t>(buttons, rawButtons, restartButtons, buttonTime, levelWindows,
+			bias, now);
+
+		for (uint8_t level = 0; level < 2; level++)
+			levelWindows[level] += GAMEPAD_BUTTON_COUNT;
+
+		debounceState.dpad = debounceBits<uint8_t>(dpad, rawDpad, restartDpad, dpadTime, levelWindows, bias, now);
 	}
 
 	state->dpad = debounceState.dpad;
 	state->buttons = debounceState.buttons;
 }
+
+GamepadVerticalDebouncer::GamepadVerticalDebouncer(const uint8_t debounceMS) : debounceMS(debounceMS)
+{
+	for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+		setWindows(key, debounceMS * GAMEPAD_CLOCK_TICKS_PER_MS, debounceMS * GAMEPAD_CLOCK_TICKS_PER_MS);
+}
+
+// Windows are rounded up to whole counter ticks, leaving room for the extra clock tick of a lockout. That only takes
+// another counter tick when the window was already a whole number of them.
+void GamepadVerticalDebouncer::setWindows(uint8_t key, uint16_t press, uint16_t release)
+{
+	uint32_t bit = 1UL << ((key < GAMEPAD_BUTTON_COUNT) ? key : (key - GAMEPAD_BUTTON_COUNT + 16));
+	const uint16_t ticks[2] = { press, release };
+	for (uint8_t window = 0; window < 2; window++)
+	{
+		uint32_t value = ticks[window] / DEBOUNCE_COUNTER_TICK + ((ticks[window] % DEBOUNCE_COUNTER_TICK) != 0);
+		if (value > DEBOUNCE_COUNTER_MAX - 1)
+			value = DEBOUNCE_COUNTER_MAX - 1;
+
+		whole[window] = (whole[window] & ~bit) | (((ticks[window] % DEBOUNCE_COUNTER_TICK) == 0) ? bit : 0);
+
+		for (int i = 0; i < DEBOUNCE_COUNTER_BITS; i++)
+			windows[window][i] = (windows[window][i] & ~bit) | (((value >> i) & 1) ? bit : 0);
+	}
+
+	compileRules();
+}
+
+uint16_t GamepadVerticalDebouncer::getWindow(uint8_t window, uint8_t key) const
+{
+	uint8_t shift = (key < GAMEPAD_BUTTON_COUNT) ? key : (key - GAMEPAD_BUTTON_COUNT + 16);
+	uint32_t value = 0;
+	for (int i = 0; i < DEBOUNCE_COUNTER_BITS; i++)
+		value |= ((windows[window][i] >> shift) & 1UL) << i;
+
+	return value * DEBOUNCE_COUNTER_TICK;
+}
+
+void GamepadVerticalDebouncer::compileRules()
+{
+	for (uint8_t level = 0; level < 2; level++)
+	{
+		for (int i = 0; i < DEBOUNCE_COUNTER_BITS; i++)
+			reloads[level][i] = timed[level] ? windows[row[level]][i] : 0;
+
+		// Add the extra tick of a lockout, carrying up the planes
+		uint32_t carry = (timed[level] && bias[level]) ? whole[row[level]] : 0;
+		for (int i = 0; i < DEBOUNCE_COUNTER_BITS; i++)
+		{
+			uint32_t next = reloads[level][i] & carry;
+			reloads[level][i] ^= carry;
+			carry = next;
+		}
+
+		restarts[level] = restart[level] ? DEBOUNCE_INPUT_MASK : 0;
+	}
+}
+
+void GamepadVerticalDebouncer::debounce(GamepadState *state, uint32_t now)
+{
+	// Count whole ticks, leaving the rest of the elapsed time for the next call. The subtraction is wrap safe.
+	uint32_t elapsed = (now - lastTick) / DEBOUNCE_COUNTER_TICK;
+	lastTick += elapsed * DEBOUNCE_COUNTER_TICK;
+
+	uint32_t planes[DEBOUNCE_COUNTER_BITS];
+	uint32_t locked = 0;
+	for (int i = 0; i < DEBOUNCE_COUNTER_BITS; i++)
+		planes[i] = counters[i];
+
+	// Multiple calls within the same tick are common, and there is nothing to count down for them
+	if (elapsed != 0)
+	{
+		// Counting down by the max value clears every counter, so saturate instead of special casing long gaps
+		if (elapsed > DEBOUNCE_COUNTER_MAX)
+			elapsed = DEBOUNCE_COUNTER_MAX;
+
+		// Subtract the elapsed time from all counters at once, one bit plane at a time
+		uint32_t borrow = 0;
+		for (int i = 0; i < DEBOUNCE_COUNTER_BITS; i++)
+		{
+			uint32_t subtrahend = -((elapsed >> i) & 1UL);
+			uint32_t plane = planes[i];
+			planes[i] = plane ^ subtrahend ^ borrow;
+			borrow = (~plane & (subtrahend | borrow)) | (subtrahend & borrow);
+		}
+
+		// Counters that went below zero have expired
+		for (int i = 0; i < DEBOUNCE_COUNTER_BITS; i++)
+			planes[i] &= ~borrow;
+	}
+
+	for (int i = 0; i < DEBOUNCE_COUNTER_BITS; i++)
+		locked |= planes[i];
+
+	uint32_t raw = (state->buttons | (static_cast<uint32_t>(state->dpad) << 16)) & DEBOUNCE_INPUT_MASK;
+	uint32_t changed = (raw ^ debounced) & ~locked;
+	debounced ^= changed;
+
+	// Changed inputs wait again by their new level, and so do inputs whose wait restarts while they read that level
+	uint32_t restarting = (debounced & restarts[1]) | (~debounced & restarts[0]);
+	uint32_t load = changed | (~(raw ^ debounced) & restarting);
+	for (int i = 0; i < DEBOUNCE_COUNTER_BITS; i++)
+	{
+		uint32_t reload = (debounced & reloads[1][i]) | (~debounced & reloads[0][i]);
+		counters[i] = (planes[i] & ~load) | (reload & load);
+	}
+
+	state->dpad = static_cast<uint8_t>(debounced >> 16);
+	state->buttons = static_cast<uint16_t>(debounced);
+}
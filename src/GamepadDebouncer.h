@@ -8,20 +8,290 @@
 #include <string.h>
 #include <stdint.h>
 #include "GamepadState.h"
+#include "GamepadClock.h"
 
-// Implement this wrapper function for your platform
-// TODO: Make this a pure virtual member instead.
-uint32_t getMillis();
+// Number of bit planes used by GamepadVerticalDebouncer, supports debounce times up to (2^bits - 2) ticks
+#ifndef DEBOUNCE_COUNTER_BITS
+#define DEBOUNCE_COUNTER_BITS 8
+#endif
 
-class GamepadDebouncer
+// Length of the ticks GamepadVerticalDebouncer counts in, in microseconds, at least one tick of the gamepad's clock
+#ifndef DEBOUNCE_COUNTER_TICK_US
+#define DEBOUNCE_COUNTER_TICK_US 1000
+#endif
+
+/*
+	Debounce modes and intervals.
+
+	Each input has a press window and a release window, both `debounceMS` to start with, and the mode decides what
+	they mean:
+
+	* DEBOUNCE_MODE_LOCKOUT: a change is reported at once, then the input is ignored for its press window. This is the
+	  original behavior, the same rule both ways with the release window unused.
+	* DEBOUNCE_MODE_ASYMMETRIC: a change is reported at once, then the input is ignored for its press window after a
+	  press and its release window after a release.
+	* DEBOUNCE_MODE_EAGER: a press is reported on its first edge, and bounce after it is ignored because a release is
+	  only reported once the input has read released for the release window. The press window is unused.
+	* DEBOUNCE_MODE_DEFER: a change is only reported once the input has read its new level for the press or release
+	  window. This adds the window to every edge, but also ignores short glitches that were never a press.
+
+	Windows are set per input, so D-pad levers and microswitches can bounce for different times:
+
+	    gamepad.debouncer.setMode(DEBOUNCE_MODE_EAGER);
+	    gamepad.debouncer.setButtonInterval(GAMEPAD_MASK_B1 | GAMEPAD_MASK_B2, 2, 5);
+	    gamepad.debouncer.setDpadInterval(GAMEPAD_MASK_DPAD, 2, 10);
+
+	Windows are kept in ticks of the gamepad's clock (see GamepadClock.h), up to 0xFFFF of them. With the default
+	`getMillis()` clock a tick is a millisecond and the debouncers behave exactly as they always have. With
+	GAMEPAD_CLOCK_MICROS windows can be shorter than a millisecond, e.g. `setButtonIntervalUs(GAMEPAD_MASK_B1, 500,
+	800)`, and on a millisecond clock they are rounded up to whole milliseconds.
+
+	Inputs are keys indexed as in GamepadRapidTrigger.h: buttons by bit, then the D-pad.
+*/
+
+/**
+ * @brief The mode and the window setters shared by both debouncers, which keep the windows themselves in as little
+ * memory as they can use them from. `Debouncer` provides `setWindows(key, pressTicks, releaseTicks)`,
+ * `getWindow(window, key)` and `compileRules()`, called after the mode changes.
+ */
+template <class Debouncer>
+class GamepadDebounceRules
+{
+	public:
+		void setMode(DebounceMode newMode)
+		{
+			mode = (newMode < DEBOUNCE_MODE_COUNT) ? newMode : DEBOUNCE_MODE_LOCKOUT;
+			setRules();
+			debouncer().compileRules();
+		}
+
+		inline DebounceMode getMode() const { return static_cast<DebounceMode>(mode); }
+
+		/**
+		 * @brief Set the press and release windows of each button in `buttons`, in milliseconds.
+		 */
+		inline void setButtonInterval(uint16_t buttons, uint8_t pressMS, uint8_t releaseMS)
+		{
+			setButtonIntervalUs(buttons, pressMS * 1000UL, releaseMS * 1000UL);
+		}
+
+		/**
+		 * @brief Set the press and release windows of each D-pad direction in `dpad`, in milliseconds.
+		 */
+		inline void setDpadInterval(uint8_t dpad, uint8_t pressMS, uint8_t releaseMS)
+		{
+			setDpadIntervalUs(dpad, pressMS * 1000UL, releaseMS * 1000UL);
+		}
+
+		/**
+		 * @brief Set the press and release windows of each button in `buttons`, in microseconds.
+		 */
+		void setButtonIntervalUs(uint16_t buttons, uint32_t pressUs, uint32_t releaseUs)
+		{
+			for (uint8_t key = 0; key < GAMEPAD_BUTTON_COUNT; key++)
+			{
+				if (buttons & buttonMasks[key])
+					debouncer().setWindows(key, getWindowTicks(pressUs), getWindowTicks(releaseUs));
+			}
+		}
+
+		/**
+		 * @brief Set the press and release windows of each D-pad direction in `dpad`, in microseconds.
+		 */
+		void setDpadIntervalUs(uint8_t dpad, uint32_t pressUs, uint32_t releaseUs)
+		{
+			for (uint8_t i = 0; i < 4; i++)
+			{
+				if (dpad & dpadMasks[i])
+					debouncer().setWindows(GAMEPAD_BUTTON_COUNT + i, getWindowTicks(pressUs), getWindowTicks(releaseUs));
+			}
+		}
+
+		/**
+		 * @brief The windows in ticks of the gamepad's clock.
+		 */
+		inline uint32_t getPressTicks(uint8_t key) const
+		{
+			return (key < GAMEPAD_DIGITAL_INPUT_COUNT) ? debouncer().getWindow(DEBOUNCE_WINDOW_PRESS, key) : 0;
+		}
+
+		inline uint32_t getReleaseTicks(uint8_t key) const
+		{
+			return (key < GAMEPAD_DIGITAL_INPUT_COUNT) ? debouncer().getWindow(DEBOUNCE_WINDOW_RELEASE, key) : 0;
+		}
+
+		inline uint32_t getPressUs(uint8_t key) const { return getPressTicks(key) * GAMEPAD_CLOCK_TICK_US; }
+		inline uint32_t getReleaseUs(uint8_t key) const { return getReleaseTicks(key) * GAMEPAD_CLOCK_TICK_US; }
+
+		/**
+		 * @brief The windows in whole milliseconds, rounded down.
+		 */
+		inline uint8_t getPressMS(uint8_t key) const { return getPressTicks(key) / GAMEPAD_CLOCK_TICKS_PER_MS; }
+		inline uint8_t getReleaseMS(uint8_t key) const { return getReleaseTicks(key) / GAMEPAD_CLOCK_TICKS_PER_MS; }
+
+	protected:
+		static const uint8_t DEBOUNCE_WINDOW_PRESS = 0;
+		static const uint8_t DEBOUNCE_WINDOW_RELEASE = 1;
+		static const uint8_t DEBOUNCE_WINDOW_NONE = 2;
+
+		GamepadDebounceRules() { setRules(); }
+
+		inline Debouncer &debouncer() { return *static_cast<Debouncer *>(this); }
+		inline const Debouncer &debouncer() const { return *static_cast<const Debouncer *>(this); }
+
+		static inline uint16_t getWindowTicks(uint32_t us)
+		{
+			uint32_t ticks = getGamepadTicks(us);
+			return (ticks < 0xFFFF) ? ticks : 0xFFFF;
+		}
+
+		// A change reported at once is followed by a lockout, checked as `> window` like the original debouncer, so
+		// its wait is one tick more. A deferred change only needs the input to have read its new level for the window
+		// since it last read the old one.
+		void setRules()
+		{
+			switch (mode)
+			{
+				case DEBOUNCE_MODE_ASYMMETRIC:
+					setLevel(1, DEBOUNCE_WINDOW_PRESS, 1);
+					setLevel(0, DEBOUNCE_WINDOW_RELEASE, 1);
+					break;
+
+				case DEBOUNCE_MODE_EAGER:
+					setLevel(1, DEBOUNCE_WINDOW_RELEASE, 0);
+					setLevel(0, DEBOUNCE_WINDOW_NONE, 0);
+					break;
+
+				case DEBOUNCE_MODE_DEFER:
+					setLevel(1, DEBOUNCE_WINDOW_RELEASE, 0);
+					setLevel(0, DEBOUNCE_WINDOW_PRESS, 0);
+					break;
+
+				default:
+					setLevel(1, DEBOUNCE_WINDOW_PRESS, 1);
+					setLevel(0, DEBOUNCE_WINDOW_PRESS, 1);
+					break;
+			}
+
+			restart[1] = (mode == DEBOUNCE_MODE_EAGER || mode == DEBOUNCE_MODE_DEFER);
+			restart[0] = (mode == DEBOUNCE_MODE_DEFER);
+		}
+
+		inline void setLevel(uint8_t level, uint8_t window, uint8_t extra)
+		{
+			timed[level] = (window != DEBOUNCE_WINDOW_NONE);
+			row[level] = timed[level] ? window : DEBOUNCE_WINDOW_PRESS;
+			bias[level] = extra;
+		}
+
+		uint8_t mode {DEBOUNCE_MODE_LOCKOUT};
+
+		// By debounced level: whether a change away from it waits, the window it waits and the ticks added to it, and
+		// whether reading that level restarts the wait
+		bool timed[2];
+		uint8_t row[2];
+		uint8_t bias[2];
+		bool restart[2];
+};
+
+class GamepadDebouncer : public GamepadDebounceRules<GamepadDebouncer>
 {
+	friend class GamepadDebounceRules<GamepadDebouncer>;
+
 	public:
-		GamepadDebouncer(const uint8_t debounceMS = 5) : debounceMS(debounceMS) { }
+		GamepadDebouncer(const uint8_t debounceMS = 5);
+
+		/**
+		 * @brief Debounce `state` in place at `now`, a time from the gamepad's clock.
+		 */
+		void debounce(GamepadState *state, uint32_t now);
 
-		void debounce(GamepadState *state);
+		/**
+		 * @brief Debounce `state` in place at the board's time.
+		 */
+		inline void debounce(GamepadState *state) { debounce(state, getGamepadTime()); }
 
 		const uint8_t debounceMS;
 		GamepadState debounceState;
-		uint32_t dpadTime[4];
-		uint32_t buttonTime[GAMEPAD_BUTTON_COUNT];
+		uint32_t dpadTime[4] { };
+		uint32_t buttonTime[GAMEPAD_BUTTON_COUNT] { };
+
+	protected:
+		// Older than any wait, as windows are at most 0xFFFF ticks
+		static const uint32_t DEBOUNCE_MAX_WAIT = 0x10000;
+
+		inline void setWindows(uint8_t key, uint16_t press, uint16_t release)
+		{
+			windows[DEBOUNCE_WINDOW_PRESS][key] = press;
+			windows[DEBOUNCE_WINDOW_RELEASE][key] = release;
+		}
+
+		inline uint16_t getWindow(uint8_t window, uint8_t key) const { return windows[window][key]; }
+
+		// The windows are read as they are, by the rules of each level
+		inline void compileRules() { }
+
+		inline void ageTime(uint32_t &time, uint32_t now)
+		{
+			if (now - time > DEBOUNCE_MAX_WAIT)
+				time = now - DEBOUNCE_MAX_WAIT;
+		}
+
+		uint16_t windows[2][GAMEPAD_DIGITAL_INPUT_COUNT]; // The press and release windows in ticks
+		uint32_t agedAt {0}; // When the times were last aged
+};
+
+/**
+ * @brief Bit-parallel debouncer using vertical counters.
+ *
+ * Behaves like GamepadDebouncer in every mode: instead of a timestamp per input, each input owns one bit in every
+ * counter plane, holding the time it has left to wait, so all 18 inputs are counted down and compared with a few
+ * word-wide operations. The work per call is the same no matter which inputs are pressed.
+ *
+ * Time is counted in whole ticks of DEBOUNCE_COUNTER_TICK_US, 1 ms by default, with the rest of the elapsed time
+ * carried over to the next call. Windows are rounded up to whole ticks and limited to `2^DEBOUNCE_COUNTER_BITS - 2`
+ * of them, so windows that are not whole ticks need GamepadDebouncer or a shorter tick. The windows are kept as
+ * planes too, and compiled into the wait planes of each level whenever the mode or a window changes.
+ *
+ * Inputs are packed as `buttons | (dpad << 16)`, the same layout as the GAMEPAD_MASK_D* masks.
+ */
+class GamepadVerticalDebouncer : public GamepadDebounceRules<GamepadVerticalDebouncer>
+{
+	friend class GamepadDebounceRules<GamepadVerticalDebouncer>;
+
+	public:
+		GamepadVerticalDebouncer(const uint8_t debounceMS = 5);
+
+		void debounce(GamepadState *state, uint32_t now);
+		inline void debounce(GamepadState *state) { debounce(state, getGamepadTime()); }
+
+		const uint8_t debounceMS;
+
+		/**
+		 * @brief The debounced inputs, packed as `buttons | (dpad << 16)`.
+		 */
+		uint32_t debounced {0};
+
+		/**
+		 * @brief Vertical wait counters. Bit N of plane I is bit I of the ticks input N has left to wait.
+		 */
+		uint32_t counters[DEBOUNCE_COUNTER_BITS] { };
+
+	protected:
+		static const uint32_t DEBOUNCE_COUNTER_MAX = (1UL << DEBOUNCE_COUNTER_BITS) - 1;
+		static const uint32_t DEBOUNCE_INPUT_MASK = ((1UL << GAMEPAD_BUTTON_COUNT) - 1) | (static_cast<uint32_t>(GAMEPAD_MASK_DPAD) << 16);
+
+		// A counter tick in ticks of the gamepad's clock, 1 on the default millisecond clock so nothing is divided
+		static const uint32_t DEBOUNCE_COUNTER_TICK = (DEBOUNCE_COUNTER_TICK_US > GAMEPAD_CLOCK_TICK_US)
+			? DEBOUNCE_COUNTER_TICK_US / GAMEPAD_CLOCK_TICK_US : 1;
+
+		void setWindows(uint8_t key, uint16_t press, uint16_t release);
+		uint16_t getWindow(uint8_t window, uint8_t key) const;
+		void compileRules();
+
+		uint32_t windows[2][DEBOUNCE_COUNTER_BITS] { }; // The press and release windows in counter ticks, as planes
+		uint32_t whole[2] { };                          // The inputs whose windows were whole counter ticks
+		uint32_t reloads[2][DEBOUNCE_COUNTER_BITS] { }; // The wait of each debounced level, as planes
+		uint32_t restarts[2] { };                       // The inputs whose wait restarts while they read each level
+		uint32_t lastTick {0};                          // When the last counted tick ended
 };
@@ -5,135 +5,158 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <string.h>
 #include "GamepadEnums.h"
+#include "descriptors/StringDescriptors.h"
 #include "descriptors/HIDDescriptors.h"
 #include "descriptors/SwitchDescriptors.h"
 #include "descriptors/XInputDescriptors.h"
 
+/*
+	Every descriptor is a constant built at compile time, including the UTF-16 strings, and is found with a single
+	lookup in `gamepadDescriptors` by input mode, descriptor type and index. Enumeration copies nothing into RAM.
+*/
+
 // Default value used for networking, override if necessary
-static uint8_t macAddress[6] = { 0x02, 0x02, 0x84, 0x6A, 0x96, 0x00 };
+#ifndef GAMEPAD_MAC_ADDRESS
+#define GAMEPAD_MAC_ADDRESS 0x02, 0x02, 0x84, 0x6A, 0x96, 0x00
+#endif
 
-static const uint8_t *getConfigurationDescriptor(uint16_t *size, InputMode mode)
-{
-	switch (mode)
-	{
-		case INPUT_MODE_XINPUT:
-			*size = sizeof(xinput_configuration_descriptor);
-			return xinput_configuration_descriptor;
+#define GAMEPAD_MAC_STRING_(a, b, c, d, e, f) \
+	{ GAMEPAD_HEX_BYTE(a), GAMEPAD_HEX_BYTE(b), GAMEPAD_HEX_BYTE(c), GAMEPAD_HEX_BYTE(d), GAMEPAD_HEX_BYTE(e), GAMEPAD_HEX_BYTE(f) }
+#define GAMEPAD_MAC_STRING(address) GAMEPAD_MAC_STRING_(address)
 
-		case INPUT_MODE_SWITCH:
-			*size = sizeof(switch_configuration_descriptor);
-			return switch_configuration_descriptor;
+static GAMEPAD_DESCRIPTOR_CONST uint8_t macAddress[6] = { GAMEPAD_MAC_ADDRESS };
 
-		default:
-			*size = sizeof(hid_configuration_descriptor);
-			return hid_configuration_descriptor;
-	}
-}
-
-static const uint8_t *getDeviceDescriptor(uint16_t *size, InputMode mode)
+// The MAC address as 12 hex digits, the serial string of network interfaces
+static GAMEPAD_DESCRIPTOR_CONST struct __attribute__((packed))
 {
-	switch (mode)
-	{
-		case INPUT_MODE_XINPUT:
-			*size = sizeof(xinput_device_descriptor);
-			return xinput_device_descriptor;
-
-		case INPUT_MODE_SWITCH:
-			*size = sizeof(switch_device_descriptor);
-			return switch_device_descriptor;
+	uint8_t bLength;
+	uint8_t bDescriptorType;
+	GamepadChar16 bString[12];
+} mac_string_serial = { 2 + 12 * sizeof(GamepadChar16), USB_DESCRIPTOR_TYPE_STRING, GAMEPAD_MAC_STRING(GAMEPAD_MAC_ADDRESS) };
+
+// Descriptor types, as in the high byte of wValue in a GET_DESCRIPTOR request
+#define USB_DESCRIPTOR_TYPE_DEVICE        0x01
+#define USB_DESCRIPTOR_TYPE_CONFIGURATION 0x02
+#define USB_DESCRIPTOR_TYPE_HID           0x21
+#define USB_DESCRIPTOR_TYPE_HID_REPORT    0x22
+
+// Slots in each input mode's row of the descriptor table
+typedef enum
+{
+	DESCRIPTOR_SLOT_DEVICE,
+	DESCRIPTOR_SLOT_CONFIGURATION,
+	DESCRIPTOR_SLOT_HID,
+	DESCRIPTOR_SLOT_HID_REPORT,
+	DESCRIPTOR_SLOT_STRING,         // String indexes 0-5 follow in order
+	DESCRIPTOR_SLOT_COUNT = DESCRIPTOR_SLOT_STRING + 6,
+	DESCRIPTOR_SLOT_NONE = DESCRIPTOR_SLOT_COUNT,
+} DescriptorSlot;
+
+typedef struct
+{
+	const void *data;
+	uint16_t size;
+} GamepadDescriptor;
 
-		default:
-			*size = sizeof(hid_device_descriptor);
-			return hid_device_descriptor;
-	}
-}
+#define GAMEPAD_DESCRIPTOR(descriptor) { &descriptor, sizeof(descriptor) }
+#define GAMEPAD_DESCRIPTOR_STRING(descriptor) { &descriptor, sizeof(descriptor) - sizeof(GamepadChar16) }
+#define GAMEPAD_DESCRIPTOR_NONE { NULL, 0 }
 
-static const uint8_t *getHIDDescriptor(uint16_t *size, InputMode mode)
+// Indexed by input mode then slot. XInput has no HID descriptors, and string index 4 is unused.
+static GAMEPAD_DESCRIPTOR_CONST GamepadDescriptor gamepadDescriptors[INPUT_MODE_HID + 1][DESCRIPTOR_SLOT_COUNT + 1] =
 {
-	switch (mode)
 	{
-		case INPUT_MODE_SWITCH:
-			*size = sizeof(switch_hid_descriptor);
-			return switch_hid_descriptor;
-
-		default:
-			*size = sizeof(hid_hid_descriptor);
-			return hid_hid_descriptor;
-	}
-}
-
-static const uint8_t *getHIDReport(uint16_t *size, InputMode mode)
+		GAMEPAD_DESCRIPTOR(xinput_device_descriptor),
+		GAMEPAD_DESCRIPTOR(xinput_configuration_descriptor),
+		GAMEPAD_DESCRIPTOR_NONE,
+		GAMEPAD_DESCRIPTOR_NONE,
+		GAMEPAD_DESCRIPTOR_STRING(xinput_string_language),
+		GAMEPAD_DESCRIPTOR_STRING(xinput_string_manufacturer),
+		GAMEPAD_DESCRIPTOR_STRING(xinput_string_product),
+		GAMEPAD_DESCRIPTOR_STRING(xinput_string_version),
+		GAMEPAD_DESCRIPTOR_NONE,
+		GAMEPAD_DESCRIPTOR(mac_string_serial),
+		GAMEPAD_DESCRIPTOR_NONE,
+	},
+	{
+		GAMEPAD_DESCRIPTOR(switch_device_descriptor),
+		GAMEPAD_DESCRIPTOR(switch_configuration_descriptor),
+		GAMEPAD_DESCRIPTOR(switch_hid_descriptor),
+		GAMEPAD_DESCRIPTOR(switch_report_descriptor),
+		GAMEPAD_DESCRIPTOR_STRING(switch_string_language),
+		GAMEPAD_DESCRIPTOR_STRING(switch_string_manufacturer),
+		GAMEPAD_DESCRIPTOR_STRING(switch_string_product),
+		GAMEPAD_DESCRIPTOR_STRING(switch_string_version),
+		GAMEPAD_DESCRIPTOR_NONE,
+		GAMEPAD_DESCRIPTOR(mac_string_serial),
+		GAMEPAD_DESCRIPTOR_NONE,
+	},
+	{
+		GAMEPAD_DESCRIPTOR(hid_device_descriptor),
+		GAMEPAD_DESCRIPTOR(hid_configuration_descriptor),
+		GAMEPAD_DESCRIPTOR(hid_hid_descriptor),
+		GAMEPAD_DESCRIPTOR(hid_report_descriptor),
+		GAMEPAD_DESCRIPTOR_STRING(hid_string_language),
+		GAMEPAD_DESCRIPTOR_STRING(hid_string_manufacturer),
+		GAMEPAD_DESCRIPTOR_STRING(hid_string_product),
+		GAMEPAD_DESCRIPTOR_STRING(hid_string_version),
+		GAMEPAD_DESCRIPTOR_NONE,
+		GAMEPAD_DESCRIPTOR(mac_string_serial),
+		GAMEPAD_DESCRIPTOR_NONE,
+	},
+};
+
+static inline DescriptorSlot getDescriptorSlot(uint8_t type, uint8_t index)
 {
-	switch (mode)
+	switch (type)
 	{
-		case INPUT_MODE_SWITCH:
-			*size = sizeof(switch_report_descriptor);
-			return switch_report_descriptor;
-
-		default:
-			*size = sizeof(hid_report_descriptor);
-			return hid_report_descriptor;
+		case USB_DESCRIPTOR_TYPE_DEVICE:        return DESCRIPTOR_SLOT_DEVICE;
+		case USB_DESCRIPTOR_TYPE_CONFIGURATION: return DESCRIPTOR_SLOT_CONFIGURATION;
+		case USB_DESCRIPTOR_TYPE_HID:           return DESCRIPTOR_SLOT_HID;
+		case USB_DESCRIPTOR_TYPE_HID_REPORT:    return DESCRIPTOR_SLOT_HID_REPORT;
+		case USB_DESCRIPTOR_TYPE_STRING:
+			return (index < DESCRIPTOR_SLOT_COUNT - DESCRIPTOR_SLOT_STRING) ? (DescriptorSlot)(DESCRIPTOR_SLOT_STRING + index) : DESCRIPTOR_SLOT_NONE;
+		default:                                return DESCRIPTOR_SLOT_NONE;
 	}
 }
 
-// Convert ASCII string into UTF-16
-static const uint16_t *convertStringDescriptor(uint16_t *payloadSize, const char *str, int charCount)
+/**
+ * @brief Look up a descriptor. Modes without descriptors of their own, like INPUT_MODE_CONFIG, use the HID ones.
+ *
+ * @param size Set to the descriptor size, or 0 if there is none
+ * @return const void* The descriptor, or NULL if there is none
+ */
+static inline const void *getGamepadDescriptor(uint16_t *size, InputMode mode, uint8_t type, uint8_t index)
 {
-	static uint16_t payload[32];
-
-	// Cap at max char
-	if (charCount > 31)
-		charCount = 31;
+	const GamepadDescriptor *descriptor = &gamepadDescriptors[(mode <= INPUT_MODE_HID) ? mode : INPUT_MODE_HID][getDescriptorSlot(type, index)];
+	*size = descriptor->size;
+	return descriptor->data;
+}
 
-	for (uint8_t i = 0; i < charCount; i++)
-		payload[1 + i] = str[i];
+static inline const uint8_t *getConfigurationDescriptor(uint16_t *size, InputMode mode)
+{
+	return (const uint8_t *)getGamepadDescriptor(size, mode, USB_DESCRIPTOR_TYPE_CONFIGURATION, 0);
+}
 
-	// first byte is length (including header), second byte is string type
-	*payloadSize = (2 * charCount + 2);
-	payload[0] = (0x03 << 8) | *payloadSize;
-	return payload;
+static inline const uint8_t *getDeviceDescriptor(uint16_t *size, InputMode mode)
+{
+	return (const uint8_t *)getGamepadDescriptor(size, mode, USB_DESCRIPTOR_TYPE_DEVICE, 0);
 }
 
-static const uint16_t *getStringDescriptor(uint16_t *size, InputMode mode, uint8_t index)
+static inline const uint8_t *getHIDDescriptor(uint16_t *size, InputMode mode)
 {
-	uint8_t charCount;
-	char *str;
+	return (const uint8_t *)getGamepadDescriptor(size, mode, USB_DESCRIPTOR_TYPE_HID, 0);
+}
 
-	if (index == 0)
-	{
-		str = (char *)xinput_string_descriptors[0];
-		charCount = 1;
-	}
-	else if (index == 5)
-	{
-		// Convert MAC address into UTF-16
-		for (int i = 0; i < 6; i++)
-		{
-			str[1 + charCount++] = "0123456789ABCDEF"[(macAddress[i] >> 4) & 0xf];
-			str[1 + charCount++] = "0123456789ABCDEF"[(macAddress[i] >> 0) & 0xf];
-		}
-	}
-	else
-	{
-		switch (mode)
-		{
-			case INPUT_MODE_XINPUT:
-				str = (char *)xinput_string_descriptors[index];
-				break;
-
-			case INPUT_MODE_SWITCH:
-				str = (char *)switch_string_descriptors[index];
-				break;
-
-			default:
-				str = (char *)hid_string_descriptors[index];
-				break;
-		}
-
-		charCount = strlen(str);
-	}
+static inline const uint8_t *getHIDReport(uint16_t *size, InputMode mode)
+{
+	return (const uint8_t *)getGamepadDescriptor(size, mode, USB_DESCRIPTOR_TYPE_HID_REPORT, 0);
+}
 
-	return convertStringDescriptor(size, str, charCount);
+static inline const uint16_t *getStringDescriptor(uint16_t *size, InputMode mode, uint8_t index)
+{
+	return (const uint16_t *)getGamepadDescriptor(size, mode, USB_DESCRIPTOR_TYPE_STRING, index);
 }
@@ -31,8 +31,32 @@ typedef enum
 	SOCD_MODE_UP_PRIORITY,           // U+D=U, L+R=N
 	SOCD_MODE_NEUTRAL,               // U+D=N, L+R=N
 	SOCD_MODE_SECOND_INPUT_PRIORITY, // U>D=D, L>R=R (Last Input Priority, aka Last Win)
+	SOCD_MODE_FIRST_INPUT_PRIORITY,  // U>D=U, L>R=L (First Input Priority)
+	SOCD_MODE_CUSTOM,                // Separate vertical and horizontal policies, see GamepadSOCD
+	SOCD_MODE_COUNT,
 } SOCDMode;
 
+// How one D-pad axis resolves both of its directions held at once
+typedef enum
+{
+	SOCD_AXIS_NEUTRAL,     // Neither
+	SOCD_AXIS_LAST_INPUT,  // The one pressed last
+	SOCD_AXIS_FIRST_INPUT, // The one pressed first
+	SOCD_AXIS_UP_LEFT,     // Up, or Left on the horizontal axis
+	SOCD_AXIS_DOWN_RIGHT,  // Down, or Right on the horizontal axis
+	SOCD_AXIS_COUNT,
+} SOCDAxisPolicy;
+
+// The available debouncing methods, see GamepadDebouncer.h
+typedef enum
+{
+	DEBOUNCE_MODE_LOCKOUT,    // Report every change at once, then ignore the input for its press window
+	DEBOUNCE_MODE_ASYMMETRIC, // Report every change at once, then ignore the input for its press or release window
+	DEBOUNCE_MODE_EAGER,      // Report presses at once, and releases held for the release window
+	DEBOUNCE_MODE_DEFER,      // Report presses held for the press window, and releases held for the release window
+	DEBOUNCE_MODE_COUNT,
+} DebounceMode;
+
 // Enum for tracking last direction state of Second Input SOCD method
 typedef enum
 {
@@ -57,4 +81,6 @@ typedef enum
 	HOTKEY_SOCD_LAST_INPUT   = (1U << 7),
 	HOTKEY_INVERT_X_AXIS     = (1U << 8),
 	HOTKEY_INVERT_Y_AXIS     = (1U << 9),
+	HOTKEY_CUSTOM            = (1U << 10), // A hotkey with its own action, see GamepadHotkeys
+	HOTKEY_SOCD_FIRST_INPUT  = (1U << 11),
 } GamepadHotkey;
@@ -0,0 +1,37 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief A region of NOR-flash-like storage, split into equal erase sectors.
+ *
+ * Erasing a sector sets every byte to 0xFF, and writing can only clear bits, so each byte is written at most once
+ * between erases. Writes start on a multiple of `getWriteSize()` and cover a whole number of write units. EEPROM can
+ * be adapted by treating any size as a sector and emulating erase with 0xFF writes.
+ *
+ * Addresses are relative to the start of the region: sector `n` starts at `n * getSectorSize()`.
+ */
+class GamepadFlash
+{
+	public:
+		virtual uint32_t getSectorSize() = 0;
+		virtual uint16_t getSectorCount() = 0;
+		virtual uint16_t getWriteSize() = 0;
+
+		virtual void read(uint32_t address, uint8_t *data, uint16_t length) = 0;
+
+		/**
+		 * @return bool False if the write failed, e.g. a program error or power loss
+		 */
+		virtual bool write(uint32_t address, const uint8_t *data, uint16_t length) = 0;
+
+		/**
+		 * @return bool False if the erase failed
+		 */
+		virtual bool erase(uint16_t sector) = 0;
+};
@@ -0,0 +1,267 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#include "GamepadHotkeys.h"
+
+GamepadHotkeys::GamepadHotkeys(uint16_t f1Mask, uint16_t f2Mask) : f1Mask(f1Mask), f2Mask(f2Mask)
+{
+}
+
+static const GamepadHotkeyDpadAction f1Actions[] =
+{
+	{ GAMEPAD_MASK_LEFT,  HOTKEY_DPAD_LEFT_ANALOG,  HOTKEY_TRIGGER_HELD },
+	{ GAMEPAD_MASK_RIGHT, HOTKEY_DPAD_RIGHT_ANALOG, HOTKEY_TRIGGER_HELD },
+	{ GAMEPAD_MASK_DOWN,  HOTKEY_DPAD_DIGITAL,      HOTKEY_TRIGGER_HELD },
+	{ GAMEPAD_MASK_UP,    HOTKEY_HOME_BUTTON,       HOTKEY_TRIGGER_HELD },
+};
+
+static const GamepadHotkeyDpadAction f2Actions[] =
+{
+	{ GAMEPAD_MASK_DOWN,  HOTKEY_SOCD_NEUTRAL,      HOTKEY_TRIGGER_HELD },
+	{ GAMEPAD_MASK_UP,    HOTKEY_SOCD_UP_PRIORITY,  HOTKEY_TRIGGER_HELD },
+	{ GAMEPAD_MASK_LEFT,  HOTKEY_SOCD_LAST_INPUT,   HOTKEY_TRIGGER_HELD },
+	{ GAMEPAD_MASK_RIGHT, HOTKEY_INVERT_Y_AXIS,     HOTKEY_TRIGGER_PRESS },
+};
+
+void GamepadHotkeys::addDefaults()
+{
+	add(GAMEPAD_HOTKEY_F2, f2Actions, sizeof(f2Actions) / sizeof(f2Actions[0]));
+
+	// Added last so F1 wins when both are held
+	add(GAMEPAD_HOTKEY_F1, f1Actions, sizeof(f1Actions) / sizeof(f1Actions[0]));
+}
+
+uint8_t GamepadHotkeys::add(uint16_t buttons, uint8_t dpad, GamepadHotkey hotkey, GamepadHotkeyTrigger trigger, uint16_t holdMS)
+{
+	return insert({ buttons, static_cast<uint8_t>(dpad & GAMEPAD_MASK_DPAD), 0, trigger, holdMS, hotkey, nullptr, nullptr });
+}
+
+uint8_t GamepadHotkeys::add(uint16_t buttons, uint8_t dpad, GamepadHotkeyTrigger trigger, uint16_t holdMS,
+	GamepadHotkeyAction action, void *context)
+{
+	return insert({ buttons, static_cast<uint8_t>(dpad & GAMEPAD_MASK_DPAD), 0, trigger, holdMS, HOTKEY_CUSTOM, action,
+		context });
+}
+
+uint8_t GamepadHotkeys::add(uint16_t buttons, const GamepadHotkeyDpadAction *actions, uint8_t count, uint16_t holdMS)
+{
+	if (!actions || !count)
+		return GAMEPAD_HOTKEY_NONE;
+
+	// The list is only ever read, the context is not const so custom actions can write to theirs
+	return insert({ buttons, 0, count, HOTKEY_TRIGGER_HELD, holdMS, HOTKEY_NONE, nullptr,
+		const_cast<GamepadHotkeyDpadAction *>(actions) });
+}
+
+uint8_t GamepadHotkeys::insert(const GamepadHotkeyEntry &entry)
+{
+	// A chord of nothing would hold every frame
+	if (!entry.buttons && !entry.dpad && !entry.dpadActions)
+		return GAMEPAD_HOTKEY_NONE;
+
+	for (uint8_t i = 0; i < GAMEPAD_HOTKEY_COUNT; i++)
+	{
+		if (!isUsed(i))
+		{
+			entries[i] = entry;
+			used |= 1U << i;
+			compile();
+			return i;
+		}
+	}
+
+	return GAMEPAD_HOTKEY_NONE;
+}
+
+void GamepadHotkeys::remove(uint8_t index)
+{
+	if (index >= GAMEPAD_HOTKEY_COUNT)
+		return;
+
+	used &= ~(1U << index);
+	compile();
+}
+
+void GamepadHotkeys::clear()
+{
+	used = 0;
+	compile();
+}
+
+void GamepadHotkeys::setModifiers(uint16_t f1Mask, uint16_t f2Mask)
+{
+	this->f1Mask = f1Mask;
+	this->f2Mask = f2Mask;
+	compile();
+}
+
+void GamepadHotkeys::compile()
+{
+	top = 0;
+	base = 0;
+	for (uint8_t dpad = 0; dpad <= GAMEPAD_MASK_DPAD; dpad++)
+		byDpad[dpad] = 0;
+
+	for (uint8_t i = 0; i < GAMEPAD_HOTKEY_COUNT; i++)
+	{
+		chords[i] = 0;
+		if (!isUsed(i))
+			continue;
+
+		const GamepadHotkeyEntry &entry = entries[i];
+		uint16_t buttons = entry.buttons & ~(GAMEPAD_HOTKEY_F1 | GAMEPAD_HOTKEY_F2);
+		if (entry.buttons & GAMEPAD_HOTKEY_F1)
+			buttons |= f1Mask;
+		if (entry.buttons & GAMEPAD_HOTKEY_F2)
+			buttons |= f2Mask;
+
+		chords[i] = buttons;
+		if (!buttons && !entry.dpad && !entry.dpadActions)
+			continue; // Modifier masks of 0 leave nothing to hold
+
+		// Every frame holding the chord has its lowest button. Chords of only the D-pad keep the gate open.
+		uint16_t lowest = ANY;
+		if (buttons)
+		{
+			lowest = 1;
+			while (!(buttons & lowest))
+				lowest <<= 1;
+		}
+
+		base |= lowest;
+		top = i + 1;
+		if (entry.dpadActions)
+		{
+			const GamepadHotkeyDpadAction *actions = static_cast<const GamepadHotkeyDpadAction *>(entry.context);
+			for (uint8_t j = 0; j < entry.dpadActions; j++)
+				byDpad[actions[j].dpad & GAMEPAD_MASK_DPAD] |= 1U << i;
+		}
+		else
+		{
+			for (uint8_t dpad = 0; dpad <= GAMEPAD_MASK_DPAD; dpad++)
+			{
+				if (!entry.dpad || entry.dpad == dpad)
+					byDpad[dpad] |= 1U << i;
+			}
+		}
+	}
+
+	// A chord held across new modifiers or hotkeys stays held, unless it was removed
+	if (held != GAMEPAD_HOTKEY_NONE && !isUsed(held))
+		held = GAMEPAD_HOTKEY_NONE;
+
+	gate = base | (held != GAMEPAD_HOTKEY_NONE ? ANY : 0);
+}
+
+GamepadHotkey GamepadHotkeys::match(GamepadState &state, GamepadOptions &options, uint16_t f1, uint16_t f2,
+	GamepadClock *clock)
+{
+	if (f1 != f1Mask || f2 != f2Mask)
+		setModifiers(f1, f2);
+
+	// The last one added wins
+	uint8_t dpad = state.dpad & GAMEPAD_MASK_DPAD;
+	uint16_t candidates = byDpad[dpad];
+	uint8_t found = GAMEPAD_HOTKEY_NONE;
+	for (uint8_t i = top; candidates && i-- > 0; )
+	{
+		uint16_t mask = 1U << i;
+		if ((candidates & mask) && (state.buttons & chords[i]) == chords[i])
+		{
+			found = i;
+			break;
+		}
+
+		candidates &= ~mask;
+	}
+
+	if (found == GAMEPAD_HOTKEY_NONE)
+	{
+		held = GAMEPAD_HOTKEY_NONE;
+		gate = base;
+		return HOTKEY_NONE;
+	}
+
+	const GamepadHotkeyEntry &entry = entries[found];
+	GamepadHotkey hotkey = entry.hotkey;
+	GamepadHotkeyTrigger trigger = entry.trigger;
+	uint8_t hidden = entry.dpad;
+	if (entry.dpadActions)
+	{
+		// The D-pad has one of the actions, or the entry would not be a candidate
+		const GamepadHotkeyDpadAction *action = static_cast<const GamepadHotkeyDpadAction *>(entry.context);
+		while ((action->dpad & GAMEPAD_MASK_DPAD) != dpad)
+			action++;
+
+		hotkey = action->hotkey;
+		trigger = action->trigger;
+		hidden = dpad;
+	}
+	else
+	{
+		dpad = 0;
+	}
+
+	bool pressed = (found != held) || (dpad != heldDpad);
+	held = found;
+	heldDpad = dpad;
+	gate = base | ANY;
+	state.buttons &= ~chords[found];
+	state.dpad &= ~hidden;
+
+	bool run;
+	switch (trigger)
+	{
+		case HOTKEY_TRIGGER_PRESS:
+			run = pressed;
+			break;
+
+		case HOTKEY_TRIGGER_HOLD:
+		{
+			uint32_t now = getGamepadTime(clock);
+			if (pressed)
+			{
+				heldSince = now;
+				fired = false;
+			}
+			run = !fired && (now - heldSince >= entry.holdMS * GAMEPAD_CLOCK_TICKS_PER_MS);
+			fired |= run;
+			break;
+		}
+
+		default:
+			run = true;
+			break;
+	}
+
+	if (run)
+	{
+		if (entry.action)
+			entry.action(state, options, entry.context);
+		else
+			runBuiltin(hotkey, state, options);
+	}
+
+	return hotkey;
+}
+
+void GamepadHotkeys::runBuiltin(GamepadHotkey hotkey, GamepadState &state, GamepadOptions &options)
+{
+	switch (hotkey)
+	{
+		case HOTKEY_DPAD_DIGITAL:      options.dpadMode = DPAD_MODE_DIGITAL; break;
+		case HOTKEY_DPAD_LEFT_ANALOG:  options.dpadMode = DPAD_MODE_LEFT_ANALOG; break;
+		case HOTKEY_DPAD_RIGHT_ANALOG: options.dpadMode = DPAD_MODE_RIGHT_ANALOG; break;
+		case HOTKEY_HOME_BUTTON:       state.buttons |= GAMEPAD_MASK_A1; break;
+		case HOTKEY_CAPTURE_BUTTON:    state.buttons |= GAMEPAD_MASK_A2; break;
+		case HOTKEY_SOCD_UP_PRIORITY:  options.socdMode = SOCD_MODE_UP_PRIORITY; break;
+		case HOTKEY_SOCD_NEUTRAL:      options.socdMode = SOCD_MODE_NEUTRAL; break;
+		case HOTKEY_SOCD_LAST_INPUT:   options.socdMode = SOCD_MODE_SECOND_INPUT_PRIORITY; break;
+		case HOTKEY_SOCD_FIRST_INPUT:  options.socdMode = SOCD_MODE_FIRST_INPUT_PRIORITY; break;
+		case HOTKEY_INVERT_X_AXIS:     options.invertXAxis = !options.invertXAxis; break;
+		case HOTKEY_INVERT_Y_AXIS:     options.invertYAxis = !options.invertYAxis; break;
+		default: break;
+	}
+}
@@ -0,0 +1,185 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "GamepadConfig.h"
+#include "GamepadClock.h"
+#include "GamepadEnums.h"
+#include "GamepadOptions.h"
+#include "GamepadState.h"
+
+/*
+	Hotkeys.
+
+	A hotkey is a chord of buttons and D-pad directions, when it fires, and an action. The buttons are all held
+	together with any others, while the D-pad must be exactly the chord's directions, or anything when the chord has
+	none. GAMEPAD_HOTKEY_F1 and GAMEPAD_HOTKEY_F2 in the chord stand for the gamepad's `f1Mask` and `f2Mask`.
+
+	While a chord is held its inputs are hidden from the host, and the action runs every frame
+	(HOTKEY_TRIGGER_HELD), once per press (HOTKEY_TRIGGER_PRESS), or once after the chord has been held for
+	`holdMS` (HOTKEY_TRIGGER_HOLD). Actions are the built-in GamepadHotkey ones, or any function with a context
+	pointer, so a board can add its own without deriving from MPG:
+
+	    gamepad.hotkeys.add(GAMEPAD_HOTKEY_F1 | GAMEPAD_MASK_B1, 0, HOTKEY_TRIGGER_HOLD, 2000, resetToBootloader, &board);
+
+	A chord can also pick one of several built-in hotkeys by its D-pad, taking one slot for all of them. The gamepad
+	starts with two of these, the F1 and F2 D-pad hotkeys. When more than one chord is held, the one added last wins.
+
+	Adding or removing a hotkey compiles the chords into a gate, the lowest button of each, and the chords that can
+	match each D-pad value. A frame holding no gate button or a D-pad no chord has, with no hotkey held on the last
+	frame, is done after one test, so the usual frame with no hotkey costs next to nothing. Otherwise only the chords
+	for its D-pad are compared. A held chord stays held across a recompile.
+*/
+
+#define GAMEPAD_HOTKEY_F1 (1U << 14) // Stands for `f1Mask` in a chord
+#define GAMEPAD_HOTKEY_F2 (1U << 15) // Stands for `f2Mask` in a chord
+
+#if GAMEPAD_HOTKEY_COUNT > 16
+#error "GAMEPAD_HOTKEY_COUNT is at most 16, the entries are kept in 16-bit masks"
+#endif
+
+#define GAMEPAD_HOTKEY_NONE 0xFF
+
+typedef enum
+{
+	HOTKEY_TRIGGER_HELD,  // Every frame the chord is held
+	HOTKEY_TRIGGER_PRESS, // Once when the chord is pressed
+	HOTKEY_TRIGGER_HOLD,  // Once when the chord has been held for `holdMS`
+} GamepadHotkeyTrigger;
+
+typedef void (*GamepadHotkeyAction)(GamepadState &state, GamepadOptions &options, void *context);
+
+struct GamepadHotkeyDpadAction
+{
+	uint8_t dpad;                    // Exact D-pad directions
+	GamepadHotkey hotkey;
+	GamepadHotkeyTrigger trigger;
+};
+
+struct GamepadHotkeyEntry
+{
+	uint16_t buttons;                // GAMEPAD_MASK_* and GAMEPAD_HOTKEY_F* held together
+	uint8_t dpad;                    // Exact D-pad directions, or 0 for any
+	uint8_t dpadActions;             // The GamepadHotkeyDpadAction list in `context` the D-pad picks from, or 0
+	GamepadHotkeyTrigger trigger;
+	uint16_t holdMS;
+	GamepadHotkey hotkey;            // Returned while the chord is held
+	GamepadHotkeyAction action;
+	void *context;
+};
+
+class GamepadHotkeys
+{
+	public:
+		GamepadHotkeys(uint16_t f1Mask = (GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2), uint16_t f2Mask = (GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3));
+
+		/**
+		 * @brief Add the F1 and F2 D-pad hotkeys, one slot each: D-pad mode and Home on F1, SOCD mode and invert Y on F2.
+		 */
+		void addDefaults();
+
+		/**
+		 * @brief Add a built-in hotkey.
+		 *
+		 * @return uint8_t The index of the new hotkey, or GAMEPAD_HOTKEY_NONE when all GAMEPAD_HOTKEY_COUNT are in use
+		 */
+		uint8_t add(uint16_t buttons, uint8_t dpad, GamepadHotkey hotkey, GamepadHotkeyTrigger trigger = HOTKEY_TRIGGER_HELD,
+			uint16_t holdMS = 0);
+
+		/**
+		 * @brief Add a hotkey running a custom action, reported as HOTKEY_CUSTOM.
+		 *
+		 * @return uint8_t The index of the new hotkey, or GAMEPAD_HOTKEY_NONE when all GAMEPAD_HOTKEY_COUNT are in use
+		 */
+		uint8_t add(uint16_t buttons, uint8_t dpad, GamepadHotkeyTrigger trigger, uint16_t holdMS, GamepadHotkeyAction action,
+			void *context);
+
+		/**
+		 * @brief Add a chord of buttons whose D-pad picks one of `count` built-in hotkeys. The list is not copied, and
+		 * HOTKEY_TRIGGER_HOLD actions in it wait `holdMS`.
+		 *
+		 * @return uint8_t The index of the new hotkey, or GAMEPAD_HOTKEY_NONE when all GAMEPAD_HOTKEY_COUNT are in use
+		 */
+		uint8_t add(uint16_t buttons, const GamepadHotkeyDpadAction *actions, uint8_t count, uint16_t holdMS = 0);
+
+		/**
+		 * @brief Remove one hotkey. The indexes of the others do not change.
+		 */
+		void remove(uint8_t index);
+
+		/**
+		 * @brief Remove every hotkey, including the defaults.
+		 */
+		void clear();
+
+		inline const GamepadHotkeyEntry &getEntry(uint8_t index) const { return entries[index]; }
+		inline bool isUsed(uint8_t index) const { return (used >> index) & 1; }
+
+		/**
+		 * @brief Set what GAMEPAD_HOTKEY_F1 and GAMEPAD_HOTKEY_F2 stand for.
+		 */
+		void setModifiers(uint16_t f1Mask, uint16_t f2Mask);
+
+		inline uint16_t getF1Mask() const { return f1Mask; }
+		inline uint16_t getF2Mask() const { return f2Mask; }
+
+		/**
+		 * @brief Find the held hotkey, hide its chord from the state and run its action when due. Hold times are read
+		 * from `clock`, or the board's clock when null.
+		 *
+		 * @return GamepadHotkey The held hotkey, or HOTKEY_NONE
+		 */
+		inline GamepadHotkey update(GamepadState &state, GamepadOptions &options, GamepadClock *clock = nullptr)
+		{
+			return update(state, options, f1Mask, f2Mask, clock);
+		}
+
+		/**
+		 * @brief As `update()`, first following changes to the gamepad's F1 and F2 masks.
+		 */
+		inline GamepadHotkey update(GamepadState &state, GamepadOptions &options, uint16_t f1, uint16_t f2,
+			GamepadClock *clock = nullptr)
+		{
+			// No chord was held on the last frame, and none can be starting: no gate button is held, or no chord has
+			// this D-pad. New masks can wait until something can match.
+			bool open = ((state.buttons | ANY) & gate) | (f1 ^ f1Mask) | (f2 ^ f2Mask);
+			if (!(open & (byDpad[state.dpad & GAMEPAD_MASK_DPAD] != 0)) && held == GAMEPAD_HOTKEY_NONE)
+				return HOTKEY_NONE;
+
+			return match(state, options, f1, f2, clock);
+		}
+
+		/**
+		 * @brief Run a built-in action on a state and options.
+		 */
+		static void runBuiltin(GamepadHotkey hotkey, GamepadState &state, GamepadOptions &options);
+
+	protected:
+		static const uint16_t ANY = GAMEPAD_HOTKEY_F2; // Never a button, so it opens the gate for every frame
+
+		GamepadHotkey match(GamepadState &state, GamepadOptions &options, uint16_t f1, uint16_t f2, GamepadClock *clock);
+		void compile();
+		uint8_t insert(const GamepadHotkeyEntry &entry);
+
+		GamepadHotkeyEntry entries[GAMEPAD_HOTKEY_COUNT];
+		uint16_t used {0};
+
+		// Compiled from the entries
+		uint16_t chords[GAMEPAD_HOTKEY_COUNT] { }; // Buttons with the F placeholders filled in
+		uint16_t byDpad[GAMEPAD_MASK_DPAD + 1] { };  // The entries that can match
+		uint8_t top {0};                             // One past the last entry in use
+		uint16_t base {0};                           // The lowest button of each chord, or ANY
+		uint16_t gate {0};                           // `base`, plus ANY while a hotkey is held
+		uint16_t f1Mask;
+		uint16_t f2Mask;
+
+		uint8_t held {GAMEPAD_HOTKEY_NONE};
+		uint8_t heldDpad {0};   // The D-pad of a held D-pad list, so moving to another action is a new press
+		bool fired {false};
+		uint32_t heldSince {0}; // When the held chord was pressed, in clock ticks
+};
@@ -0,0 +1,514 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#include <string.h>
+
+#include "GamepadLogStorage.h"
+#include "GamepadChecksum.h"
+
+#define OPTIONS_PAYLOAD_SIZE 5
+#define REMAP_PAYLOAD_BITS (GAMEPAD_STORAGE_REMAP_KEYS * GAMEPAD_DIGITAL_INPUT_COUNT)
+#define REMAP_PAYLOAD_SIZE ((REMAP_PAYLOAD_BITS + 7) / 8)
+
+static inline void put32(uint8_t *out, uint32_t value)
+{
+	out[0] = static_cast<uint8_t>(value);
+	out[1] = static_cast<uint8_t>(value >> 8);
+	out[2] = static_cast<uint8_t>(value >> 16);
+	out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+static inline uint32_t get32(const uint8_t *in)
+{
+	return in[0] | (in[1] << 8) | (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+static void encodeSectorHeader(uint8_t *out, uint32_t sequence)
+{
+	out[0] = 'M';
+	out[1] = 'P';
+	out[2] = 'G';
+	out[3] = 'L';
+	put32(out + 4, sequence);
+	put32(out + 8, 0);
+	put32(out + 12, computeGamepadCRC32(out, 12));
+}
+
+static bool decodeSectorHeader(const uint8_t *data, uint32_t &sequence)
+{
+	if (data[0] != 'M' || data[1] != 'P' || data[2] != 'G' || data[3] != 'L')
+		return false;
+
+	if (get32(data + 12) != computeGamepadCRC32(data, 12))
+		return false;
+
+	sequence = get32(data + 4);
+	return sequence != 0;
+}
+
+void encodeGamepadOptionsRecord(uint8_t *out, const GamepadOptions &options)
+{
+	memset(out, 0, GAMEPAD_STORAGE_SLOT_SIZE);
+	out[0] = GAMEPAD_STORAGE_RECORD_OPTIONS;
+	out[1] = GAMEPAD_STORAGE_OPTIONS_VERSION;
+	out[2] = OPTIONS_PAYLOAD_SIZE;
+	out[4] = static_cast<uint8_t>(options.inputMode);
+	out[5] = static_cast<uint8_t>(options.dpadMode);
+	out[6] = static_cast<uint8_t>(options.socdMode);
+	out[7] = options.invertXAxis ? 1 : 0;
+	out[8] = options.invertYAxis ? 1 : 0;
+	put32(out + 12, computeGamepadCRC32(out, 12));
+}
+
+bool decodeGamepadOptionsRecord(const uint8_t *data, GamepadOptions &options)
+{
+	if (data[0] != GAMEPAD_STORAGE_RECORD_OPTIONS || data[1] != GAMEPAD_STORAGE_OPTIONS_VERSION || data[2] != OPTIONS_PAYLOAD_SIZE)
+		return false;
+
+	uint32_t crc = get32(data + 12);
+	if (crc != computeGamepadCRC32(data, 12))
+		return false;
+
+	// A record from a build with more modes is not something this build can apply
+	if ((data[4] > INPUT_MODE_HID && data[4] != INPUT_MODE_CONFIG) || data[5] > DPAD_MODE_RIGHT_ANALOG
+		|| data[6] >= SOCD_MODE_COUNT || data[7] > 1 || data[8] > 1)
+		return false;
+
+	options.inputMode = static_cast<InputMode>(data[4]);
+	options.dpadMode = static_cast<DpadMode>(data[5]);
+	options.socdMode = static_cast<SOCDMode>(data[6]);
+	options.invertXAxis = data[7];
+	options.invertYAxis = data[8];
+	options.checksum = crc;
+	return true;
+}
+
+void encodeGamepadRemapRecord(uint8_t *out, uint8_t part, const uint32_t *map)
+{
+	memset(out, 0, GAMEPAD_STORAGE_SLOT_SIZE);
+	out[0] = GAMEPAD_STORAGE_RECORD_REMAP;
+	out[1] = GAMEPAD_STORAGE_REMAP_VERSION;
+	out[2] = REMAP_PAYLOAD_SIZE;
+	out[3] = part;
+
+	// Key masks are packed end to end, least significant bit first
+	for (uint8_t i = 0; i < REMAP_PAYLOAD_BITS; i++)
+	{
+		uint8_t key = part * GAMEPAD_STORAGE_REMAP_KEYS + i / GAMEPAD_DIGITAL_INPUT_COUNT;
+		if (key < GAMEPAD_DIGITAL_INPUT_COUNT && ((map[key] >> (i % GAMEPAD_DIGITAL_INPUT_COUNT)) & 1))
+			out[4 + i / 8] |= 1 << (i % 8);
+	}
+
+	put32(out + 12, computeGamepadCRC32(out, 12));
+}
+
+bool decodeGamepadRemapRecord(const uint8_t *data, uint8_t &part, uint32_t *map)
+{
+	if (data[0] != GAMEPAD_STORAGE_RECORD_REMAP || data[1] != GAMEPAD_STORAGE_REMAP_VERSION || data[2] != REMAP_PAYLOAD_SIZE
+		|| data[3] >= GAMEPAD_STORAGE_REMAP_PARTS)
+		return false;
+
+	if (get32(data + 12) != computeGamepadCRC32(data, 12))
+		return false;
+
+	part = data[3];
+	uint32_t keys[GAMEPAD_STORAGE_REMAP_KEYS] = { };
+	for (uint8_t i = 0; i < REMAP_PAYLOAD_BITS; i++)
+	{
+		if ((data[4 + i / 8] >> (i % 8)) & 1)
+			keys[i / GAMEPAD_DIGITAL_INPUT_COUNT] |= 1UL << (i % GAMEPAD_DIGITAL_INPUT_COUNT);
+	}
+
+	for (uint8_t i = 0; i < GAMEPAD_STORAGE_REMAP_KEYS && part * GAMEPAD_STORAGE_REMAP_KEYS + i < GAMEPAD_DIGITAL_INPUT_COUNT; i++)
+		map[part * GAMEPAD_STORAGE_REMAP_KEYS + i] = keys[i];
+
+	return true;
+}
+
+void GamepadLogStorage::start()
+{
+	stored = GamepadOptions();
+	pending = stored;
+	found = false;
+	dirty = false;
+	remapFound = false;
+	remapDirty = false;
+	saveStep = STORAGE_SAVE_IDLE;
+	sequence = 0;
+	slotCount = 0;
+	nextSlot = 0;
+
+	uint16_t writeSize = flash->getWriteSize();
+	uint16_t sectorCount = flash->getSectorCount();
+	if (writeSize == 0 || sectorCount < 2)
+		return;
+
+	uint32_t slotBytes = (GAMEPAD_STORAGE_SLOT_SIZE + writeSize - 1) / writeSize * writeSize;
+	uint32_t slots = flash->getSectorSize() / slotBytes;
+	if (slotBytes > GAMEPAD_STORAGE_SLOT_MAX || slots < 2)
+		return;
+
+	slotSize = static_cast<uint16_t>(slotBytes);
+	slotCount = (slots > 0xFFFF) ? 0xFFFF : static_cast<uint16_t>(slots);
+
+	// With no sector opened yet, the first save opens sector 0
+	activeSector = sectorCount - 1;
+	nextSlot = slotCount;
+
+	uint16_t sector;
+	uint32_t sectorSequence;
+	if (!findSector(UINT32_MAX, sector, sectorSequence))
+		return;
+
+	activeSector = sector;
+	sequence = sectorSequence;
+
+	// Slots are written in order, so the first blank one is found with a binary search
+	uint16_t low = 1;
+	uint16_t high = slotCount;
+	while (low < high)
+	{
+		uint16_t middle = low + (high - low) / 2;
+		if (isBlank(getSlotAddress(sector, middle), GAMEPAD_STORAGE_SLOT_SIZE))
+			high = middle;
+		else
+			low = middle + 1;
+	}
+	nextSlot = low;
+
+	// Walk back to the newest valid records, into older sectors if the newest has none
+	uint16_t newest = sector;
+	uint16_t end = nextSlot;
+	for (uint16_t i = 0; i < sectorCount && !findOptions(sector, end); i++)
+	{
+		if (!findSector(sectorSequence, sector, sectorSequence))
+			break;
+
+		end = slotCount;
+	}
+
+	sector = newest;
+	sectorSequence = sequence;
+	end = nextSlot;
+	for (uint16_t i = 0; i < sectorCount && !findRemap(sector, end); i++)
+	{
+		if (!findSector(sectorSequence, sector, sectorSequence))
+			break;
+
+		end = slotCount;
+	}
+
+	pending = stored;
+}
+
+void GamepadLogStorage::save()
+{
+	if (!dirty && !remapDirty)
+		return;
+
+	beginSave(pending);
+	while (!stepSave()) { }
+}
+
+void GamepadLogStorage::beginSave(GamepadOptions options)
+{
+	pending = options;
+	dirty = true;
+	saveStep = STORAGE_SAVE_CHECK;
+}
+
+bool GamepadLogStorage::stepSave()
+{
+	switch (saveStep)
+	{
+		case STORAGE_SAVE_CHECK:
+		{
+			// Sectors with no room for a remap and options never hold a remap
+			if (slotCount < GAMEPAD_STORAGE_REMAP_PARTS + 2)
+				remapDirty = false;
+
+			if (!(dirty || remapDirty) || slotCount == 0)
+				break;
+
+			// Saving the same options again costs nothing
+			uint8_t current[GAMEPAD_STORAGE_SLOT_SIZE];
+			encodeGamepadOptionsRecord(saveRecord, pending);
+			encodeGamepadOptionsRecord(current, stored);
+			if (found && memcmp(saveRecord, current, GAMEPAD_STORAGE_SLOT_SIZE) == 0)
+				dirty = false;
+
+			if (!(dirty || remapDirty))
+				break;
+
+			savePart = remapDirty ? 0 : GAMEPAD_STORAGE_REMAP_PARTS;
+			saveLast = dirty ? GAMEPAD_STORAGE_REMAP_PARTS : GAMEPAD_STORAGE_REMAP_PARTS - 1;
+			saveOffset = 0;
+			if (nextSlot + saveLast - savePart < slotCount)
+			{
+				encodeSaveRecord();
+				saveStep = STORAGE_SAVE_RECORD;
+			}
+			else
+			{
+				saveSector = (activeSector + 1) % flash->getSectorCount();
+				saveStep = STORAGE_SAVE_BLANK;
+			}
+			return false;
+		}
+
+		case STORAGE_SAVE_BLANK:
+		{
+			// Sectors are only erased if they need it, so the first trip around the ring erases nothing
+			uint32_t sectorSize = flash->getSectorSize();
+			uint32_t length = (sectorSize - saveOffset < GAMEPAD_STORAGE_BLANK_CHUNK) ? sectorSize - saveOffset : GAMEPAD_STORAGE_BLANK_CHUNK;
+			if (!isBlank(getSlotAddress(saveSector, 0) + saveOffset, length))
+			{
+				saveStep = STORAGE_SAVE_ERASE;
+				return false;
+			}
+
+			saveOffset += length;
+			if (saveOffset >= sectorSize)
+			{
+				saveOffset = 0;
+				saveStep = STORAGE_SAVE_HEADER;
+			}
+			return false;
+		}
+
+		case STORAGE_SAVE_ERASE:
+			if (!flash->erase(saveSector))
+				break;
+
+			saveOffset = 0;
+			saveStep = STORAGE_SAVE_HEADER;
+			return false;
+
+		case STORAGE_SAVE_HEADER:
+		{
+			// A torn header fails its CRC, and the next save erases the sector again
+			uint8_t header[GAMEPAD_STORAGE_SLOT_SIZE];
+			encodeSectorHeader(header, sequence + 1);
+			if (!writeUnit(saveSector, 0, header))
+				break;
+
+			if (saveOffset < GAMEPAD_STORAGE_SLOT_SIZE)
+				return false;
+
+			activeSector = saveSector;
+			sequence++;
+			nextSlot = 1;
+			saveOffset = 0;
+
+			// The new sector starts with the newest remap and options, whether they changed or not
+			bool remapFits = slotCount >= GAMEPAD_STORAGE_REMAP_PARTS + 2;
+			savePart = ((remapFound || remapDirty) && remapFits) ? 0 : GAMEPAD_STORAGE_REMAP_PARTS;
+			saveLast = (found || dirty) ? GAMEPAD_STORAGE_REMAP_PARTS : GAMEPAD_STORAGE_REMAP_PARTS - 1;
+			encodeSaveRecord();
+			saveStep = STORAGE_SAVE_RECORD;
+			return false;
+		}
+
+		case STORAGE_SAVE_RECORD:
+			// A failed write leaves the records dirty for the next save, and uses up the slot unless it is still blank
+			if (!writeUnit(activeSector, nextSlot, saveRecord))
+			{
+				if (!isBlank(getSlotAddress(activeSector, nextSlot), slotSize))
+					nextSlot++;
+				break;
+			}
+
+			if (saveOffset < GAMEPAD_STORAGE_SLOT_SIZE)
+				return false;
+
+			saveStep = STORAGE_SAVE_VERIFY;
+			return false;
+
+		case STORAGE_SAVE_VERIFY:
+		{
+			uint8_t written[GAMEPAD_STORAGE_SLOT_SIZE];
+			readSlot(activeSector, nextSlot++, written);
+			if (savePart == GAMEPAD_STORAGE_REMAP_PARTS)
+			{
+				if (decodeGamepadOptionsRecord(written, stored))
+				{
+					// Options staged while the save ran are still dirty
+					found = true;
+					dirty = !equalGamepadOptions(stored, pending);
+				}
+				break;
+			}
+
+			if (memcmp(written, saveRecord, GAMEPAD_STORAGE_SLOT_SIZE) != 0)
+				break;
+
+			remapFound |= (savePart == GAMEPAD_STORAGE_REMAP_PARTS - 1);
+
+			// A remap staged since the first part was written makes the rest of this one useless
+			savePart = remapDirty ? GAMEPAD_STORAGE_REMAP_PARTS : savePart + 1;
+			if (savePart > saveLast)
+				break;
+
+			encodeSaveRecord();
+			saveOffset = 0;
+			saveStep = STORAGE_SAVE_RECORD;
+			return false;
+		}
+
+		default:
+			break;
+	}
+
+	// A remap cut short by a failure is written again by the next save
+	if (saveStep >= STORAGE_SAVE_RECORD && savePart < GAMEPAD_STORAGE_REMAP_PARTS)
+		remapDirty = true;
+
+	saveStep = STORAGE_SAVE_IDLE;
+	return true;
+}
+
+GamepadOptions GamepadLogStorage::getGamepadOptions()
+{
+	return stored;
+}
+
+void GamepadLogStorage::setGamepadOptions(GamepadOptions options)
+{
+	pending = options;
+	dirty = true;
+}
+
+bool GamepadLogStorage::getRemap(uint32_t *map)
+{
+	if (!remapFound && !remapDirty)
+		return false;
+
+	memcpy(map, remap, sizeof(remap));
+	return true;
+}
+
+void GamepadLogStorage::setRemap(const uint32_t *map)
+{
+	if ((remapFound || remapDirty) && memcmp(map, remap, sizeof(remap)) == 0)
+		return;
+
+	memcpy(remap, map, sizeof(remap));
+	remapDirty = true;
+}
+
+void GamepadLogStorage::encodeSaveRecord()
+{
+	if (savePart == GAMEPAD_STORAGE_REMAP_PARTS)
+	{
+		encodeGamepadOptionsRecord(saveRecord, pending);
+		return;
+	}
+
+	// From the first part on the remap being written is no longer dirty, unless it is staged again
+	if (savePart == 0)
+		remapDirty = false;
+
+	encodeGamepadRemapRecord(saveRecord, savePart, remap);
+}
+
+bool GamepadLogStorage::findOptions(uint16_t sector, uint16_t end)
+{
+	uint8_t data[GAMEPAD_STORAGE_SLOT_SIZE];
+	for (uint16_t slot = end; slot > 1; slot--)
+	{
+		readSlot(sector, slot - 1, data);
+		if (decodeGamepadOptionsRecord(data, stored))
+		{
+			found = true;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Find the newest run of every remap part in order, ending before slot `end`
+bool GamepadLogStorage::findRemap(uint16_t sector, uint16_t end)
+{
+	uint8_t data[GAMEPAD_STORAGE_SLOT_SIZE];
+	uint32_t map[GAMEPAD_DIGITAL_INPUT_COUNT];
+	for (uint16_t slot = end; slot > GAMEPAD_STORAGE_REMAP_PARTS; slot--)
+	{
+		uint8_t count = 0;
+		uint8_t part;
+		while (count < GAMEPAD_STORAGE_REMAP_PARTS)
+		{
+			readSlot(sector, slot - 1 - count, data);
+			if (!decodeGamepadRemapRecord(data, part, map) || part != GAMEPAD_STORAGE_REMAP_PARTS - 1 - count)
+				break;
+
+			count++;
+		}
+
+		if (count == GAMEPAD_STORAGE_REMAP_PARTS)
+		{
+			memcpy(remap, map, sizeof(remap));
+			remapFound = true;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Find the sector with the highest sequence below `below`
+bool GamepadLogStorage::findSector(uint32_t below, uint16_t &sector, uint32_t &sectorSequence)
+{
+	uint8_t data[GAMEPAD_STORAGE_SLOT_SIZE];
+	uint32_t best = 0;
+	for (uint16_t i = 0; i < flash->getSectorCount(); i++)
+	{
+		uint32_t headerSequence;
+		readSlot(i, 0, data);
+		if (decodeSectorHeader(data, headerSequence) && headerSequence < below && headerSequence > best)
+		{
+			best = headerSequence;
+			sector = i;
+		}
+	}
+
+	sectorSequence = best;
+	return best != 0;
+}
+
+// Write the next write unit of a slot, leaving the erased padding after the 16 data bytes alone
+bool GamepadLogStorage::writeUnit(uint16_t sector, uint16_t slot, const uint8_t *data)
+{
+	uint16_t writeSize = flash->getWriteSize();
+	uint8_t buffer[GAMEPAD_STORAGE_SLOT_MAX];
+	for (uint16_t i = 0; i < writeSize; i++)
+		buffer[i] = (saveOffset + i < GAMEPAD_STORAGE_SLOT_SIZE) ? data[saveOffset + i] : 0xFF;
+
+	uint32_t address = getSlotAddress(sector, slot) + saveOffset;
+	saveOffset += writeSize;
+	return flash->write(address, buffer, writeSize);
+}
+
+void GamepadLogStorage::readSlot(uint16_t sector, uint16_t slot, uint8_t *data)
+{
+	flash->read(getSlotAddress(sector, slot), data, GAMEPAD_STORAGE_SLOT_SIZE);
+}
+
+bool GamepadLogStorage::isBlank(uint32_t address, uint32_t length)
+{
+	uint8_t data[GAMEPAD_STORAGE_SLOT_SIZE];
+	for (uint32_t offset = 0; offset < length; offset += GAMEPAD_STORAGE_SLOT_SIZE)
+	{
+		uint16_t chunk = (length - offset < GAMEPAD_STORAGE_SLOT_SIZE) ? length - offset : GAMEPAD_STORAGE_SLOT_SIZE;
+		flash->read(address + offset, data, chunk);
+		for (uint16_t i = 0; i < chunk; i++)
+		{
+			if (data[i] != 0xFF)
+				return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,186 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "GamepadFlash.h"
+#include "GamepadStorage.h"
+
+/*
+	Wear-levelled GamepadOptions and remap storage.
+
+	Instead of rewriting the same cells on every save, options are appended as records to a ring of flash sectors.
+	Each sector starts with a header slot holding its sequence number, and records fill the following slots in
+	order. When a sector is full the next one in the ring is erased (only if it is not blank already) and opened
+	with the next sequence number, so every sector is erased once per trip around the ring.
+
+	    header  'M' 'P' 'G' 'L' sequence(4) reserved(4) crc32(4)
+	    record  tag(1) version(1) length(1) reserved(1) payload(8) crc32(4)
+
+	All fields are little-endian and both CRCs cover the 12 bytes before them. Slots are 16 bytes, rounded up to
+	the medium's write size, and unused bytes are left erased.
+
+	At boot `start()` reads the sector headers, binary searches the newest sector for its first blank slot and walks
+	back to the last record with a valid CRC, version and values. A torn write from a power loss therefore only
+	loses the options being saved, and falls back to the previous record, or the previous sector when the newest
+	sector has none.
+
+	A button remap is saved as GAMEPAD_STORAGE_REMAP_PARTS records in consecutive slots, each with its part number in
+	the reserved byte and the 18-bit key masks of GAMEPAD_STORAGE_REMAP_KEYS physical keys packed into its payload.
+	Only a run of every part in order counts, so a torn remap save falls back to the previous remap. A save that
+	opens a sector starts it with the newest remap and options, so older sectors can be erased without losing them.
+
+	Saves run as a state machine, so `stepSave()` can spread one over several frames: each step does at most one
+	erase, one write unit, or a GAMEPAD_STORAGE_BLANK_CHUNK sized read. An erase cannot be split, so a step that
+	erases takes as long as the medium's sector erase, once per sector per trip around the ring.
+*/
+
+#define GAMEPAD_STORAGE_SLOT_SIZE 16
+#define GAMEPAD_STORAGE_RECORD_OPTIONS 0x4F
+#define GAMEPAD_STORAGE_OPTIONS_VERSION 1
+#define GAMEPAD_STORAGE_RECORD_REMAP 0x52
+#define GAMEPAD_STORAGE_REMAP_VERSION 1
+#define GAMEPAD_STORAGE_REMAP_KEYS 3 // Key masks per remap record
+#define GAMEPAD_STORAGE_REMAP_PARTS ((GAMEPAD_DIGITAL_INPUT_COUNT + GAMEPAD_STORAGE_REMAP_KEYS - 1) / GAMEPAD_STORAGE_REMAP_KEYS)
+
+#ifndef GAMEPAD_STORAGE_BLANK_CHUNK
+#define GAMEPAD_STORAGE_BLANK_CHUNK 256 // Bytes checked per save step when opening a sector
+#endif
+
+#ifndef GAMEPAD_STORAGE_SLOT_MAX
+#if defined(__AVR__)
+#define GAMEPAD_STORAGE_SLOT_MAX GAMEPAD_STORAGE_SLOT_SIZE
+#else
+#define GAMEPAD_STORAGE_SLOT_MAX 256 // Largest flash write size supported, e.g. an RP2040 page
+#endif
+#endif
+
+typedef enum
+{
+	STORAGE_SAVE_IDLE,
+	STORAGE_SAVE_CHECK,    // Skip unchanged options, or pick where the records go
+	STORAGE_SAVE_BLANK,    // Check the next sector in the ring is blank
+	STORAGE_SAVE_ERASE,
+	STORAGE_SAVE_HEADER,   // Open the next sector
+	STORAGE_SAVE_RECORD,
+	STORAGE_SAVE_VERIFY,
+} StorageSaveStep;
+
+class GamepadLogStorage : public GamepadStorage
+{
+	public:
+		GamepadLogStorage(GamepadFlash *flash) : flash(flash) { }
+
+		/**
+		 * @brief Find the newest valid options and the next free slot.
+		 */
+		void start() override;
+
+		/**
+		 * @brief Append the options passed to `setGamepadOptions()` and the remap passed to `setRemap()`, if they differ
+		 * from the stored ones.
+		 */
+		void save() override;
+
+		void beginSave(GamepadOptions options) override;
+		bool stepSave() override;
+
+		/**
+		 * @brief The newest stored options, or defaults if there are none.
+		 */
+		GamepadOptions getGamepadOptions() override;
+
+		/**
+		 * @brief Stage options for the next `save()`.
+		 */
+		void setGamepadOptions(GamepadOptions options) override;
+
+		/**
+		 * @brief The newest remap, staged or stored.
+		 */
+		bool getRemap(uint32_t *map) override;
+
+		/**
+		 * @brief Stage a remap for the next save, if it differs from the newest one. A remap staged while one is being
+		 * written cuts that one short and is saved by the next save.
+		 */
+		void setRemap(const uint32_t *map) override;
+
+		/**
+		 * @brief True if `start()` found valid options or they have been saved since.
+		 */
+		inline bool hasOptions() const { return found; }
+
+		/**
+		 * @brief True if `start()` found a valid remap or one has been saved since.
+		 */
+		inline bool hasRemap() const { return remapFound; }
+
+		inline uint16_t getActiveSector() const { return activeSector; }
+		inline uint32_t getSequence() const { return sequence; }
+		inline uint16_t getNextSlot() const { return nextSlot; }
+		inline uint16_t getSlotCount() const { return slotCount; }
+		inline StorageSaveStep getSaveStep() const { return saveStep; }
+
+	protected:
+		bool findOptions(uint16_t sector, uint16_t end);
+		bool findRemap(uint16_t sector, uint16_t end);
+		void encodeSaveRecord();
+		bool findSector(uint32_t below, uint16_t &sector, uint32_t &sectorSequence);
+		bool writeUnit(uint16_t sector, uint16_t slot, const uint8_t *data);
+		bool isBlank(uint32_t address, uint32_t length);
+		void readSlot(uint16_t sector, uint16_t slot, uint8_t *data);
+		inline uint32_t getSlotAddress(uint16_t sector, uint16_t slot)
+		{
+			return static_cast<uint32_t>(sector) * flash->getSectorSize() + static_cast<uint32_t>(slot) * slotSize;
+		}
+
+		GamepadFlash *flash;
+		GamepadOptions stored;
+		GamepadOptions pending;
+		bool found {false};
+		bool dirty {false};
+		uint16_t slotSize {0};
+		uint16_t slotCount {0};
+		uint16_t activeSector {0};
+		uint16_t nextSlot {0};        // Next free slot in the active sector, slotCount when it is full or unknown
+		uint32_t sequence {0};        // Sequence of the active sector, 0 before the first sector is opened
+		uint32_t remap[GAMEPAD_DIGITAL_INPUT_COUNT];
+		bool remapFound {false};
+		bool remapDirty {false};      // Staged and not yet being written
+
+		StorageSaveStep saveStep {STORAGE_SAVE_IDLE};
+		uint8_t saveRecord[GAMEPAD_STORAGE_SLOT_SIZE];
+		uint16_t saveSector {0};      // Sector being checked, erased or opened
+		uint32_t saveOffset {0};      // Progress through the sector or slot
+		uint8_t savePart {0};         // Remap part being written, GAMEPAD_STORAGE_REMAP_PARTS for the options
+		uint8_t saveLast {0};         // The last part of this save
+};
+
+/**
+ * @brief Encode options as a record slot.
+ */
+void encodeGamepadOptionsRecord(uint8_t *out, const GamepadOptions &options);
+
+/**
+ * @brief Decode a record slot, checking its CRC, version and values.
+ *
+ * @return bool False if the slot does not hold valid options, in which case `options` is unchanged
+ */
+bool decodeGamepadOptionsRecord(const uint8_t *data, GamepadOptions &options);
+
+/**
+ * @brief Encode part of a remap as a record slot.
+ */
+void encodeGamepadRemapRecord(uint8_t *out, uint8_t part, const uint32_t *map);
+
+/**
+ * @brief Decode a remap record slot into its part of `map`, checking its CRC, version and part.
+ *
+ * @return bool False if the slot does not hold part of a remap, in which case `map` is unchanged
+ */
+bool decodeGamepadRemapRecord(const uint8_t *data, uint8_t &part, uint32_t *map);
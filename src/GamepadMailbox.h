@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "GamepadAtomics.h"
+#include "GamepadState.h"
+
+/**
+ * @brief Lock-free single-producer/single-consumer handoff of the latest value.
+ *
+ * Lets one core scan inputs as fast as it can while another core reports them:
+ *
+ *     // Core 0: scanner instance
+ *     scanner.read();
+ *     scanner.debounce();
+ *     mailbox.publish(scanner.state);
+ *
+ *     // Core 1: reporter instance
+ *     if (mailbox.receive(reporter.state))
+ *     {
+ *         reporter.hotkey();
+ *         reporter.process();
+ *         sendReport(reporter.getReport(), size);
+ *     }
+ *
+ * Use separate gamepad instances on each side so no state is shared. Run `hotkey()` and `process()` on one
+ * instance only, since they keep state between calls.
+ *
+ * This is Simpson's four-slot mechanism. The writer never waits and never overwrites the slot being read. The reader
+ * never waits and always gets the most recently completed value, never a torn one. Intermediate values are
+ * dropped when the producer is faster, which is what a report loop wants. Only byte-sized control variables are
+ * shared, so it works on cores without atomic read-modify-write instructions.
+ */
+template <typename T = GamepadState>
+class GamepadMailbox
+{
+	public:
+		/**
+		 * @brief Publish a new value. Producer side only.
+		 */
+		void publish(const T &value)
+		{
+			uint8_t pair = !gamepadAtomicLoad(&reading);
+			uint8_t index = !slot[pair];
+			Slot &target = slots[pair][index];
+			target.value = value;
+			target.sequence = ++published;
+			gamepadAtomicStore(&slot[pair], index);
+			gamepadAtomicStore(&latest, pair);
+		}
+
+		/**
+		 * @brief Copy the latest value. Consumer side only.
+		 *
+		 * @return bool True when the value is newer than the previous call returned
+		 */
+		bool receive(T &value)
+		{
+			uint8_t pair = gamepadAtomicLoad(&latest);
+			gamepadAtomicStore(&reading, pair);
+			uint8_t index = gamepadAtomicLoad(&slot[pair]);
+			const Slot &source = slots[pair][index];
+			value = source.value;
+
+			bool fresh = (source.sequence != received);
+			received = source.sequence;
+			return fresh;
+		}
+
+		/**
+		 * @brief The number of values published, as seen by the producer.
+		 */
+		uint32_t publishedCount() const { return published; }
+
+		/**
+		 * @brief The sequence number of the last value received, as seen by the consumer. Values are numbered from 1.
+		 */
+		uint32_t receivedSequence() const { return received; }
+
+	protected:
+		struct Slot
+		{
+			T value;
+			uint32_t sequence {0};
+		};
+
+		Slot slots[2][2];
+		uint8_t slot[2] {0, 0};  // Written by the producer: most recent slot of each pair
+		uint8_t latest {0};      // Written by the producer: most recent pair
+		uint8_t reading {0};     // Written by the consumer: pair being read
+		uint32_t published {0};  // Producer only
+		uint32_t received {0};   // Consumer only
+};
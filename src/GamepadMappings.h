@@ -0,0 +1,209 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "GamepadEnums.h"
+#include "GamepadState.h"
+#include "descriptors/HIDDescriptors.h"
+#include "descriptors/SwitchDescriptors.h"
+#include "descriptors/XInputDescriptors.h"
+
+/*
+	Table-driven report conversion.
+
+	Each output report layout is described by one GamepadReportMapping row: the output mask for every MPG button
+	(in GAMEPAD_MASK_* bit order) and for each D-pad direction. From that row the compiler generates lookup tables
+	that map each 4-bit slice of `GamepadState.buttons` and the D-pad nibble straight to output bits, so a
+	conversion is five table loads OR'd together instead of a branch per button. Adding a report layout only needs
+	a new mapping row and one MPG_REPORT_TABLE line.
+
+	Tables are placed in flash on AVR.
+*/
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define MPG_TABLE_ATTR PROGMEM
+#define MPG_TABLE_READ8(addr) pgm_read_byte(addr)
+#define MPG_TABLE_READ16(addr) pgm_read_word(addr)
+#else
+#define MPG_TABLE_ATTR
+#define MPG_TABLE_READ8(addr) (*(addr))
+#define MPG_TABLE_READ16(addr) (*(addr))
+#endif
+
+// XInput packs its buttons into two bytes, mapped here as `buttons1 | (buttons2 << 8)`
+#define XINPUT_BUTTONS1(mask) (mask)
+#define XINPUT_BUTTONS2(mask) ((mask) << 8)
+
+struct GamepadReportMapping
+{
+	uint16_t buttons[GAMEPAD_BUTTON_COUNT]; // B1, B2, B3, B4, L1, R1, L2, R2, S1, S2, L3, R3, A1, A2
+	uint16_t dpad[4];                       // Up, Down, Left, Right when the D-pad is reported as buttons
+};
+
+/*
+	The rows below implement the mapping table documented in GamepadState.h. XInput reports L2/R2 as analog
+	triggers and has no A2, so those entries are left empty.
+*/
+
+static constexpr GamepadReportMapping xinputReportMapping =
+{
+	{
+		XINPUT_BUTTONS2(XBOX_MASK_A),
+		XINPUT_BUTTONS2(XBOX_MASK_B),
+		XINPUT_BUTTONS2(XBOX_MASK_X),
+		XINPUT_BUTTONS2(XBOX_MASK_Y),
+		XINPUT_BUTTONS2(XBOX_MASK_LB),
+		XINPUT_BUTTONS2(XBOX_MASK_RB),
+		0,
+		0,
+		XINPUT_BUTTONS1(XBOX_MASK_BACK),
+		XINPUT_BUTTONS1(XBOX_MASK_START),
+		XINPUT_BUTTONS1(XBOX_MASK_LS),
+		XINPUT_BUTTONS1(XBOX_MASK_RS),
+		XINPUT_BUTTONS2(XBOX_MASK_HOME),
+		0,
+	},
+	{
+		XINPUT_BUTTONS1(XBOX_MASK_UP),
+		XINPUT_BUTTONS1(XBOX_MASK_DOWN),
+		XINPUT_BUTTONS1(XBOX_MASK_LEFT),
+		XINPUT_BUTTONS1(XBOX_MASK_RIGHT),
+	},
+};
+
+static constexpr GamepadReportMapping switchReportMapping =
+{
+	{
+		SWITCH_MASK_B,
+		SWITCH_MASK_A,
+		SWITCH_MASK_Y,
+		SWITCH_MASK_X,
+		SWITCH_MASK_L,
+		SWITCH_MASK_R,
+		SWITCH_MASK_ZL,
+		SWITCH_MASK_ZR,
+		SWITCH_MASK_MINUS,
+		SWITCH_MASK_PLUS,
+		SWITCH_MASK_L3,
+		SWITCH_MASK_R3,
+		SWITCH_MASK_HOME,
+		SWITCH_MASK_CAPTURE,
+	},
+	{ 0, 0, 0, 0 },
+};
+
+static constexpr GamepadReportMapping hidReportMapping =
+{
+	{
+		HID_MASK_CROSS,
+		HID_MASK_CIRCLE,
+		HID_MASK_SQUARE,
+		HID_MASK_TRIANGLE,
+		HID_MASK_L1,
+		HID_MASK_R1,
+		HID_MASK_L2,
+		HID_MASK_R2,
+		HID_MASK_SELECT,
+		HID_MASK_START,
+		HID_MASK_L3,
+		HID_MASK_R3,
+		HID_MASK_PS,
+		HID_MASK_TP,
+	},
+	{ 0, 0, 0, 0 },
+};
+
+// Map one 4-bit slice of GamepadState.buttons, starting at button index `first`, to output bits
+constexpr uint16_t mapButtonNibble(const GamepadReportMapping &mapping, uint8_t first, uint8_t value, uint8_t bit = 0)
+{
+	return (bit == 4) ? 0 : (
+		((((value >> bit) & 1) && (first + bit) < GAMEPAD_BUTTON_COUNT) ? mapping.buttons[first + bit] : 0)
+		| mapButtonNibble(mapping, first, value, bit + 1)
+	);
+}
+
+// Map a D-pad nibble to output bits
+constexpr uint16_t mapDpadNibble(const GamepadReportMapping &mapping, uint8_t value, uint8_t bit = 0)
+{
+	return (bit == 4) ? 0 : (
+		(((value >> bit) & 1) ? mapping.dpad[bit] : 0)
+		| mapDpadNibble(mapping, value, bit + 1)
+	);
+}
+
+// Map a D-pad nibble to a hat switch value. HID and Switch share the same hat encoding.
+constexpr uint8_t mapDpadHat(uint8_t dpad)
+{
+	return
+		(dpad == (GAMEPAD_MASK_UP))                        ? HID_HAT_UP        :
+		(dpad == (GAMEPAD_MASK_UP | GAMEPAD_MASK_RIGHT))   ? HID_HAT_UPRIGHT   :
+		(dpad == (GAMEPAD_MASK_RIGHT))                     ? HID_HAT_RIGHT     :
+		(dpad == (GAMEPAD_MASK_DOWN | GAMEPAD_MASK_RIGHT)) ? HID_HAT_DOWNRIGHT :
+		(dpad == (GAMEPAD_MASK_DOWN))                      ? HID_HAT_DOWN      :
+		(dpad == (GAMEPAD_MASK_DOWN | GAMEPAD_MASK_LEFT))  ? HID_HAT_DOWNLEFT  :
+		(dpad == (GAMEPAD_MASK_LEFT))                      ? HID_HAT_LEFT      :
+		(dpad == (GAMEPAD_MASK_UP | GAMEPAD_MASK_LEFT))    ? HID_HAT_UPLEFT    :
+		                                                     HID_HAT_NOTHING
+	;
+}
+
+#define MPG_NIBBLE_TABLE(fn, ...) { \
+	fn(__VA_ARGS__,  0), fn(__VA_ARGS__,  1), fn(__VA_ARGS__,  2), fn(__VA_ARGS__,  3), \
+	fn(__VA_ARGS__,  4), fn(__VA_ARGS__,  5), fn(__VA_ARGS__,  6), fn(__VA_ARGS__,  7), \
+	fn(__VA_ARGS__,  8), fn(__VA_ARGS__,  9), fn(__VA_ARGS__, 10), fn(__VA_ARGS__, 11), \
+	fn(__VA_ARGS__, 12), fn(__VA_ARGS__, 13), fn(__VA_ARGS__, 14), fn(__VA_ARGS__, 15), \
+}
+
+#define MPG_HAT_TABLE { \
+	mapDpadHat( 0), mapDpadHat( 1), mapDpadHat( 2), mapDpadHat( 3), \
+	mapDpadHat( 4), mapDpadHat( 5), mapDpadHat( 6), mapDpadHat( 7), \
+	mapDpadHat( 8), mapDpadHat( 9), mapDpadHat(10), mapDpadHat(11), \
+	mapDpadHat(12), mapDpadHat(13), mapDpadHat(14), mapDpadHat(15), \
+}
+
+struct GamepadReportTable
+{
+	uint16_t buttons[4][16]; // Indexed by [nibble][value], nibble 0 is B1-B4
+	uint16_t dpad[16];
+};
+
+#define MPG_REPORT_TABLE(mapping) { \
+	{ \
+		MPG_NIBBLE_TABLE(mapButtonNibble, mapping,  0), \
+		MPG_NIBBLE_TABLE(mapButtonNibble, mapping,  4), \
+		MPG_NIBBLE_TABLE(mapButtonNibble, mapping,  8), \
+		MPG_NIBBLE_TABLE(mapButtonNibble, mapping, 12), \
+	}, \
+	MPG_NIBBLE_TABLE(mapDpadNibble, mapping), \
+}
+
+static const GamepadReportTable xinputReportTable MPG_TABLE_ATTR = MPG_REPORT_TABLE(xinputReportMapping);
+static const GamepadReportTable switchReportTable MPG_TABLE_ATTR = MPG_REPORT_TABLE(switchReportMapping);
+static const GamepadReportTable hidReportTable MPG_TABLE_ATTR = MPG_REPORT_TABLE(hidReportMapping);
+static const uint8_t hatReportTable[16] MPG_TABLE_ATTR = MPG_HAT_TABLE;
+
+/**
+ * @brief Convert buttons and D-pad to the output button bits of a report layout.
+ */
+inline uint16_t __attribute__((always_inline)) convertGamepadButtons(const GamepadReportTable &table, uint16_t buttons, uint8_t dpad)
+{
+	return MPG_TABLE_READ16(&table.buttons[0][(buttons >>  0) & 0xF])
+	     | MPG_TABLE_READ16(&table.buttons[1][(buttons >>  4) & 0xF])
+	     | MPG_TABLE_READ16(&table.buttons[2][(buttons >>  8) & 0xF])
+	     | MPG_TABLE_READ16(&table.buttons[3][(buttons >> 12) & 0x3])
+	     | MPG_TABLE_READ16(&table.dpad[dpad & GAMEPAD_MASK_DPAD]);
+}
+
+/**
+ * @brief Convert a D-pad value to a HID/Switch hat switch value.
+ */
+inline uint8_t __attribute__((always_inline)) convertGamepadHat(uint8_t dpad)
+{
+	return MPG_TABLE_READ8(&hatReportTable[dpad & GAMEPAD_MASK_DPAD]);
+}
@@ -13,7 +13,16 @@ struct GamepadOptions
 	InputMode inputMode {InputMode::INPUT_MODE_XINPUT}; 
 	DpadMode dpadMode {DpadMode::DPAD_MODE_DIGITAL};
 	SOCDMode socdMode {SOCDMode::SOCD_MODE_NEUTRAL};
-	uint32_t checksum;
-	bool invertXAxis;
-	bool invertYAxis;
+	uint32_t checksum {0}; // CRC-32 of the stored record, filled in by GamepadLogStorage
+	bool invertXAxis {false};
+	bool invertYAxis {false};
 };
+
+/**
+ * @brief Compare the option values, ignoring the checksum.
+ */
+inline bool equalGamepadOptions(const GamepadOptions &a, const GamepadOptions &b)
+{
+	return a.inputMode == b.inputMode && a.dpadMode == b.dpadMode && a.socdMode == b.socdMode
+		&& a.invertXAxis == b.invertXAxis && a.invertYAxis == b.invertYAxis;
+}
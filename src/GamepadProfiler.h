@@ -0,0 +1,333 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "GamepadConfig.h"
+
+/*
+	Per-stage latency profiling.
+
+	With GAMEPAD_PROFILE set to 1, MPG times each pipeline stage with a free-running cycle counter and records the
+	result into a GamepadProfiler: a log2 histogram per stage (for min/p50/p99/max) plus a small ring of the most
+	recent samples. Call `gamepad.profiler.begin()` in setup, after the core has configured its timers, and dump the
+	results on demand with `gamepad.profiler.dump(print)`. With GAMEPAD_PROFILE at 0 (the default) none of this is
+	compiled into MPG.
+
+	The read stage is only timed when frames run through `update()`, since `read()` is called by the board.
+
+	Cycle counters, in order of preference:
+	- GAMEPAD_PROFILE_CYCLES(), if defined, e.g. `#define GAMEPAD_PROFILE_CYCLES() time_us_32()` on RP2040
+	- DWT CYCCNT on Cortex-M3/M4/M7/M33
+	- Timer1 on AVR, which is reconfigured as a free-running counter with no prescaler (stages up to ~4ms at 16MHz)
+	- rdtsc on x86 hosts, clock_gettime() nanoseconds on other POSIX hosts
+*/
+
+#if defined(GAMEPAD_PROFILE_CYCLES)
+
+inline void gamepadCyclesInit() { }
+inline uint32_t gamepadCycles() { return GAMEPAD_PROFILE_CYCLES(); }
+inline uint32_t gamepadCyclesElapsed(uint32_t start, uint32_t end) { return end - start; }
+
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+
+#define GAMEPAD_DWT_CTRL   (*reinterpret_cast<volatile uint32_t *>(0xE0001000))
+#define GAMEPAD_DWT_CYCCNT (*reinterpret_cast<volatile uint32_t *>(0xE0001004))
+#define GAMEPAD_DEMCR      (*reinterpret_cast<volatile uint32_t *>(0xE000EDFC))
+
+inline void gamepadCyclesInit()
+{
+	GAMEPAD_DEMCR |= (1UL << 24); // TRCENA
+	GAMEPAD_DWT_CYCCNT = 0;
+	GAMEPAD_DWT_CTRL |= 1UL;      // CYCCNTENA
+}
+
+inline uint32_t __attribute__((always_inline)) gamepadCycles() { return GAMEPAD_DWT_CYCCNT; }
+inline uint32_t __attribute__((always_inline)) gamepadCyclesElapsed(uint32_t start, uint32_t end) { return end - start; }
+
+#elif defined(__AVR__)
+
+#include <avr/io.h>
+
+inline void gamepadCyclesInit()
+{
+	TCCR1A = 0;
+	TCCR1B = (1 << CS10);
+}
+
+inline uint32_t __attribute__((always_inline)) gamepadCycles() { return TCNT1; }
+
+// Timer1 is 16 bits wide
+inline uint32_t __attribute__((always_inline)) gamepadCyclesElapsed(uint32_t start, uint32_t end)
+{
+	return static_cast<uint16_t>(end - start);
+}
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+#include <x86intrin.h>
+
+inline void gamepadCyclesInit() { }
+inline uint32_t __attribute__((always_inline)) gamepadCycles() { return static_cast<uint32_t>(__rdtsc()); }
+inline uint32_t __attribute__((always_inline)) gamepadCyclesElapsed(uint32_t start, uint32_t end) { return end - start; }
+
+#elif defined(__unix__) || defined(__APPLE__)
+
+#include <time.h>
+
+inline void gamepadCyclesInit() { }
+
+inline uint32_t gamepadCycles()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<uint32_t>(now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+
+inline uint32_t gamepadCyclesElapsed(uint32_t start, uint32_t end) { return end - start; }
+
+#else
+
+#error "No cycle counter for this platform, define GAMEPAD_PROFILE_CYCLES() to return a free-running counter"
+
+#endif
+
+typedef enum
+{
+	GAMEPAD_STAGE_READ,
+	GAMEPAD_STAGE_DEBOUNCE,
+	GAMEPAD_STAGE_TURBO,
+	GAMEPAD_STAGE_HOTKEY,
+	GAMEPAD_STAGE_PROCESS,
+	GAMEPAD_STAGE_REPORT,
+	GAMEPAD_STAGE_COUNT,
+} GamepadStage;
+
+inline const char *getGamepadStageName(GamepadStage stage)
+{
+	switch (stage)
+	{
+		case GAMEPAD_STAGE_READ:     return "read";
+		case GAMEPAD_STAGE_DEBOUNCE: return "debounce";
+		case GAMEPAD_STAGE_TURBO:    return "turbo";
+		case GAMEPAD_STAGE_HOTKEY:   return "hotkey";
+		case GAMEPAD_STAGE_PROCESS:  return "process";
+		case GAMEPAD_STAGE_REPORT:   return "report";
+		default:                     return "?";
+	}
+}
+
+#define GAMEPAD_PROFILE_SAMPLE_BITS 29
+#define GAMEPAD_PROFILE_SAMPLE_MAX  ((1UL << GAMEPAD_PROFILE_SAMPLE_BITS) - 1)
+
+struct GamepadProfileSample
+{
+	uint8_t stage;
+	uint32_t cycles;
+};
+
+struct GamepadProfileStats
+{
+	uint32_t count;
+	uint32_t min;
+	uint32_t p50;   // Upper bound of the histogram bucket holding the median
+	uint32_t p99;   // Upper bound of the histogram bucket holding the 99th percentile
+	uint32_t max;
+};
+
+/**
+ * @brief Fixed-size latency recorder for the pipeline stages.
+ *
+ * Bucket 0 counts zero-cycle samples and bucket `b` counts samples in [2^(b-1), 2^b), so percentiles are reported
+ * as the upper bound of their bucket (at most 2x high) and clamped to the exact min and max. When a bucket fills up,
+ * every bucket of its stage is halved, so percentiles keep tracking the recent mix while count, min and max stay exact.
+ */
+class GamepadProfiler
+{
+	public:
+		typedef void (*PrintFunc)(const char *line);
+
+		GamepadProfiler() { reset(); }
+
+		/**
+		 * @brief Start the cycle counter and clear all samples.
+		 */
+		void begin()
+		{
+			gamepadCyclesInit();
+			reset();
+		}
+
+		void reset()
+		{
+			for (uint8_t stage = 0; stage < GAMEPAD_STAGE_COUNT; stage++)
+			{
+				for (uint8_t bucket = 0; bucket < GAMEPAD_PROFILE_BUCKETS; bucket++)
+					histograms[stage][bucket] = 0;
+
+				counts[stage] = 0;
+				mins[stage] = UINT32_MAX;
+				maxes[stage] = 0;
+			}
+
+			ringIndex = 0;
+			for (uint8_t i = 0; i < GAMEPAD_PROFILE_RING_SIZE; i++)
+				ring[i] = packSample(GAMEPAD_STAGE_COUNT, 0);
+		}
+
+		/**
+		 * @brief Record one stage duration.
+		 */
+		inline void record(GamepadStage stage, uint32_t cycles)
+		{
+			uint8_t bucket = getBucket(cycles);
+			if (histograms[stage][bucket] == UINT16_MAX)
+			{
+				// Halve the whole stage so the buckets keep their proportions on long runs
+				for (uint8_t i = 0; i < GAMEPAD_PROFILE_BUCKETS; i++)
+					histograms[stage][i] >>= 1;
+			}
+
+			histograms[stage][bucket]++;
+
+			counts[stage]++;
+			if (cycles < mins[stage]) mins[stage] = cycles;
+			if (cycles > maxes[stage]) maxes[stage] = cycles;
+
+			ring[ringIndex] = packSample(stage, cycles);
+			ringIndex = (ringIndex + 1) & (GAMEPAD_PROFILE_RING_SIZE - 1);
+		}
+
+		/**
+		 * @brief Get the histogram bucket for a duration.
+		 */
+		static inline uint8_t getBucket(uint32_t cycles)
+		{
+			uint8_t bucket = 0;
+			while (cycles != 0 && bucket < GAMEPAD_PROFILE_BUCKETS - 1)
+			{
+				cycles >>= 1;
+				bucket++;
+			}
+
+			return bucket;
+		}
+
+		/**
+		 * @brief Summarize a stage.
+		 */
+		GamepadProfileStats getStats(GamepadStage stage) const
+		{
+			GamepadProfileStats stats { counts[stage], 0, 0, 0, 0 };
+			if (stats.count == 0)
+				return stats;
+
+			stats.min = mins[stage];
+			stats.max = maxes[stage];
+			stats.p50 = getPercentile(stage, 50);
+			stats.p99 = getPercentile(stage, 99);
+			return stats;
+		}
+
+		/**
+		 * @brief Get the `offset`th most recent sample, 0 being the latest. Unused entries have stage GAMEPAD_STAGE_COUNT.
+		 * Durations above GAMEPAD_PROFILE_SAMPLE_MAX are saturated.
+		 */
+		GamepadProfileSample getRecent(uint8_t offset) const
+		{
+			uint32_t packed = ring[(ringIndex - 1 - offset) & (GAMEPAD_PROFILE_RING_SIZE - 1)];
+			return { static_cast<uint8_t>(packed >> GAMEPAD_PROFILE_SAMPLE_BITS), static_cast<uint32_t>(packed & GAMEPAD_PROFILE_SAMPLE_MAX) };
+		}
+
+		/**
+		 * @brief Print a summary line per stage, then the recent samples, oldest first.
+		 */
+		void dump(PrintFunc print) const
+		{
+			char line[80];
+			print("stage count min p50 p99 max");
+			for (uint8_t stage = 0; stage < GAMEPAD_STAGE_COUNT; stage++)
+			{
+				GamepadProfileStats stats = getStats(static_cast<GamepadStage>(stage));
+				snprintf(line, sizeof(line), "%s %lu %lu %lu %lu %lu", getGamepadStageName(static_cast<GamepadStage>(stage)),
+					(unsigned long)stats.count, (unsigned long)stats.min, (unsigned long)stats.p50,
+					(unsigned long)stats.p99, (unsigned long)stats.max);
+				print(line);
+			}
+
+			print("recent");
+			for (int8_t offset = GAMEPAD_PROFILE_RING_SIZE - 1; offset >= 0; offset--)
+			{
+				GamepadProfileSample sample = getRecent(offset);
+				if (sample.stage >= GAMEPAD_STAGE_COUNT)
+					continue;
+
+				snprintf(line, sizeof(line), "%s %lu", getGamepadStageName(static_cast<GamepadStage>(sample.stage)),
+					(unsigned long)sample.cycles);
+				print(line);
+			}
+		}
+
+		uint16_t histograms[GAMEPAD_STAGE_COUNT][GAMEPAD_PROFILE_BUCKETS];
+
+	protected:
+		// Ring entries hold the stage in the top 3 bits and the duration, saturated, below it
+		static inline uint32_t packSample(uint8_t stage, uint32_t cycles)
+		{
+			if (cycles > GAMEPAD_PROFILE_SAMPLE_MAX)
+				cycles = GAMEPAD_PROFILE_SAMPLE_MAX;
+
+			return (static_cast<uint32_t>(stage) << GAMEPAD_PROFILE_SAMPLE_BITS) | cycles;
+		}
+
+		uint32_t getPercentile(GamepadStage stage, uint8_t percent) const
+		{
+			uint32_t total = 0;
+			for (uint8_t bucket = 0; bucket < GAMEPAD_PROFILE_BUCKETS; bucket++)
+				total += histograms[stage][bucket];
+
+			uint32_t target = (total * percent + 99) / 100;
+			uint32_t seen = 0;
+			for (uint8_t bucket = 0; bucket < GAMEPAD_PROFILE_BUCKETS; bucket++)
+			{
+				seen += histograms[stage][bucket];
+				if (seen >= target)
+				{
+					uint32_t upper = (bucket == 0) ? 0 : (bucket >= 32 ? UINT32_MAX : ((1UL << bucket) - 1));
+					if (upper < mins[stage]) upper = mins[stage];
+					if (upper > maxes[stage] || bucket == GAMEPAD_PROFILE_BUCKETS - 1) upper = maxes[stage];
+					return upper;
+				}
+			}
+
+			return maxes[stage];
+		}
+
+		uint32_t counts[GAMEPAD_STAGE_COUNT];
+		uint32_t mins[GAMEPAD_STAGE_COUNT];
+		uint32_t maxes[GAMEPAD_STAGE_COUNT];
+		uint32_t ring[GAMEPAD_PROFILE_RING_SIZE];
+		uint8_t ringIndex;
+};
+
+/**
+ * @brief Records the time from construction to destruction as one stage sample.
+ */
+class GamepadProfileScope
+{
+	public:
+		inline GamepadProfileScope(GamepadProfiler &profiler, GamepadStage stage)
+			: profiler(profiler), stage(stage), start(gamepadCycles()) { }
+
+		inline ~GamepadProfileScope() { profiler.record(stage, gamepadCyclesElapsed(start, gamepadCycles())); }
+
+	protected:
+		GamepadProfiler &profiler;
+		GamepadStage stage;
+		uint32_t start;
+};
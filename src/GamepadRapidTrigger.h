@@ -0,0 +1,149 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "GamepadState.h"
+
+/*
+	Analog (Hall-effect) keys.
+
+	Each key is a travel reading instead of a switch, from 0 at rest to GAMEPAD_TRAVEL_FULL bottomed out. The board
+	writes the readings to `travel` in its `read()`, and the stage turns them into `state.buttons` and `state.dpad`:
+
+	    void read()
+	    {
+	        for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+	            rapidTrigger.travel[key] = readTravel(key); // Calibrated to 0..GAMEPAD_TRAVEL_FULL
+	    }
+
+	With rapid trigger, a key has no fixed actuation point. It releases as soon as it moves back up by
+	`releaseSensitivity` from the deepest point of the press, and presses again once it moves down by
+	`pressSensitivity` from the highest point since, wherever that is in its travel. Short of `actuation` the key is
+	always released, and from there it presses at `actuation`. Without rapid trigger, a key presses at `actuation`
+	and releases `releaseSensitivity` above it.
+
+	Keys are indexed by button bit (B1 is 0, A2 is 13), then the D-pad (GAMEPAD_KEY_UP to GAMEPAD_KEY_RIGHT). Travel
+	readings are not bouncing contacts, so the keys the stage drives skip debouncing.
+*/
+
+#define GAMEPAD_TRAVEL_FULL 0xFFFF
+
+#define GAMEPAD_KEY_UP    (GAMEPAD_BUTTON_COUNT + 0)
+#define GAMEPAD_KEY_DOWN  (GAMEPAD_BUTTON_COUNT + 1)
+#define GAMEPAD_KEY_LEFT  (GAMEPAD_BUTTON_COUNT + 2)
+#define GAMEPAD_KEY_RIGHT (GAMEPAD_BUTTON_COUNT + 3)
+
+#define GAMEPAD_KEY_ALL ((1UL << GAMEPAD_DIGITAL_INPUT_COUNT) - 1)
+
+struct GamepadKeyConfig
+{
+	uint16_t actuation {6554};          // Travel a key must pass to press at all, 10% by default
+	uint16_t pressSensitivity {3277};   // Travel down from the highest point that presses again, 5% by default
+	uint16_t releaseSensitivity {3277}; // Travel up from the deepest point that releases, 5% by default
+	bool rapid {true};                  // False for a fixed actuation point, with releaseSensitivity as hysteresis
+};
+
+class GamepadRapidTrigger
+{
+	public:
+		/**
+		 * @param keys Bit N set for each key N with a travel sensor. Other inputs are left to the board and debouncer.
+		 */
+		GamepadRapidTrigger(uint32_t keys = GAMEPAD_KEY_ALL) : keys(keys & GAMEPAD_KEY_ALL) { }
+
+		/**
+		 * @brief Set the actuation and sensitivity of one key, or of every key when `key` is out of range.
+		 */
+		void configure(uint8_t key, const GamepadKeyConfig &config)
+		{
+			for (uint8_t i = 0; i < GAMEPAD_DIGITAL_INPUT_COUNT; i++)
+			{
+				if (i == key || key >= GAMEPAD_DIGITAL_INPUT_COUNT)
+				{
+					configs[i] = config;
+					extremes[i] = 0;
+				}
+			}
+
+			pressed = 0;
+		}
+
+		inline const GamepadKeyConfig &getConfig(uint8_t key) const { return configs[key]; }
+
+		/**
+		 * @brief The keys with travel sensors, as passed to the constructor.
+		 */
+		inline uint32_t getKeys() const { return keys; }
+
+		/**
+		 * @brief The keys currently pressed, bit N for key N.
+		 */
+		inline uint32_t getPressed() const { return pressed; }
+
+		/**
+		 * @brief Update every key from `travel` and write the pressed keys to the state. Inputs without a travel
+		 * sensor are left as they are.
+		 */
+		inline void read(GamepadState &state)
+		{
+			uint32_t now = 0;
+			for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+			{
+				if (keys & (1UL << key))
+					now |= update(key, (pressed >> key) & 1) << key;
+			}
+			pressed = now;
+
+			uint16_t buttonKeys = keys & ((1U << GAMEPAD_BUTTON_COUNT) - 1);
+			uint8_t dpadKeys = (keys >> GAMEPAD_BUTTON_COUNT) & GAMEPAD_MASK_DPAD;
+			state.buttons = (state.buttons & ~buttonKeys) | (pressed & buttonKeys);
+			state.dpad = (state.dpad & ~dpadKeys) | ((pressed >> GAMEPAD_BUTTON_COUNT) & dpadKeys);
+		}
+
+		/**
+		 * @brief The latest reading of each key, written by the board before `read()`.
+		 */
+		uint16_t travel[GAMEPAD_DIGITAL_INPUT_COUNT] { };
+
+	protected:
+		// Written with masks rather than branches, since keys under a player's fingers go every which way
+		inline uint32_t update(uint8_t key, uint32_t wasPressed)
+		{
+			const GamepadKeyConfig &config = configs[key];
+			const uint32_t current = travel[key];
+			const uint32_t extreme = extremes[key];
+			const uint32_t actuated = current >= config.actuation;
+
+			uint32_t down;
+			if (config.rapid)
+			{
+				// `extreme` is the deepest point while pressed and the highest point while released. Short of
+				// actuation it is the top, so coming from there the key presses at actuation.
+				uint32_t held = (current + config.releaseSensitivity) > extreme;
+				uint32_t pressedAgain = current >= extreme + config.pressSensitivity;
+				down = actuated & ((wasPressed & held) | (~wasPressed & pressedAgain));
+
+				uint32_t deeper = -static_cast<uint32_t>(current > extreme);
+				uint32_t deepest = (current & deeper) | (extreme & ~deeper);
+				uint32_t highest = (current & ~deeper) | (extreme & deeper);
+				uint32_t keep = -down;
+				extremes[key] = static_cast<uint16_t>(((deepest & keep) | (highest & ~keep)) & -actuated);
+			}
+			else
+			{
+				down = actuated | (wasPressed & ((current + config.releaseSensitivity) >= config.actuation));
+			}
+
+			return down;
+		}
+
+		const uint32_t keys;
+		uint32_t pressed {0};
+		uint16_t extremes[GAMEPAD_DIGITAL_INPUT_COUNT] { };
+		GamepadKeyConfig configs[GAMEPAD_DIGITAL_INPUT_COUNT];
+};
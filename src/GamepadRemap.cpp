@@ -0,0 +1,85 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#include "GamepadRemap.h"
+
+void GamepadRemap::reset()
+{
+	for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+		map[key] = 1UL << key;
+
+	compile();
+}
+
+void GamepadRemap::setKey(uint8_t key, uint32_t keys)
+{
+	if (key >= GAMEPAD_DIGITAL_INPUT_COUNT)
+		return;
+
+	map[key] = keys & GAMEPAD_KEY_ALL;
+	compile();
+}
+
+void GamepadRemap::setButton(uint16_t button, uint16_t buttons, uint8_t dpad)
+{
+	for (uint8_t key = 0; key < GAMEPAD_BUTTON_COUNT; key++)
+	{
+		if (button & (1U << key))
+			map[key] = gamepadKeys(buttons, dpad);
+	}
+
+	compile();
+}
+
+void GamepadRemap::setDpad(uint8_t direction, uint16_t buttons, uint8_t dpad)
+{
+	for (uint8_t key = GAMEPAD_KEY_UP; key <= GAMEPAD_KEY_RIGHT; key++)
+	{
+		if (direction & (1U << (key - GAMEPAD_KEY_UP)))
+			map[key] = gamepadKeys(buttons, dpad);
+	}
+
+	compile();
+}
+
+void GamepadRemap::setMap(const uint32_t *keys)
+{
+	for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+		map[key] = keys[key] & GAMEPAD_KEY_ALL;
+
+	compile();
+}
+
+bool GamepadRemap::isIdentity() const
+{
+	for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+	{
+		if (map[key] != (1UL << key))
+			return false;
+	}
+
+	return true;
+}
+
+void GamepadRemap::compile()
+{
+	for (uint8_t i = 0; i < TABLE_COUNT; i++)
+		compileTable(tables[i], i * GAMEPAD_REMAP_TABLE_BITS, GAMEPAD_REMAP_TABLE_BITS);
+
+	compileTable(rest, TABLE_COUNT * GAMEPAD_REMAP_TABLE_BITS, REST_BITS);
+	revision++;
+}
+
+// Each key doubles the table: the entries with its bit set are the ones without it, plus its logical keys
+void GamepadRemap::compileTable(uint32_t *table, uint8_t first, uint8_t bits)
+{
+	table[0] = 0;
+	for (uint8_t bit = 0; bit < bits; bit++)
+	{
+		uint16_t size = 1U << bit;
+		for (uint16_t entry = 0; entry < size; entry++)
+			table[size + entry] = table[entry] | map[first + bit];
+	}
+}
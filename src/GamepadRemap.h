@@ -0,0 +1,119 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "GamepadRapidTrigger.h"
+#include "GamepadState.h"
+
+/*
+	Button remapping.
+
+	The map sends each physical input to any set of logical inputs, so a board can swap buttons, press two with one,
+	turn a D-pad direction into a button or switch an input off, per game and without touching its `read()`:
+
+	    remap.setButton(GAMEPAD_MASK_B1, GAMEPAD_MASK_B2);              // B1 presses B2
+	    remap.setButton(GAMEPAD_MASK_B2, GAMEPAD_MASK_B1);              // and B2 presses B1
+	    remap.setButton(GAMEPAD_MASK_A2, GAMEPAD_MASK_L1 | GAMEPAD_MASK_R1);
+	    remap.setDpad(GAMEPAD_MASK_UP, GAMEPAD_MASK_B3);                // Up is B3, with no Up left
+	    gamepad.remap = &remap;
+
+	Inputs are keys indexed as in GamepadRapidTrigger.h: buttons by bit (B1 is 0, A2 is 13), then the D-pad
+	(GAMEPAD_KEY_UP to GAMEPAD_KEY_RIGHT). The map holds the logical keys of each physical key, and starts out as
+	the identity.
+
+	Every change compiles the map into tables, one per GAMEPAD_REMAP_TABLE_BITS of the physical keys, holding the
+	logical keys of each combination of them. Applying the map is then a table load per slice ORed together, the
+	same few loads whatever the map is. With 8 bits the tables take just over 2KB, and with 4 bits, the default on
+	AVR, under 300 bytes.
+*/
+
+#ifndef GAMEPAD_REMAP_TABLE_BITS
+#if defined(__AVR__)
+#define GAMEPAD_REMAP_TABLE_BITS 4
+#else
+#define GAMEPAD_REMAP_TABLE_BITS 8 // Physical keys looked up per table, 4 or 8
+#endif
+#endif
+
+#define GAMEPAD_KEY_BUTTONS ((1UL << GAMEPAD_BUTTON_COUNT) - 1)
+
+/**
+ * @brief Buttons and D-pad directions as keys.
+ */
+inline uint32_t gamepadKeys(uint16_t buttons, uint8_t dpad)
+{
+	return (buttons & GAMEPAD_KEY_BUTTONS) | (static_cast<uint32_t>(dpad & GAMEPAD_MASK_DPAD) << GAMEPAD_BUTTON_COUNT);
+}
+
+class GamepadRemap
+{
+	public:
+		GamepadRemap() { reset(); }
+
+		/**
+		 * @brief Go back to the identity map.
+		 */
+		void reset();
+
+		/**
+		 * @brief Set the logical keys of one physical key. Keys out of range are ignored.
+		 */
+		void setKey(uint8_t key, uint32_t keys);
+
+		/**
+		 * @brief Set the logical buttons and D-pad of each physical button in `button`.
+		 */
+		void setButton(uint16_t button, uint16_t buttons, uint8_t dpad = 0);
+
+		/**
+		 * @brief Set the logical buttons and D-pad of each physical D-pad direction in `direction`.
+		 */
+		void setDpad(uint8_t direction, uint16_t buttons, uint8_t dpad = 0);
+
+		/**
+		 * @brief Replace the whole map, GAMEPAD_DIGITAL_INPUT_COUNT logical key masks, compiling it once.
+		 */
+		void setMap(const uint32_t *map);
+
+		inline const uint32_t *getMap() const { return map; }
+		inline uint32_t getKey(uint8_t key) const { return (key < GAMEPAD_DIGITAL_INPUT_COUNT) ? map[key] : 0; }
+
+		bool isIdentity() const;
+
+		/**
+		 * @brief Incremented on every change, so storage can tell when the map needs saving.
+		 */
+		inline uint16_t getRevision() const { return revision; }
+
+		/**
+		 * @brief Replace the physical buttons and D-pad in the state with the logical ones.
+		 */
+		inline void update(GamepadState &state) const
+		{
+			uint32_t keys = gamepadKeys(state.buttons, state.dpad);
+			uint32_t mapped = rest[keys >> (TABLE_COUNT * GAMEPAD_REMAP_TABLE_BITS)];
+			for (uint8_t i = 0; i < TABLE_COUNT; i++)
+				mapped |= tables[i][(keys >> (i * GAMEPAD_REMAP_TABLE_BITS)) & (TABLE_SIZE - 1)];
+
+			state.buttons = mapped & GAMEPAD_KEY_BUTTONS;
+			state.dpad = (state.dpad & ~GAMEPAD_MASK_DPAD) | ((mapped >> GAMEPAD_BUTTON_COUNT) & GAMEPAD_MASK_DPAD);
+		}
+
+	protected:
+		static const uint8_t TABLE_COUNT = GAMEPAD_DIGITAL_INPUT_COUNT / GAMEPAD_REMAP_TABLE_BITS;
+		static const uint16_t TABLE_SIZE = 1U << GAMEPAD_REMAP_TABLE_BITS;
+		static const uint8_t REST_BITS = GAMEPAD_DIGITAL_INPUT_COUNT % GAMEPAD_REMAP_TABLE_BITS;
+
+		void compile();
+		void compileTable(uint32_t *table, uint8_t first, uint8_t bits);
+
+		uint32_t map[GAMEPAD_DIGITAL_INPUT_COUNT];
+		uint32_t tables[TABLE_COUNT][TABLE_SIZE];
+		uint32_t rest[1U << REST_BITS]; // The keys left over after the full tables
+		uint16_t revision {0};
+};
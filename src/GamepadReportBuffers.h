@@ -0,0 +1,97 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define GAMEPAD_REPORT_BUFFER_NONE 0xFF
+
+/**
+ * @brief A pair of report buffers owned by the USB driver, e.g. its endpoint or DMA buffers.
+ *
+ * MPG fills the back buffer and flips it to the front whenever the report changes, so the driver can hand the front
+ * buffer to the hardware without copying it. A buffer the driver marks as sending is never written until the driver
+ * calls `sent()`, e.g. from its transfer complete interrupt:
+ *
+ *     static uint16_t endpointBuffers[2][32];
+ *     GamepadReportBuffers buffers(endpointBuffers[0], endpointBuffers[1], sizeof(endpointBuffers[0]));
+ *     gamepad.setReportBuffers(&buffers);
+ *
+ *     gamepad.getReport(&changed);
+ *     if (changed)
+ *         startTransfer(buffers.send(), gamepad.getReportSize());
+ *
+ * Buffers must be 2-byte aligned and at least as large as the report for the input mode.
+ */
+class GamepadReportBuffers
+{
+	public:
+		GamepadReportBuffers(void *first, void *second, uint16_t size)
+			: size(size)
+		{
+			buffers[0] = static_cast<uint8_t *>(first);
+			buffers[1] = static_cast<uint8_t *>(second);
+			memset(buffers[0], 0, size);
+			memset(buffers[1], 0, size);
+		}
+
+		inline uint16_t getSize() const { return size; }
+
+		/**
+		 * @brief The newest report.
+		 */
+		inline void *getFront() const { return buffers[front]; }
+
+		/**
+		 * @brief Mark the front buffer as handed to the hardware.
+		 *
+		 * @return void* The front buffer
+		 */
+		inline void *send()
+		{
+			sending = front;
+			return buffers[front];
+		}
+
+		/**
+		 * @brief The hardware is done with the buffer from `send()`.
+		 */
+		inline void sent() { sending = GAMEPAD_REPORT_BUFFER_NONE; }
+
+		/**
+		 * @brief Pick the buffer to write the next report into: the back buffer, or the front one in place while the
+		 * hardware still has the back one, since the front has not been sent yet. A buffer last filled for another
+		 * report type is cleared first, so no bytes of the old report are left in fields the new one does not set.
+		 *
+		 * @param key The report type, as tracked by MPGCore
+		 * @return void* The buffer to fill, which becomes the front in `endFill()`
+		 */
+		inline void *beginFill(uint8_t key)
+		{
+			filling = front ^ 1;
+			if (filling == sending)
+				filling = front;
+
+			if (keys[filling] != key)
+			{
+				memset(buffers[filling], 0, size);
+				keys[filling] = key;
+			}
+
+			return buffers[filling];
+		}
+
+		inline void endFill() { front = filling; }
+
+	protected:
+		uint8_t *buffers[2];
+		uint16_t size;
+		uint8_t keys[2] {GAMEPAD_REPORT_BUFFER_NONE, GAMEPAD_REPORT_BUFFER_NONE};
+		uint8_t front {0};
+		uint8_t filling {0};
+		volatile uint8_t sending {GAMEPAD_REPORT_BUFFER_NONE};
+};
@@ -0,0 +1,160 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "GamepadEnums.h"
+#include "GamepadMappings.h"
+#include "GamepadState.h"
+
+/*
+	SOCD cleaning.
+
+	Each D-pad axis resolves both of its directions held at once by its own SOCDAxisPolicy. The SOCD modes pick a
+	policy for each axis, and SOCD_MODE_CUSTOM uses the ones set with `setCustom()`, e.g. up-priority vertically and
+	last-input horizontally:
+
+	    gamepad.socd.setCustom(SOCD_AXIS_UP_LEFT, SOCD_AXIS_LAST_INPUT);
+	    gamepad.options.socdMode = SOCD_MODE_CUSTOM;
+
+	An axis remembers the direction it last had on its own: none, the first (Up or Left) or the second (Down or
+	Right). A policy is a 16-entry table indexed by that and the axis's two raw bits, giving the clean bits and the
+	new memory, so cleaning the D-pad is two table loads with no branches. The tables are placed in flash on AVR.
+*/
+
+#define SOCD_N 0 // Neither direction
+#define SOCD_F 1 // The first direction, Up or Left
+#define SOCD_S 2 // The second direction, Down or Right
+#define SOCD_ENTRY(out, last) static_cast<uint8_t>(((last) << 2) | (out))
+
+// Rows by the direction last held alone (none, first, second, unused), columns by the raw bits (none, first,
+// second, both)
+static const uint8_t socdAxisTable[SOCD_AXIS_COUNT * 16] MPG_TABLE_ATTR =
+{
+	// SOCD_AXIS_NEUTRAL
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_N, SOCD_N),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_N, SOCD_N),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_N, SOCD_N),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_N, SOCD_N),
+
+	// SOCD_AXIS_LAST_INPUT, keeping the memory so the direction flips back when the newer one is released
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_N, SOCD_N),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_S, SOCD_F),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_F, SOCD_S),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_N, SOCD_N),
+
+	// SOCD_AXIS_FIRST_INPUT
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_N, SOCD_N),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_F, SOCD_F),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_S, SOCD_S),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_N, SOCD_N),
+
+	// SOCD_AXIS_UP_LEFT
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_F, SOCD_F),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_F, SOCD_F),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_F, SOCD_F),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_F, SOCD_F),
+
+	// SOCD_AXIS_DOWN_RIGHT
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_S, SOCD_S),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_S, SOCD_S),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_S, SOCD_S),
+	SOCD_ENTRY(SOCD_N, SOCD_N), SOCD_ENTRY(SOCD_F, SOCD_F), SOCD_ENTRY(SOCD_S, SOCD_S), SOCD_ENTRY(SOCD_S, SOCD_S),
+};
+
+// The vertical and horizontal policies of each mode. Modes past the last one, e.g. from corrupt options, are neutral.
+static const uint8_t socdModePolicies[8][2] =
+{
+	{ SOCD_AXIS_UP_LEFT, SOCD_AXIS_NEUTRAL },         // SOCD_MODE_UP_PRIORITY
+	{ SOCD_AXIS_NEUTRAL, SOCD_AXIS_NEUTRAL },         // SOCD_MODE_NEUTRAL
+	{ SOCD_AXIS_LAST_INPUT, SOCD_AXIS_LAST_INPUT },   // SOCD_MODE_SECOND_INPUT_PRIORITY
+	{ SOCD_AXIS_FIRST_INPUT, SOCD_AXIS_FIRST_INPUT }, // SOCD_MODE_FIRST_INPUT_PRIORITY
+	{ SOCD_AXIS_NEUTRAL, SOCD_AXIS_NEUTRAL },         // SOCD_MODE_CUSTOM, until set
+};
+
+class GamepadSOCD
+{
+	public:
+		GamepadSOCD()
+		{
+			for (uint8_t mode = 0; mode < MODE_SLOTS; mode++)
+			{
+				rows[mode][0] = socdModePolicies[mode][0] * 16;
+				rows[mode][1] = socdModePolicies[mode][1] * 16;
+			}
+		}
+
+		/**
+		 * @brief Set the vertical and horizontal policies of SOCD_MODE_CUSTOM, neutral on both axes until set.
+		 */
+		inline void setCustom(SOCDAxisPolicy vertical, SOCDAxisPolicy horizontal)
+		{
+			rows[SOCD_MODE_CUSTOM][0] = ((vertical < SOCD_AXIS_COUNT) ? vertical : SOCD_AXIS_NEUTRAL) * 16;
+			rows[SOCD_MODE_CUSTOM][1] = ((horizontal < SOCD_AXIS_COUNT) ? horizontal : SOCD_AXIS_NEUTRAL) * 16;
+		}
+
+		inline SOCDAxisPolicy getCustomVertical() const
+		{
+			return static_cast<SOCDAxisPolicy>(rows[SOCD_MODE_CUSTOM][0] / 16);
+		}
+
+		inline SOCDAxisPolicy getCustomHorizontal() const
+		{
+			return static_cast<SOCDAxisPolicy>(rows[SOCD_MODE_CUSTOM][1] / 16);
+		}
+
+		/**
+		 * @brief Forget the directions held, as if the D-pad had been released.
+		 */
+		inline void reset() { last = 0; }
+
+		/**
+		 * @brief Clean a D-pad value.
+		 *
+		 * @return uint8_t The clean D-pad value, with no bits above the four directions
+		 */
+		inline uint8_t update(SOCDMode mode, uint8_t dpad)
+		{
+			const uint8_t *row = rows[mode & (MODE_SLOTS - 1)];
+			uint8_t vertical = MPG_TABLE_READ8(&socdAxisTable[row[0] + ((last & 0x3) << 2) + (dpad & 0x3)]);
+			uint8_t horizontal = MPG_TABLE_READ8(&socdAxisTable[row[1] + (last & 0xC) + ((dpad >> 2) & 0x3)]);
+			last = (vertical >> 2) | (horizontal & 0xC);
+			return (vertical & 0x3) | ((horizontal & 0x3) << 2);
+		}
+
+	protected:
+		static const uint8_t MODE_SLOTS = 8; // SOCD_MODE_COUNT rounded up to a power of 2
+
+		uint8_t rows[MODE_SLOTS][2];         // Table offsets of the vertical and horizontal policies of each mode
+		uint8_t last {0};                    // Direction last held alone, vertical in bits 0-1, horizontal in 2-3
+};
+
+// The name of the SOCD state before it became the engine
+typedef GamepadSOCD GamepadSOCDState;
+
+/**
+ * @brief Run SOCD cleaning against a D-pad value.
+ *
+ * @param mode The SOCD cleaning mode.
+ * @param dpad The GamepadState.dpad value.
+ * @param socd The gamepad's SOCD state, updated with the directions held.
+ * @return uint8_t The clean D-pad value.
+ */
+inline uint8_t runSOCDCleaner(SOCDMode mode, uint8_t dpad, GamepadSOCD &socd)
+{
+	return socd.update(mode, dpad);
+}
+
+/**
+ * @brief Run SOCD cleaning with a single state shared by all callers. Only suitable for a single gamepad, use the
+ * overload taking a GamepadSOCD otherwise.
+ */
+inline uint8_t runSOCDCleaner(SOCDMode mode, uint8_t dpad)
+{
+	static GamepadSOCD socd;
+	return socd.update(mode, dpad);
+}
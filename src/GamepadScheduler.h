@@ -0,0 +1,168 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "GamepadAtomics.h"
+#include "GamepadConfig.h"
+
+/**
+ * @brief Just-in-time frame scheduling against the USB host's polls.
+ *
+ * A spinning `loop()` hands the host a report that was read anywhere from one to two loop times before the poll.
+ * GamepadScheduler learns when the host polls from a driver hook, and how long a frame takes, so that read() ...
+ * getReport() starts just early enough to finish right before the next poll:
+ *
+ *     // USB driver, e.g. the start-of-frame interrupt
+ *     scheduler.onPoll(micros());
+ *
+ *     // loop()
+ *     uint32_t start = micros();
+ *     if (scheduler.ready(start))
+ *     {
+ *         void *report = gamepad.update(&changed);
+ *         sendReport(report, size, changed);
+ *         scheduler.done(start, micros());
+ *     }
+ *
+ * Until it has seen GAMEPAD_SCHEDULER_LOCK_POLLS consistent polls, and whenever a frame takes longer than the poll
+ * interval, `ready()` always returns true, so the loop behaves as if there were no scheduler.
+ *
+ * `onPoll()` only stores the timestamp and bumps a byte counter, so it is safe to call from an interrupt. All other
+ * methods belong to the main loop.
+ */
+class GamepadScheduler
+{
+	public:
+		GamepadScheduler(uint16_t guardUs = GAMEPAD_SCHEDULER_GUARD_US) : guardUs(guardUs) { }
+
+		/**
+		 * @brief Driver hook, called at each USB start-of-frame or IN token with a microsecond timestamp.
+		 */
+		inline void onPoll(uint32_t us)
+		{
+			pollTime = us;
+			gamepadAtomicStore(&pollCount, static_cast<uint8_t>(pollCount + 1));
+		}
+
+		/**
+		 * @brief Check whether the next frame should start now.
+		 */
+		bool ready(uint32_t nowUs)
+		{
+			sync();
+			if (!isLocked())
+				return true;
+
+			return static_cast<int32_t>(nowUs - (target - getLead())) >= 0;
+		}
+
+		/**
+		 * @brief Report that a frame ran from `startUs` to `endUs`.
+		 */
+		void done(uint32_t startUs, uint32_t endUs)
+		{
+			// Decaying peak: a slow frame raises the lead at once, which then relaxes over ~64 frames
+			uint32_t cost = endUs - startUs;
+			costUs = (cost > costUs) ? cost : costUs - ((costUs - cost) >> 6);
+
+			if (isLocked())
+			{
+				ranFor = target;
+				target += getPeriod();
+			}
+		}
+
+		/**
+		 * @brief True once the poll interval is known and frames are being aligned to it.
+		 */
+		inline bool isLocked() const { return locks >= GAMEPAD_SCHEDULER_LOCK_POLLS && getLead() < getPeriod(); }
+
+		/**
+		 * @brief The learned poll interval in microseconds, 0 until the first two polls.
+		 */
+		inline uint32_t getPeriod() const { return periodQ4 >> 4; }
+
+		/**
+		 * @brief How long before a poll frames are started: the frame time plus the guard time.
+		 */
+		inline uint32_t getLead() const { return costUs + guardUs; }
+
+		/**
+		 * @brief The poll the next frame is aimed at.
+		 */
+		inline uint32_t getTarget() const { return target; }
+
+		const uint16_t guardUs;
+
+	protected:
+		/**
+		 * @brief Pick up polls seen by `onPoll()` since the last call.
+		 */
+		void sync()
+		{
+			uint8_t count;
+			uint32_t time;
+			do
+			{
+				count = gamepadAtomicLoad(&pollCount);
+				time = pollTime;
+			}
+			while (count != gamepadAtomicLoad(&pollCount));
+
+			if (count == seenCount)
+				return;
+
+			uint8_t polls = count - seenCount;
+			if (seenPoll)
+			{
+				// Intervals spanning polls the main loop did not see are averaged over them
+				uint32_t interval = time - lastPoll;
+				if (polls > 1)
+					interval /= polls;
+
+				uint32_t period = getPeriod();
+				if (period != 0 && interval > period - (period >> 3) && interval < period + (period >> 3))
+				{
+					periodQ4 += (static_cast<int32_t>(interval << 4) - static_cast<int32_t>(periodQ4)) >> 3;
+					if (locks < GAMEPAD_SCHEDULER_LOCK_POLLS)
+						locks++;
+				}
+				else
+				{
+					// First interval, or the host changed rate or resumed from suspend
+					periodQ4 = interval << 4;
+					locks = 0;
+				}
+			}
+
+			seenCount = count;
+			seenPoll = true;
+			lastPoll = time;
+
+			// Aim at the poll after this one, or the one after that if this frame already ran for it
+			uint32_t period = getPeriod();
+			uint32_t next = lastPoll + period;
+			uint32_t offset = ranFor - next;
+			if (offset < (period >> 1) || offset > ~(period >> 1))
+				next += period;
+
+			target = next;
+		}
+
+		volatile uint32_t pollTime {0};  // Written by onPoll()
+		uint8_t pollCount {0};           // Written by onPoll()
+
+		uint8_t seenCount {0};
+		bool seenPoll {false};
+		uint8_t locks {0};
+		uint32_t lastPoll {0};
+		uint32_t periodQ4 {0};           // Poll interval in 1/16 us
+		uint32_t costUs {0};
+		uint32_t target {0};
+		uint32_t ranFor {0};
+};
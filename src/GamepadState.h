@@ -9,6 +9,7 @@
 #include "GamepadEnums.h"
 
 #define GAMEPAD_BUTTON_COUNT 14
+#define GAMEPAD_DIGITAL_INPUT_COUNT 18 // Total number of buttons, including D-pad
 
 /*
 	Gamepad button mapping table:
@@ -31,6 +32,8 @@
 	| A1     | Guide  | Home    | -        | 13       | -      |
 	| A2     | -      | Capture | -        | 14       | -      |
 	+--------+--------+---------+----------+----------+--------+
+
+	The report conversions are generated from this table, see GamepadMappings.h.
 */
 
 #define GAMEPAD_MASK_UP    (1U << 0)
@@ -112,6 +115,30 @@ struct GamepadState
 	uint8_t rt {0};
 };
 
+// Change mask bits, see compareGamepadState()
+#define GAMEPAD_CHANGED_DPAD        (1U << 0)
+#define GAMEPAD_CHANGED_BUTTONS     (1U << 1)
+#define GAMEPAD_CHANGED_AUX         (1U << 2)
+#define GAMEPAD_CHANGED_LEFT_STICK  (1U << 3)
+#define GAMEPAD_CHANGED_RIGHT_STICK (1U << 4)
+#define GAMEPAD_CHANGED_TRIGGERS    (1U << 5)
+#define GAMEPAD_CHANGED_REPORT      (1U << 7) // Input mode or report options changed
+
+/**
+ * @brief Get the mask of GamepadState fields that differ between two states.
+ */
+inline uint8_t compareGamepadState(const GamepadState &a, const GamepadState &b)
+{
+	return 0
+		| ((a.dpad != b.dpad)                   ? GAMEPAD_CHANGED_DPAD        : 0)
+		| ((a.buttons != b.buttons)             ? GAMEPAD_CHANGED_BUTTONS     : 0)
+		| ((a.aux != b.aux)                     ? GAMEPAD_CHANGED_AUX         : 0)
+		| ((a.lx != b.lx || a.ly != b.ly)       ? GAMEPAD_CHANGED_LEFT_STICK  : 0)
+		| ((a.rx != b.rx || a.ry != b.ry)       ? GAMEPAD_CHANGED_RIGHT_STICK : 0)
+		| ((a.lt != b.lt || a.rt != b.rt)       ? GAMEPAD_CHANGED_TRIGGERS    : 0)
+	;
+}
+
 // Convert the horizontal GamepadState dpad axis value into an analog value
 inline uint16_t dpadToAnalogX(uint8_t dpad)
 {
@@ -143,72 +170,3 @@ inline uint16_t dpadToAnalogY(uint8_t dpad)
 			return GAMEPAD_JOYSTICK_MID;
 	}
 }
-
-/**
- * @brief Run SOCD cleaning against a D-pad value.
- *
- * @param mode The SOCD cleaning mode.
- * @param dpad The GamepadState.dpad value.
- * @return uint8_t The clean D-pad value.
- */
-inline uint8_t runSOCDCleaner(SOCDMode mode, uint8_t dpad)
-{
-	static DpadDirection lastUD = DIRECTION_NONE;
-	static DpadDirection lastLR = DIRECTION_NONE;
-	uint8_t newDpad = 0;
-
-	switch (dpad & (GAMEPAD_MASK_UP | GAMEPAD_MASK_DOWN))
-	{
-		case (GAMEPAD_MASK_UP | GAMEPAD_MASK_DOWN):
-			if (mode == SOCD_MODE_UP_PRIORITY)
-			{
-				newDpad |= GAMEPAD_MASK_UP;
-				lastUD = DIRECTION_UP;
-			}
-			else if (mode == SOCD_MODE_SECOND_INPUT_PRIORITY && lastUD != DIRECTION_NONE)
-				newDpad |= (lastUD == DIRECTION_UP) ? GAMEPAD_MASK_DOWN : GAMEPAD_MASK_UP;
-			else
-				lastUD = DIRECTION_NONE;
-			break;
-
-		case GAMEPAD_MASK_UP:
-			newDpad |= GAMEPAD_MASK_UP;
-			lastUD = DIRECTION_UP;
-			break;
-
-		case GAMEPAD_MASK_DOWN:
-			newDpad |= GAMEPAD_MASK_DOWN;
-			lastUD = DIRECTION_DOWN;
-			break;
-
-		default:
-			lastUD = DIRECTION_NONE;
-			break;
-	}
-
-	switch (dpad & (GAMEPAD_MASK_LEFT | GAMEPAD_MASK_RIGHT))
-	{
-		case (GAMEPAD_MASK_LEFT | GAMEPAD_MASK_RIGHT):
-			if (mode == SOCD_MODE_SECOND_INPUT_PRIORITY && lastLR != DIRECTION_NONE)
-				newDpad |= (lastLR == DIRECTION_LEFT) ? GAMEPAD_MASK_RIGHT : GAMEPAD_MASK_LEFT;
-			else
-				lastLR = DIRECTION_NONE;
-			break;
-
-		case GAMEPAD_MASK_LEFT:
-			newDpad |= GAMEPAD_MASK_LEFT;
-			lastLR = DIRECTION_LEFT;
-			break;
-
-		case GAMEPAD_MASK_RIGHT:
-			newDpad |= GAMEPAD_MASK_RIGHT;
-			lastLR = DIRECTION_RIGHT;
-			break;
-
-		default:
-			lastLR = DIRECTION_NONE;
-			break;
-	}
-
-	return newDpad;
-}
@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include "GamepadOptions.h"
+#include "GamepadState.h"
 
 #define STORAGE_FIRST_AVAILBLE_INDEX 2048
 
@@ -17,8 +18,84 @@ class GamepadStorage
 		virtual void start(); // TODO: Should be pure virtual.
 		virtual void save(); // TODO: Should be pure virtual.
 
-		GamepadOptions getGamepadOptions();
-		void setGamepadOptions(GamepadOptions options);
+		virtual GamepadOptions getGamepadOptions();
+		virtual void setGamepadOptions(GamepadOptions options);
+
+		/**
+		 * @brief Get the saved button remap, GAMEPAD_DIGITAL_INPUT_COUNT logical key masks as in GamepadRemap.h.
+		 * Storage that keeps no remap, like the board-defined methods above, has none.
+		 *
+		 * @return bool False if there is no saved remap, in which case `map` is unchanged
+		 */
+		virtual bool getRemap(uint32_t * /* map */) { return false; }
+
+		/**
+		 * @brief Stage a button remap to save along with the options.
+		 */
+		virtual void setRemap(const uint32_t * /* map */) { }
+
+		/**
+		 * @brief Start saving options a slice at a time, see `stepSave()`.
+		 */
+		virtual void beginSave(GamepadOptions options) { savingOptions = options; }
+
+		/**
+		 * @brief Do the next slice of the save started by `beginSave()`, e.g. once per frame. Storage that cannot be
+		 * split up, like the board-defined methods above, saves changed options in a single step.
+		 *
+		 * @return bool True once the save has finished
+		 */
+		virtual bool stepSave()
+		{
+			if (!equalGamepadOptions(getGamepadOptions(), savingOptions))
+			{
+				setGamepadOptions(savingOptions);
+				save();
+			}
+
+			return true;
+		}
+
+	protected:
+		GamepadOptions savingOptions;
+};
+
+/**
+ * @brief Options and remap kept in RAM by the instance itself, for gamepads that do not persist them or persist them
+ * some other way. Unlike the board-defined methods above, which all share the board's one storage medium, every
+ * instance holds its own options.
+ */
+class GamepadMemoryStorage : public GamepadStorage
+{
+	public:
+		void start() override { }
+		void save() override { }
+
+		GamepadOptions getGamepadOptions() override { return options; }
+		void setGamepadOptions(GamepadOptions value) override { options = value; }
+
+		bool getRemap(uint32_t *map) override
+		{
+			for (uint8_t key = 0; hasRemap && key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+				map[key] = remap[key];
+
+			return hasRemap;
+		}
+
+		void setRemap(const uint32_t *map) override
+		{
+			for (uint8_t key = 0; key < GAMEPAD_DIGITAL_INPUT_COUNT; key++)
+				remap[key] = map[key];
+
+			hasRemap = true;
+		}
+
+	protected:
+		GamepadOptions options;
+		uint32_t remap[GAMEPAD_DIGITAL_INPUT_COUNT];
+		bool hasRemap {false};
 };
 
+// The board's storage, used by `MPGS` by default. Each additional gamepad needs its own storage object, e.g. a
+// GamepadLogStorage on its own flash region or a GamepadMemoryStorage.
 static GamepadStorage GamepadStore;
@@ -0,0 +1,194 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "GamepadState.h"
+
+/*
+	Compact binary trace of GamepadState changes.
+
+	A trace is an 8 byte header followed by one record per state change:
+
+	    header  'M' 'P' 'G' 'R' version(1) reserved(3)
+	    record  mask(1) delta_us(varint) fields...
+
+	`mask` holds the GAMEPAD_CHANGED_* bits from compareGamepadState() against the previous record. Each set bit is
+	followed by the new value of its fields, little-endian and in bit order: dpad (1 byte), buttons (2), aux (2),
+	lx ly (4), rx ry (4), lt rt (2). Bits 6 and 7 are reserved and must be 0. `delta_us` is the time since the
+	previous record (or since `begin()` for the first) as an unsigned LEB128 varint. Fields not in the mask keep
+	their previous value, and the state before the first record is a default GamepadState.
+
+	A button press costs 4-6 bytes, so a 16KB buffer holds thousands of events.
+*/
+
+#define GAMEPAD_TRACE_VERSION 1
+#define GAMEPAD_TRACE_HEADER_SIZE 8
+#define GAMEPAD_TRACE_RECORD_MAX (1 + 5 + 15) // mask, largest varint, every field
+#define GAMEPAD_TRACE_MASK_FIELDS 0x3F
+
+/**
+ * @brief Write the trace header.
+ *
+ * @return uint8_t The header size
+ */
+inline uint8_t writeGamepadTraceHeader(uint8_t *out)
+{
+	out[0] = 'M';
+	out[1] = 'P';
+	out[2] = 'G';
+	out[3] = 'R';
+	out[4] = GAMEPAD_TRACE_VERSION;
+	out[5] = out[6] = out[7] = 0;
+	return GAMEPAD_TRACE_HEADER_SIZE;
+}
+
+/**
+ * @brief Check a trace header.
+ */
+inline bool checkGamepadTraceHeader(const uint8_t *data, size_t length)
+{
+	return length >= GAMEPAD_TRACE_HEADER_SIZE
+		&& data[0] == 'M' && data[1] == 'P' && data[2] == 'G' && data[3] == 'R'
+		&& data[4] == GAMEPAD_TRACE_VERSION;
+}
+
+/**
+ * @brief Encode one record.
+ *
+ * @param out At least GAMEPAD_TRACE_RECORD_MAX bytes
+ * @param mask The fields to store, from compareGamepadState()
+ * @return uint8_t The record size
+ */
+inline uint8_t encodeGamepadTraceRecord(uint8_t *out, uint32_t deltaUs, uint8_t mask, const GamepadState &state)
+{
+	uint8_t *p = out;
+	*p++ = mask & GAMEPAD_TRACE_MASK_FIELDS;
+
+	while (deltaUs >= 0x80)
+	{
+		*p++ = static_cast<uint8_t>(deltaUs) | 0x80;
+		deltaUs >>= 7;
+	}
+	*p++ = static_cast<uint8_t>(deltaUs);
+
+	auto put16 = [&p](uint16_t value) { *p++ = static_cast<uint8_t>(value); *p++ = static_cast<uint8_t>(value >> 8); };
+
+	if (mask & GAMEPAD_CHANGED_DPAD)        *p++ = state.dpad;
+	if (mask & GAMEPAD_CHANGED_BUTTONS)     put16(state.buttons);
+	if (mask & GAMEPAD_CHANGED_AUX)         put16(state.aux);
+	if (mask & GAMEPAD_CHANGED_LEFT_STICK)  { put16(state.lx); put16(state.ly); }
+	if (mask & GAMEPAD_CHANGED_RIGHT_STICK) { put16(state.rx); put16(state.ry); }
+	if (mask & GAMEPAD_CHANGED_TRIGGERS)    { *p++ = state.lt; *p++ = state.rt; }
+
+	return static_cast<uint8_t>(p - out);
+}
+
+/**
+ * @brief Decode one record, applying its fields on top of `state`.
+ *
+ * @return size_t The record size, or 0 if the record is truncated or malformed
+ */
+inline size_t decodeGamepadTraceRecord(const uint8_t *data, size_t length, uint32_t &deltaUs, GamepadState &state)
+{
+	if (length == 0 || (data[0] & ~GAMEPAD_TRACE_MASK_FIELDS))
+		return 0;
+
+	const uint8_t *p = data;
+	const uint8_t *end = data + length;
+	uint8_t mask = *p++;
+
+	deltaUs = 0;
+	for (uint8_t shift = 0; ; shift += 7)
+	{
+		if (p == end || shift > 28)
+			return 0;
+
+		uint8_t byte = *p++;
+		deltaUs |= static_cast<uint32_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			break;
+	}
+
+	size_t size = 0
+		+ ((mask & GAMEPAD_CHANGED_DPAD)        ? 1 : 0)
+		+ ((mask & GAMEPAD_CHANGED_BUTTONS)     ? 2 : 0)
+		+ ((mask & GAMEPAD_CHANGED_AUX)         ? 2 : 0)
+		+ ((mask & GAMEPAD_CHANGED_LEFT_STICK)  ? 4 : 0)
+		+ ((mask & GAMEPAD_CHANGED_RIGHT_STICK) ? 4 : 0)
+		+ ((mask & GAMEPAD_CHANGED_TRIGGERS)    ? 2 : 0);
+
+	if (static_cast<size_t>(end - p) < size)
+		return 0;
+
+	auto get16 = [&p]() { uint16_t value = p[0] | (p[1] << 8); p += 2; return value; };
+
+	if (mask & GAMEPAD_CHANGED_DPAD)        state.dpad = *p++;
+	if (mask & GAMEPAD_CHANGED_BUTTONS)     state.buttons = get16();
+	if (mask & GAMEPAD_CHANGED_AUX)         state.aux = get16();
+	if (mask & GAMEPAD_CHANGED_LEFT_STICK)  { state.lx = get16(); state.ly = get16(); }
+	if (mask & GAMEPAD_CHANGED_RIGHT_STICK) { state.rx = get16(); state.ry = get16(); }
+	if (mask & GAMEPAD_CHANGED_TRIGGERS)    { state.lt = p[0]; state.rt = p[1]; p += 2; }
+
+	return static_cast<size_t>(p - data);
+}
+
+/**
+ * @brief Streaming trace recorder.
+ *
+ * Keeps only the previous state and timestamp, and hands each encoded record to a write callback, e.g. one that
+ * appends to a RAM buffer or a serial port:
+ *
+ *     GamepadTraceWriter trace([](const uint8_t *data, uint8_t length) { Serial.write(data, length); });
+ *     trace.begin(micros());
+ *     ...
+ *     gamepad.read();
+ *     trace.record(micros(), gamepad.state);
+ */
+class GamepadTraceWriter
+{
+	public:
+		typedef void (*WriteFunc)(const uint8_t *data, uint8_t length);
+
+		GamepadTraceWriter(WriteFunc write) : write(write) { }
+
+		/**
+		 * @brief Write the header and start timing from `timeUs`.
+		 */
+		void begin(uint32_t timeUs)
+		{
+			uint8_t header[GAMEPAD_TRACE_HEADER_SIZE];
+			write(header, writeGamepadTraceHeader(header));
+			previous = GamepadState();
+			lastTime = timeUs;
+		}
+
+		/**
+		 * @brief Record the state if it changed since the last record.
+		 *
+		 * @param timeUs A free-running microsecond counter, wrapping is fine between records less than ~71 minutes apart
+		 * @return bool True when a record was written
+		 */
+		bool record(uint32_t timeUs, const GamepadState &state)
+		{
+			uint8_t mask = compareGamepadState(state, previous) & GAMEPAD_TRACE_MASK_FIELDS;
+			if (mask == 0)
+				return false;
+
+			uint8_t buffer[GAMEPAD_TRACE_RECORD_MAX];
+			write(buffer, encodeGamepadTraceRecord(buffer, timeUs - lastTime, mask, state));
+			previous = state;
+			lastTime = timeUs;
+			return true;
+		}
+
+	protected:
+		WriteFunc write;
+		GamepadState previous;
+		uint32_t lastTime {0};
+};
@@ -0,0 +1,324 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#include <string.h>
+
+#include "GamepadTurbo.h"
+
+GamepadTurbo::GamepadTurbo(uint16_t tickHz)
+	: tickHz(tickHz ? tickHz : 1)
+	, turnTime((GAMEPAD_TURBO_WHEEL_SLOTS * CLOCK_HZ + this->tickHz - 1) / this->tickHz)
+{
+	memset(slots, NONE, sizeof(slots));
+	memset(slotOf, NONE, sizeof(slotOf));
+}
+
+void GamepadTurbo::setTurbo(uint16_t buttons, uint16_t rate)
+{
+	if (rate > tickHz / 2)
+		rate = tickHz / 2;
+
+	for (uint8_t i = 0; i < GAMEPAD_BUTTON_COUNT; i++)
+	{
+		uint16_t mask = 1U << i;
+		if (!(buttons & mask))
+			continue;
+
+		rates[i] = rate;
+		if (rate == 0)
+		{
+			cancel(i);
+			turboButtons &= ~mask;
+			turboHeld &= ~mask;
+			turboOn &= ~mask;
+		}
+		else
+		{
+			turboButtons |= mask;
+		}
+	}
+}
+
+bool GamepadTurbo::setMacro(uint8_t index, uint16_t trigger, const GamepadMacroStep *steps, uint8_t count)
+{
+	if (index >= GAMEPAD_MACRO_COUNT || count > GAMEPAD_MACRO_STEPS)
+		return false;
+
+	clearMacro(index);
+	Macro &macro = macros[index];
+	memcpy(macro.steps, steps, count * sizeof(GamepadMacroStep));
+	macro.trigger = trigger;
+	macro.count = count;
+	macro.step = count;
+	if (count)
+		macroTriggers |= trigger;
+
+	return true;
+}
+
+void GamepadTurbo::clearMacro(uint8_t index)
+{
+	if (index >= GAMEPAD_MACRO_COUNT)
+		return;
+
+	cancel(MACRO_TIMER + index);
+	macros[index] = Macro();
+
+	macroTriggers = 0;
+	for (uint8_t i = 0; i < GAMEPAD_MACRO_COUNT; i++)
+	{
+		if (macros[i].count)
+			macroTriggers |= macros[i].trigger;
+	}
+}
+
+void GamepadTurbo::beginRecording(uint8_t index, uint16_t trigger)
+{
+	if (index >= GAMEPAD_MACRO_COUNT)
+		return;
+
+	clearMacro(index);
+	recording = index;
+	recordTrigger = trigger;
+}
+
+uint8_t GamepadTurbo::endRecording()
+{
+	if (!isRecording())
+		return 0;
+
+	Macro &macro = macros[recording];
+	recording = NONE;
+
+	// Drop the wait before the first input and the idle time after the last
+	uint8_t first = (macro.count && !macro.steps[0].buttons && !macro.steps[0].dpad) ? 1 : 0;
+	uint8_t count = macro.count;
+	if (count > first && !macro.steps[count - 1].buttons && !macro.steps[count - 1].dpad)
+		count--;
+
+	GamepadMacroStep steps[GAMEPAD_MACRO_STEPS];
+	count -= first;
+	memcpy(steps, macro.steps + first, count * sizeof(GamepadMacroStep));
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (steps[i].ticks == 0)
+			steps[i].ticks = 1;
+	}
+
+	setMacro(static_cast<uint8_t>(&macro - macros), recordTrigger, steps, count);
+	return count;
+}
+
+void GamepadTurbo::update(GamepadState &state, uint32_t time)
+{
+	// The ticks the clock has seen, at most a turn of the wheel. The subtraction is wrap safe, and as a frame mostly
+	// sees a tick or none, counting them off is cheaper than dividing.
+	uint32_t elapsed = time - lastTime;
+	if (elapsed > turnTime)
+		elapsed = turnTime;
+
+	uint32_t scaled = elapsed * tickHz + remainder;
+	uint8_t clockTicks = 0;
+	while (scaled >= CLOCK_HZ && clockTicks < GAMEPAD_TURBO_WHEEL_SLOTS)
+	{
+		scaled -= CLOCK_HZ;
+		clockTicks++;
+	}
+
+	// Tick on the polls seen since the last frame. Once a turn has passed since the last poll, the count may have
+	// wrapped, and polls that have stopped coming leave the clock to tick the wheel.
+	uint8_t polls = gamepadAtomicLoad(&pollCount);
+	uint8_t pollTicks = polls - seenPolls;
+	seenPolls = polls;
+
+	uint8_t ticks = 0;
+	if (pollTicks)
+	{
+		polled = true;
+		ticks = (clockTicks < GAMEPAD_TURBO_WHEEL_SLOTS) ? pollTicks : GAMEPAD_TURBO_WHEEL_SLOTS;
+		lastTime = time;
+		remainder = 0;
+	}
+	else if (!polled || clockTicks == GAMEPAD_TURBO_WHEEL_SLOTS)
+	{
+		polled = false;
+		ticks = clockTicks;
+		lastTime = time;
+		remainder = (clockTicks < GAMEPAD_TURBO_WHEEL_SLOTS) ? scaled : 0;
+	}
+
+	for (uint8_t i = 0; i < ticks; i++)
+		advance();
+
+	if (isRecording())
+	{
+		record(state, ticks);
+	}
+	else if (macroTriggers)
+	{
+		uint16_t triggers = state.buttons & macroTriggers;
+		uint16_t pressed = triggers & ~lastTriggers;
+		lastTriggers = triggers;
+		state.buttons &= ~macroTriggers;
+
+		for (uint8_t i = 0; pressed && i < GAMEPAD_MACRO_COUNT; i++)
+		{
+			Macro &macro = macros[i];
+			if ((pressed & macro.trigger) && macro.count && !isPlaying(i))
+			{
+				macro.step = 0;
+				schedule(MACRO_TIMER + i, macro.steps[0].ticks);
+			}
+		}
+	}
+
+	// Turbo buttons start pressed, then toggle on the wheel until released
+	uint16_t held = state.buttons & turboButtons;
+	uint16_t changed = held ^ turboHeld;
+	for (uint8_t i = 0; changed; i++, changed >>= 1)
+	{
+		if (!(changed & 1))
+			continue;
+
+		uint16_t mask = 1U << i;
+		if (held & mask)
+		{
+			turboOn |= mask;
+			carry[i] = 0;
+			schedule(i, nextToggle(i));
+		}
+		else
+		{
+			cancel(i);
+			turboOn &= ~mask;
+		}
+	}
+
+	turboHeld = held;
+	state.buttons = (state.buttons & ~turboButtons) | (held & turboOn);
+
+	for (uint8_t i = 0; i < GAMEPAD_MACRO_COUNT; i++)
+	{
+		if (isPlaying(i))
+		{
+			const GamepadMacroStep &step = macros[i].steps[macros[i].step];
+			state.buttons |= step.buttons;
+			state.dpad |= step.dpad;
+		}
+	}
+}
+
+void GamepadTurbo::advance()
+{
+	now++;
+	uint8_t timer = slots[now & (GAMEPAD_TURBO_WHEEL_SLOTS - 1)];
+	while (timer != NONE)
+	{
+		uint8_t following = next[timer];
+		if (rounds[timer])
+		{
+			rounds[timer]--;
+		}
+		else
+		{
+			cancel(timer);
+			fire(timer);
+		}
+		timer = following;
+	}
+}
+
+void GamepadTurbo::schedule(uint8_t timer, uint32_t delay)
+{
+	cancel(timer);
+	if (delay == 0)
+		delay = 1;
+
+	uint8_t slot = (now + delay) & (GAMEPAD_TURBO_WHEEL_SLOTS - 1);
+	rounds[timer] = static_cast<uint16_t>((delay - 1) / GAMEPAD_TURBO_WHEEL_SLOTS);
+	slotOf[timer] = slot;
+	previous[timer] = NONE;
+	next[timer] = slots[slot];
+	if (slots[slot] != NONE)
+		previous[slots[slot]] = timer;
+	slots[slot] = timer;
+}
+
+void GamepadTurbo::cancel(uint8_t timer)
+{
+	uint8_t slot = slotOf[timer];
+	if (slot == NONE)
+		return;
+
+	if (previous[timer] != NONE)
+		next[previous[timer]] = next[timer];
+	else
+		slots[slot] = next[timer];
+
+	if (next[timer] != NONE)
+		previous[next[timer]] = previous[timer];
+
+	slotOf[timer] = NONE;
+}
+
+void GamepadTurbo::fire(uint8_t timer)
+{
+	if (timer < MACRO_TIMER)
+	{
+		turboOn ^= 1U << timer;
+		schedule(timer, nextToggle(timer));
+		return;
+	}
+
+	Macro &macro = macros[timer - MACRO_TIMER];
+	if (++macro.step < macro.count)
+		schedule(timer, macro.steps[macro.step].ticks);
+}
+
+uint32_t GamepadTurbo::nextToggle(uint8_t button)
+{
+	uint32_t toggles = 2UL * rates[button];
+	uint32_t delay = tickHz / toggles;
+	carry[button] += tickHz % toggles;
+	if (carry[button] >= toggles)
+	{
+		carry[button] -= toggles;
+		delay++;
+	}
+
+	return delay;
+}
+
+void GamepadTurbo::record(const GamepadState &state, uint8_t ticks)
+{
+	Macro &macro = macros[recording];
+	uint16_t buttons = state.buttons & ~recordTrigger;
+
+	// The time since the last frame belongs to the step that was held through it
+	if (macro.count)
+	{
+		GamepadMacroStep &last = macro.steps[macro.count - 1];
+		uint32_t held = last.ticks + ticks;
+		last.ticks = static_cast<uint16_t>((held > 0xFFFF) ? 0xFFFF : held);
+		if (last.buttons == buttons && last.dpad == state.dpad)
+			return;
+
+		// Changed again before a tick passed
+		if (last.ticks == 0)
+		{
+			last.buttons = buttons;
+			last.dpad = state.dpad;
+			return;
+		}
+	}
+
+	if (macro.count == GAMEPAD_MACRO_STEPS)
+	{
+		endRecording();
+		return;
+	}
+
+	macro.steps[macro.count++] = { buttons, state.dpad, 0 };
+}
@@ -0,0 +1,178 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "GamepadAtomics.h"
+#include "GamepadClock.h"
+#include "GamepadConfig.h"
+#include "GamepadState.h"
+
+/*
+	Turbo buttons and macros.
+
+	A turbo button held down is sent pressed and released over and over at its own rate. A macro plays a short
+	sequence of button and D-pad steps when its trigger button is pressed, either set up in code or recorded from
+	the player's own inputs. The stage runs on the debounced state, before hotkeys.
+
+	All timing runs on a hashed time wheel of GAMEPAD_TURBO_WHEEL_SLOTS slots. Each running turbo button or macro
+	is one timer, filed in the slot for the tick it fires on, with a count of whole turns of the wheel still to
+	wait. A tick only looks at its own slot, so a frame costs the same however many timers are running.
+
+	The wheel ticks `tickHz` times a second by the gamepad's clock, or once per host poll while the USB driver calls
+	`onPoll()`, e.g. from the start-of-frame interrupt. Ticking on polls lines every turbo edge up with a poll, and
+	each level lasts at least one poll, so the host sees every edge as long as a frame runs for each poll (see
+	GamepadScheduler). If polls stop for a turn of the wheel, e.g. while the host is suspended, the clock takes
+	over. A gap between frames longer than a turn only runs one turn, so every timer then due fires once, late.
+	Rates are in presses per second at `tickHz` ticks per second, and the wheel spreads the remainder over the
+	presses so the average rate is exact.
+*/
+
+#define GAMEPAD_TURBO_TIMERS (GAMEPAD_BUTTON_COUNT + GAMEPAD_MACRO_COUNT)
+
+struct GamepadMacroStep
+{
+	uint16_t buttons;
+	uint8_t dpad;
+	uint16_t ticks;   // How long the step is held
+};
+
+class GamepadTurbo
+{
+	public:
+		/**
+		 * @param tickHz Wheel ticks per second: the host's poll rate when `onPoll()` is used, or the frame rate
+		 */
+		GamepadTurbo(uint16_t tickHz = 1000);
+
+		/**
+		 * @brief Set the turbo rate of buttons, in presses per second, or 0 to turn turbo off for them. Rates are
+		 * capped at half the tick rate.
+		 */
+		void setTurbo(uint16_t buttons, uint16_t rate);
+
+		/**
+		 * @brief The buttons with turbo on.
+		 */
+		inline uint16_t getTurboButtons() const { return turboButtons; }
+
+		/**
+		 * @brief Bind a macro to a trigger button. The trigger itself is no longer sent while a macro is bound to it.
+		 *
+		 * @return bool False if the index or the number of steps is out of range
+		 */
+		bool setMacro(uint8_t index, uint16_t trigger, const GamepadMacroStep *steps, uint8_t count);
+
+		/**
+		 * @brief Unbind a macro, stopping it if it is playing.
+		 */
+		void clearMacro(uint8_t index);
+
+		/**
+		 * @brief Record the player's inputs into a macro from the next `update()` on, until `endRecording()` or
+		 * GAMEPAD_MACRO_STEPS changes. Macros do not play while recording.
+		 */
+		void beginRecording(uint8_t index, uint16_t trigger);
+
+		/**
+		 * @brief Stop recording and bind the macro, without the idle time before the first input and after the last.
+		 *
+		 * @return uint8_t The number of steps recorded
+		 */
+		uint8_t endRecording();
+
+		inline bool isRecording() const { return recording < GAMEPAD_MACRO_COUNT; }
+		inline bool isPlaying(uint8_t index) const { return macros[index].step < macros[index].count; }
+		inline uint8_t getMacroSteps(uint8_t index, const GamepadMacroStep **steps) const
+		{
+			*steps = macros[index].steps;
+			return macros[index].count;
+		}
+
+		/**
+		 * @brief Convert milliseconds to wheel ticks.
+		 */
+		inline uint16_t msToTicks(uint32_t ms) const
+		{
+			uint32_t ticks = (ms * tickHz + 999) / 1000;
+			return static_cast<uint16_t>((ticks > 0xFFFF) ? 0xFFFF : ticks);
+		}
+
+		/**
+		 * @brief Driver hook, called at each USB start-of-frame or IN token. Safe to call from an interrupt.
+		 */
+		inline void onPoll() { gamepadAtomicStore(&pollCount, static_cast<uint8_t>(pollCount + 1)); }
+
+		/**
+		 * @brief Advance the wheel to `time`, from the gamepad's clock, and apply turbo and macros to the debounced
+		 * state.
+		 */
+		void update(GamepadState &state, uint32_t time);
+
+		/**
+		 * @brief Advance the wheel to the board's time and apply turbo and macros to the debounced state.
+		 */
+		inline void update(GamepadState &state) { update(state, getGamepadTime()); }
+
+		/**
+		 * @brief Ticks run since construction.
+		 */
+		inline uint32_t getTicks() const { return now; }
+
+		const uint16_t tickHz;
+
+	protected:
+		static const uint8_t NONE = 0xFF;
+		static const uint8_t MACRO_TIMER = GAMEPAD_BUTTON_COUNT;
+		static const uint32_t CLOCK_HZ = 1000UL * GAMEPAD_CLOCK_TICKS_PER_MS;
+
+		struct Macro
+		{
+			uint16_t trigger {0};
+			uint8_t count {0};
+			uint8_t step {0};
+			GamepadMacroStep steps[GAMEPAD_MACRO_STEPS];
+		};
+
+		void advance();
+		void schedule(uint8_t timer, uint32_t delay);
+		void cancel(uint8_t timer);
+		void fire(uint8_t timer);
+		uint32_t nextToggle(uint8_t button);
+		void record(const GamepadState &state, uint8_t ticks);
+
+		// The wheel: a list of timers per slot, linked through `next` and `previous`
+		uint8_t slots[GAMEPAD_TURBO_WHEEL_SLOTS];
+		uint8_t next[GAMEPAD_TURBO_TIMERS];
+		uint8_t previous[GAMEPAD_TURBO_TIMERS];
+		uint8_t slotOf[GAMEPAD_TURBO_TIMERS];
+		uint16_t rounds[GAMEPAD_TURBO_TIMERS];
+		uint32_t now {0};
+
+		uint8_t pollCount {0};    // Written by onPoll()
+		uint8_t seenPolls {0};
+		bool polled {false};      // Polls are arriving, and tick the wheel instead of the clock
+
+		// The clock: when the wheel was last brought up to it, the fraction of a tick left over, and a turn of the
+		// wheel in clock ticks
+		uint32_t lastTime {0};
+		uint32_t remainder {0};
+		const uint32_t turnTime;
+
+		// Turbo: each button toggles every tickHz / (2 * rate) ticks, carrying the remainder
+		uint16_t turboButtons {0};
+		uint16_t turboHeld {0};
+		uint16_t turboOn {0};
+		uint16_t rates[GAMEPAD_BUTTON_COUNT] { };
+		uint16_t carry[GAMEPAD_BUTTON_COUNT] { };
+
+		Macro macros[GAMEPAD_MACRO_COUNT];
+		uint16_t macroTriggers {0};
+		uint16_t lastTriggers {0};
+		uint8_t recording {NONE};
+		uint16_t recordTrigger {0};
+};
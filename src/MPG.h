@@ -5,69 +5,15 @@
 
 #pragma once
 
-#include <stdio.h>
-#include <stdint.h>
+#include "MPGCore.h"
 
-#include "GamepadEnums.h"
-#include "GamepadOptions.h"
-#include "GamepadConfig.h"
-#include "GamepadDescriptors.h"
-#include "GamepadState.h"
-#include "GamepadDebouncer.h"
-
-#define GAMEPAD_DIGITAL_INPUT_COUNT 18 // Total number of buttons, including D-pad
-
-class MPG
+class MPG : public MPGCore
 {
 	public:
-		MPG(int debounceMS = 5)
-			: debounceMS(debounceMS)
-			, f1Mask((GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2))
-			, f2Mask((GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3))
-			, debouncer(debounceMS)
+		MPG(int debounceMS = 5) : MPGCore(debounceMS)
 		{
 		}
 
-		/**
-		 * @brief The button debounce time in milliseconds. A value of 0 disables debouncing.
-		 */
-		const uint8_t debounceMS;
-
-		/**
-		 * @brief The input mask for the F1 button
-		 */
-		uint16_t f1Mask;
-
-		/**
-		 * @brief The input mask for the F2 button
-		 */
-		uint16_t f2Mask;
-
-		/**
-		 * @brief The current D-pad mode.
-		 */
-		GamepadOptions options;
-
-		/**
-		 * @brief The current gamepad state object.
-		 */
-		GamepadState state;
-
-		/**
-		 * @brief Flag to indicate analog trigger support.
-		 */
-		bool hasAnalogTriggers {false};
-
-		/**
-		 * @brief Flag to indicate Left analog stick support.
-		 */
-		bool hasLeftAnalogStick {false};
-
-		/**
-		 * @brief Flag to indicate Right analog stick support.
-		 */
-		bool hasRightAnalogStick {false};
-
 		/**
 		 * @brief Perform pin setup and any other initialization the board requires. Derived classes must overide this member.
 		 */
@@ -85,22 +31,33 @@ class MPG
 		 */
 		virtual GamepadHotkey hotkey();
 
-		/**
-		 * @brief Run debouncing algorithm against current state inputs
-		 */
-		inline void __attribute__((always_inline)) debounce() { debouncer.debounce(&state); }
-
 		/**
 		 * @brief Process the inputs before sending state to host
 		 */
 		virtual void process();
 
 		/**
-		 * @brief Generate USB report for the current input mode.
+		 * @brief Generate USB report for the current input mode. The report is only rebuilt when the state or input
+		 * mode changed since the previous call.
 		 *
+		 * @param changed Set to whether the report changed, so drivers can skip sending it
 		 * @return uint8_t* Report data pointer
 		 */
-		void *getReport();
+		void *getReport(bool *changed = nullptr);
+
+		/**
+		 * @brief Run a full frame: read, debounce, turbo, hotkey, process and report.
+		 *
+		 * @param changed Set to whether the report changed, may be null
+		 * @return void* Report data pointer
+		 */
+		void *update(bool *changed = nullptr);
+
+		/**
+		 * @brief Build reports in driver-owned buffers from now on instead of the instance's own reports, or go back
+		 * to its own reports with null. Buffers too small for the current input mode's report are not used.
+		 */
+		void setReportBuffers(GamepadReportBuffers *buffers);
 
 		/**
 		 * @brief Get the size of the USB report for the current input mode.
@@ -130,40 +87,43 @@ class MPG
 		 */
 		XInputReport *getXInputReport();
 
-		/**
-		 * @brief Check for a button press. Used by `pressed[Button]` helper methods.
-		 */
-		inline bool __attribute__((always_inline)) pressedButton(const uint16_t mask) { return (state.buttons & mask) == mask; }
-
-		/**
-		 * @brief Check for a dpad press. Used by `pressed[Dpad]` helper methods.
-		 */
-		inline bool __attribute__((always_inline)) pressedDpad(const uint8_t mask) { return (state.dpad & mask) == mask; }
-
-		inline bool __attribute__((always_inline)) pressedUp()    { return pressedDpad(GAMEPAD_MASK_UP); }
-		inline bool __attribute__((always_inline)) pressedDown()  { return pressedDpad(GAMEPAD_MASK_DOWN); }
-		inline bool __attribute__((always_inline)) pressedLeft()  { return pressedDpad(GAMEPAD_MASK_LEFT); }
-		inline bool __attribute__((always_inline)) pressedRight() { return pressedDpad(GAMEPAD_MASK_RIGHT); }
-		inline bool __attribute__((always_inline)) pressedB1()    { return pressedButton(GAMEPAD_MASK_B1); }
-		inline bool __attribute__((always_inline)) pressedB2()    { return pressedButton(GAMEPAD_MASK_B2); }
-		inline bool __attribute__((always_inline)) pressedB3()    { return pressedButton(GAMEPAD_MASK_B3); }
-		inline bool __attribute__((always_inline)) pressedB4()    { return pressedButton(GAMEPAD_MASK_B4); }
-		inline bool __attribute__((always_inline)) pressedL1()    { return pressedButton(GAMEPAD_MASK_L1); }
-		inline bool __attribute__((always_inline)) pressedR1()    { return pressedButton(GAMEPAD_MASK_R1); }
-		inline bool __attribute__((always_inline)) pressedL2()    { return pressedButton(GAMEPAD_MASK_L2); }
-		inline bool __attribute__((always_inline)) pressedR2()    { return pressedButton(GAMEPAD_MASK_R2); }
-		inline bool __attribute__((always_inline)) pressedS1()    { return pressedButton(GAMEPAD_MASK_S1); }
-		inline bool __attribute__((always_inline)) pressedS2()    { return pressedButton(GAMEPAD_MASK_S2); }
-		inline bool __attribute__((always_inline)) pressedL3()    { return pressedButton(GAMEPAD_MASK_L3); }
-		inline bool __attribute__((always_inline)) pressedR3()    { return pressedButton(GAMEPAD_MASK_R3); }
-		inline bool __attribute__((always_inline)) pressedA1()    { return pressedButton(GAMEPAD_MASK_A1); }
-		inline bool __attribute__((always_inline)) pressedA2()    { return pressedButton(GAMEPAD_MASK_A2); }
-		inline bool __attribute__((always_inline)) pressedF1()    { return pressedButton(f1Mask); }
-		inline bool __attribute__((always_inline)) pressedF2()    { return pressedButton(f2Mask); }
-
 	protected:
-		/**
-		 * @brief Button debouncer instance.
-		 */
-		GamepadDebouncer debouncer;
+		GamepadReportBuffers *reportBuffers {nullptr};
+
+		// Each instance builds its own reports, so any number of gamepads can run side by side
+		HIDReport hidReport
+		{
+			.buttons = 0,
+			.hat = HID_HAT_NOTHING,
+			.lx = HID_JOYSTICK_MID,
+			.ly = HID_JOYSTICK_MID,
+			.rx = HID_JOYSTICK_MID,
+			.ry = HID_JOYSTICK_MID,
+		};
+
+		SwitchReport switchReport
+		{
+			.buttons = 0,
+			.hat = SWITCH_HAT_NOTHING,
+			.lx = SWITCH_JOYSTICK_MID,
+			.ly = SWITCH_JOYSTICK_MID,
+			.rx = SWITCH_JOYSTICK_MID,
+			.ry = SWITCH_JOYSTICK_MID,
+			.vendor = 0,
+		};
+
+		XInputReport xinputReport
+		{
+			.report_id = 0,
+			.report_size = XINPUT_ENDPOINT_SIZE,
+			.buttons1 = 0,
+			.buttons2 = 0,
+			.lt = 0,
+			.rt = 0,
+			.lx = GAMEPAD_JOYSTICK_MID,
+			.ly = GAMEPAD_JOYSTICK_MID,
+			.rx = GAMEPAD_JOYSTICK_MID,
+			.ry = GAMEPAD_JOYSTICK_MID,
+			._reserved = { },
+		};
 };
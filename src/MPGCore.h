@@ -0,0 +1,509 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "GamepadEnums.h"
+#include "GamepadOptions.h"
+#include "GamepadConfig.h"
+#include "GamepadClock.h"
+#include "GamepadDescriptors.h"
+#include "GamepadState.h"
+#include "GamepadDebouncer.h"
+#include "GamepadAnalog.h"
+#include "GamepadADC.h"
+#include "GamepadRapidTrigger.h"
+#include "GamepadRemap.h"
+#include "GamepadSOCD.h"
+#include "GamepadTurbo.h"
+#include "GamepadHotkeys.h"
+#include "GamepadMappings.h"
+#include "GamepadReportBuffers.h"
+
+#if GAMEPAD_PROFILE
+#include "GamepadProfiler.h"
+#define MPG_PROFILE_STAGE(stage) GamepadProfileScope profileScope(profiler, stage)
+#else
+#define MPG_PROFILE_STAGE(stage)
+#endif
+
+#if DEBOUNCE_VERTICAL_COUNTERS
+typedef GamepadVerticalDebouncer MPGDebouncer;
+#else
+typedef GamepadDebouncer MPGDebouncer;
+#endif
+
+/**
+ * @brief Gamepad state and input processing shared by `MPG` and `MPGT`.
+ *
+ * Nothing in this class is virtual. All stages are defined inline so `MPGT` can compile the whole input chain into
+ * its caller, while `MPG` wraps them in its overridable virtual methods.
+ */
+class MPGCore
+{
+	public:
+		MPGCore(int debounceMS = 5)
+			: debounceMS(debounceMS)
+			, f1Mask((GAMEPAD_MASK_S1 | GAMEPAD_MASK_S2))
+			, f2Mask((GAMEPAD_MASK_L3 | GAMEPAD_MASK_R3))
+			, hotkeys(f1Mask, f2Mask)
+			, debouncer(debounceMS)
+		{
+			hotkeys.addDefaults();
+		}
+
+		/**
+		 * @brief The button debounce time in milliseconds. A value of 0 disables debouncing.
+		 */
+		const uint8_t debounceMS;
+
+		/**
+		 * @brief The input mask for the F1 button
+		 */
+		uint16_t f1Mask;
+
+		/**
+		 * @brief The input mask for the F2 button
+		 */
+		uint16_t f2Mask;
+
+		/**
+		 * @brief The hotkeys checked in `hotkey()`, starting with the F1 and F2 defaults.
+		 */
+		GamepadHotkeys hotkeys;
+
+		/**
+		 * @brief Button debouncer instance, with its mode and per-input windows set through `setMode()`,
+		 * `setButtonInterval()` and `setDpadInterval()`.
+		 */
+		MPGDebouncer debouncer;
+
+		/**
+		 * @brief The SOCD cleaner run in `process()` with `options.socdMode`, holding the custom policies and the last
+		 * input on each axis.
+		 */
+		GamepadSOCD socd;
+
+		/**
+		 * @brief The current D-pad mode.
+		 */
+		GamepadOptions options;
+
+		/**
+		 * @brief The current gamepad state object.
+		 */
+		GamepadState state;
+
+		/**
+		 * @brief Flag to indicate analog trigger support.
+		 */
+		bool hasAnalogTriggers {false};
+
+		/**
+		 * @brief Analog inputs sampled in the background, picked up at the start of `debounce()`, or none if null.
+		 */
+		GamepadADC *adc {nullptr};
+
+		/**
+		 * @brief Analog keys turned into buttons and D-pad by travel in `debounce()`, or none if null.
+		 */
+		GamepadRapidTrigger *rapidTrigger {nullptr};
+
+		/**
+		 * @brief Physical inputs mapped to logical ones at the end of `debounce()`, or left as they are if null.
+		 */
+		GamepadRemap *remap {nullptr};
+
+		/**
+		 * @brief Turbo buttons and macros applied to the debounced inputs at the end of `debounce()`, or none if null.
+		 */
+		GamepadTurbo *turbo {nullptr};
+
+		/**
+		 * @brief Deadzones and response curves applied to the analog sticks in `process()`, or none if null.
+		 */
+		GamepadAnalog *analog {nullptr};
+
+		/**
+		 * @brief The clock timing debouncing, hotkey holds and saves, or the board's `getMillis()`, or `getMicros()`
+		 * with GAMEPAD_CLOCK_MICROS, if null.
+		 */
+		GamepadClock *clock {nullptr};
+
+		/**
+		 * @brief The current time in ticks from `clock`, for the timed stages.
+		 */
+		inline uint32_t __attribute__((always_inline)) now() { return getGamepadTime(clock); }
+
+		/**
+		 * @brief Flag to indicate Left analog stick support.
+		 */
+		bool hasLeftAnalogStick {false};
+
+		/**
+		 * @brief Flag to indicate Right analog stick support.
+		 */
+		bool hasRightAnalogStick {false};
+
+		/**
+		 * @brief Incremented each time a report is built from a changed state.
+		 */
+		uint32_t generation {0};
+
+		/**
+		 * @brief The GAMEPAD_CHANGED_* fields that changed since the previous report.
+		 */
+		uint8_t changedFields {0};
+
+		/**
+		 * @brief Force the next report to be rebuilt, e.g. after changing `hasAnalogTriggers`.
+		 */
+		inline void invalidateReport() { reportKey = 0xFF; }
+
+#if GAMEPAD_PROFILE
+		/**
+		 * @brief Per-stage timings, only present when GAMEPAD_PROFILE is enabled.
+		 */
+		GamepadProfiler profiler;
+#endif
+
+		/**
+		 * @brief Pick up the analog inputs from `adc`, run debouncing algorithm against current state inputs, then set
+		 * the keys `rapidTrigger` drives from their travel. The debouncer is skipped when it drives every key. Everything after, turbo and hotkeys
+		 * included, sees the inputs as mapped by `remap`. Turbo and macros are applied last, timed as their own stage.
+		 *
+		 * Every frame goes through here, from `update()` or from a loop calling each stage itself.
+		 */
+		inline void __attribute__((always_inline)) debounce()
+		{
+			{
+				MPG_PROFILE_STAGE(GAMEPAD_STAGE_DEBOUNCE);
+				if (adc)
+					adc->read(state);
+				if (!rapidTrigger || rapidTrigger->getKeys() != GAMEPAD_KEY_ALL)
+					debouncer.debounce(&state, now());
+				if (rapidTrigger)
+					rapidTrigger->read(state);
+				if (remap)
+					remap->update(state);
+			}
+
+			runTurbo();
+		}
+
+		/**
+		 * @brief Check for a button press. Used by `pressed[Button]` helper methods.
+		 */
+		inline bool __attribute__((always_inline)) pressedButton(const uint16_t mask) { return (state.buttons & mask) == mask; }
+
+		/**
+		 * @brief Check for a dpad press. Used by `pressed[Dpad]` helper methods.
+		 */
+		inline bool __attribute__((always_inline)) pressedDpad(const uint8_t mask) { return (state.dpad & mask) == mask; }
+
+		inline bool __attribute__((always_inline)) pressedUp()    { return pressedDpad(GAMEPAD_MASK_UP); }
+		inline bool __attribute__((always_inline)) pressedDown()  { return pressedDpad(GAMEPAD_MASK_DOWN); }
+		inline bool __attribute__((always_inline)) pressedLeft()  { return pressedDpad(GAMEPAD_MASK_LEFT); }
+		inline bool __attribute__((always_inline)) pressedRight() { return pressedDpad(GAMEPAD_MASK_RIGHT); }
+		inline bool __attribute__((always_inline)) pressedB1()    { return pressedButton(GAMEPAD_MASK_B1); }
+		inline bool __attribute__((always_inline)) pressedB2()    { return pressedButton(GAMEPAD_MASK_B2); }
+		inline bool __attribute__((always_inline)) pressedB3()    { return pressedButton(GAMEPAD_MASK_B3); }
+		inline bool __attribute__((always_inline)) pressedB4()    { return pressedButton(GAMEPAD_MASK_B4); }
+		inline bool __attribute__((always_inline)) pressedL1()    { return pressedButton(GAMEPAD_MASK_L1); }
+		inline bool __attribute__((always_inline)) pressedR1()    { return pressedButton(GAMEPAD_MASK_R1); }
+		inline bool __attribute__((always_inline)) pressedL2()    { return pressedButton(GAMEPAD_MASK_L2); }
+		inline bool __attribute__((always_inline)) pressedR2()    { return pressedButton(GAMEPAD_MASK_R2); }
+		inline bool __attribute__((always_inline)) pressedS1()    { return pressedButton(GAMEPAD_MASK_S1); }
+		inline bool __attribute__((always_inline)) pressedS2()    { return pressedButton(GAMEPAD_MASK_S2); }
+		inline bool __attribute__((always_inline)) pressedL3()    { return pressedButton(GAMEPAD_MASK_L3); }
+		inline bool __attribute__((always_inline)) pressedR3()    { return pressedButton(GAMEPAD_MASK_R3); }
+		inline bool __attribute__((always_inline)) pressedA1()    { return pressedButton(GAMEPAD_MASK_A1); }
+		inline bool __attribute__((always_inline)) pressedA2()    { return pressedButton(GAMEPAD_MASK_A2); }
+		inline bool __attribute__((always_inline)) pressedF1()    { return pressedButton(f1Mask); }
+		inline bool __attribute__((always_inline)) pressedF2()    { return pressedButton(f2Mask); }
+
+	protected:
+		/**
+		 * @brief Call the board's `read()`, timed as the read stage when profiling.
+		 */
+		template <class Board>
+		inline void __attribute__((always_inline)) runRead(Board *board)
+		{
+			MPG_PROFILE_STAGE(GAMEPAD_STAGE_READ);
+			board->read();
+		}
+
+		/**
+		 * @brief Apply turbo and macros at the end of `debounce()`, timed as the turbo stage when profiling.
+		 */
+		inline void __attribute__((always_inline)) runTurbo()
+		{
+			MPG_PROFILE_STAGE(GAMEPAD_STAGE_TURBO);
+			if (turbo)
+				turbo->update(state, now());
+		}
+
+		/**
+		 * @brief The state and report settings the current reports were built from.
+		 */
+		GamepadState reportState;
+		uint8_t reportKey {0xFF};
+
+		/**
+		 * @brief Checks and executes any hotkey being pressed.
+		 *
+		 * @return GamepadHotkey The selected hotkey action
+		 */
+		inline GamepadHotkey runHotkeys()
+		{
+			MPG_PROFILE_STAGE(GAMEPAD_STAGE_HOTKEY);
+			return hotkeys.update(state, options, f1Mask, f2Mask, clock);
+		}
+
+		/**
+		 * @brief Process the inputs before sending state to host
+		 */
+		inline void runProcess()
+		{
+			MPG_PROFILE_STAGE(GAMEPAD_STAGE_PROCESS);
+			if (analog)
+				analog->process(state);
+
+			state.dpad = socd.update(options.socdMode, state.dpad);
+
+			switch (options.dpadMode)
+			{
+				case DpadMode::DPAD_MODE_LEFT_ANALOG:
+					if (!hasRightAnalogStick) {
+						state.rx = GAMEPAD_JOYSTICK_MID;
+						state.ry = GAMEPAD_JOYSTICK_MID;
+					}
+					state.lx = dpadToAnalogX(state.dpad);
+					state.ly = dpadToAnalogY(state.dpad);
+					state.dpad = 0;
+					break;
+
+				case DpadMode::DPAD_MODE_RIGHT_ANALOG:
+					if (!hasLeftAnalogStick) {
+						state.lx = GAMEPAD_JOYSTICK_MID;
+						state.ly = GAMEPAD_JOYSTICK_MID;
+					}
+					state.rx = dpadToAnalogX(state.dpad);
+					state.ry = dpadToAnalogY(state.dpad);
+					state.dpad = 0;
+					break;
+
+				default:
+					if (!hasLeftAnalogStick) {
+						state.lx = GAMEPAD_JOYSTICK_MID;
+						state.ly = GAMEPAD_JOYSTICK_MID;
+					}
+					if (!hasRightAnalogStick) {
+						state.rx = GAMEPAD_JOYSTICK_MID;
+						state.ry = GAMEPAD_JOYSTICK_MID;
+					}
+					break;
+			}
+		}
+
+		/**
+		 * @brief Convert the current state into a HID report.
+		 */
+		inline void fillHIDReport(HIDReport *report)
+		{
+			report->hat = convertGamepadHat(state.dpad);
+			report->buttons = convertGamepadButtons(hidReportTable, state.buttons, 0);
+
+			report->lx = static_cast<uint8_t>(state.lx >> 8);
+			report->ly = static_cast<uint8_t>(state.ly >> 8);
+			report->rx = static_cast<uint8_t>(state.rx >> 8);
+			report->ry = static_cast<uint8_t>(state.ry >> 8);
+		}
+
+		/**
+		 * @brief Convert the current state into a Switch report.
+		 */
+		inline void fillSwitchReport(SwitchReport *report)
+		{
+			report->hat = convertGamepadHat(state.dpad);
+			report->buttons = convertGamepadButtons(switchReportTable, state.buttons, 0);
+
+			report->lx = static_cast<uint8_t>(state.lx >> 8);
+			report->ly = static_cast<uint8_t>(state.ly >> 8);
+			report->rx = static_cast<uint8_t>(state.rx >> 8);
+			report->ry = static_cast<uint8_t>(state.ry >> 8);
+			report->vendor = 0;
+		}
+
+		/**
+		 * @brief Convert the current state into an XInput report.
+		 */
+		inline void fillXInputReport(XInputReport *report)
+		{
+			report->report_id = 0;
+			report->report_size = XINPUT_ENDPOINT_SIZE;
+
+			uint16_t buttons = convertGamepadButtons(xinputReportTable, state.buttons, state.dpad);
+			report->buttons1 = static_cast<uint8_t>(buttons);
+			report->buttons2 = static_cast<uint8_t>(buttons >> 8);
+
+			report->lx = static_cast<int16_t>(state.lx) + INT16_MIN;
+			report->ly = static_cast<int16_t>(~state.ly) + INT16_MIN;
+			report->rx = static_cast<int16_t>(state.rx) + INT16_MIN;
+			report->ry = static_cast<int16_t>(~state.ry) + INT16_MIN;
+
+			if (hasAnalogTriggers)
+			{
+				report->lt = state.lt;
+				report->rt = state.rt;
+			}
+			else
+			{
+				report->lt = pressedL2() ? 0xFF : 0;
+				report->rt = pressedR2() ? 0xFF : 0;
+			}
+		}
+
+		/**
+		 * @brief Select the report for an input mode.
+		 */
+		inline void *selectReport(InputMode mode, XInputReport *xinput, SwitchReport *switchReport, HIDReport *hid)
+		{
+			switch (mode)
+			{
+				case INPUT_MODE_XINPUT: return xinput;
+				case INPUT_MODE_SWITCH: return switchReport;
+				default:                return hid;
+			}
+		}
+
+		/**
+		 * @brief Fill the report for an input mode. Folds to a single conversion when `mode` is a constant.
+		 *
+		 * @return void* The filled report
+		 */
+		inline void *fillReport(InputMode mode, XInputReport *xinput, SwitchReport *switchReport, HIDReport *hid)
+		{
+			switch (mode)
+			{
+				case INPUT_MODE_XINPUT:
+					fillXInputReport(xinput);
+					break;
+
+				case INPUT_MODE_SWITCH:
+					fillSwitchReport(switchReport);
+					break;
+
+				default:
+					fillHIDReport(hid);
+					break;
+			}
+
+			return selectReport(mode, xinput, switchReport, hid);
+		}
+
+		/**
+		 * @brief Compare the state against the one the last report was built from, and update `changedFields` and
+		 * `generation`.
+		 *
+		 * @return bool True when the report needs to be rebuilt
+		 */
+		inline bool trackChanges(InputMode mode)
+		{
+			uint8_t key = static_cast<uint8_t>(mode) | (hasAnalogTriggers ? 0x10 : 0);
+			changedFields = compareGamepadState(state, reportState) | ((key != reportKey) ? GAMEPAD_CHANGED_REPORT : 0);
+			if (changedFields == 0)
+				return false;
+
+			reportState = state;
+			reportKey = key;
+			generation++;
+			return true;
+		}
+
+		/**
+		 * @brief Fill the report for an input mode only when the state changed since the last call.
+		 *
+		 * @param changed Set to whether the report was rebuilt, may be null
+		 * @return void* The current report
+		 */
+		inline void *fillChangedReport(InputMode mode, XInputReport *xinput, SwitchReport *switchReport, HIDReport *hid, bool *changed)
+		{
+			MPG_PROFILE_STAGE(GAMEPAD_STAGE_REPORT);
+			bool rebuild = trackChanges(mode);
+			if (changed)
+				*changed = rebuild;
+
+			if (rebuild)
+				return fillReport(mode, xinput, switchReport, hid);
+
+			return selectReport(mode, xinput, switchReport, hid);
+		}
+
+		/**
+		 * @brief Fill the report straight into driver-owned buffers only when the state changed since the last call.
+		 *
+		 * @param changed Set to whether the report was rebuilt, may be null
+		 * @return void* The front buffer, holding the current report
+		 */
+		inline void *fillChangedReport(InputMode mode, GamepadReportBuffers *buffers, bool *changed)
+		{
+			MPG_PROFILE_STAGE(GAMEPAD_STAGE_REPORT);
+			bool rebuild = trackChanges(mode);
+			if (changed)
+				*changed = rebuild;
+
+			if (rebuild)
+			{
+				void *report = buffers->beginFill(reportKey);
+				fillReport(mode, static_cast<XInputReport *>(report), static_cast<SwitchReport *>(report), static_cast<HIDReport *>(report));
+				buffers->endFill();
+			}
+
+			return buffers->getFront();
+		}
+};
+
+/**
+ * @brief Map an input mode to its report type and size at compile time.
+ */
+template <int Mode>
+struct GamepadReportTraits
+{
+	typedef HIDReport Type;
+};
+
+template <>
+struct GamepadReportTraits<INPUT_MODE_XINPUT>
+{
+	typedef XInputReport Type;
+};
+
+template <>
+struct GamepadReportTraits<INPUT_MODE_SWITCH>
+{
+	typedef SwitchReport Type;
+};
+
+/**
+ * @brief Get the USB report size for an input mode.
+ */
+inline uint16_t getGamepadReportSize(InputMode mode)
+{
+	switch (mode)
+	{
+		case INPUT_MODE_XINPUT:
+			return sizeof(XInputReport);
+
+		case INPUT_MODE_SWITCH:
+			return sizeof(SwitchReport);
+
+		default:
+			return sizeof(HIDReport);
+	}
+}
@@ -3,26 +3,75 @@
 GamepadHotkey MPGS::hotkey()
 {
 	GamepadHotkey hotkey = MPG::hotkey();
-	if (hotkey != GamepadHotkey::HOTKEY_NONE)
-		save();
+	hotkeyHeld = (hotkey != GamepadHotkey::HOTKEY_NONE);
 
+	// Only hotkeys save on their own, the sketch saves its own changes with requestSave() or save()
+	if (hotkeyHeld && (!equalGamepadOptions(options, lastOptions) || (remap && remap->getRevision() != lastRemap)))
+		requestSave();
+
+	stepSave();
 	return hotkey;
 }
 
 void MPGS::load()
 {
 	options = mpgStorage->getGamepadOptions();
+	lastOptions = options;
+	saveWaiting = false;
+
+	uint32_t map[GAMEPAD_DIGITAL_INPUT_COUNT];
+	if (remap)
+	{
+		if (mpgStorage->getRemap(map))
+			remap->setMap(map);
+
+		lastRemap = remap->getRevision();
+	}
 }
+
 void MPGS::save()
 {
-	bool dirty = false;
-	GamepadOptions savedOptions = mpgStorage->getGamepadOptions();
-	if (memcmp(&savedOptions, &options, sizeof(GamepadOptions)))
+	while (saveRunning)
+		saveRunning = !mpgStorage->stepSave();
+
+	lastOptions = options;
+	saveWaiting = false;
+	if (remap)
+	{
+		lastRemap = remap->getRevision();
+		mpgStorage->setRemap(remap->getMap());
+	}
+
+	mpgStorage->beginSave(options);
+	while (!mpgStorage->stepSave()) { }
+}
+
+void MPGS::requestSave()
+{
+	lastOptions = options;
+	if (remap)
+		lastRemap = remap->getRevision();
+
+	changedAt = now();
+	saveWaiting = true;
+}
+
+bool MPGS::stepSave()
+{
+	// Options and remaps that change while a save runs are saved after it
+	if (saveRunning)
 	{
-		mpgStorage->setGamepadOptions(options);
-		dirty = true;
+		saveRunning = !mpgStorage->stepSave();
+	}
+	else if (saveWaiting && (!hotkeyHeld || now() - changedAt >= GAMEPAD_SAVE_DELAY_MS * GAMEPAD_CLOCK_TICKS_PER_MS))
+	{
+		saveWaiting = false;
+		saveRunning = true;
+		if (remap)
+			mpgStorage->setRemap(remap->getMap());
+
+		mpgStorage->beginSave(lastOptions);
 	}
 
-	if (dirty)
-		mpgStorage->save();
+	return saveWaiting || saveRunning;
 }
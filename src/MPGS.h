@@ -6,6 +6,7 @@
 #pragma once
 
 #include "MPG.h"
+#include "GamepadConfig.h"
 #include "GamepadStorage.h"
 
 class MPGS : public MPG
@@ -17,23 +18,50 @@ class MPGS : public MPG
 		}
 
 		/**
-		 * @brief Load the saved configuration from persistent storage.
+		 * @brief Load the saved configuration from persistent storage, including the map of `remap` if set.
 		 */
 		void load();
 
 		/**
-		 * @brief Save the current configuration to persistent storage if changed.
+		 * @brief Save the current configuration to persistent storage if changed, waiting for the save to finish.
 		 */
 		void save();
 
+		/**
+		 * @brief Save the current configuration from `stepSave()` once the hotkey is released or
+		 * GAMEPAD_SAVE_DELAY_MS has passed without changes.
+		 */
+		void requestSave();
+
+		/**
+		 * @brief Start a requested save or do the next slice of a running one. Called from `hotkey()` every frame, or
+		 * can be called from an idle loop or another core instead.
+		 *
+		 * @return bool True while a save is waiting or running
+		 */
+		bool stepSave();
+
 		/**
 		 * @brief Checks and executes any hotkey being pressed...with automatic save!
 		 *
+		 * Options changed while a hotkey is held are not saved here. The save is coalesced until the hotkey is released
+		 * and then spread over the following frames, so reading inputs never waits on storage. Changes made with no
+		 * hotkey held are left for `requestSave()` or `save()`.
+		 *
 		 * @return GamepadHotkey - The selected hotkey action
 		 */
 		GamepadHotkey hotkey() override;
 
+		inline bool isSaving() const { return saveWaiting || saveRunning; }
+
 	protected:
 		// TODO: bare pointers should be avoided when possible. Consider using shared_ptr or similar.
 		GamepadStorage *mpgStorage;
+
+		GamepadOptions lastOptions;   // Options as of the last change seen
+		uint16_t lastRemap {0};       // Revision of `remap` as of the last change seen
+		uint32_t changedAt {0};       // When they changed, in clock ticks
+		bool saveWaiting {false};
+		bool saveRunning {false};
+		bool hotkeyHeld {false};
 };
@@ -0,0 +1,128 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include "MPGCore.h"
+
+// Use as the MPGT input mode parameter to select the report at runtime from `options.inputMode`
+#define INPUT_MODE_RUNTIME -1
+
+// Compile-time type selection, since <type_traits> is not available on every platform
+template <bool Condition, typename T, typename F> struct MPGTConditional { typedef T Type; };
+template <typename T, typename F> struct MPGTConditional<false, T, F> { typedef F Type; };
+
+/**
+ * @brief Statically dispatched MPG variant.
+ *
+ * `Board` is the derived class (CRTP) and must define `setup()` and `read()`. It may also define its own `hotkey()`
+ * or `process()` to replace the defaults. Nothing is virtual, so when `Mode` is fixed the compiler can inline the
+ * whole read -> debounce -> hotkey -> process -> report chain with no vtable lookups and no input mode switch.
+ *
+ * class Gamepad : public MPGT<Gamepad, INPUT_MODE_XINPUT>
+ * {
+ *   public:
+ *     void setup();
+ *     void read();
+ * };
+ *
+ * The runtime switchable `MPG` class remains available, and both produce identical reports.
+ */
+template <class Board, int Mode = INPUT_MODE_RUNTIME>
+class MPGT : public MPGCore
+{
+	public:
+		typedef typename GamepadReportTraits<Mode>::Type FixedReportType;
+
+		// `void` when the mode is picked at runtime, otherwise the report struct for the fixed mode
+		typedef typename MPGTConditional<Mode == INPUT_MODE_RUNTIME, void, FixedReportType>::Type ReportType;
+
+		MPGT(int debounceMS = 5) : MPGCore(debounceMS)
+		{
+			if (Mode != INPUT_MODE_RUNTIME)
+				options.inputMode = static_cast<InputMode>(Mode);
+		}
+
+		/**
+		 * @brief The input mode used to build reports.
+		 */
+		inline InputMode __attribute__((always_inline)) inputMode()
+		{
+			return (Mode == INPUT_MODE_RUNTIME) ? options.inputMode : static_cast<InputMode>(Mode);
+		}
+
+		/**
+		 * @brief Checks and executes any hotkey being pressed.
+		 *
+		 * @return GamepadHotkey The selected hotkey action
+		 */
+		inline GamepadHotkey hotkey() { return runHotkeys(); }
+
+		/**
+		 * @brief Process the inputs before sending state to host
+		 */
+		inline void process() { runProcess(); }
+
+		/**
+		 * @brief Generate USB report for the current input mode. The report is only rebuilt when the state or input
+		 * mode changed since the previous call.
+		 *
+		 * @param changed Set to whether the report changed, so drivers can skip sending it
+		 * @return ReportType* Report data pointer
+		 */
+		inline ReportType *getReport(bool *changed = nullptr)
+		{
+			return static_cast<ReportType *>(fillChangedReport(inputMode(), &report.xinput, &report.switchReport, &report.hid, changed));
+		}
+
+		/**
+		 * @brief Get the size of the USB report for the current input mode.
+		 *
+		 * @return uint16_t Report data size
+		 */
+		inline uint16_t getReportSize() { return getGamepadReportSize(inputMode()); }
+
+		/**
+		 * @brief Run a full frame: read, debounce, turbo, hotkey, process and report.
+		 *
+		 * Calls go through `Board`, so any stage the board redefines is used instead of the default.
+		 *
+		 * @param changed Set to whether the report changed, may be null
+		 * @return ReportType* Report data pointer
+		 */
+		inline ReportType *update(bool *changed = nullptr)
+		{
+			Board *board = static_cast<Board *>(this);
+			runRead(board);
+			board->debounce();
+			board->hotkey();
+			board->process();
+			return board->getReport(changed);
+		}
+
+	protected:
+		union
+		{
+			XInputReport xinput;
+			SwitchReport switchReport;
+			HIDReport hid;
+		} report
+		{
+			.xinput =
+			{
+				.report_id = 0,
+				.report_size = XINPUT_ENDPOINT_SIZE,
+				.buttons1 = 0,
+				.buttons2 = 0,
+				.lt = 0,
+				.rt = 0,
+				.lx = GAMEPAD_JOYSTICK_MID,
+				.ly = GAMEPAD_JOYSTICK_MID,
+				.rx = GAMEPAD_JOYSTICK_MID,
+				.ry = GAMEPAD_JOYSTICK_MID,
+				._reserved = { },
+			}
+		};
+};
@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+#include "StringDescriptors.h"
+
 #define HID_ENDPOINT_SIZE 64
 
 // HAT report (4 bits)
@@ -51,18 +53,10 @@ typedef struct __attribute((packed, aligned(1)))
 	uint8_t ry;
 } HIDReport;
 
-static const uint8_t hid_string_language[]     = { 0x09, 0x04 };
-static const uint8_t hid_string_manufacturer[] = "Generic";
-static const uint8_t hid_string_product[]      = "HID Gamepad";
-static const uint8_t hid_string_version[]      = "1.0";
-
-static const uint8_t *hid_string_descriptors[] =
-{
-	hid_string_language,
-	hid_string_manufacturer,
-	hid_string_product,
-	hid_string_version
-};
+GAMEPAD_STRING_DESCRIPTOR(hid_string_language, u"\u0409"); // English (United States)
+GAMEPAD_STRING_DESCRIPTOR(hid_string_manufacturer, u"Generic");
+GAMEPAD_STRING_DESCRIPTOR(hid_string_product, u"HID Gamepad");
+GAMEPAD_STRING_DESCRIPTOR(hid_string_version, u"1.0");
 
 static const uint8_t hid_device_descriptor[] =
 {
@@ -90,7 +84,7 @@ static const uint8_t hid_hid_descriptor[] =
 	0x00,        // bCountryCode
 	0x01,        // bNumDescriptors
 	0x22,        // bDescriptorType[0] (HID)
-	0x5A, 0x00,  // wDescriptorLength[0] 90
+	0x51, 0x00,  // wDescriptorLength[0] 81
 };
 
 static const uint8_t hid_configuration_descriptor[] =
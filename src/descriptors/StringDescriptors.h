@@ -0,0 +1,39 @@
+/*
+ * SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: Copyright (c) 2021 Jason Skuby (mytechtoybox.com)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// UTF-16 code unit, as the type of u"" literals in both C11 and C++11
+#ifdef __cplusplus
+typedef char16_t GamepadChar16;
+#define GAMEPAD_DESCRIPTOR_CONST constexpr
+#else
+typedef __CHAR16_TYPE__ GamepadChar16;
+#define GAMEPAD_DESCRIPTOR_CONST const
+#endif
+
+#define USB_DESCRIPTOR_TYPE_STRING 0x03
+
+/*
+	Declare a USB string descriptor from a u"" literal, converted to UTF-16 by the compiler:
+
+	    GAMEPAD_STRING_DESCRIPTOR(my_string_product, u"My Gamepad");
+
+	bLength is the literal's size, which counts the terminator in place of the two header bytes, so the terminator
+	is stored after the descriptor but never sent.
+*/
+#define GAMEPAD_STRING_DESCRIPTOR(name, text) \
+	static GAMEPAD_DESCRIPTOR_CONST struct __attribute__((packed)) \
+	{ \
+		uint8_t bLength; \
+		uint8_t bDescriptorType; \
+		GamepadChar16 bString[sizeof(text) / sizeof(GamepadChar16)]; \
+	} name = { sizeof(text), USB_DESCRIPTOR_TYPE_STRING, text }
+
+// Upper case hex digit for the low nibble of `value`, as a constant expression
+#define GAMEPAD_HEX_DIGIT(value) ((((value) & 0xF) < 10) ? ('0' + ((value) & 0xF)) : ('A' + ((value) & 0xF) - 10))
+#define GAMEPAD_HEX_BYTE(value) GAMEPAD_HEX_DIGIT((value) >> 4), GAMEPAD_HEX_DIGIT(value)
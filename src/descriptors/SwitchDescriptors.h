@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+#include "StringDescriptors.h"
+
 #define SWITCH_ENDPOINT_SIZE 64
 
 // HAT report (4 bits)
@@ -62,18 +64,10 @@ typedef struct
 	uint8_t ry;
 } SwitchOutReport;
 
-static const uint8_t switch_string_language[]     = { 0x09, 0x04 };
-static const uint8_t switch_string_manufacturer[] = "HORI CO.,LTD.";
-static const uint8_t switch_string_product[]      = "POKKEN CONTROLLER";
-static const uint8_t switch_string_version[]      = "1.0";
-
-static const uint8_t *switch_string_descriptors[] =
-{
-	switch_string_language,
-	switch_string_manufacturer,
-	switch_string_product,
-	switch_string_version
-};
+GAMEPAD_STRING_DESCRIPTOR(switch_string_language, u"\u0409"); // English (United States)
+GAMEPAD_STRING_DESCRIPTOR(switch_string_manufacturer, u"HORI CO.,LTD.");
+GAMEPAD_STRING_DESCRIPTOR(switch_string_product, u"POKKEN CONTROLLER");
+GAMEPAD_STRING_DESCRIPTOR(switch_string_version, u"1.0");
 
 static const uint8_t switch_device_descriptor[] =
 {
@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+#include "StringDescriptors.h"
+
 #define XINPUT_ENDPOINT_SIZE 20
 
 // Buttons 1 (8 bits)
@@ -46,18 +48,10 @@ typedef struct __attribute((packed, aligned(1)))
 	uint8_t _reserved[6];
 } XInputReport;
 
-static const uint8_t xinput_string_language[]    = { 0x09, 0x04 };
-static const uint8_t xinput_string_manfacturer[] = "Microsoft";
-static const uint8_t xinput_string_product[]     = "XInput STANDARD GAMEPAD";
-static const uint8_t xinput_string_version[]     = "1.0";
-
-static const uint8_t *xinput_string_descriptors[] =
-{
-	xinput_string_language,
-	xinput_string_manfacturer,
-	xinput_string_product,
-	xinput_string_version
-};
+GAMEPAD_STRING_DESCRIPTOR(xinput_string_language, u"\u0409"); // English (United States)
+GAMEPAD_STRING_DESCRIPTOR(xinput_string_manufacturer, u"Microsoft");
+GAMEPAD_STRING_DESCRIPTOR(xinput_string_product, u"XInput STANDARD GAMEPAD");
+GAMEPAD_STRING_DESCRIPTOR(xinput_string_version, u"1.0");
 
 static const uint8_t xinput_device_descriptor[] =
 {